@@ -163,7 +163,7 @@ namespace JUnit
 //==============================================================================
 namespace TestRunner
 {
-    int runTests (const File& junitResultsFile)
+    int runTests (const File& junitResultsFile, bool runPerformanceTests)
     {
         CoutLogger logger;
         Logger::setCurrentLogger (&logger);
@@ -175,6 +175,10 @@ namespace TestRunner
 
         Array<UnitTest*> tests;
         tests.addArray (UnitTest::getTestsInCategory ("tracktion_graph"));
+
+        // Set TRACKTION_GRAPH_BENCHMARK_FILE to write the performance results as JSON
+        if (runPerformanceTests)
+            tests.addArray (UnitTest::getTestsInCategory ("tracktion_graph_performance"));
         
         const auto startTime = Time::getCurrentTime();
         testRunner.runTests (tests);
@@ -209,12 +213,18 @@ namespace TestRunner
 int main (int argv, char** argc)
 {
     File junitFile;
+    bool runPerformanceTests = false;
     
     for (int i = 1; i < argv; ++i)
+    {
         if (String (argc[i]) == "--junit-xml-file")
             if ((i + 1) < argv)
                 junitFile = String (argc[i + 1]);
+
+        if (String (argc[i]) == "--performance")
+            runPerformanceTests = true;
+    }
     
     ScopedJuceInitialiser_GUI init;
-    return TestRunner::runTests (junitFile);
+    return TestRunner::runTests (junitFile, runPerformanceTests);
 }
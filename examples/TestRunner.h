@@ -216,5 +216,18 @@ int main (int argv, char** argc)
                 junitFile = String (argc[i + 1]);
     
     ScopedJuceInitialiser_GUI init;
+
+    // The PluginBridge tests launch this app again as the bridge's child process
+    StringArray args;
+
+    for (int i = 1; i < argv; ++i)
+        args.add (argc[i]);
+
+    if (PluginManager::startChildProcessPluginBridge (args.joinIntoString (" ")))
+    {
+        MessageManager::getInstance()->runDispatchLoop();
+        return 0;
+    }
+
     return TestRunner::runTests (junitFile);
 }
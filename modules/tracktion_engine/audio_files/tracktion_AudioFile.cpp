@@ -449,8 +449,8 @@ private:
 //==============================================================================
 struct AudioFileManager::KnownFile
 {
-    KnownFile (const AudioFile& f)
-        : file (f), info (AudioFileInfo::parse (file))
+    KnownFile (const AudioFile& f, const AudioFileInfo& i)
+        : file (f), info (i)
     {
     }
 
@@ -460,6 +460,283 @@ struct AudioFileManager::KnownFile
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KnownFile)
 };
 
+//==============================================================================
+static const int infoCacheMagic = (int) juce::ByteOrder::littleEndianInt ("TKAI");
+static const int infoCacheVersion = 1;
+
+/** Keeps the AudioFileInfo of files between sessions so their headers don't need
+    to be parsed again, keyed by the file's path, modification time and size.
+
+    The cache file is memory-mapped when it's loaded and the entries are then
+    checked against the files on disk on background threads. Looking up an entry
+    that hasn't been checked yet checks it there and then.
+*/
+struct AudioFileManager::PersistentInfoCache
+{
+    PersistentInfoCache (Engine& e)
+        : PersistentInfoCache (e, e.getTemporaryFileManager().getTempDirectory().getChildFile ("audio_file_info.cache"))
+    {
+    }
+
+    PersistentInfoCache (Engine& e, const juce::File& file)
+        : engine (e), cacheFile (file)
+    {
+        load();
+        startValidating();
+    }
+
+    ~PersistentInfoCache()
+    {
+        shouldStopValidating = true;
+
+        for (auto& t : validationTasks)
+            t.wait();
+    }
+
+    bool lookup (const AudioFile& f, AudioFileInfo& result)
+    {
+        const juce::ScopedLock sl (lock);
+        auto found = entries.find (f.getHash());
+
+        if (found == entries.end())
+            return false;
+
+        auto& entry = found->second;
+
+        if (! entry.validated)
+        {
+            if (entry.file != f.getFile() || ! entry.matchesFileOnDisk())
+            {
+                entries.erase (found);
+                needsSaving = true;
+                return false;
+            }
+
+            entry.validated = true;
+        }
+
+        result = entry.info;
+        return true;
+    }
+
+    void store (const AudioFile& f, const AudioFileInfo& info)
+    {
+        auto& file = f.getFile();
+
+        if (! info.wasParsedOk || info.format == nullptr)
+        {
+            const juce::ScopedLock sl (lock);
+
+            if (entries.erase (f.getHash()) > 0)
+                needsSaving = true;
+
+            return;
+        }
+
+        Entry entry { file, info.fileModificationTime.toMilliseconds(), file.getSize(), info, true };
+
+        const juce::ScopedLock sl (lock);
+        entries.erase (f.getHash());
+        entries.emplace (f.getHash(), std::move (entry));
+        needsSaving = true;
+    }
+
+    void save()
+    {
+        const juce::ScopedLock sl (lock);
+
+        if (! needsSaving)
+            return;
+
+        cacheFile.getParentDirectory().createDirectory();
+
+        // Write to a temporary first so a partially written file can never be read back
+        juce::TemporaryFile temp (cacheFile);
+
+        {
+            juce::FileOutputStream out (temp.getFile());
+
+            if (! out.openedOk())
+                return;
+
+            out.writeInt (infoCacheMagic);
+            out.writeInt (infoCacheVersion);
+            out.writeInt ((int) entries.size());
+
+            for (auto& e : entries)
+                e.second.writeTo (out);
+        }
+
+        if (temp.overwriteTargetFileWithTemporary())
+            needsSaving = false;
+    }
+
+private:
+    struct Entry
+    {
+        juce::File file;
+        juce::int64 modificationTime = 0, fileSize = 0;
+        AudioFileInfo info;
+        bool validated = false;
+
+        bool matchesFileOnDisk() const
+        {
+            return file.getLastModificationTime().toMilliseconds() == modificationTime
+                     && file.getSize() == fileSize;
+        }
+
+        void writeTo (juce::OutputStream& out) const
+        {
+            out.writeString (file.getFullPathName());
+            out.writeInt64 (modificationTime);
+            out.writeInt64 (fileSize);
+            out.writeString (info.format->getFormatName());
+            out.writeDouble (info.sampleRate);
+            out.writeInt64 (info.lengthInSamples);
+            out.writeInt (info.numChannels);
+            out.writeInt (info.bitsPerSample);
+            out.writeBool (info.isFloatingPoint);
+            out.writeBool (info.needsCachedProxy);
+
+            auto keys = info.metadata.getAllKeys();
+            auto values = info.metadata.getAllValues();
+            out.writeInt (keys.size());
+
+            for (int i = 0; i < keys.size(); ++i)
+            {
+                out.writeString (keys[i]);
+                out.writeString (values[i]);
+            }
+
+            info.loopInfo.state.writeToStream (out);
+        }
+    };
+
+    Engine& engine;
+    const juce::File cacheFile;
+    std::unordered_map<juce::int64, Entry> entries;
+    juce::CriticalSection lock;
+    bool needsSaving = false;
+
+    std::vector<std::future<void>> validationTasks;
+    std::atomic<bool> shouldStopValidating { false };
+
+    void load()
+    {
+        CRASH_TRACER
+        juce::MemoryMappedFile mappedFile (cacheFile, juce::MemoryMappedFile::readOnly);
+
+        if (mappedFile.getData() == nullptr)
+            return;
+
+        juce::MemoryInputStream in (mappedFile.getData(), mappedFile.getSize(), false);
+
+        if (in.readInt() != infoCacheMagic || in.readInt() != infoCacheVersion)
+            return;
+
+        auto& formatManager = engine.getAudioFileFormatManager();
+        const int numEntries = in.readInt();
+
+        for (int i = 0; i < numEntries && ! in.isExhausted(); ++i)
+        {
+            Entry entry { juce::File (in.readString()), 0, 0, AudioFileInfo (engine), false };
+            entry.modificationTime = in.readInt64();
+            entry.fileSize = in.readInt64();
+
+            auto formatName = in.readString();
+            auto& info = entry.info;
+            info.wasParsedOk        = true;
+            info.hashCode           = getAudioFileHash (entry.file);
+            info.format             = formatManager.getNamedFormat (formatName);
+            info.sampleRate         = in.readDouble();
+            info.lengthInSamples    = in.readInt64();
+            info.numChannels        = in.readInt();
+            info.bitsPerSample      = in.readInt();
+            info.isFloatingPoint    = in.readBool();
+            info.needsCachedProxy   = in.readBool();
+            info.fileModificationTime = juce::Time (entry.modificationTime);
+
+            const int numMetadataValues = in.readInt();
+
+            for (int j = 0; j < numMetadataValues && ! in.isExhausted(); ++j)
+            {
+                auto key = in.readString();
+                info.metadata.set (key, in.readString());
+            }
+
+            auto loopInfoState = juce::ValueTree::readFromStream (in);
+
+            // A format that's no longer available would give the file the wrong reader
+            if (info.format == nullptr || info.format->getFormatName() != formatName
+                 || ! loopInfoState.hasType (IDs::LOOPINFO))
+                continue;
+
+            info.loopInfo = LoopInfo (engine, loopInfoState, nullptr);
+            entries.emplace (info.hashCode, std::move (entry));
+        }
+    }
+
+    void startValidating()
+    {
+        struct FileToCheck
+        {
+            juce::int64 hash;
+            juce::File file;
+            juce::int64 modificationTime, fileSize;
+        };
+
+        auto filesToCheck = std::make_shared<std::vector<FileToCheck>>();
+
+        for (auto& e : entries)
+            filesToCheck->push_back ({ e.first, e.second.file, e.second.modificationTime, e.second.fileSize });
+
+        const auto numTasks = (size_t) juce::jmin ((int) filesToCheck->size(), juce::SystemStats::getNumCpus());
+
+        for (size_t task = 0; task < numTasks; ++task)
+        {
+            validationTasks.push_back (std::async (std::launch::async, [this, filesToCheck, task, numTasks]
+            {
+                std::vector<std::pair<const FileToCheck*, bool>> results;
+
+                for (size_t i = task; i < filesToCheck->size(); i += numTasks)
+                {
+                    if (shouldStopValidating)
+                        return;
+
+                    auto& f = (*filesToCheck)[i];
+                    results.push_back ({ &f, f.file.getLastModificationTime().toMilliseconds() == f.modificationTime
+                                               && f.file.getSize() == f.fileSize });
+                }
+
+                const juce::ScopedLock sl (lock);
+
+                for (auto& r : results)
+                {
+                    auto found = entries.find (r.first->hash);
+
+                    // Skip anything that's been looked up or replaced since the check started
+                    if (found == entries.end() || found->second.validated
+                         || found->second.modificationTime != r.first->modificationTime
+                         || found->second.fileSize != r.first->fileSize)
+                        continue;
+
+                    if (r.second)
+                    {
+                        found->second.validated = true;
+                    }
+                    else
+                    {
+                        entries.erase (found);
+                        needsSaving = true;
+                    }
+                }
+            }));
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PersistentInfoCache)
+};
+
 //==============================================================================
 enum { initialTimerDelay = 10 };
 
@@ -600,25 +877,45 @@ void SmartThumbnail::timerCallback()
 
 //==============================================================================
 AudioFileManager::AudioFileManager (Engine& e)
-    : engine (e), cache (e), thumbnailCache (new TracktionThumbnailCache (e))
+    : engine (e), cache (e), infoCache (new PersistentInfoCache (e)),
+      thumbnailCache (new TracktionThumbnailCache (e))
 {
 }
 
 AudioFileManager::~AudioFileManager()
 {
+    saveInfoCache();
     clearFiles();
 }
 
+void AudioFileManager::saveInfoCache()
+{
+    CRASH_TRACER
+    infoCache->save();
+}
+
 AudioFileManager::KnownFile& AudioFileManager::findOrCreateKnown (const AudioFile& f)
 {
     if (auto kf = knownFiles[f.getHash()])
         return *kf;
 
-    auto kf = new KnownFile (f);
+    auto kf = new KnownFile (f, parseInfo (f));
     knownFiles.set (f.getHash(), kf);
     return *kf;
 }
 
+AudioFileInfo AudioFileManager::parseInfo (const AudioFile& f)
+{
+    AudioFileInfo info (engine);
+
+    if (infoCache->lookup (f, info))
+        return info;
+
+    info = AudioFileInfo::parse (f);
+    infoCache->store (f, info);
+    return info;
+}
+
 void AudioFileManager::clearFiles()
 {
     CRASH_TRACER
@@ -653,17 +950,43 @@ AudioFileInfo AudioFileManager::getInfo (const AudioFile& file)
 }
 
 bool AudioFileManager::checkFileTime (KnownFile& f)
+{
+    return checkFileTime (f, f.file.getFile().getLastModificationTime());
+}
+
+bool AudioFileManager::checkFileTime (KnownFile& f, juce::Time currentModificationTime)
 {
     if (! f.info.wasParsedOk
-        || f.info.fileModificationTime != f.file.getFile().getLastModificationTime())
+        || f.info.fileModificationTime != currentModificationTime)
     {
         f.info = AudioFileInfo::parse (f.file);
+        infoCache->store (f.file, f.info);
         return true;
     }
 
     return false;
 }
 
+static std::vector<juce::Time> getModificationTimes (const juce::Array<juce::File>& files)
+{
+    // Large sessions can reference thousands of files, possibly on network drives, so stat them in parallel
+    std::vector<juce::Time> times ((size_t) files.size());
+    const int numTasks = juce::jlimit (1, juce::SystemStats::getNumCpus(), files.size() / 64);
+    std::vector<std::future<void>> tasks;
+
+    for (int task = 0; task < numTasks; ++task)
+        tasks.push_back (std::async (std::launch::async, [&files, &times, task, numTasks]
+                                     {
+                                         for (int i = task; i < files.size(); i += numTasks)
+                                             times[(size_t) i] = files.getReference (i).getLastModificationTime();
+                                     }));
+
+    for (auto& t : tasks)
+        t.wait();
+
+    return times;
+}
+
 void AudioFileManager::checkFileForChanges (const AudioFile& file)
 {
     CRASH_TRACER
@@ -693,11 +1016,23 @@ void AudioFileManager::checkFilesForChanges()
 
     {
         const juce::ScopedLock sl (knownFilesLock);
+        juce::Array<KnownFile*> files;
+        juce::Array<juce::File> filesOnDisk;
 
         for (juce::HashMap<juce::int64, KnownFile*>::Iterator i (knownFiles); i.next();)
+        {
             if (auto f = i.getValue())
-                if (checkFileTime (*f))
-                    changedFiles.add (f->file);
+            {
+                files.add (f);
+                filesOnDisk.add (f->file.getFile());
+            }
+        }
+
+        auto modificationTimes = getModificationTimes (filesOnDisk);
+
+        for (int i = 0; i < files.size(); ++i)
+            if (checkFileTime (*files.getUnchecked (i), modificationTimes[(size_t) i]))
+                changedFiles.add (files.getUnchecked (i)->file);
     }
 
     for (auto& f : changedFiles)
@@ -753,6 +1088,7 @@ void AudioFileManager::forceFileUpdate (const AudioFile& file)
     if (auto f = knownFiles[file.getHash()])
     {
         f->info = AudioFileInfo::parse (f->file);
+        infoCache->store (f->file, f->info);
         releaseFile (file);
         callListeners (file);
     }
@@ -794,4 +1130,128 @@ void AudioFileManager::handleAsyncUpdate()
         checkFileForChanges (fileToCheck);
 }
 
+
+//==============================================================================
+//==============================================================================
+#if TRACKTION_UNIT_TESTS
+
+class PersistentInfoCacheTests  : public juce::UnitTest
+{
+public:
+    PersistentInfoCacheTests() : juce::UnitTest ("PersistentInfoCache", "Tracktion") {}
+
+    //==============================================================================
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines()[0];
+        juce::TemporaryFile cacheFile (".cache"), wavFile (".wav");
+        writeSinFile (wavFile.getFile(), 44100.0, 2);
+
+        const AudioFile audioFile (engine, wavFile.getFile());
+        const auto info = AudioFileInfo::parse (audioFile);
+        expect (info.wasParsedOk);
+
+        auto saveCache = [&]
+        {
+            AudioFileManager::PersistentInfoCache cache (engine, cacheFile.getFile());
+            cache.store (audioFile, info);
+            cache.save();
+        };
+
+        auto isInCache = [&] (AudioFileInfo& result)
+        {
+            AudioFileManager::PersistentInfoCache cache (engine, cacheFile.getFile());
+            return cache.lookup (audioFile, result);
+        };
+
+        beginTest ("Save and load");
+        {
+            saveCache();
+            expect (cacheFile.getFile().getSize() > 0);
+
+            AudioFileInfo loaded (engine);
+            expect (isInCache (loaded));
+            expect (loaded.wasParsedOk);
+            expect (loaded.format != nullptr);
+
+            if (loaded.format != nullptr)
+                expectEquals (loaded.format->getFormatName(), info.format->getFormatName());
+
+            expectEquals (loaded.hashCode, info.hashCode);
+            expectEquals (loaded.sampleRate, info.sampleRate);
+            expectEquals (loaded.lengthInSamples, info.lengthInSamples);
+            expectEquals (loaded.numChannels, info.numChannels);
+            expectEquals (loaded.bitsPerSample, info.bitsPerSample);
+            expectEquals (loaded.isFloatingPoint, info.isFloatingPoint);
+            expectEquals (loaded.fileModificationTime.toMilliseconds(), info.fileModificationTime.toMilliseconds());
+        }
+
+        const auto modificationTime = wavFile.getFile().getLastModificationTime();
+
+        beginTest ("Changed modification time");
+        {
+            saveCache();
+            wavFile.getFile().setLastModificationTime (modificationTime + juce::RelativeTime::seconds (10.0));
+
+            AudioFileInfo loaded (engine);
+            expect (! isInCache (loaded));
+            wavFile.getFile().setLastModificationTime (modificationTime);
+        }
+
+        beginTest ("Changed size");
+        {
+            saveCache();
+
+            {
+                juce::FileOutputStream out (wavFile.getFile());
+                out.writeInt (0);
+            }
+
+            // Put the time back so only the size differs
+            wavFile.getFile().setLastModificationTime (modificationTime);
+
+            AudioFileInfo loaded (engine);
+            expect (! isInCache (loaded));
+        }
+
+        beginTest ("Unknown cache version");
+        {
+            saveCache();
+
+            {
+                juce::FileOutputStream out (cacheFile.getFile());
+                out.setPosition (4);
+                out.writeInt (infoCacheVersion + 1);
+            }
+
+            AudioFileInfo loaded (engine);
+            expect (! isInCache (loaded));
+        }
+    }
+
+    static void writeSinFile (const juce::File& file, double sampleRate, int numChannels)
+    {
+        juce::AudioBuffer<float> buffer (numChannels, (int) sampleRate);
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            for (int chan = 0; chan < numChannels; ++chan)
+                buffer.setSample (chan, i, (float) std::sin (juce::MathConstants<double>::twoPi * 220.0 * i / sampleRate));
+
+        file.deleteFile();
+
+        if (auto out = file.createOutputStream())
+        {
+            if (auto writer = std::unique_ptr<juce::AudioFormatWriter> (juce::WavAudioFormat().createWriterFor (out.get(), sampleRate, (unsigned int) numChannels, 16, {}, 0)))
+            {
+                out.release();
+                writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+            }
+        }
+    }
+};
+
+static PersistentInfoCacheTests persistentInfoCacheTests;
+
+#endif
+
 }
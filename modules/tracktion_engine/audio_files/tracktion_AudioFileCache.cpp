@@ -69,6 +69,47 @@ public:
                 touchAllReaders ({ pos + distanceAhead, pos + distanceAhead + 8192 });
     }
 
+    /** Adds any prefetch points that the clients are still waiting for. */
+    void addPrefetchRequests (juce::Array<PrefetchRequest>& requests, juce::uint32 now)
+    {
+        const juce::ScopedReadLock sl (clientListLock);
+
+        for (auto r : clients)
+        {
+            if (r->getReferenceCount() > 1)
+            {
+                for (auto& p : r->prefetchPoints)
+                {
+                    juce::int64 position;
+                    juce::uint32 deadline;
+                    p.get (position, deadline);
+
+                    if (isPrefetchPending (deadline, now))
+                        requests.add ({ this, std::max ((juce::int64) 0, position), deadline });
+                }
+            }
+        }
+    }
+
+    void touchRange (juce::Range<juce::int64> range)
+    {
+        const juce::ScopedReadLock sl (readerLock);
+        touchAllReaders (range);
+    }
+
+    /** A prefetch point is kept for a second after its deadline, by which time the
+        reader will either be reading from there or won't need it any more.
+    */
+    static bool isPrefetchPending (juce::uint32 deadline, juce::uint32 now) noexcept
+    {
+        return deadline != 0 && (int) (deadline + 1000 - now) > 0;
+    }
+
+    static bool isEarlierDeadline (juce::uint32 deadline, juce::uint32 other) noexcept
+    {
+        return (int) (deadline - other) < 0;
+    }
+
     void touchAllReaders (juce::Range<juce::int64> range) const
     {
         for (auto* r : readers)
@@ -156,6 +197,18 @@ public:
                         for (int i = start; i <= end; ++i)
                             blocksNeeded.addIfNotAlreadyThere (i);
                     }
+
+                    const auto now = juce::Time::getApproximateMillisecondCounter();
+
+                    for (auto& p : r->prefetchPoints)
+                    {
+                        juce::int64 position;
+                        juce::uint32 deadline;
+                        p.get (position, deadline);
+
+                        if (isPrefetchPending (deadline, now))
+                            blocksNeeded.addIfNotAlreadyThere (juce::jlimit (0, lastPossibleBlockIndex, (int) (position / blockSize)));
+                    }
                 }
             }
         }
@@ -690,16 +743,33 @@ bool AudioFileCache::serviceNextReader()
 void AudioFileCache::touchReaders()
 {
     juce::int64 totalBytes = 0;
+    prefetchRequests.clearQuick();
 
     const juce::ScopedReadLock sl (fileListLock);
+    const auto now = juce::Time::getApproximateMillisecondCounter();
 
+    // The current read positions are needed right now, so do all of those first..
     for (auto f : activeFiles)
     {
         f->touchFiles();
+        f->addPrefetchRequests (prefetchRequests, now);
         totalBytes += f->totalBytesInUse;
     }
 
     totalBytesUsed = totalBytes;
+
+    // ..then the places the playhead is heading to, across all the files, soonest first
+    std::sort (prefetchRequests.begin(), prefetchRequests.end(),
+               [] (const PrefetchRequest& a, const PrefetchRequest& b)
+               {
+                   return CachedFile::isEarlierDeadline (a.deadline, b.deadline);
+               });
+
+    for (auto& r : prefetchRequests)
+        r.file->touchRange ({ r.position, r.position + 4096 });
+
+    for (auto& r : prefetchRequests)
+        r.file->touchRange ({ r.position + 4096, r.position + CachedFile::readAheadSamples });
 }
 
 bool AudioFileCache::hasCacheMissed (bool clearMissedFlag)
@@ -727,10 +797,10 @@ AudioFileCache::Reader::Ptr AudioFileCache::createReader (const AudioFile& file)
 
     if (auto reader = AudioFileUtils::createReaderFor (engine, file.getFile()))
     {
-        backgroundReaderThread.startThread (4);
+        if (decodedBlockCache == nullptr)
+            decodedBlockCache.reset (new DecodedBlockCache (juce::jlimit (1, 4, juce::SystemStats::getNumCpus() / 2), 32));
 
-        return new Reader (*this, nullptr, new juce::BufferingAudioReader (reader, backgroundReaderThread,
-                                                                           48000 * 5));
+        return new Reader (*this, nullptr, new StreamingAudioReader (reader, *decodedBlockCache, file.getHash()));
     }
 
     return {};
@@ -747,7 +817,7 @@ void AudioFileCache::purgeOrphanReaders()
 }
 
 //==============================================================================
-AudioFileCache::Reader::Reader (AudioFileCache& c, void* f, juce::BufferingAudioReader* fallback)
+AudioFileCache::Reader::Reader (AudioFileCache& c, void* f, StreamingAudioReader* fallback)
     : cache (c), file (f), fallbackReader (fallback)
 {
     jassert (file != nullptr || fallbackReader != nullptr);
@@ -757,17 +827,67 @@ AudioFileCache::Reader::~Reader()
 {
 }
 
-void AudioFileCache::Reader::setReadPosition (juce::int64 pos) noexcept
+juce::int64 AudioFileCache::Reader::getLoopedPosition (juce::int64 pos) const noexcept
 {
     const auto localLoopStart = loopStart.load();
     const auto localLoopLength = loopLength.load();
 
-    if (loopLength == 0)
-        readPos = pos;
-    else if (pos >= 0)
-        readPos = localLoopStart + (pos % localLoopLength);
-    else
-        readPos = localLoopStart + juce::negativeAwareModulo (pos, localLoopLength);
+    if (localLoopLength == 0)
+        return pos;
+
+    if (pos >= 0)
+        return localLoopStart + (pos % localLoopLength);
+
+    return localLoopStart + juce::negativeAwareModulo (pos, localLoopLength);
+}
+
+void AudioFileCache::Reader::setReadPosition (juce::int64 pos) noexcept
+{
+    readPos = getLoopedPosition (pos);
+}
+
+void AudioFileCache::Reader::prefetch (juce::int64 position, double secondsUntilNeeded) noexcept
+{
+    if (file == nullptr)
+    {
+        fallbackReader->prefetch (getLoopedPosition (position), secondsUntilNeeded);
+        return;
+    }
+
+    const auto now = juce::Time::getApproximateMillisecondCounter();
+    const auto deadline = std::max ((juce::uint32) 1, now + (juce::uint32) juce::roundToInt (juce::jmax (0.0, secondsUntilNeeded) * 1000.0));
+    position = getLoopedPosition (position);
+
+    PrefetchPoint* slot = nullptr;
+
+    // Re-use the slot for the same position, or an expired one, otherwise replace
+    // the one that's needed last if this is needed sooner
+    for (auto& p : prefetchPoints)
+    {
+        if (! CachedFile::isPrefetchPending (p.getDeadline(), now))
+        {
+            if (slot == nullptr)
+                slot = &p;
+        }
+        else if (p.getPosition() == position)
+        {
+            slot = &p;
+            break;
+        }
+    }
+
+    if (slot == nullptr)
+    {
+        for (auto& p : prefetchPoints)
+            if (CachedFile::isEarlierDeadline (deadline, p.getDeadline())
+                 && (slot == nullptr || CachedFile::isEarlierDeadline (slot->getDeadline(), p.getDeadline())))
+                slot = &p;
+
+        if (slot == nullptr)
+            return;
+    }
+
+    slot->set (position, deadline);
 }
 
 int AudioFileCache::Reader::getNumChannels() const noexcept
@@ -962,8 +1082,6 @@ bool AudioFileCache::Reader::readSamples (int** destSamples, int numDestChannels
             startOffsetInDestBuffer += numToRead;
             numSamples -= numToRead;
         }
-
-        return allOk;
     }
     else
     {
@@ -1037,4 +1155,153 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CacheAudioFormatReader)
 };
 
+//==============================================================================
+#if TRACKTION_UNIT_TESTS
+
+class AudioFileCacheTests  : public juce::UnitTest
+{
+public:
+    AudioFileCacheTests() : juce::UnitTest ("AudioFileCache", "Tracktion:Longer") {}
+
+    void runTest() override
+    {
+        const double sampleRate = 44100.0;
+
+        // A wav is memory-mapped, so on 64-bit builds the whole file is always mapped and
+        // a prefetch only touches its pages. An ogg can't be mapped, so it's read through
+        // a StreamingAudioReader, which won't decode a jump target without a prefetch.
+        {
+            auto wavFile = createNoiseFile<juce::WavAudioFormat> (sampleRate, 20);
+            testPrefetching ("wav", wavFile->getFile(), sampleRate, false);
+        }
+
+        {
+            auto oggFile = createNoiseFile<juce::OggVorbisAudioFormat> (sampleRate, 20);
+            testPrefetching ("ogg", oggFile->getFile(), sampleRate, true);
+        }
+    }
+
+    void testPrefetching (const juce::String& formatName, const juce::File& file, double sampleRate, bool isStreamed)
+    {
+        auto& engine = *Engine::getEngines()[0];
+        auto& cache = engine.getAudioFileManager().cache;
+        const int blockSize = 512;
+
+        AudioFile af (engine, file);
+        auto reader = cache.createReader (af);
+        expect (reader != nullptr);
+
+        if (reader == nullptr)
+            return;
+
+        juce::AudioBuffer<float> buffer (1, blockSize);
+
+        // Give the cache as long as it needs to open the file, then every read should be ready in time
+        reader->setReadPosition (0);
+        expect (reader->readSamples ((int**) buffer.getArrayOfWritePointers(), 1, 0, blockSize, 5000));
+        cache.hasCacheMissed (true);
+
+        auto samplesAt = [sampleRate] (double seconds) { return (juce::int64) (seconds * sampleRate); };
+
+        if (isStreamed)
+        {
+            beginTest ("Jumping without a prefetch (" + formatName + ")");
+            {
+                // Nothing has asked for this far past the read-ahead, so it can't be ready yet.
+                // It's after the points the other tests jump to, so its read-ahead won't cover them.
+                reader->setReadPosition (samplesAt (1.0));
+                reader->readSamples ((int**) buffer.getArrayOfWritePointers(), 1, 0, blockSize, 0);
+                expect (! readAt (*reader, buffer, samplesAt (18.0)));
+                cache.hasCacheMissed (true);
+            }
+        }
+
+        beginTest ("Prefetching a clip start (" + formatName + ")");
+        {
+            playTowards (*reader, buffer, samplesAt (1.0), samplesAt (15.0));
+            expect (readAt (*reader, buffer, samplesAt (15.0)));
+            expect (! cache.hasCacheMissed (true));
+        }
+
+        beginTest ("Prefetching a loop wrap (" + formatName + ")");
+        {
+            playTowards (*reader, buffer, samplesAt (17.0), samplesAt (5.0));
+            expect (readAt (*reader, buffer, samplesAt (5.0)));
+            expect (! cache.hasCacheMissed (true));
+        }
+
+        beginTest ("Reading a looped range (" + formatName + ")");
+        {
+            reader->setLoopRange ({ samplesAt (8.0), samplesAt (9.0) });
+            reader->setReadPosition (samplesAt (8.0));
+
+            // Plays through the loop end twice, giving the cache time to follow
+            bool allRead = true;
+
+            for (int i = 0; i < (int) (2.5 * sampleRate) / blockSize; ++i)
+            {
+                allRead = reader->readSamples ((int**) buffer.getArrayOfWritePointers(), 1, 0, blockSize, 0) && allRead;
+                juce::Thread::sleep (2);
+            }
+
+            expect (allRead);
+            expect (! cache.hasCacheMissed (true));
+            reader->setLoopRange ({});
+        }
+    }
+
+private:
+    /** Reads blocks from a position for about a second, as a node would whilst the
+        playhead approaches the point it'll jump to, asking for that point to be prefetched.
+    */
+    static void playTowards (AudioFileCache::Reader& reader, juce::AudioBuffer<float>& buffer,
+                             juce::int64 playPosition, juce::int64 jumpPosition)
+    {
+        const int numBlocks = 100;
+
+        reader.setReadPosition (playPosition);
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            reader.prefetch (jumpPosition, (numBlocks - i) * 0.01);
+            reader.readSamples ((int**) buffer.getArrayOfWritePointers(), 1, 0, buffer.getNumSamples(), 0);
+            juce::Thread::sleep (10);
+        }
+    }
+
+    static bool readAt (AudioFileCache::Reader& reader, juce::AudioBuffer<float>& buffer, juce::int64 position)
+    {
+        reader.setReadPosition (position);
+        return reader.readSamples ((int**) buffer.getArrayOfWritePointers(), 1, 0, buffer.getNumSamples(), 0);
+    }
+
+    template<typename AudioFormatType>
+    static std::unique_ptr<juce::TemporaryFile> createNoiseFile (double sampleRate, int numSeconds)
+    {
+        juce::AudioBuffer<float> buffer (1, (int) sampleRate * numSeconds);
+        juce::Random r;
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            buffer.setSample (0, i, r.nextFloat() * 0.5f - 0.25f);
+
+        AudioFormatType format;
+        auto f = std::make_unique<juce::TemporaryFile> (format.getFileExtensions()[0]);
+
+        if (auto fileStream = f->getFile().createOutputStream())
+        {
+            if (auto writer = std::unique_ptr<juce::AudioFormatWriter> (format.createWriterFor (fileStream.get(), sampleRate, 1, 16, {}, 0)))
+            {
+                fileStream.release();
+                writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+            }
+        }
+
+        return f;
+    }
+};
+
+static AudioFileCacheTests audioFileCacheTests;
+
+#endif
+
 }
@@ -51,6 +51,14 @@ public:
 
         void setLoopRange (juce::Range<juce::int64> newRange);
 
+        /** Tells the cache that this reader will be reading from a position soon, e.g.
+            because the playhead is approaching the start of a clip or is about to loop back.
+            The cache will try to load that part of the file before it's needed, dealing
+            with the positions that are needed soonest first.
+            Only the few most urgent positions are kept. This is safe to call from the audio thread.
+        */
+        void prefetch (juce::int64 position, double secondsUntilNeeded) noexcept;
+
         int getNumChannels() const noexcept;
         double getSampleRate() const noexcept;
 
@@ -60,9 +68,14 @@ public:
         AudioFileCache& cache;
         void* file;
         std::atomic<juce::int64> readPos { 0 }, loopStart { 0 }, loopLength { 0 };
-        std::unique_ptr<juce::BufferingAudioReader> fallbackReader;
+        std::unique_ptr<StreamingAudioReader> fallbackReader;
+
+        static constexpr int maxNumPrefetchPoints = 4;
+        PrefetchPoint prefetchPoints[maxNumPrefetchPoints];
 
-        Reader (AudioFileCache&, void*, juce::BufferingAudioReader* fallback);
+        Reader (AudioFileCache&, void*, StreamingAudioReader* fallback);
+
+        juce::int64 getLoopedPosition (juce::int64 pos) const noexcept;
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Reader)
     };
@@ -92,6 +105,15 @@ private:
     int nextFileToService = 0;
     juce::ReadWriteLock fileListLock;
 
+    struct PrefetchRequest
+    {
+        CachedFile* file;
+        juce::int64 position;
+        juce::uint32 deadline;
+    };
+
+    juce::Array<PrefetchRequest> prefetchRequests;
+
     CachedFile* getOrCreateCachedFile (const AudioFile&);
     bool serviceNextReader();
     void touchReaders();
@@ -101,7 +123,8 @@ private:
     class RefresherThread;
     std::unique_ptr<RefresherThread> refresherThread;
 
-    juce::TimeSliceThread backgroundReaderThread { "Preview Buffer" };
+    // Decodes the files that can't be memory-mapped
+    std::unique_ptr<DecodedBlockCache> decodedBlockCache;
 
     void stopThreads();
 
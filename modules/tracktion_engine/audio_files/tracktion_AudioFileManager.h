@@ -34,16 +34,27 @@ public:
 
     juce::AudioThumbnailCache& getAudioThumbnailCache()     { return *thumbnailCache; }
 
+    /** Writes the info of the files that have been parsed to the temp directory so their
+        headers don't need to be read again next session. This is called on destruction.
+    */
+    void saveInfoCache();
+
     Engine& engine;
     AudioProxyGenerator proxyGenerator;
     AudioFileCache cache;
 
+    /** The on-disk cache behind saveInfoCache(). */
+    struct PersistentInfoCache;
+
 private:
     struct KnownFile;
     juce::HashMap<juce::int64, KnownFile*> knownFiles;
     juce::CriticalSection knownFilesLock;
 
+    std::unique_ptr<PersistentInfoCache> infoCache;
+
     KnownFile& findOrCreateKnown (const AudioFile&);
+    AudioFileInfo parseInfo (const AudioFile&);
     void removeFile (juce::int64 hash);
     void clearFiles();
 
@@ -51,6 +62,7 @@ private:
 
     void handleAsyncUpdate();
     bool checkFileTime (KnownFile&);
+    bool checkFileTime (KnownFile&, juce::Time currentModificationTime);
     void callListeners (const AudioFile&);
 
     friend class SmartThumbnail;
@@ -0,0 +1,660 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+namespace StreamingAudioReaderHelpers
+{
+    /** How much time's worth of audio to decode ahead of the read position. */
+    static constexpr double readAheadSeconds = 3.0;
+
+    /** The fastest rate, as a multiple of the sample rate, that's believed when working
+        out how fast a reader is being read. Anything quicker is treated as a jump.
+    */
+    static constexpr double maxSpeedRatio = 8.0;
+
+    static juce::int64 getBlockStart (juce::int64 position) noexcept
+    {
+        return position - (position % DecodedBlockCache::blockSize);
+    }
+
+    /** A prefetch point is kept for a second after its deadline, by which time the
+        reader will either be reading from there or won't need it any more.
+    */
+    static bool isPrefetchPending (juce::uint32 deadline, juce::uint32 now) noexcept
+    {
+        return deadline != 0 && (int) (deadline + 1000 - now) > 0;
+    }
+}
+
+//==============================================================================
+void PrefetchPoint::set (juce::int64 newPosition, juce::uint32 newDeadline) noexcept
+{
+    const auto seq = sequence.load (std::memory_order_relaxed);
+    sequence.store (seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    position.store (newPosition, std::memory_order_relaxed);
+    deadline.store (newDeadline, std::memory_order_relaxed);
+
+    sequence.store (seq + 2, std::memory_order_release);
+}
+
+void PrefetchPoint::get (juce::int64& positionResult, juce::uint32& deadlineResult) const noexcept
+{
+    for (;;)
+    {
+        const auto seq = sequence.load (std::memory_order_acquire);
+
+        if ((seq & 1) == 0)
+        {
+            positionResult = position.load (std::memory_order_relaxed);
+            deadlineResult = deadline.load (std::memory_order_relaxed);
+            std::atomic_thread_fence (std::memory_order_acquire);
+
+            if (sequence.load (std::memory_order_relaxed) == seq)
+                return;
+        }
+
+        // The audio thread is part way through a write, which is only a few instructions
+        juce::Thread::yield();
+    }
+}
+
+//==============================================================================
+struct DecodedBlockCache::Block
+{
+    juce::int64 start = 0;
+    int numSamples = 0;
+    juce::AudioBuffer<float> buffer;
+    std::atomic<juce::uint32> lastUsedTime { 0 };
+};
+
+//==============================================================================
+/** The blocks decoded from one file, which are shared by all the readers of it. */
+struct DecodedBlockCache::DecodedFile
+{
+    DecodedFile (juce::int64 h) : hash (h)
+    {
+        blocks.reserve (32);
+    }
+
+    Block* findBlockContaining (juce::int64 position) const noexcept
+    {
+        for (auto& b : blocks)
+            if (position >= b->start && position < b->start + b->numSamples)
+                return b.get();
+
+        return {};
+    }
+
+    std::unique_ptr<Block> removeBlock (Block* block)
+    {
+        const juce::ScopedLock sl (blockLock);
+
+        for (auto i = blocks.begin(); i != blocks.end(); ++i)
+        {
+            if (i->get() == block)
+            {
+                auto b = std::move (*i);
+                blocks.erase (i);
+                return b;
+            }
+        }
+
+        jassertfalse;
+        return {};
+    }
+
+    const juce::int64 hash;
+
+    // These are protected by the cache's readerListLock
+    juce::Array<StreamingAudioReader*> readers;
+    int numUsers = 0;
+    bool isBeingDecoded = false;
+
+    juce::CriticalSection blockLock;
+    std::vector<std::unique_ptr<Block>> blocks;
+};
+
+//==============================================================================
+class DecodedBlockCache::DecoderThread   : public juce::Thread
+{
+public:
+    DecoderThread (DecodedBlockCache& c)
+        : juce::Thread ("Audio Decoder"), owner (c)
+    {
+    }
+
+    ~DecoderThread() override
+    {
+        stopThread (15000);
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+            if (! owner.decodeNextBlock())
+                wait (10);
+    }
+
+    DecodedBlockCache& owner;
+};
+
+//==============================================================================
+DecodedBlockCache::DecodedBlockCache (int numThreads, int minBlocks)
+    : minNumBlocks (minBlocks)
+{
+    jassert (numThreads > 0 && minNumBlocks > 0);
+
+    for (int i = 0; i < numThreads; ++i)
+        threads.add (new DecoderThread (*this))->startThread (4);
+}
+
+DecodedBlockCache::~DecodedBlockCache()
+{
+    // The readers must all be deleted before the cache they use
+    jassert (readers.isEmpty() && files.isEmpty());
+
+    for (auto t : threads)
+        t->signalThreadShouldExit();
+
+    threads.clear();
+}
+
+DecodedBlockCache::DecodedFile& DecodedBlockCache::getOrCreateFile (juce::int64 fileHash)
+{
+    const juce::ScopedLock sl (readerListLock);
+    DecodedFile* file = nullptr;
+
+    // A hash of 0 means the reader can't be identified so gets its own blocks
+    if (fileHash != 0)
+        for (auto f : files)
+            if (f->hash == fileHash)
+                file = f;
+
+    if (file == nullptr)
+        file = files.add (new DecodedFile (fileHash));
+
+    ++file->numUsers;
+    return *file;
+}
+
+void DecodedBlockCache::addReader (StreamingAudioReader* r)
+{
+    const juce::ScopedLock sl (readerListLock);
+    readers.add (r);
+    r->file.readers.add (r);
+    ++numReaders;
+}
+
+void DecodedBlockCache::removeReader (StreamingAudioReader* r)
+{
+    {
+        const juce::ScopedLock sl (readerListLock);
+        readers.removeFirstMatchingValue (r);
+        r->file.readers.removeFirstMatchingValue (r);
+        --numReaders;
+    }
+
+    // Once it's out of the list nothing new will start, but a thread may still be decoding for it
+    while (r->isBeingDecoded)
+        juce::Thread::sleep (1);
+
+    const juce::ScopedLock sl (readerListLock);
+
+    if (--r->file.numUsers == 0)
+    {
+        numBlocks -= (int) r->file.blocks.size();
+        files.removeObject (&r->file);
+    }
+}
+
+bool DecodedBlockCache::decodeNextBlock()
+{
+    StreamingAudioReader* reader = nullptr;
+    juce::int64 blockStart = 0;
+    auto mostUrgent = std::numeric_limits<double>::max();
+
+    {
+        const juce::ScopedLock sl (readerListLock);
+
+        for (auto r : readers)
+        {
+            juce::int64 start;
+            double secondsUntilNeeded;
+
+            // Only one thread decodes a file at a time so two readers of it can't decode the same block
+            if (! r->file.isBeingDecoded
+                 && r->getNextBlockToDecode (start, secondsUntilNeeded)
+                 && secondsUntilNeeded < mostUrgent)
+            {
+                reader = r;
+                blockStart = start;
+                mostUrgent = secondsUntilNeeded;
+            }
+        }
+
+        if (reader == nullptr)
+            return false;
+
+        reader->isBeingDecoded = true;
+        reader->file.isBeingDecoded = true;
+    }
+
+    auto block = getFreeBlock ((int) reader->numChannels, mostUrgent);
+    const bool gotBlock = block != nullptr;
+
+    if (gotBlock)
+        reader->decodeBlock (std::move (block), blockStart);
+
+    {
+        const juce::ScopedLock sl (readerListLock);
+        reader->file.isBeingDecoded = false;
+    }
+
+    reader->isBeingDecoded = false;
+    return gotBlock;
+}
+
+std::unique_ptr<DecodedBlockCache::Block> DecodedBlockCache::getFreeBlock (int numChannels, double secondsUntilNeeded)
+{
+    std::unique_ptr<Block> block;
+
+    if (++numBlocks <= getMaxNumBlocks())
+    {
+        block.reset (new Block());
+    }
+    else
+    {
+        --numBlocks;
+
+        // Re-use the block that's needed furthest in the future by any reader of its file,
+        // and of those that aren't needed at all, the one read least recently.
+        // Holding the list lock stops any other thread taking the same one.
+        const juce::ScopedLock sl (readerListLock);
+        const auto now = juce::Time::getApproximateMillisecondCounter();
+        DecodedFile* owner = nullptr;
+        Block* victim = nullptr;
+        auto victimSecondsUntilNeeded = 0.0;
+
+        for (auto f : files)
+        {
+            const juce::ScopedLock bl (f->blockLock);
+
+            for (auto& b : f->blocks)
+            {
+                auto seconds = std::numeric_limits<double>::max();
+
+                for (auto r : f->readers)
+                    seconds = std::min (seconds, r->getSecondsUntilNeeded (*b, now));
+
+                if (victim == nullptr || seconds > victimSecondsUntilNeeded
+                     || (seconds == victimSecondsUntilNeeded && (int) (b->lastUsedTime - victim->lastUsedTime) < 0))
+                {
+                    victim = b.get();
+                    owner = f;
+                    victimSecondsUntilNeeded = seconds;
+                }
+            }
+        }
+
+        // Replacing a block that's needed sooner than the new one would just mean decoding it again
+        if (victim == nullptr || victimSecondsUntilNeeded <= secondsUntilNeeded)
+            return {};
+
+        block = owner->removeBlock (victim);
+    }
+
+    block->buffer.setSize (numChannels, blockSize, false, false, true);
+    return block;
+}
+
+//==============================================================================
+StreamingAudioReader::StreamingAudioReader (juce::AudioFormatReader* sourceReader, DecodedBlockCache& c, juce::int64 fileHash)
+    : juce::AudioFormatReader (nullptr, sourceReader->getFormatName()),
+      cache (c), source (sourceReader), file (c.getOrCreateFile (fileHash))
+{
+    sampleRate            = source->sampleRate;
+    lengthInSamples       = source->lengthInSamples;
+    numChannels           = source->numChannels;
+    metadataValues        = source->metadataValues;
+    bitsPerSample         = 32;
+    usesFloatingPointData = true;
+
+    playbackRate = sampleRate;
+    cache.addReader (this);
+}
+
+StreamingAudioReader::~StreamingAudioReader()
+{
+    cache.removeReader (this);
+}
+
+void StreamingAudioReader::setReadTimeout (int timeoutMs) noexcept
+{
+    timeout = timeoutMs;
+}
+
+void StreamingAudioReader::prefetch (juce::int64 position, double secondsUntilNeeded) noexcept
+{
+    const auto now = juce::Time::getApproximateMillisecondCounter();
+
+    prefetchPoint.set (position, std::max ((juce::uint32) 1, now + (juce::uint32) juce::roundToInt (juce::jmax (0.0, secondsUntilNeeded) * 1000.0)));
+}
+
+bool StreamingAudioReader::readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                                        juce::int64 startSampleInFile, int numSamples)
+{
+    const auto startTime = juce::Time::getMillisecondCounter();
+
+    clearSamplesBeyondAvailableLength (destSamples, numDestChannels, startOffsetInDestBuffer,
+                                       startSampleInFile, numSamples, lengthInSamples);
+
+    nextReadPosition = startSampleInFile;
+    updatePlaybackRate (startSampleInFile, startTime);
+
+    bool allSamplesRead = true;
+    const juce::ScopedLock sl (file.blockLock);
+
+    while (numSamples > 0)
+    {
+        if (auto block = file.findBlockContaining (startSampleInFile))
+        {
+            block->lastUsedTime = startTime;
+
+            auto offset = (int) (startSampleInFile - block->start);
+            auto numToDo = std::min (numSamples, block->numSamples - offset);
+
+            for (int j = 0; j < numDestChannels; ++j)
+            {
+                if (auto dest = (float*) destSamples[j])
+                {
+                    dest += startOffsetInDestBuffer;
+
+                    if (j < (int) numChannels)
+                        juce::FloatVectorOperations::copy (dest, block->buffer.getReadPointer (j, offset), numToDo);
+                    else
+                        juce::FloatVectorOperations::clear (dest, numToDo);
+                }
+            }
+
+            startOffsetInDestBuffer += numToDo;
+            startSampleInFile += numToDo;
+            numSamples -= numToDo;
+        }
+        else
+        {
+            const auto timeoutMs = timeout.load();
+
+            if (timeoutMs >= 0 && juce::Time::getMillisecondCounter() >= startTime + (juce::uint32) timeoutMs)
+            {
+                for (int j = 0; j < numDestChannels; ++j)
+                    if (auto dest = (float*) destSamples[j])
+                        juce::FloatVectorOperations::clear (dest + startOffsetInDestBuffer, numSamples);
+
+                allSamplesRead = false;
+                break;
+            }
+
+            // Make sure the block that's missing is the next one to be decoded
+            nextReadPosition = startSampleInFile;
+
+            const juce::ScopedUnlock ul (file.blockLock);
+            juce::Thread::yield();
+        }
+    }
+
+    return allSamplesRead;
+}
+
+juce::int64 StreamingAudioReader::getReadAheadSamples() const noexcept
+{
+    using namespace StreamingAudioReaderHelpers;
+
+    return juce::jlimit ((juce::int64) DecodedBlockCache::blockSize,
+                         (juce::int64) DecodedBlockCache::blockSize * 16,
+                         (juce::int64) (playbackRate.load() * readAheadSeconds));
+}
+
+double StreamingAudioReader::getSecondsUntilNeeded (const Block& block, juce::uint32 now) const noexcept
+{
+    const auto readPos = nextReadPosition.load();
+
+    if (block.start + block.numSamples > readPos && block.start < readPos + getReadAheadSamples())
+        return std::max ((juce::int64) 0, block.start - readPos) / juce::jmax (1.0, playbackRate.load());
+
+    juce::int64 prefetchPos;
+    juce::uint32 deadline;
+    prefetchPoint.get (prefetchPos, deadline);
+
+    if (StreamingAudioReaderHelpers::isPrefetchPending (deadline, now)
+         && prefetchPos >= block.start && prefetchPos < block.start + block.numSamples)
+        return juce::jmax (0, (int) (deadline - now)) / 1000.0;
+
+    return std::numeric_limits<double>::max();
+}
+
+bool StreamingAudioReader::getNextBlockToDecode (juce::int64& blockStart, double& secondsUntilNeeded) const
+{
+    using namespace StreamingAudioReaderHelpers;
+
+    const auto rate = juce::jmax (1.0, playbackRate.load());
+    const auto readPos = juce::jlimit ((juce::int64) 0, lengthInSamples, nextReadPosition.load());
+    const auto readAheadEnd = std::min (lengthInSamples, readPos + getReadAheadSamples());
+    bool found = false;
+
+    const juce::ScopedLock sl (file.blockLock);
+
+    for (auto pos = getBlockStart (readPos); pos < readAheadEnd; pos += DecodedBlockCache::blockSize)
+    {
+        if (file.findBlockContaining (pos) == nullptr)
+        {
+            blockStart = pos;
+            secondsUntilNeeded = std::max ((juce::int64) 0, pos - readPos) / rate;
+            found = true;
+            break;
+        }
+    }
+
+    const auto now = juce::Time::getApproximateMillisecondCounter();
+    juce::int64 prefetchPos;
+    juce::uint32 deadline;
+    prefetchPoint.get (prefetchPos, deadline);
+
+    if (isPrefetchPending (deadline, now))
+    {
+        const auto pos = getBlockStart (juce::jmax ((juce::int64) 0, prefetchPos));
+        const auto secondsUntilDeadline = juce::jmax (0, (int) (deadline - now)) / 1000.0;
+
+        if (pos < lengthInSamples && file.findBlockContaining (pos) == nullptr
+             && (! found || secondsUntilDeadline < secondsUntilNeeded))
+        {
+            blockStart = pos;
+            secondsUntilNeeded = secondsUntilDeadline;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+void StreamingAudioReader::decodeBlock (std::unique_ptr<Block> block, juce::int64 blockStart)
+{
+    // Only one thread decodes for a file at a time, so the source can be read without a lock
+    block->start = blockStart;
+    block->numSamples = (int) std::min ((juce::int64) DecodedBlockCache::blockSize, lengthInSamples - blockStart);
+    block->lastUsedTime = juce::Time::getMillisecondCounter();
+    source->read (&block->buffer, 0, block->numSamples, blockStart, true, true);
+
+    const juce::ScopedLock sl (file.blockLock);
+    file.blocks.push_back (std::move (block));
+}
+
+void StreamingAudioReader::updatePlaybackRate (juce::int64 position, juce::uint32 now) noexcept
+{
+    const auto elapsedMs = (int) (now - rateWindowStartTime);
+
+    if (elapsedMs < 250)
+        return;
+
+    const auto distance = position - rateWindowStartPosition;
+
+    // Jumps and pauses don't say anything about the rate it's playing at, so they just start a new measurement
+    if (distance > 0 && elapsedMs < 1000
+         && distance < sampleRate * StreamingAudioReaderHelpers::maxSpeedRatio * elapsedMs / 1000.0)
+        playbackRate = distance * 1000.0 / elapsedMs;
+
+    rateWindowStartPosition = position;
+    rateWindowStartTime = now;
+}
+
+//==============================================================================
+#if TRACKTION_UNIT_TESTS
+
+class StreamingAudioReaderTests   : public juce::UnitTest
+{
+public:
+    StreamingAudioReaderTests()
+        : juce::UnitTest ("StreamingAudioReader", "Tracktion") {}
+
+    //==============================================================================
+    void runTest() override
+    {
+        const int numSamples = DecodedBlockCache::blockSize * 10 + 123;
+        auto wavData = createRampWav (numSamples);
+
+        DecodedBlockCache cache (2, 6);
+        juce::WavAudioFormat wavFormat;
+
+        StreamingAudioReader reader (wavFormat.createReaderFor (new juce::MemoryInputStream (wavData, false), true), cache);
+        reader.setReadTimeout (-1);
+        expectEquals (reader.lengthInSamples, (juce::int64) numSamples);
+
+        beginTest ("Sequential reads");
+        {
+            expect (readMatchesRamp (reader, 0, numSamples, 1000));
+            expect (cache.getNumBlocksInUse() <= 6);
+        }
+
+        beginTest ("Reads after the start has been evicted");
+        {
+            expect (readMatchesRamp (reader, 100, DecodedBlockCache::blockSize * 2, 777));
+            expect (readMatchesRamp (reader, numSamples - 5000, numSamples, 512));
+        }
+
+        beginTest ("Reads past the end");
+        {
+            juce::AudioBuffer<float> buffer (1, 100);
+            reader.read (&buffer, 0, 100, numSamples - 50, true, true);
+            expectEquals (buffer.getSample (0, 49), getRampSample (numSamples - 1));
+            expectEquals (buffer.getMagnitude (50, 50), 0.0f);
+        }
+
+        beginTest ("Readers of the same file share blocks");
+        {
+            DecodedBlockCache sharedCache (1, 6);
+            const juce::int64 fileHash = 1234;
+
+            StreamingAudioReader reader1 (wavFormat.createReaderFor (new juce::MemoryInputStream (wavData, false), true), sharedCache, fileHash);
+            StreamingAudioReader reader2 (wavFormat.createReaderFor (new juce::MemoryInputStream (wavData, false), true), sharedCache, fileHash);
+            reader1.setReadTimeout (-1);
+
+            expect (readMatchesRamp (reader1, 0, DecodedBlockCache::blockSize * 2, 1000));
+
+            // The second reader mustn't have to wait for anything to be decoded
+            reader2.setReadTimeout (0);
+            expect (readMatchesRamp (reader2, 0, DecodedBlockCache::blockSize * 2, 1000));
+        }
+
+        beginTest ("More readers than the minimum number of blocks");
+        {
+            // Each reader holds on to its read-ahead, so with a fixed pool this many
+            // readers would leave none of them a block to decode in to
+            const int numReaders = 8;
+            DecodedBlockCache smallCache (2, 4);
+            juce::OwnedArray<StreamingAudioReader> readers;
+
+            for (int i = 0; i < numReaders; ++i)
+            {
+                readers.add (new StreamingAudioReader (wavFormat.createReaderFor (new juce::MemoryInputStream (wavData, false), true), smallCache));
+                readers.getLast()->setReadTimeout (5000);
+            }
+
+            expectEquals (smallCache.getMaxNumBlocks(), numReaders * DecodedBlockCache::blocksPerReader);
+
+            // The readers play through the file together, each from a different start
+            const int chunkSize = 4096;
+            bool allMatched = true;
+
+            for (int pos = 0; pos < numSamples; pos += chunkSize)
+            {
+                for (int i = 0; i < numReaders; ++i)
+                {
+                    auto start = (pos + i * DecodedBlockCache::blockSize) % numSamples;
+                    allMatched = readMatchesRamp (*readers.getUnchecked (i), start, std::min (numSamples, start + chunkSize), chunkSize) && allMatched;
+                }
+            }
+
+            expect (allMatched);
+            expect (smallCache.getNumBlocksInUse() <= smallCache.getMaxNumBlocks());
+        }
+    }
+
+private:
+    static float getRampSample (int i)
+    {
+        return (i % 1000) / 1000.0f;
+    }
+
+    static juce::MemoryBlock createRampWav (int numSamples)
+    {
+        juce::AudioBuffer<float> buffer (1, numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+            buffer.setSample (0, i, getRampSample (i));
+
+        juce::MemoryBlock data;
+
+        {
+            juce::WavAudioFormat wavFormat;
+            std::unique_ptr<juce::AudioFormatWriter> writer (wavFormat.createWriterFor (new juce::MemoryOutputStream (data, false),
+                                                                                        44100.0, 1, 32, {}, 0));
+            writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+        }
+
+        return data;
+    }
+
+    static bool readMatchesRamp (juce::AudioFormatReader& reader, int start, int end, int blockSize)
+    {
+        juce::AudioBuffer<float> buffer (1, blockSize);
+
+        for (int pos = start; pos < end; pos += blockSize)
+        {
+            auto numToRead = std::min (blockSize, end - pos);
+
+            reader.read (&buffer, 0, numToRead, pos, true, true);
+
+            for (int i = 0; i < numToRead; ++i)
+                if (buffer.getSample (0, i) != getRampSample (pos + i))
+                    return false;
+        }
+
+        return true;
+    }
+};
+
+static StreamingAudioReaderTests streamingAudioReaderTests;
+
+#endif // TRACKTION_UNIT_TESTS
+
+} // namespace tracktion_engine
@@ -0,0 +1,158 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+class StreamingAudioReader;
+
+//==============================================================================
+/**
+    A position and deadline for a prefetch, which are published together with a
+    sequence count so the threads reading them never see the position of one request
+    with the deadline of another. Only the audio thread calling prefetch() writes these.
+*/
+struct PrefetchPoint
+{
+    void set (juce::int64 newPosition, juce::uint32 newDeadline) noexcept;
+    void get (juce::int64& positionResult, juce::uint32& deadlineResult) const noexcept;
+
+    // These can be read without the sequence count by the thread that writes them
+    juce::int64 getPosition() const noexcept        { return position.load (std::memory_order_relaxed); }
+    juce::uint32 getDeadline() const noexcept       { return deadline.load (std::memory_order_relaxed); }
+
+private:
+    std::atomic<juce::uint32> sequence { 0 };   // odd whilst being written
+    std::atomic<juce::int64> position { 0 };
+    std::atomic<juce::uint32> deadline { 0 };   // in ms, or 0 if unused
+};
+
+//==============================================================================
+/**
+    A pool of decoded blocks of audio, and the threads that fill them, shared by a
+    set of StreamingAudioReaders.
+
+    Each thread decodes whichever missing block is needed soonest across all the
+    readers, so several files can be decoded at once and a slow one doesn't hold up
+    the rest. Readers of the same file share its decoded blocks.
+
+    The pool grows by blocksPerReader for each reader, so adding readers doesn't
+    starve the others of blocks. Once it's full, the block that's needed furthest in
+    the future, or not at all, is re-used, but only if it's needed later than the
+    block it would be replaced with.
+*/
+class DecodedBlockCache
+{
+public:
+    /** Creates a cache which will hold at least minNumBlocks blocks. */
+    DecodedBlockCache (int numThreads, int minNumBlocks);
+    ~DecodedBlockCache();
+
+    /** The number of samples in each decoded block. */
+    static constexpr int blockSize = 32768;
+
+    /** The number of blocks the pool grows by for each reader. This is enough for the
+        read-ahead of a file playing at normal speed.
+    */
+    static constexpr int blocksPerReader = 6;
+
+    int getNumBlocksInUse() const noexcept          { return numBlocks.load(); }
+
+    /** Returns the number of blocks the pool can hold with its current readers. */
+    int getMaxNumBlocks() const noexcept            { return std::max (minNumBlocks, numReaders.load() * blocksPerReader); }
+
+private:
+    friend class StreamingAudioReader;
+    struct Block;
+    struct DecodedFile;
+    class DecoderThread;
+
+    const int minNumBlocks;
+    std::atomic<int> numBlocks { 0 }, numReaders { 0 };
+
+    juce::CriticalSection readerListLock;
+    juce::Array<StreamingAudioReader*> readers;
+    juce::OwnedArray<DecodedFile> files;
+    juce::OwnedArray<DecoderThread> threads;
+
+    DecodedFile& getOrCreateFile (juce::int64 fileHash);
+    void addReader (StreamingAudioReader*);
+    void removeReader (StreamingAudioReader*);
+
+    bool decodeNextBlock();
+    std::unique_ptr<Block> getFreeBlock (int numChannels, double secondsUntilNeeded);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DecodedBlockCache)
+};
+
+//==============================================================================
+/**
+    An AudioFormatReader which reads another reader in blocks decoded by a
+    DecodedBlockCache. This is used by the AudioFileCache for files which can't be
+    memory-mapped, e.g. compressed formats.
+
+    Blocks are decoded ahead of the position it was last read from. How far ahead
+    follows how quickly that position has been moving, so a file being played faster
+    is read further ahead. If a block hasn't been decoded yet when it's needed,
+    readSamples will wait for it for up to the time given to setReadTimeout().
+*/
+class StreamingAudioReader  : public juce::AudioFormatReader
+{
+public:
+    /** Creates a reader for a source, which this will take ownership of.
+        Readers created with the same non-zero fileHash share their decoded blocks, so
+        it must only be shared by readers of identical audio.
+    */
+    StreamingAudioReader (juce::AudioFormatReader* sourceReader, DecodedBlockCache&, juce::int64 fileHash = 0);
+    ~StreamingAudioReader() override;
+
+    /** Sets how long readSamples will wait for a block to be decoded, or -1 to wait
+        for as long as it takes.
+    */
+    void setReadTimeout (int timeoutMs) noexcept;
+
+    /** Asks for a position to be decoded before it's needed. This is safe to call from the audio thread. */
+    void prefetch (juce::int64 position, double secondsUntilNeeded) noexcept;
+
+    /** Returns the estimated number of samples per second the reader is being read at. */
+    double getPlaybackRate() const noexcept          { return playbackRate.load(); }
+
+    bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                      juce::int64 startSampleInFile, int numSamples) override;
+
+private:
+    friend class DecodedBlockCache;
+    using Block = DecodedBlockCache::Block;
+    using DecodedFile = DecodedBlockCache::DecodedFile;
+
+    DecodedBlockCache& cache;
+    std::unique_ptr<juce::AudioFormatReader> source;
+    DecodedFile& file;
+
+    std::atomic<int> timeout { 0 };
+    std::atomic<bool> isBeingDecoded { false };
+    std::atomic<juce::int64> nextReadPosition { 0 };
+    PrefetchPoint prefetchPoint;
+    std::atomic<double> playbackRate { 0 };
+
+    // Only used by readSamples
+    juce::int64 rateWindowStartPosition = 0;
+    juce::uint32 rateWindowStartTime = 0;
+
+    juce::int64 getReadAheadSamples() const noexcept;
+    double getSecondsUntilNeeded (const Block&, juce::uint32 now) const noexcept;
+    bool getNextBlockToDecode (juce::int64& blockStart, double& secondsUntilNeeded) const;
+    void decodeBlock (std::unique_ptr<Block>, juce::int64 blockStart);
+    void updatePlaybackRate (juce::int64 position, juce::uint32 now) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamingAudioReader)
+};
+
+} // namespace tracktion_engine
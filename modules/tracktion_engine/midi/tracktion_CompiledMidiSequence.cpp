@@ -0,0 +1,383 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+CompiledMidiSequence::Ptr CompiledMidiSequence::create (juce::MidiMessageSequence sequence)
+{
+    CRASH_TRACER
+    sequence.updateMatchedPairs();
+
+    auto numEvents = (size_t) sequence.getNumEvents();
+    std::shared_ptr<CompiledMidiSequence> compiled (new CompiledMidiSequence());
+
+    compiled->times.reserve (numEvents);
+    compiled->messages.reserve (numEvents);
+    compiled->noteOffIndexes.reserve (numEvents);
+
+    std::unordered_map<const juce::MidiMessageSequence::MidiEventHolder*, int> indexes;
+    indexes.reserve (numEvents);
+
+    for (int i = 0; i < (int) numEvents; ++i)
+        indexes[sequence.getEventPointer (i)] = i;
+
+    for (auto meh : sequence)
+    {
+        auto& m = meh->message;
+        Message message = {};
+
+        if (m.getRawDataSize() <= 3)
+        {
+            message.numBytes = (juce::uint8) m.getRawDataSize();
+            std::copy (m.getRawData(), m.getRawData() + m.getRawDataSize(), message.data);
+        }
+        else
+        {
+            auto longIndex = (juce::uint32) compiled->longMessages.size();
+            jassert (longIndex < (1u << 24));
+            message.data[0] = (juce::uint8) (longIndex & 0xff);
+            message.data[1] = (juce::uint8) ((longIndex >> 8) & 0xff);
+            message.data[2] = (juce::uint8) ((longIndex >> 16) & 0xff);
+            compiled->longMessages.push_back (m);
+        }
+
+        int noteOffIndex = -1;
+
+        if (m.isNoteOn())
+        {
+            compiled->noteOnChannels |= (1 << m.getChannel());
+
+            if (meh->noteOffObject != nullptr)
+                noteOffIndex = indexes[meh->noteOffObject];
+        }
+
+        compiled->times.push_back (m.getTimeStamp());
+        compiled->messages.push_back (message);
+        compiled->noteOffIndexes.push_back (noteOffIndex);
+    }
+
+    compiled->buildCheckpoints();
+
+    return compiled;
+}
+
+//==============================================================================
+namespace CompiledMidiSequenceHelpers
+{
+    // The kinds of event kept in a ChannelState, after the 128 controllers
+    enum StateKind
+    {
+        programChangeKind = 128,
+        pitchWheelKind,
+        channelPressureKind,
+        noteOnKind,
+        noteOffKind,
+        numStateKinds
+    };
+
+    static int& getIndexForKind (CompiledMidiSequence::ChannelState& state, int kind) noexcept
+    {
+        switch (kind)
+        {
+            case programChangeKind:     return state.programChange;
+            case pitchWheelKind:        return state.pitchWheel;
+            case channelPressureKind:   return state.channelPressure;
+            case noteOnKind:            return state.noteOn;
+            case noteOffKind:           return state.noteOff;
+            default:                    jassert (kind >= 0 && kind < 128); return state.controllers[kind];
+        }
+    }
+}
+
+template<typename Fn>
+void CompiledMidiSequence::forEachStateKind (const Message& m, Fn&& fn)
+{
+    using namespace CompiledMidiSequenceHelpers;
+
+    if (m.numBytes == 0)
+        return;
+
+    switch (m.data[0] & 0xf0)
+    {
+        case 0xb0:  if (m.numBytes == 3) fn (m.data[1] & 0x7f); break;
+        case 0xc0:  fn ((int) programChangeKind); break;
+        case 0xd0:  fn ((int) channelPressureKind); break;
+        case 0xe0:  fn ((int) pitchWheelKind); break;
+        case 0x80:  fn ((int) noteOffKind); break;
+
+        case 0x90:
+            fn ((int) noteOnKind);
+
+            if (m.numBytes == 3 && m.data[2] == 0)
+                fn ((int) noteOffKind);
+
+            break;
+
+        default:
+            break;
+    }
+}
+
+void CompiledMidiSequence::buildCheckpoints()
+{
+    using namespace CompiledMidiSequenceHelpers;
+
+    std::vector<int> latest ((size_t) 16 * numStateKinds, -1);
+    std::vector<int> held;
+
+    for (int i = 0; i < size(); ++i)
+    {
+        if (i % checkpointInterval == 0)
+        {
+            Checkpoint checkpoint;
+            checkpoint.firstHeldNote = (int) heldNoteOns.size();
+            checkpoint.numHeldNotes = (int) held.size();
+            checkpoint.firstState = (int) checkpointStates.size();
+
+            heldNoteOns.insert (heldNoteOns.end(), held.begin(), held.end());
+
+            for (int key = 0; key < (int) latest.size(); ++key)
+                if (latest[(size_t) key] >= 0)
+                    checkpointStates.push_back ({ key, latest[(size_t) key] });
+
+            checkpoint.numStates = (int) checkpointStates.size() - checkpoint.firstState;
+            checkpoints.push_back (checkpoint);
+        }
+
+        held.erase (std::remove_if (held.begin(), held.end(),
+                                    [this, i] (int noteOnIndex) { return noteOffIndexes[(size_t) noteOnIndex] == i; }),
+                    held.end());
+
+        if (noteOffIndexes[(size_t) i] >= 0)
+            held.push_back (i);
+
+        if (auto channel = getChannel (i))
+        {
+            auto channelKey = (channel - 1) * numStateKinds;
+            forEachStateKind (messages[(size_t) i], [&] (int kind) { latest[(size_t) (channelKey + kind)] = i; });
+        }
+    }
+}
+
+//==============================================================================
+juce::MidiMessage CompiledMidiSequence::getMessage (int index) const
+{
+    auto& m = messages[(size_t) index];
+
+    if (m.numBytes == 0)
+    {
+        auto longIndex = (size_t) m.data[0] | ((size_t) m.data[1] << 8) | ((size_t) m.data[2] << 16);
+        return longMessages[longIndex];
+    }
+
+    return juce::MidiMessage (m.data, m.numBytes, times[(size_t) index]);
+}
+
+int CompiledMidiSequence::getChannel (int index) const noexcept
+{
+    auto& m = messages[(size_t) index];
+
+    if (m.numBytes == 0 || (m.data[0] & 0xf0) == 0xf0)
+        return 0;
+
+    return (m.data[0] & 0x0f) + 1;
+}
+
+bool CompiledMidiSequence::isNoteOn (int index) const noexcept
+{
+    auto& m = messages[(size_t) index];
+    return m.numBytes == 3 && (m.data[0] & 0xf0) == 0x90 && m.data[2] != 0;
+}
+
+bool CompiledMidiSequence::isNoteOff (int index) const noexcept
+{
+    auto& m = messages[(size_t) index];
+    return m.numBytes == 3 && ((m.data[0] & 0xf0) == 0x80 || ((m.data[0] & 0xf0) == 0x90 && m.data[2] == 0));
+}
+
+int CompiledMidiSequence::getNextIndexAtTime (double time) const noexcept
+{
+    return (int) std::distance (times.begin(), std::lower_bound (times.begin(), times.end(), time));
+}
+
+void CompiledMidiSequence::createControllerUpdatesForTime (int channel, double time, juce::Array<juce::MidiMessage>& dest) const
+{
+    auto endIndex = (int) std::distance (times.begin(), std::upper_bound (times.begin(), times.end(), time));
+    auto state = getChannelState (channel, endIndex);
+
+    int indexes[130];
+    int numIndexes = 0;
+
+    for (auto index : state.controllers)
+        if (index >= 0)
+            indexes[numIndexes++] = index;
+
+    for (auto index : { state.programChange, state.pitchWheel })
+        if (index >= 0)
+            indexes[numIndexes++] = index;
+
+    // Add them most recent first, as MidiMessageSequence does
+    std::sort (indexes, indexes + numIndexes, std::greater<int>());
+
+    for (int i = 0; i < numIndexes; ++i)
+    {
+        auto& m = messages[(size_t) indexes[i]];
+        dest.add (juce::MidiMessage (m.data, m.numBytes, 0.0));
+    }
+}
+
+CompiledMidiSequence::ChannelState CompiledMidiSequence::getChannelState (int channel, int endIndex) const
+{
+    using namespace CompiledMidiSequenceHelpers;
+    jassert (channel > 0 && channel <= 16);
+
+    ChannelState state;
+
+    if (checkpoints.empty())
+        return state;
+
+    endIndex = juce::jlimit (0, size(), endIndex);
+    auto& checkpoint = getCheckpointFor (endIndex);
+
+    // The checkpoint's entries are sorted by key, so this channel's are together
+    const int firstKey = (channel - 1) * numStateKinds;
+    auto entries = checkpointStates.begin() + checkpoint.firstState;
+    auto entriesEnd = entries + checkpoint.numStates;
+
+    for (auto e = std::lower_bound (entries, entriesEnd, firstKey, [] (const StateEntry& entry, int key) { return entry.key < key; });
+         e != entriesEnd && e->key < firstKey + numStateKinds; ++e)
+        getIndexForKind (state, e->key - firstKey) = e->index;
+
+    for (int i = getCheckpointIndex (checkpoint); i < endIndex; ++i)
+        if (getChannel (i) == channel)
+            forEachStateKind (messages[(size_t) i], [&] (int kind) { getIndexForKind (state, kind) = i; });
+
+    return state;
+}
+
+//==============================================================================
+#if TRACKTION_UNIT_TESTS
+
+class CompiledMidiSequenceTests   : public juce::UnitTest
+{
+public:
+    CompiledMidiSequenceTests()
+        : juce::UnitTest ("CompiledMidiSequence", "Tracktion") {}
+
+    //==============================================================================
+    void runTest() override
+    {
+        juce::MidiMessageSequence source;
+        source.addEvent (juce::MidiMessage::controllerEvent (1, 7, 100), 0.0);
+        source.addEvent (juce::MidiMessage::noteOn (1, 60, (juce::uint8) 100), 1.0);
+        source.addEvent (juce::MidiMessage::controllerEvent (1, 7, 50), 1.5);
+        source.addEvent (juce::MidiMessage::noteOff (1, 60), 2.0);
+        source.addEvent (juce::MidiMessage::noteOn (3, 64, (juce::uint8) 80), 2.0);
+        source.addEvent (juce::MidiMessage::noteOff (3, 64), 3.0);
+
+        const juce::uint8 sysexData[] = { 1, 2, 3, 4, 5 };
+        source.addEvent (juce::MidiMessage::createSysExMessage (sysexData, (int) sizeof (sysexData)), 2.5);
+
+        auto compiled = CompiledMidiSequence::create (source);
+        source.updateMatchedPairs();
+
+        beginTest ("Events");
+        {
+            expectEquals (compiled->size(), source.getNumEvents());
+
+            for (int i = 0; i < compiled->size(); ++i)
+            {
+                auto& expected = source.getEventPointer (i)->message;
+                auto m = compiled->getMessage (i);
+
+                expectEquals (compiled->getEventTime (i), expected.getTimeStamp());
+                expectEquals (m.getTimeStamp(), expected.getTimeStamp());
+                expect (m.getRawDataSize() == expected.getRawDataSize()
+                          && std::memcmp (m.getRawData(), expected.getRawData(), (size_t) m.getRawDataSize()) == 0);
+                expect (compiled->isNoteOn (i) == expected.isNoteOn());
+                expect (compiled->isNoteOff (i) == expected.isNoteOff());
+                expectEquals (compiled->getChannel (i), expected.getChannel());
+            }
+        }
+
+        beginTest ("Note-offs");
+        {
+            for (int i = 0; i < compiled->size(); ++i)
+            {
+                auto noteOff = source.getEventPointer (i)->noteOffObject;
+                expectEquals (compiled->getNoteOffIndex (i), noteOff != nullptr ? source.getIndexOf (noteOff) : -1);
+            }
+
+            expectEquals (compiled->getNoteOnChannels(), (1 << 1) | (1 << 3));
+        }
+
+        beginTest ("Searching");
+        {
+            for (double t : { -1.0, 0.0, 0.5, 1.0, 2.0, 2.25, 3.0, 4.0 })
+                expectEquals (compiled->getNextIndexAtTime (t), source.getNextIndexAtTime (t));
+
+            for (double t : { 0.0, 1.25, 1.5, 3.0 })
+            {
+                juce::Array<juce::MidiMessage> expected, actual;
+                source.createControllerUpdatesForTime (1, t, expected);
+                compiled->createControllerUpdatesForTime (1, t, actual);
+
+                expectEquals (actual.size(), expected.size());
+
+                for (int i = 0; i < juce::jmin (actual.size(), expected.size()); ++i)
+                    expectEquals (actual[i].getControllerValue(), expected[i].getControllerValue());
+            }
+        }
+
+        beginTest ("Held notes across checkpoints");
+        {
+            // Long notes overlapping lots of controller events, so several checkpoints are needed
+            juce::MidiMessageSequence longSequence;
+
+            for (int i = 0; i < 50; ++i)
+            {
+                longSequence.addEvent (juce::MidiMessage::noteOn (1, 40 + i, (juce::uint8) 100), i);
+                longSequence.addEvent (juce::MidiMessage::noteOff (1, 40 + i), i + 7.5);
+
+                for (int j = 0; j < 8; ++j)
+                    longSequence.addEvent (juce::MidiMessage::controllerEvent (1, 1 + j, i), i + j / 8.0);
+            }
+
+            auto compiledLong = CompiledMidiSequence::create (longSequence);
+            longSequence.updateMatchedPairs();
+
+            for (double t = 0.0; t < 60.0; t += 0.7)
+            {
+                const int index = compiledLong->getNextIndexAtTime (t);
+                juce::Array<int> expected, actual;
+
+                for (int i = 0; i < index; ++i)
+                    if (auto noteOff = longSequence.getEventPointer (i)->noteOffObject)
+                        if (longSequence.getIndexOf (noteOff) >= index)
+                            expected.add (i);
+
+                compiledLong->forEachNoteOnHeldAt (index, [&] (int noteOnIndex) { actual.add (noteOnIndex); });
+                expect (actual == expected);
+
+                juce::Array<juce::MidiMessage> expectedControllers, actualControllers;
+                longSequence.createControllerUpdatesForTime (1, t, expectedControllers);
+                compiledLong->createControllerUpdatesForTime (1, t, actualControllers);
+                expectEquals (actualControllers.size(), expectedControllers.size());
+            }
+        }
+    }
+};
+
+static CompiledMidiSequenceTests compiledMidiSequenceTests;
+
+#endif // TRACKTION_UNIT_TESTS
+
+} // namespace tracktion_engine
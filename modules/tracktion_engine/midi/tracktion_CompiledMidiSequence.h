@@ -0,0 +1,171 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+/**
+    A flattened, immutable copy of a MidiMessageSequence, used for playback.
+
+    The events are held in parallel arrays of times, message bytes and the index of
+    each note-on's note-off, rather than as a list of separately allocated MidiEventHolders,
+    so they're quick to search and iterate. Messages longer than 3 bytes, such as sysex,
+    are kept separately.
+
+    Once created these can't be changed, so a single one can be shared between the
+    model and any number of nodes playing it on other threads.
+
+    When it's created, a checkpoint is also stored every few events recording which
+    notes are held over it and the most recent controller values on each channel. This
+    means the state at any point can be found by starting from the checkpoint before it
+    and scanning a handful of events, rather than the whole sequence, so jumping to a new
+    position doesn't take longer as the sequence grows.
+    @see MidiClip::getCompiledSequence
+*/
+class CompiledMidiSequence
+{
+public:
+    using Ptr = std::shared_ptr<const CompiledMidiSequence>;
+
+    /** Compiles a sequence. The timestamps can be in any units, e.g. seconds or beats,
+        and the note-offs are matched to their note-ons first.
+    */
+    static Ptr create (juce::MidiMessageSequence);
+
+    //==============================================================================
+    int size() const noexcept                               { return (int) times.size(); }
+    bool isEmpty() const noexcept                           { return times.empty(); }
+
+    /** Returns the timestamp of an event. */
+    double getEventTime (int index) const noexcept          { return times[(size_t) index]; }
+
+    /** Creates a MidiMessage for an event, with its timestamp. */
+    juce::MidiMessage getMessage (int index) const;
+
+    /** Returns the channel of an event, or 0 if it isn't a channel message. */
+    int getChannel (int index) const noexcept;
+
+    bool isNoteOn (int index) const noexcept;
+    bool isNoteOff (int index) const noexcept;
+
+    /** Returns the index of the note-off for a note-on, or -1 if it hasn't got one. */
+    int getNoteOffIndex (int index) const noexcept          { return noteOffIndexes[(size_t) index]; }
+
+    /** Returns the index of the first event at or after the given time, or size() if there isn't one. */
+    int getNextIndexAtTime (double time) const noexcept;
+
+    /** Returns a mask of the channels that have note-ons in the sequence, with bit n set for channel n. */
+    int getNoteOnChannels() const noexcept                  { return noteOnChannels; }
+
+    /** Adds the most recent program change, pitch-wheel and controller messages on a
+        channel at or before a time, in the same way as MidiMessageSequence::createControllerUpdatesForTime.
+    */
+    void createControllerUpdatesForTime (int channel, double time, juce::Array<juce::MidiMessage>& dest) const;
+
+    //==============================================================================
+    /** The indexes of the most recent events of each kind on a channel, or -1 where
+        there hasn't been one.
+        Note-ons with a velocity of 0 count as both a note-on and a note-off.
+    */
+    struct ChannelState
+    {
+        ChannelState() noexcept                             { std::fill (std::begin (controllers), std::end (controllers), -1); }
+
+        int controllers[128];
+        int programChange = -1, pitchWheel = -1, channelPressure = -1, noteOn = -1, noteOff = -1;
+    };
+
+    /** Returns the most recent events on a channel before the event at endIndex. */
+    ChannelState getChannelState (int channel, int endIndex) const;
+
+    /** Calls a function with the index of each note-on before the event at the given index
+        whose note-off is at or after it, in order.
+        The function should have the form (int noteOnIndex) -> void.
+    */
+    template<typename Fn>
+    void forEachNoteOnHeldAt (int index, Fn&& fn) const
+    {
+        if (checkpoints.empty())
+            return;
+
+        index = juce::jlimit (0, size(), index);
+        auto& checkpoint = getCheckpointFor (index);
+
+        for (int i = checkpoint.firstHeldNote; i < checkpoint.firstHeldNote + checkpoint.numHeldNotes; ++i)
+        {
+            auto noteOnIndex = heldNoteOns[(size_t) i];
+
+            if (noteOffIndexes[(size_t) noteOnIndex] >= index)
+                fn (noteOnIndex);
+        }
+
+        for (int i = getCheckpointIndex (checkpoint); i < index; ++i)
+            if (noteOffIndexes[(size_t) i] >= index)
+                fn (i);
+    }
+
+private:
+    //==============================================================================
+    /** The bytes of a message. Long messages have a size of 0 and hold their index in longMessages. */
+    struct Message
+    {
+        juce::uint8 data[3];
+        juce::uint8 numBytes;
+    };
+
+    std::vector<double> times;
+    std::vector<Message> messages;
+    std::vector<int> noteOffIndexes;
+    std::vector<juce::MidiMessage> longMessages;
+    int noteOnChannels = 0;
+
+    //==============================================================================
+    /** The state before every checkpointInterval'th event. The held notes and channel
+        state entries are stored in heldNoteOns and checkpointStates.
+    */
+    struct Checkpoint
+    {
+        int firstHeldNote, numHeldNotes;
+        int firstState, numStates;
+    };
+
+    /** The index of the most recent event of a kind, keyed by channel and kind. */
+    struct StateEntry
+    {
+        int key, index;
+    };
+
+    static constexpr int checkpointInterval = 64;
+
+    std::vector<Checkpoint> checkpoints;
+    std::vector<int> heldNoteOns;
+    std::vector<StateEntry> checkpointStates;
+
+    CompiledMidiSequence() = default;
+
+    void buildCheckpoints();
+
+    const Checkpoint& getCheckpointFor (int index) const noexcept
+    {
+        return checkpoints[std::min ((size_t) index / checkpointInterval, checkpoints.size() - 1)];
+    }
+
+    int getCheckpointIndex (const Checkpoint& checkpoint) const noexcept
+    {
+        return (int) std::distance (checkpoints.data(), &checkpoint) * checkpointInterval;
+    }
+
+    template<typename Fn>
+    static void forEachStateKind (const Message&, Fn&&);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompiledMidiSequence)
+};
+
+} // namespace tracktion_engine
@@ -35,6 +35,7 @@ public:
 
     /** This takes into account quantising, groove templates, clip offset, etc */
     double getEditTime (const MidiClip&) const;
+    double getEditBeats (const MidiClip&) const;
 
     juce::String getLevelDescription (MidiClip*) const;
 
@@ -285,14 +285,51 @@ void addMidiNoteOnExpressionToSequence (juce::MidiMessageSequence& seq, const ju
     seq.addEvent (juce::MidiMessage (createTimbre (midiChannel, timbre), noteOnTime));
 }
 
-static void addMidiExpressionToSequence (juce::MidiMessageSequence& seq, const juce::ValueTree& state, const MidiClip& clip, int midiChannel, double notePlaybackBeat, double notePlaybackEndTime) noexcept
+//==============================================================================
+/** Converts the beat positions of a clip's events to the timestamps of a playback
+    sequence, either in seconds or in beats from the start of the clip.
+*/
+struct PlaybackTimeBase
+{
+    PlaybackTimeBase (const MidiClip& c, bool useBeats)
+        : clip (c), ts (c.edit.tempoSequence), inBeats (useBeats),
+          clipStartBeat (ts.timeToBeats (c.getPosition().getStart()))
+    {
+    }
+
+    double getNoteTime (const MidiNote& note, MidiNote::NoteEdge edge, const GrooveTemplate* groove) const
+    {
+        return inBeats ? note.getPlaybackBeats (edge, clip, groove)
+                       : note.getPlaybackTime (edge, clip, groove);
+    }
+
+    double getEventTime (double editBeat) const
+    {
+        return inBeats ? editBeat - clipStartBeat
+                       : ts.beatsToTime (editBeat) - clip.getPosition().getStart();
+    }
+
+    /** Returns the sequence time a number of beats after another one. */
+    double addBeats (double time, double beats) const
+    {
+        return inBeats ? time + beats
+                       : ts.beatsToTime (ts.timeToBeats (time) + beats);
+    }
+
+    const MidiClip& clip;
+    const TempoSequence& ts;
+    const bool inBeats;
+    const double clipStartBeat;
+};
+
+static void addMidiExpressionToSequence (juce::MidiMessageSequence& seq, const juce::ValueTree& state, const PlaybackTimeBase& timeBase,
+                                         int midiChannel, double notePlaybackStart, double notePlaybackEnd) noexcept
 {
     using namespace NoteHelpers;
 
-    auto& ts = clip.edit.tempoSequence;
-    auto time = ts.beatsToTime (notePlaybackBeat + static_cast<double> (state.getProperty (IDs::b)));
+    auto time = timeBase.addBeats (notePlaybackStart, static_cast<double> (state.getProperty (IDs::b)));
 
-    if (time > notePlaybackEndTime)
+    if (time > notePlaybackEnd)
         return;
 
     if (state.hasType (IDs::PITCHBEND))
@@ -305,19 +342,18 @@ static void addMidiExpressionToSequence (juce::MidiMessageSequence& seq, const j
         jassertfalse;
 }
 
-static void addExpressiveNoteToSequence (juce::MidiMessageSequence& seq, const MidiClip& clip, const MidiNote& note, int midiChannel, const GrooveTemplate* grooveTemplate)
+static void addExpressiveNoteToSequence (juce::MidiMessageSequence& seq, const PlaybackTimeBase& timeBase, const MidiNote& note, int midiChannel, const GrooveTemplate* grooveTemplate)
 {
     if (note.isMute() || note.getLengthBeats() <= 0.00001)
         return;
 
-    auto downTime = note.getPlaybackTime (MidiNote::startEdge, clip, grooveTemplate);
-    auto upTime   = note.getPlaybackTime (MidiNote::endEdge,   clip, grooveTemplate);
+    auto downTime = timeBase.getNoteTime (note, MidiNote::startEdge, grooveTemplate);
+    auto upTime   = timeBase.getNoteTime (note, MidiNote::endEdge,   grooveTemplate);
 
     if (upTime < downTime || upTime <= 0.0)
         return;
 
     auto state = note.state;
-    auto noteStartBeat = clip.edit.tempoSequence.timeToBeats (downTime);
 
     // First add expression with defaults if not present
     addMidiNoteOnExpressionToSequence (seq, state, midiChannel, downTime);
@@ -329,7 +365,7 @@ static void addExpressiveNoteToSequence (juce::MidiMessageSequence& seq, const M
 
     // Then modulating expression
     for (auto v : state)
-        addMidiExpressionToSequence (seq, v, clip, midiChannel, noteStartBeat, upTime);
+        addMidiExpressionToSequence (seq, v, timeBase, midiChannel, downTime, upTime);
 
     // Finally note-off
     const auto noteOffVelocity = state.hasProperty (IDs::lift) ? int (state[IDs::lift]) / 127.0f : 0.0f;
@@ -337,7 +373,7 @@ static void addExpressiveNoteToSequence (juce::MidiMessageSequence& seq, const M
 }
 
 //==============================================================================
-static void addToSequence (juce::MidiMessageSequence& seq, const MidiClip& clip,
+static void addToSequence (juce::MidiMessageSequence& seq, const PlaybackTimeBase& timeBase,
                            const MidiNote& note, int channelNumber, bool addNoteUp,
                            const GrooveTemplate* grooveTemplate)
 {
@@ -346,14 +382,14 @@ static void addToSequence (juce::MidiMessageSequence& seq, const MidiClip& clip,
     if (note.isMute() || note.getLengthBeats() <= 0.00001)
         return;
 
-    double downTime = note.getPlaybackTime (MidiNote::startEdge, clip, grooveTemplate);
+    double downTime = timeBase.getNoteTime (note, MidiNote::startEdge, grooveTemplate);
     auto velocity = (juce::uint8) note.getVelocity();
     int noteNumber = note.getNoteNumber();
 
     if (addNoteUp)
     {
         // nudge the note-up backwards just a bit to make sure the ordering is correct
-        double upTime = note.getPlaybackTime (MidiNote::endEdge, clip, grooveTemplate);
+        double upTime = timeBase.getNoteTime (note, MidiNote::endEdge, grooveTemplate);
 
         if (upTime > downTime && upTime > 0.0)
         {
@@ -367,10 +403,11 @@ static void addToSequence (juce::MidiMessageSequence& seq, const MidiClip& clip,
     }
 }
 
-static void addToSequence (juce::MidiMessageSequence& seq, const MidiClip& clip,
+static void addToSequence (juce::MidiMessageSequence& seq, const PlaybackTimeBase& timeBase,
                            const MidiControllerEvent& controller, int channelNumber)
 {
-    auto time = std::max (0.0, controller.getEditTime (clip) - clip.getPosition().getStart());
+    auto& clip = timeBase.clip;
+    auto time = std::max (0.0, timeBase.getEventTime (controller.getEditBeats (clip)));
     auto type = controller.getType();
     auto value = controller.getControllerValue();
 
@@ -412,9 +449,9 @@ static void addToSequence (juce::MidiMessageSequence& seq, const MidiClip& clip,
     }
 }
 
-static void addToSequence (juce::MidiMessageSequence& seq, const MidiClip& clip, const MidiSysexEvent& sysex)
+static void addToSequence (juce::MidiMessageSequence& seq, const PlaybackTimeBase& timeBase, const MidiSysexEvent& sysex)
 {
-    auto time = std::max (0.0, sysex.getEditTime (clip) - clip.getPosition().getStart());
+    auto time = std::max (0.0, timeBase.getEventTime (sysex.getEditBeats (timeBase.clip)));
     auto m = sysex.getMessage();
     m.setTimeStamp (time);
     seq.addEvent (m);
@@ -429,8 +466,8 @@ class MPEChannelAssigner
 public:
     //==========================================================================
     /** Constructor. */
-    MPEChannelAssigner (juce::MidiMessageSequence& s, const MidiClip& c, const GrooveTemplate* g)
-        : seq (s), clip (c), groove (g)
+    MPEChannelAssigner (juce::MidiMessageSequence& s, const PlaybackTimeBase& t, const GrooveTemplate* g)
+        : seq (s), timeBase (t), groove (g)
     {
         zoneLayout.setLowerZone (15);
         const auto mpeZone = zoneLayout.getLowerZone();
@@ -442,13 +479,13 @@ public:
 
     void addNote (MidiNote& note)
     {
-        clearNotesEndingBefore (note.getPlaybackTime (MidiNote::startEdge, clip, groove));
+        clearNotesEndingBefore (timeBase.getNoteTime (note, MidiNote::startEdge, groove));
 
         auto midiChannel = findMidiChannelForNewNote (note.getNoteNumber());
         midiChannels[midiChannel].notes.add (&note);
         midiChannels[midiChannel].lastNoteNumberPlayed = note.getNoteNumber();
 
-        addExpressiveNoteToSequence (seq, clip, note, zoneLayout.getLowerZone().getMasterChannel() + midiChannel, groove);
+        addExpressiveNoteToSequence (seq, timeBase, note, zoneLayout.getLowerZone().getMasterChannel() + midiChannel, groove);
     }
 
 private:
@@ -484,7 +521,7 @@ private:
         for (auto& midiChannel : midiChannels)
             for (int i = midiChannel.notes.size(); --i >= 0;)
                 if (auto n = midiChannel.notes.getUnchecked (i))
-                    if (n->getPlaybackTime (MidiNote::endEdge, clip, groove) < time)
+                    if (timeBase.getNoteTime (*n, MidiNote::endEdge, groove) < time)
                         stopNote (*n);
     }
 
@@ -555,7 +592,7 @@ private:
 
     //==========================================================================
     juce::MidiMessageSequence& seq;
-    const MidiClip& clip;
+    const PlaybackTimeBase& timeBase;
     const GrooveTemplate* groove;
     juce::MPEZoneLayout zoneLayout;
     MidiChannel midiChannels[16];
@@ -765,6 +802,22 @@ double MidiNote::getPlaybackTime (NoteEdge edge, const MidiClip& clip, const Gro
     return time - pos.getStart();
 }
 
+double MidiNote::getPlaybackBeats (NoteEdge edge, const MidiClip& clip, const GrooveTemplate* const grooveTemplate) const
+{
+    auto& ts = clip.edit.tempoSequence;
+    auto pos = clip.getPosition();
+    auto quantisedStartBeat = clip.getQuantisation().roundBeatToNearest (startBeat + clip.getContentStartBeat());
+
+    // nudge the note-up backwards just a bit to make sure the ordering is correct
+    auto beat = edge == startEdge ? quantisedStartBeat
+                                  : std::min (quantisedStartBeat + lengthInBeats, ts.timeToBeats (pos.getEnd())) - 0.0001;
+
+    if (grooveTemplate != nullptr)
+        beat = grooveTemplate->beatsTimeToGroovyTime (beat, clip.getGrooveStrength());
+
+    return beat - ts.timeToBeats (pos.getStart());
+}
+
 //==============================================================================
 juce::ValueTree MidiControllerEvent::createControllerEvent (const MidiControllerEvent& e, double newBeat)
 {
@@ -846,12 +899,14 @@ juce::String MidiControllerEvent::getControllerTypeName (int type) noexcept
     return "(" + TRANS("Unnamed") + ")";
 }
 
-double MidiControllerEvent::getEditTime (const MidiClip& c) const
+double MidiControllerEvent::getEditBeats (const MidiClip& c) const
 {
-    const double quantisedBeatInEdit = c.getQuantisation()
-                                        .roundBeatToNearest (beatNumber + c.getContentStartBeat());
+    return c.getQuantisation().roundBeatToNearest (beatNumber + c.getContentStartBeat());
+}
 
-    return c.edit.tempoSequence.beatsToTime (quantisedBeatInEdit);
+double MidiControllerEvent::getEditTime (const MidiClip& c) const
+{
+    return c.edit.tempoSequence.beatsToTime (getEditBeats (c));
 }
 
 juce::String MidiControllerEvent::getLevelDescription (MidiClip* ownerClip) const
@@ -1013,11 +1068,14 @@ struct MidiList::EventDelegate<MidiSysexEvent>
     }
 };
 
-double MidiSysexEvent::getEditTime (const MidiClip& c) const
+double MidiSysexEvent::getEditBeats (const MidiClip& c) const
 {
-    auto quantisedBeatInEdit = c.getQuantisation().roundBeatToNearest (message.getTimeStamp() + c.getContentStartBeat());
+    return c.getQuantisation().roundBeatToNearest (message.getTimeStamp() + c.getContentStartBeat());
+}
 
-    return c.edit.tempoSequence.beatsToTime (quantisedBeatInEdit);
+double MidiSysexEvent::getEditTime (const MidiClip& c) const
+{
+    return c.edit.tempoSequence.beatsToTime (getEditBeats (c));
 }
 
 void MidiSysexEvent::setMessage (const juce::MidiMessage& m, juce::UndoManager* um)
@@ -1774,9 +1832,11 @@ void MidiList::importFromEditTimeSequenceWithNoteExpression (const juce::MidiMes
 }
 
 //==============================================================================
-void MidiList::exportToPlaybackMidiSequence (juce::MidiMessageSequence& destSequence, MidiClip& clip, bool generateMPE) const
+void MidiList::exportToPlaybackMidiSequence (juce::MidiMessageSequence& destSequence, MidiClip& clip,
+                                             bool generateMPE, bool timestampsInBeats) const
 {
     auto& ts = clip.edit.tempoSequence;
+    const PlaybackTimeBase timeBase (clip, timestampsInBeats);
     auto midiStartBeat = clip.getContentStartBeat();
     auto channelNumber = getMidiChannel().getChannelNumber();
 
@@ -1829,12 +1889,12 @@ void MidiList::exportToPlaybackMidiSequence (juce::MidiMessageSequence& destSequ
             }
 
             if (thisNoteEnd > firstNoteTime)
-                addToSequence (destSequence, clip, note, channelNumber, useNoteUp, grooveTemplate);
+                addToSequence (destSequence, timeBase, note, channelNumber, useNoteUp, grooveTemplate);
         }
     }
     else
     {
-        MPEChannelAssigner assigner (destSequence, clip, grooveTemplate);
+        MPEChannelAssigner assigner (destSequence, timeBase, grooveTemplate);
 
         for (auto note : notes)
         {
@@ -1859,7 +1919,7 @@ void MidiList::exportToPlaybackMidiSequence (juce::MidiMessageSequence& destSequ
             {
                 if (! doneControllers.contains (e->getType()))
                 {
-                    addToSequence (destSequence, clip, *e, channelNumber);
+                    addToSequence (destSequence, timeBase, *e, channelNumber);
                     doneControllers.add (e->getType());
                 }
             }
@@ -1872,7 +1932,7 @@ void MidiList::exportToPlaybackMidiSequence (juce::MidiMessageSequence& destSequ
         auto beat = e->getBeatPosition();
 
         if (beat >= firstNoteTime && beat < lastNoteTime)
-            addToSequence (destSequence, clip, *e, channelNumber);
+            addToSequence (destSequence, timeBase, *e, channelNumber);
     }
 
     // Add the SysEx events:
@@ -1881,7 +1941,7 @@ void MidiList::exportToPlaybackMidiSequence (juce::MidiMessageSequence& destSequ
         auto beat = e->getBeatPosition();
 
         if (beat >= firstNoteTime && beat < lastNoteTime)
-            addToSequence (destSequence, clip, *e);
+            addToSequence (destSequence, timeBase, *e);
     }
 }
 
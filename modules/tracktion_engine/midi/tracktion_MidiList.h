@@ -127,8 +127,10 @@ public:
     void importFromEditTimeSequenceWithNoteExpression (const juce::MidiMessageSequence&, Edit*,
                                                        double editTimeOfListTimeZero, juce::UndoManager*);
 
-    // Add equivalent events to the sequence, for playback
-    void exportToPlaybackMidiSequence (juce::MidiMessageSequence&, MidiClip&, bool generateMPE) const;
+    // Add equivalent events to the sequence, for playback. The timestamps are from the start
+    // of the clip, in seconds or, if timestampsInBeats is true, in beats
+    void exportToPlaybackMidiSequence (juce::MidiMessageSequence&, MidiClip&, bool generateMPE,
+                                       bool timestampsInBeats = false) const;
 
     //==============================================================================
     static bool looksLikeMPEData (const juce::File&);
@@ -38,6 +38,9 @@ public:
 
     double getPlaybackTime (NoteEdge, const MidiClip&, const GrooveTemplate*) const;
 
+    /** Returns the same position as getPlaybackTime, but in beats from the start of the clip. */
+    double getPlaybackBeats (NoteEdge, const MidiClip&, const GrooveTemplate*) const;
+
     /** Returns the start, quantised according to the clip's settings. */
     double getQuantisedStartBeat (const MidiClip&) const;
     double getQuantisedStartBeat (const MidiClip*) const;
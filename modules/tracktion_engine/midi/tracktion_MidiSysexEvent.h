@@ -32,6 +32,7 @@ public:
 
     // takes into account quantising, groove templates, clip offset, etc
     double getEditTime (const MidiClip&) const;
+    double getEditBeats (const MidiClip&) const;
 
     juce::ValueTree state;
 
@@ -266,48 +266,22 @@ public:
     bool isResultSensible()                             { return isSensible; }
 
     //==============================================================================
-    /** Performs the actual detection. */
+    /** Performs the actual detection.
+        This goes via the AudioFileAnalysisCache so files that have already been
+        analysed return immediately and new results are cached for next time.
+    */
     JobStatus runJob() override
     {
-        std::unique_ptr<AudioFormatReader> reader (AudioFileUtils::createReaderFor (engine, sourceFile));
+        auto result = engine.getAudioFileAnalysisCache().analyseFile (AudioFile (engine, sourceFile),
+                                                                      [this] (float p)
+                                                                      {
+                                                                          progress = p;
+                                                                          return ! shouldExit();
+                                                                      });
 
-        if (reader == nullptr)
-            return jobHasFinished;
-
-        auto numChannels = (int) reader->numChannels;
-        auto numSamples = reader->lengthInSamples;
-        auto sampleRate = reader->sampleRate;
-
-        if (numSamples <= 0)
-            return jobHasFinished;
-
-        // main detection loop
+        if (result.wasAnalysed)
         {
-            TempoDetect detector (numChannels, sampleRate);
-            const int blockSize = 65536;
-            const bool useRightChan = numChannels > 1;
-
-            // can't use an AudioScratchBuffer yet
-            AudioBuffer<float> buffer (numChannels, blockSize);
-
-            int64 numLeft = numSamples;
-            int64 startSample = 0;
-
-            while (numLeft > 0)
-            {
-                if (shouldExit())
-                    return jobHasFinished;
-
-                const int numThisTime = (int) jmin (numLeft, (int64) blockSize);
-                reader->read (&buffer, 0, numThisTime, startSample, true, useRightChan);
-                detector.processSection (buffer, numThisTime);
-
-                startSample += numThisTime;
-                numLeft -= numThisTime;
-                progress = numLeft / (float) numSamples;
-            }
-
-            bpm = detector.finishAndDetect();
+            bpm = result.bpm;
             isSensible = bpm > 0;
         }
 
@@ -1439,6 +1413,19 @@ LoopInfo AudioClipBase::autoDetectBeatMarkers (const LoopInfo& current, bool aut
 
 bool AudioClipBase::performTempoDetect()
 {
+    const AudioFile sourceFile (edit.engine, getCurrentSourceFile());
+    AudioFileAnalysisCache::Result cachedResult;
+
+    // Previously analysed files don't need to show a progress bar
+    if (edit.engine.getAudioFileAnalysisCache().getCachedResult (sourceFile, cachedResult))
+    {
+        if (cachedResult.bpm <= 0)
+            return false;
+
+        loopInfo.setBpm (cachedResult.bpm, sourceFile.getInfo());
+        return true;
+    }
+
     TempoDetectTask tempoDetectTask (edit.engine, getCurrentSourceFile());
 
     edit.engine.getUIBehaviour().runTaskWithProgressBar (tempoDetectTask);
@@ -1446,7 +1433,7 @@ bool AudioClipBase::performTempoDetect()
     if (! tempoDetectTask.isResultSensible())
         return false;
 
-    const AudioFileInfo wi = AudioFile (edit.engine, getCurrentSourceFile()).getInfo();
+    const AudioFileInfo wi = sourceFile.getInfo();
     loopInfo.setBpm (tempoDetectTask.getBpm(), wi);
 
     return true;
@@ -603,6 +603,129 @@ protected:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BlockBasedRenderJob)
 };
 
+//==============================================================================
+/** The threads that all FusedChunkRenderJobs share to process their chunks. */
+struct ChunkProcessingPool  : public juce::ThreadPool
+{
+    ChunkProcessingPool()  : juce::ThreadPool (jmax (1, SystemStats::getNumCpus() - 1)) {}
+};
+
+/** Reads the source once and passes each chunk through a chain of ChunkProcessors
+    before writing it, so none of the effects in the chain need their own file.
+    A few chunks are read at a time and processed in parallel on a shared pool.
+*/
+struct FusedChunkRenderJob  : public BlockBasedRenderJob
+{
+    FusedChunkRenderJob (Engine& e, const AudioFile& dest, const AudioFile& src, double sourceLength,
+                         std::vector<std::unique_ptr<ClipEffect::ChunkProcessor>> p)
+        : BlockBasedRenderJob (e, dest, src, sourceLength), processors (std::move (p))
+    {
+        jassert (! processors.empty());
+
+        for (int i = 1; i < numChunksPerBlock; ++i)
+            chunkJobs.push_back (std::make_unique<ChunkJob> (*this));
+    }
+
+    ~FusedChunkRenderJob() override
+    {
+        for (auto& job : chunkJobs)
+            pool->removeJob (job.get(), false, -1);
+    }
+
+    bool setUpRender() override
+    {
+        if (! BlockBasedRenderJob::setUpRender())
+            return false;
+
+        buffer.setSize ((int) reader->numChannels, chunkSize * numChunksPerBlock);
+        return true;
+    }
+
+    bool renderNextBlock() override
+    {
+        CRASH_TRACER
+        auto todo = (int) jmin ((juce::int64) buffer.getNumSamples(), sourceLengthSamples - position);
+
+        reader->read (&buffer, 0, todo, position, true, true);
+
+        // The first chunk is processed on this thread while the pool does the rest
+        size_t numJobs = 0;
+
+        for (int start = chunkSize; start < todo; start += chunkSize)
+        {
+            auto& job = *chunkJobs[numJobs++];
+            job.startSample = start;
+            job.numSamples = jmin (chunkSize, todo - start);
+            pool->addJob (&job, false);
+        }
+
+        processChunk (0, jmin (chunkSize, todo));
+
+        for (size_t i = 0; i < numJobs; ++i)
+            pool->waitForJobToFinish (chunkJobs[i].get(), -1);
+
+        writer->appendBuffer (buffer, todo);
+
+        position += todo;
+        progress = float (position) / float (sourceLengthSamples);
+
+        return position >= sourceLengthSamples;
+    }
+
+private:
+    struct ChunkJob  : public juce::ThreadPoolJob
+    {
+        ChunkJob (FusedChunkRenderJob& o)  : ThreadPoolJob ("Clip Effect Chunk"), owner (o) {}
+
+        JobStatus runJob() override
+        {
+            owner.processChunk (startSample, numSamples);
+            return jobHasFinished;
+        }
+
+        FusedChunkRenderJob& owner;
+        int startSample = 0, numSamples = 0;
+    };
+
+    const int chunkSize = 32768;
+    const int numChunksPerBlock = jlimit (1, 8, SystemStats::getNumCpus());
+
+    std::vector<std::unique_ptr<ClipEffect::ChunkProcessor>> processors;
+    juce::AudioBuffer<float> buffer;
+
+    SharedResourcePointer<ChunkProcessingPool> pool;
+    std::vector<std::unique_ptr<ChunkJob>> chunkJobs;
+
+    void processChunk (int startSample, int numSamples)
+    {
+        if (numSamples <= 0)
+            return;
+
+        juce::AudioBuffer<float> chunk (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), startSample, numSamples);
+
+        for (auto& p : processors)
+            p->process (chunk, position + startSample, reader->sampleRate);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FusedChunkRenderJob)
+};
+
+/** Clears the parts of a chunk that fall within any of the given source times. */
+static void clearTimeRanges (juce::AudioBuffer<float>& buffer, juce::int64 startSample, double sampleRate,
+                             const Array<EditTimeRange>& times)
+{
+    const auto endSample = startSample + buffer.getNumSamples();
+
+    for (auto t : times)
+    {
+        auto s = jmax (startSample, (juce::int64) (t.getStart() * sampleRate + 0.5));
+        auto e = jmin (endSample, (juce::int64) (t.getEnd() * sampleRate + 0.5));
+
+        if (e > s)
+            buffer.clear ((int) (s - startSample), (int) (e - s));
+    }
+}
+
 //==============================================================================
 class WarpTimeEffectRenderJob :   public BlockBasedRenderJob
 {
@@ -677,6 +800,41 @@ ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> VolumeEffect::createR
                                    getDestinationFile(), sourceFile);
 }
 
+std::unique_ptr<ClipEffect::ChunkProcessor> VolumeEffect::createChunkProcessor (double)
+{
+    // Automated volumes are rendered through the plugin
+    if (plugin == nullptr || plugin->isAutomationNeeded())
+        return {};
+
+    struct GainChunkProcessor  : public ChunkProcessor
+    {
+        void process (juce::AudioBuffer<float>& buffer, juce::int64, double) const override
+        {
+            const int numSamples = buffer.getNumSamples();
+            buffer.applyGain (0, 0, numSamples, leftGain);
+
+            if (buffer.getNumChannels() > 1)
+                buffer.applyGain (1, 0, numSamples, rightGain);
+
+            for (int i = 2; i < buffer.getNumChannels(); ++i)
+                buffer.applyGain (i, 0, numSamples, otherGain);
+        }
+
+        float leftGain = 1.0f, rightGain = 1.0f, otherGain = 1.0f;
+    };
+
+    auto p = std::make_unique<GainChunkProcessor>();
+    const float polarity = plugin->polarity ? -1.0f : 1.0f;
+
+    getGainsFromVolumeFaderPositionAndPan (plugin->getSliderPos(), plugin->getPan(), plugin->getPanLaw(),
+                                           p->leftGain, p->rightGain);
+    p->leftGain *= polarity;
+    p->rightGain *= polarity;
+    p->otherGain = volumeFaderPositionToGain (plugin->getSliderPos()) * polarity;
+
+    return p;
+}
+
 bool VolumeEffect::hasProperties()
 {
     return true;
@@ -767,6 +925,57 @@ void FadeInOutEffect::setFadeOut (double out)
     }
 }
 
+struct FadeInOutEffect::FadeChunkProcessor  : public ChunkProcessor
+{
+    void process (juce::AudioBuffer<float>& buffer, juce::int64 startSample, double sampleRate) const override
+    {
+        const int numSamples = buffer.getNumSamples();
+        const EditTimeRange chunkTime (startSample / sampleRate, (startSample + numSamples) / sampleRate);
+
+        if (! (fadeInRange.isEmpty() && fadeOutRange.isEmpty()))
+            FadeInOutAudioNode::applyFades (buffer, 0, numSamples, chunkTime,
+                                            fadeInRange, fadeOutRange, fadeInType, fadeOutType, true);
+
+        clearTimeRanges (buffer, startSample, sampleRate, muteTimes);
+    }
+
+    EditTimeRange fadeInRange, fadeOutRange;
+    AudioFadeCurve::Type fadeInType, fadeOutType;
+    Array<EditTimeRange> muteTimes;
+};
+
+EditTimeRange FadeInOutEffect::getEffectRangeInSource() const
+{
+    auto speedRatio = clipEffects.getSpeedRatioEstimate();
+    auto effectRange = clipEffects.getEffectsRange();
+
+    return { effectRange.getStart() * speedRatio,
+             effectRange.getEnd() * speedRatio };
+}
+
+std::unique_ptr<ClipEffect::ChunkProcessor> FadeInOutEffect::createChunkProcessor (double sourceLength)
+{
+    // Tape start/stop changes the speed so has to be rendered by a SpeedRampAudioNode
+    if (getType() != EffectType::fadeInOut)
+        return {};
+
+    auto effectRange = getEffectRangeInSource();
+    auto p = std::make_unique<FadeChunkProcessor>();
+
+    if (fadeIn > 0.0 || fadeOut > 0.0)
+    {
+        p->fadeInRange  = { effectRange.getStart(), effectRange.getStart() + fadeIn };
+        p->fadeOutRange = { effectRange.getEnd() - fadeOut, effectRange.getEnd() };
+    }
+
+    p->fadeInType = fadeInType;
+    p->fadeOutType = fadeOutType;
+    p->muteTimes = { EditTimeRange (0.0, effectRange.getStart()),
+                     EditTimeRange (effectRange.getEnd(), sourceLength) };
+
+    return p;
+}
+
 ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> FadeInOutEffect::createRenderJob (const AudioFile& sourceFile, double sourceLength)
 {
     CRASH_TRACER
@@ -777,10 +986,7 @@ ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> FadeInOutEffect::crea
     AudioNode* n = new WaveAudioNode (sourceFile, timeRange, 0.0, {}, {}, 1.0, AudioChannelSet::stereo());
     int blockSize = 32768;
 
-    auto speedRatio = clipEffects.getSpeedRatioEstimate();
-    auto effectRange = clipEffects.getEffectsRange();
-    effectRange = { effectRange.getStart() * speedRatio,
-                    effectRange.getEnd() * speedRatio };
+    auto effectRange = getEffectRangeInSource();
 
     const EditTimeRange fadeInRange (effectRange.getStart(), effectRange.getStart() + fadeIn);
     const EditTimeRange fadeOutRange (effectRange.getEnd() - fadeOut, effectRange.getEnd());
@@ -862,14 +1068,8 @@ int StepVolumeEffect::getMaxNumNotes()
     return (int) std::ceil ((endBeat - startBeat) / noteLength);
 }
 
-ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> StepVolumeEffect::createRenderJob (const AudioFile& sourceFile, double sourceLength)
+Array<EditTimeRange> StepVolumeEffect::getNonMuteTimes()
 {
-    CRASH_TRACER
-    jassert (sourceLength > 0);
-
-    auto destFile = getDestinationFile();
-    EditTimeRange timeRange (0.0, sourceLength);
-
     auto speedRatio = clipEffects.getSpeedRatioEstimate();
     auto effectRange = clipEffects.getEffectsRange();
 
@@ -931,12 +1131,62 @@ ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> StepVolumeEffect::cre
             t = t.rescaled (0.0, speedRatio);
     }
 
+    return nonMuteTimes;
+}
+
+ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> StepVolumeEffect::createRenderJob (const AudioFile& sourceFile, double sourceLength)
+{
+    CRASH_TRACER
+    jassert (sourceLength > 0);
+
+    auto destFile = getDestinationFile();
+    EditTimeRange timeRange (0.0, sourceLength);
+    auto nonMuteTimes = getNonMuteTimes();
+
     auto waveNode = new WaveAudioNode (sourceFile, timeRange, 0.0, {}, {}, 1.0, AudioChannelSet::stereo());
-    auto compNode = TrackCompManager::createTrackCompAudioNode (waveNode, TrackCompManager::TrackComp::getMuteTimes (nonMuteTimes), nonMuteTimes, fade);
+    auto compNode = TrackCompManager::createTrackCompAudioNode (waveNode, TrackCompManager::TrackComp::getMuteTimes (nonMuteTimes), nonMuteTimes, crossfade);
 
     return new AudioNodeRenderJob (edit.engine, compNode, destFile, sourceFile);
 }
 
+/** Applies the same muting and crossfades as TrackCompManager::createTrackCompAudioNode. */
+struct StepVolumeEffect::StepVolumeChunkProcessor  : public ChunkProcessor
+{
+    void process (juce::AudioBuffer<float>& buffer, juce::int64 startSample, double sampleRate) const override
+    {
+        if (muteTimes.isEmpty())
+            return;
+
+        const int numSamples = buffer.getNumSamples();
+        const EditTimeRange chunkTime (startSample / sampleRate, (startSample + numSamples) / sampleRate);
+
+        clearTimeRanges (buffer, startSample, sampleRate, muteTimes);
+
+        for (auto r : nonMuteTimes)
+        {
+            auto fadeIn = r.withLength (crossfadeTime) - 0.0001;
+            auto fadeOut = fadeIn.movedToEndAt (r.getEnd() + 0.0001);
+
+            if (! (fadeIn.isEmpty() && fadeOut.isEmpty()))
+                FadeInOutAudioNode::applyFades (buffer, 0, numSamples, chunkTime, fadeIn, fadeOut,
+                                                AudioFadeCurve::convex, AudioFadeCurve::convex, false);
+        }
+    }
+
+    Array<EditTimeRange> nonMuteTimes, muteTimes;
+    double crossfadeTime = 0.0;
+};
+
+std::unique_ptr<ClipEffect::ChunkProcessor> StepVolumeEffect::createChunkProcessor (double)
+{
+    auto p = std::make_unique<StepVolumeChunkProcessor>();
+    p->nonMuteTimes = getNonMuteTimes();
+    p->muteTimes = TrackCompManager::TrackComp::getMuteTimes (p->nonMuteTimes);
+    p->crossfadeTime = crossfade;
+
+    return p;
+}
+
 bool StepVolumeEffect::hasProperties()
 {
     return true;
@@ -1631,6 +1881,19 @@ ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> InvertEffect::createR
     return new InvertRenderJob (edit.engine, getDestinationFile(), sourceFile, sourceLength);
 }
 
+std::unique_ptr<ClipEffect::ChunkProcessor> InvertEffect::createChunkProcessor (double)
+{
+    struct InvertChunkProcessor  : public ChunkProcessor
+    {
+        void process (juce::AudioBuffer<float>& buffer, juce::int64, double) const override
+        {
+            buffer.applyGain (-1.0f);
+        }
+    };
+
+    return std::make_unique<InvertChunkProcessor>();
+}
+
 //==============================================================================
 ClipEffect* ClipEffect::create (const ValueTree& v, ClipEffects& ce)
 {
@@ -1740,24 +2003,205 @@ RenderManager::Job::Ptr ClipEffects::createRenderJob (const AudioFile& destFile,
     AudioFile inputFile (sourceFile);
     ReferenceCountedArray<ClipEffect::ClipEffectRenderJob> jobs;
 
+    // Runs of effects that can be processed in chunks are fused into a single job
+    // which writes to the last effect's file
+    std::vector<std::unique_ptr<ClipEffect::ChunkProcessor>> chunkProcessors;
+    ClipEffect* lastChunkedEffect = nullptr;
+
+    auto addFusedJob = [&]
+    {
+        if (chunkProcessors.empty())
+            return;
+
+        ClipEffect::ClipEffectRenderJob::Ptr j = new FusedChunkRenderJob (clip.edit.engine, lastChunkedEffect->getDestinationFile(),
+                                                                          inputFile, length, std::move (chunkProcessors));
+        chunkProcessors.clear();
+        inputFile = j->destination;
+        jobs.add (j);
+    };
+
     for (auto ce : objects)
     {
         const AudioFile af (ce->getDestinationFile());
 
         if (af.getFile().existsAsFile() && af.isValid())
         {
+            // This already includes any effects before it
+            chunkProcessors.clear();
             inputFile = af;
         }
-        else if (ClipEffect::ClipEffectRenderJob::Ptr j = ce->createRenderJob (inputFile, length))
+        else if (auto p = ce->createChunkProcessor (length))
         {
-            inputFile = j->destination;
-            jobs.add (j);
+            chunkProcessors.push_back (std::move (p));
+            lastChunkedEffect = ce;
+        }
+        else
+        {
+            addFusedJob();
+
+            if (ClipEffect::ClipEffectRenderJob::Ptr j = ce->createRenderJob (inputFile, length))
+            {
+                inputFile = j->destination;
+                jobs.add (j);
+            }
         }
     }
 
+    addFusedJob();
+
     AudioFile firstFile (jobs.isEmpty() ? inputFile : jobs.getFirst()->source);
 
     return new AggregateJob (clip.edit.engine, destFile, firstFile, std::move (jobs));
 }
 
+//==============================================================================
+//==============================================================================
+#if TRACKTION_UNIT_TESTS
+
+class FusedClipEffectTests  : public UnitTest
+{
+public:
+    FusedClipEffectTests() : UnitTest ("Fused Clip Effects", "Tracktion") {}
+
+    //==============================================================================
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines()[0];
+        auto sourceFile = createSinFile (44100.0);
+        auto edit = Edit::createSingleTrackEdit (engine);
+        auto track = getAudioTracks (*edit)[0];
+
+        auto clip = track->insertWaveClip ("sin", sourceFile->getFile(), {{ 0.0, 1.0 }}, false);
+        expect (clip != nullptr);
+
+        clip->enableEffects (true, false);
+        clip->addEffect (ClipEffect::create (ClipEffect::EffectType::volume));
+        clip->addEffect (ClipEffect::create (ClipEffect::EffectType::fadeInOut));
+        clip->addEffect (ClipEffect::create (ClipEffect::EffectType::invert));
+
+        auto clipEffects = clip->getClipEffects();
+        expect (clipEffects != nullptr);
+        expectEquals (clipEffects->objects.size(), 3);
+
+        // Stop the clip rendering its own proxy while the effects are being compared
+        ClipEffects::RenderInhibitor inhibitor (*clipEffects);
+
+        if (auto volume = dynamic_cast<VolumeEffect*> (clipEffects->objects[0]))
+            volume->plugin->setVolumeDb (-6.0f);
+
+        if (auto fade = dynamic_cast<FadeInOutEffect*> (clipEffects->objects[1]))
+        {
+            fade->setFadeIn (0.25);
+            fade->setFadeOut (0.25);
+        }
+
+        const AudioFile source (engine, sourceFile->getFile());
+        const double length = source.getLength();
+
+        beginTest ("Fused effects match the sequential renders");
+        {
+            // Each effect rendered to its own file, one after the other
+            AudioFile sequential (source);
+
+            for (auto ce : clipEffects->objects)
+            {
+                auto job = ce->createRenderJob (sequential, length);
+                expect (job != nullptr);
+                expect (render (*job));
+                sequential = job->destination;
+            }
+
+            // And all the effects applied to each chunk of a single pass
+            std::vector<std::unique_ptr<ClipEffect::ChunkProcessor>> processors;
+
+            for (auto ce : clipEffects->objects)
+                if (auto p = ce->createChunkProcessor (length))
+                    processors.push_back (std::move (p));
+
+            expectEquals ((int) processors.size(), clipEffects->objects.size());
+
+            TemporaryFile fusedFile (".wav");
+            const AudioFile fused (engine, fusedFile.getFile());
+            ClipEffect::ClipEffectRenderJob::Ptr fusedJob = new FusedChunkRenderJob (engine, fused, source, length, std::move (processors));
+            expect (render (*fusedJob));
+
+            expectBuffersMatch (read (engine, fused.getFile()), read (engine, sequential.getFile()), 1.0e-3f);
+
+            for (auto ce : clipEffects->objects)
+                ce->getDestinationFile().deleteFile();
+        }
+
+        engine.getAudioFileManager().releaseAllFiles();
+        edit->getTempDirectory (false).deleteRecursively();
+    }
+
+    static bool render (ClipEffect::ClipEffectRenderJob& job)
+    {
+        if (! job.setUpRender())
+            return false;
+
+        while (! job.renderNextBlock())
+        {}
+
+        return job.completeRender();
+    }
+
+    static juce::AudioBuffer<float> read (Engine& engine, const File& file)
+    {
+        juce::AudioBuffer<float> buffer;
+
+        if (std::unique_ptr<AudioFormatReader> reader { AudioFileUtils::createReaderFor (engine, file) })
+        {
+            buffer.setSize ((int) reader->numChannels, (int) reader->lengthInSamples);
+            reader->read (&buffer, 0, buffer.getNumSamples(), 0, true, true);
+        }
+
+        return buffer;
+    }
+
+    void expectBuffersMatch (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b, float tolerance)
+    {
+        expect (a.getNumSamples() > 0);
+        expectEquals (a.getNumChannels(), b.getNumChannels());
+
+        // The node based renders round their length in seconds so may differ by a sample
+        const int numSamples = jmin (a.getNumSamples(), b.getNumSamples());
+        expectWithinAbsoluteError (a.getNumSamples(), b.getNumSamples(), 1);
+
+        float maxError = 0.0f;
+
+        for (int chan = 0; chan < jmin (a.getNumChannels(), b.getNumChannels()); ++chan)
+            for (int i = 0; i < numSamples; ++i)
+                maxError = jmax (maxError, std::abs (a.getSample (chan, i) - b.getSample (chan, i)));
+
+        expectLessThan (maxError, tolerance);
+    }
+
+    /** Writes a 1s, 220Hz mono sine wave to a temporary wav file. */
+    static std::unique_ptr<TemporaryFile> createSinFile (double sampleRate)
+    {
+        juce::AudioBuffer<float> buffer (1, (int) sampleRate);
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            buffer.setSample (0, i, (float) std::sin (MathConstants<double>::twoPi * 220.0 * i / sampleRate));
+
+        auto f = std::make_unique<TemporaryFile> (".wav");
+
+        if (auto fileStream = f->getFile().createOutputStream())
+        {
+            if (auto writer = std::unique_ptr<AudioFormatWriter> (WavAudioFormat().createWriterFor (fileStream.get(), sampleRate, 1, 16, {}, 0)))
+            {
+                fileStream.release();
+                writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+            }
+        }
+
+        return f;
+    }
+};
+
+static FusedClipEffectTests fusedClipEffectTests;
+
+#endif
+
 }
@@ -56,6 +56,25 @@ public:
     */
     virtual juce::ReferenceCountedObjectPtr<ClipEffectRenderJob> createRenderJob (const AudioFile& sourceFile, double sourceLength) = 0;
 
+    /** A stateless process that can be applied in place to chunks of a source file.
+        Consecutive effects that provide one of these are fused into a single pass that
+        reads the source once and writes only the last effect's file. As no state is kept
+        between calls, chunks may be processed in any order and on several threads at once.
+    */
+    struct ChunkProcessor
+    {
+        virtual ~ChunkProcessor() = default;
+
+        /** Processes a chunk in place. startSample is the position of the chunk in the source. */
+        virtual void process (juce::AudioBuffer<float>&, juce::int64 startSample, double sampleRate) const = 0;
+    };
+
+    /** Effects that can be applied as a ChunkProcessor should return one here, otherwise
+        createRenderJob will be used to render them to their own file.
+        This is called on the message thread so should take a copy of any properties it needs.
+    */
+    virtual std::unique_ptr<ChunkProcessor> createChunkProcessor (double /*sourceLength*/)    { return {}; }
+
     /** Return true here to show a properties button in the editor and enable the propertiesButtonPressed callback. */
     virtual bool hasProperties()                                { return false; }
     virtual void propertiesButtonPressed (SelectionManager&)    {}
@@ -343,6 +362,7 @@ struct VolumeEffect : public ClipEffect,
 {
     VolumeEffect (const juce::ValueTree&, ClipEffects&);
     juce::ReferenceCountedObjectPtr<ClipEffectRenderJob> createRenderJob (const AudioFile& sourceFile, double sourceLength) override;
+    std::unique_ptr<ChunkProcessor> createChunkProcessor (double sourceLength) override;
 
     bool hasProperties() override;
     void propertiesButtonPressed (SelectionManager&) override;
@@ -369,6 +389,7 @@ struct FadeInOutEffect  : public ClipEffect
     void setFadeOut (double);
 
     juce::ReferenceCountedObjectPtr<ClipEffectRenderJob> createRenderJob (const AudioFile& sourceFile, double sourceLength) override;
+    std::unique_ptr<ChunkProcessor> createChunkProcessor (double sourceLength) override;
 
     juce::CachedValue<double> fadeIn, fadeOut;
     juce::CachedValue<AudioFadeCurve::Type> fadeInType, fadeOutType;
@@ -376,6 +397,11 @@ struct FadeInOutEffect  : public ClipEffect
 protected:
     juce::int64 getIndividualHash() const override;
 
+private:
+    struct FadeChunkProcessor;
+
+    EditTimeRange getEffectRangeInSource() const;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FadeInOutEffect)
 };
 
@@ -391,6 +417,7 @@ struct StepVolumeEffect  : public ClipEffect,
     int getMaxNumNotes();
 
     juce::ReferenceCountedObjectPtr<ClipEffectRenderJob> createRenderJob (const AudioFile& sourceFile, double sourceLength) override;
+    std::unique_ptr<ChunkProcessor> createChunkProcessor (double sourceLength) override;
 
     bool hasProperties() override;
     void propertiesButtonPressed (SelectionManager&) override;
@@ -430,6 +457,11 @@ struct StepVolumeEffect  : public ClipEffect,
 protected:
     juce::int64 getIndividualHash() const override;
 
+private:
+    struct StepVolumeChunkProcessor;
+
+    juce::Array<EditTimeRange> getNonMuteTimes();
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StepVolumeEffect)
 };
 
@@ -583,6 +615,7 @@ struct InvertEffect  : public ClipEffect
     InvertEffect (const juce::ValueTree&, ClipEffects&);
 
     juce::ReferenceCountedObjectPtr<ClipEffect::ClipEffectRenderJob> createRenderJob (const AudioFile&, double sourceLength) override;
+    std::unique_ptr<ChunkProcessor> createChunkProcessor (double sourceLength) override;
 
     struct InvertRenderJob;
 
@@ -167,11 +167,22 @@ bool EditRenderJob::completeRender()
 
 //==============================================================================
 EditRenderJob::RenderPass::RenderPass (EditRenderJob& j, Renderer::Parameters& renderParams, const String& description)
-    : owner (j), r (renderParams), desc (description), originalCategory (r.category),
-      tempFile (r.destFile, TemporaryFile::useHiddenFile)
+    : owner (j), r (renderParams), desc (description), originalCategory (r.category)
 {
     r.category = ProjectItem::Category::none;
-    r.destFile = tempFile.getFile();
+
+    // A pass that only writes stems won't have a master file
+    if (r.destFile != File())
+    {
+        tempFile = std::make_unique<TemporaryFile> (r.destFile, TemporaryFile::useHiddenFile);
+        r.destFile = tempFile->getFile();
+    }
+
+    for (auto& stem : r.stems)
+    {
+        auto stemTempFile = stemTempFiles.add (new TemporaryFile (stem.destFile, TemporaryFile::useHiddenFile));
+        stem.destFile = stemTempFile->getFile();
+    }
 }
 
 EditRenderJob::RenderPass::~RenderPass()
@@ -184,34 +195,50 @@ EditRenderJob::RenderPass::~RenderPass()
     if (owner.editDeleter.willDeleteObject())
         callBlocking ([this] { Renderer::turnOffAllPlugins (*r.edit); });
 
+    // swap these back to the originals
+    r.category = originalCategory;
+
+    if (tempFile != nullptr)
+    {
+        r.destFile = tempFile->getTargetFile();
+        finishFile (*tempFile, errorMessage, completedOk);
+    }
+
+    for (int i = 0; i < stemTempFiles.size(); ++i)
+    {
+        r.stems.getReference (i).destFile = stemTempFiles.getUnchecked (i)->getTargetFile();
+        finishFile (*stemTempFiles.getUnchecked (i), errorMessage, completedOk);
+    }
+}
+
+void EditRenderJob::RenderPass::finishFile (TemporaryFile& temp, const String& errorMessage, bool completedOk)
+{
     // overwite with temp file
     if (! errorMessage.isEmpty() && owner.silenceOnBackup)
-        owner.generateSilence (tempFile.getFile());
+        owner.generateSilence (temp.getFile());
 
-    if (tempFile.getFile().existsAsFile() && (completedOk || owner.silenceOnBackup))
-        tempFile.overwriteTargetFileWithTemporary();
+    if (temp.getFile().existsAsFile() && (completedOk || owner.silenceOnBackup))
+        temp.overwriteTargetFileWithTemporary();
     else
-        tempFile.getTargetFile().deleteFile();
+        temp.getTargetFile().deleteFile();
 
-    // swap this back to the original
-    r.destFile = tempFile.getTargetFile();
-    r.category = originalCategory;
+    auto destFile = temp.getTargetFile();
 
     // reverse if needed
     if (owner.reverse)
     {
-        TemporaryFile tempReverseFile (r.destFile);
+        TemporaryFile tempReverseFile (destFile);
 
-        if (r.destFile.existsAsFile())
-            if (AudioFileUtils::reverse (owner.engine, r.destFile, tempReverseFile.getFile(), owner.progress, nullptr))
+        if (destFile.existsAsFile())
+            if (AudioFileUtils::reverse (owner.engine, destFile, tempReverseFile.getFile(), owner.progress, nullptr))
                 if (tempReverseFile.getFile().existsAsFile())
                     tempReverseFile.overwriteTargetFileWithTemporary();
     }
 
-    if (! r.destFile.existsAsFile())
+    if (! destFile.existsAsFile())
         return;
 
-    if (r.category != ProjectItem::Category::none && r.destFile.existsAsFile())
+    if (r.category != ProjectItem::Category::none && destFile.existsAsFile())
     {
         CRASH_TRACER
 
@@ -234,7 +261,7 @@ EditRenderJob::RenderPass::~RenderPass()
             if (! r.createMidiFile && errorMessage.isNotEmpty())
             {
                 ok = false;
-                r.destFile.deleteFile();
+                destFile.deleteFile();
             }
 
             if (ok)
@@ -243,10 +270,10 @@ EditRenderJob::RenderPass::~RenderPass()
                 newItemDesc << TRANS("Rendered from edit") << r.edit->getName().quoted() << " " << TRANS("On") << " "
                             << Time::getCurrentTime().toString (true, true);
 
-                if (auto item = proj->createNewItem (r.destFile,
+                if (auto item = proj->createNewItem (destFile,
                                                      r.createMidiFile ? ProjectItem::midiItemType()
                                                                       : ProjectItem::waveItemType(),
-                                                     r.destFile.getFileNameWithoutExtension().trim(),
+                                                     destFile.getFileNameWithoutExtension().trim(),
                                                      newItemDesc,
                                                      r.category,
                                                      true))
@@ -263,7 +290,7 @@ EditRenderJob::RenderPass::~RenderPass()
     }
 
     // validates the AudioFile by giving it a sample rate etc.
-    owner.engine.getAudioFileManager().checkFileForChangesAsync (AudioFile (owner.engine, r.destFile));
+    owner.engine.getAudioFileManager().checkFileForChangesAsync (AudioFile (owner.engine, destFile));
 }
 
 bool EditRenderJob::RenderPass::initialise()
@@ -278,9 +305,10 @@ bool EditRenderJob::RenderPass::initialise()
                       r.edit->getTransport().stop (false, true);
                   });
 
-    if (r.tracksToDo.countNumberOfSetBits() > 0
-        && r.destFile.hasWriteAccess()
-        && ! r.destFile.isDirectory())
+    const bool hasValidTarget = r.destFile != File() ? (r.destFile.hasWriteAccess() && ! r.destFile.isDirectory())
+                                                     : ! r.stems.isEmpty();
+
+    if (r.tracksToDo.countNumberOfSetBits() > 0 && hasValidTarget)
     {
         AudioNode* node = nullptr;
 
@@ -293,7 +321,7 @@ bool EditRenderJob::RenderPass::initialise()
 
         callBlocking ([this, &node, &cnp]
         {
-            node = createRenderingNodeFromEdit (*r.edit, cnp, r.useMasterPlugins);
+            node = createRenderingNodeFromEdit (*r.edit, cnp, r.useMasterPlugins, r.stems);
         });
 
         if (node != nullptr)
@@ -314,8 +342,18 @@ void EditRenderJob::renderSeparateTracks()
     // 2. Any top-level sub-mix folder tracks
     // 3. Any audio or sub-mix folder tracks contained in Folder tracks (which aren't sub-mix tracks)
     // 4. Only tracks that are contained in the tracksToDo mask
+    //
+    // Unless each file needs normalising or trimming, or the master plugins applying (the
+    // stems are tapped before the master bus), all the tracks are tapped and written as
+    // stems from a single pass through the Edit rather than one pass each.
 
     auto originalTracksToDo = params.tracksToDo;
+    const bool needsPassPerTrack = params.shouldNormalise || params.shouldNormaliseByRMS || params.trimSilenceAtEnds
+                                     || params.useMasterPlugins;
+    juce::BigInteger allStemTracks;
+    juce::Array<Renderer::StemTarget> stems;
+    juce::Array<juce::BigInteger> stemTracksToDo;
+    juce::StringArray stemDescriptions;
 
     for (int i = 0; i <= originalTracksToDo.getHighestBit(); ++i)
     {
@@ -364,12 +402,61 @@ void EditRenderJob::renderSeparateTracks()
                 params.destFile = File (File::createLegalPathName (getNonExistentSiblingWithIncrementedNumberSuffix (trackFile, false).getFullPathName()));
                 params.tracksToDo = tracksToDo;
 
-                if (Renderer::checkTargetFile (track->edit.engine, params.destFile))
+                if (! Renderer::checkTargetFile (track->edit.engine, params.destFile))
+                    continue;
+
+                if (needsPassPerTrack)
+                {
                     renderPasses.add (new RenderPass (*this, params, getDescription()));
+                }
+                else
+                {
+                    allStemTracks |= tracksToDo;
+                    stems.add ({ track, params.destFile });
+                    stemTracksToDo.add (tracksToDo);
+                    stemDescriptions.add (getDescription());
+                }
             }
         }
     }
 
+    // Any tracks that can't be tapped, e.g. ones that feed into another track, get their own pass
+    for (int i = 0; i < stems.size();)
+    {
+        auto& stem = stems.getReference (i);
+
+        if (Renderer::canRenderAsStem (*params.edit, allStemTracks, *stem.track))
+        {
+            ++i;
+            continue;
+        }
+
+        params.destFile = stem.destFile;
+        params.tracksToDo = stemTracksToDo[i];
+        renderPasses.add (new RenderPass (*this, params, stemDescriptions[i]));
+
+        stems.remove (i);
+        stemTracksToDo.remove (i);
+        stemDescriptions.remove (i);
+    }
+
+    allStemTracks.clear();
+
+    for (auto& tracksToDo : stemTracksToDo)
+        allStemTracks |= tracksToDo;
+
+    if (! stems.isEmpty())
+    {
+        params.destFile = {};
+        params.tracksToDo = allStemTracks;
+        params.stems = stems;
+
+        renderPasses.add (new RenderPass (*this, params, TRANS("Rendering Tracks") + "..."));
+
+        params.destFile = stems.getLast().destFile;
+        params.stems.clear();
+    }
+
     params.tracksToDo = originalTracksToDo;
 }
 
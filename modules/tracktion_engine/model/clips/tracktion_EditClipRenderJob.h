@@ -73,12 +73,14 @@ private:
         ~RenderPass();
 
         bool initialise();
+        void finishFile (juce::TemporaryFile&, const juce::String& errorMessage, bool completedOk);
 
         EditRenderJob& owner;
         Renderer::Parameters r;
         const juce::String desc;
         ProjectItem::Category originalCategory;
-        juce::TemporaryFile tempFile;
+        std::unique_ptr<juce::TemporaryFile> tempFile;
+        juce::OwnedArray<juce::TemporaryFile> stemTempFiles;
         std::unique_ptr<Renderer::RenderTask> task;
     };
 
@@ -247,18 +247,50 @@ bool MidiClip::usesGrooveStrength() const
 AudioNode* MidiClip::createAudioNode (const CreateAudioNodeParams& params)
 {
     CRASH_TRACER
-    MidiMessageSequence sequence;
-    getSequenceLooped().exportToPlaybackMidiSequence (sequence, *this, mpeMode);
-
     const auto nodeToReplace = getClipIfPresentInNode (params.audioNodeToBeReplaced, *this);
 
     auto channels = mpeMode ? Range<int> (2, 15)
                             : Range<int>::withStartAndLength (getMidiChannel().getChannelNumber(), 1);
 
-    return new MidiAudioNode (std::move (sequence), channels, getEditTimeRange(),
+    return new MidiAudioNode (getCompiledSequence(), edit.tempoSequence.getTempoSections(), channels, getEditTimeRange(),
                               volumeDb, mute, *this, nodeToReplace);
 }
 
+CompiledMidiSequence::Ptr MidiClip::getCompiledSequence()
+{
+    CRASH_TRACER
+    TRACKTION_ASSERT_MESSAGE_THREAD
+    auto& ts = edit.tempoSequence;
+
+    CompiledSequenceKey key;
+    key.position = getPosition();
+    key.tempoChangeCount = ts.getTempoSections().getChangeCount();
+    auto& grooveManager = edit.engine.getGrooveTemplateManager();
+    key.grooveTemplate = grooveManager.getTemplateByName (grooveTemplate);
+    key.grooveTemplateChangeCount = grooveManager.getChangeCount(); // an edited template can reuse the old one's address
+    key.sendBankChange = sendBankChange;
+
+    // When only the selected events are being played the sequence is a one-off so isn't cached
+    const bool canUseCache = selectedEvents == nullptr;
+
+    if (canUseCache && compiledSequence != nullptr && key == compiledSequenceKey)
+        return compiledSequence;
+
+    // The node plays the sequence in beats from the start of the clip
+    MidiMessageSequence sequence;
+    getSequenceLooped().exportToPlaybackMidiSequence (sequence, *this, mpeMode, true);
+
+    auto compiled = CompiledMidiSequence::create (std::move (sequence));
+
+    if (canUseCache)
+    {
+        compiledSequence = compiled;
+        compiledSequenceKey = key;
+    }
+
+    return compiled;
+}
+
 MidiList& MidiClip::getSequence() const noexcept
 {
     if (! hasValidSequence())
@@ -846,6 +878,7 @@ void MidiClip::valueTreeChildRemoved (ValueTree& p, juce::ValueTree& c, int)
 void MidiClip::clearCachedLoopSequence()
 {
     cachedLoopedSequence = nullptr;
+    compiledSequence = nullptr;
     changed();
 }
 
@@ -35,6 +35,13 @@ public:
     MidiList& getSequenceLooped();
     std::unique_ptr<MidiList> createSequenceLooped (MidiList& sourceSequence);
 
+    /** Returns the sequence this clip plays, timestamped in beats from the start of the
+        clip, ready to be handed to a MidiAudioNode.
+        This is cached until the clip's contents, position or the tempo change, so
+        rebuilding the playback graph doesn't have to re-export unchanged clips.
+    */
+    CompiledMidiSequence::Ptr getCompiledSequence();
+
     const SelectedMidiEvents* getSelectedEvents() const             { return selectedEvents; }
 
     void scaleVerticallyToFit();
@@ -171,6 +178,26 @@ private:
     SelectedMidiEvents* selectedEvents = nullptr;
 
     mutable std::unique_ptr<MidiList> cachedLoopedSequence;
+
+    struct CompiledSequenceKey
+    {
+        ClipPosition position;
+        juce::uint32 tempoChangeCount = 0;
+        const GrooveTemplate* grooveTemplate = nullptr;
+        juce::uint32 grooveTemplateChangeCount = 0;
+        bool sendBankChange = false;
+
+        bool operator== (const CompiledSequenceKey& other) const
+        {
+            return position == other.position && tempoChangeCount == other.tempoChangeCount
+                    && grooveTemplate == other.grooveTemplate
+                    && grooveTemplateChangeCount == other.grooveTemplateChangeCount
+                    && sendBankChange == other.sendBankChange;
+        }
+    };
+
+    CompiledMidiSequence::Ptr compiledSequence;
+    CompiledSequenceKey compiledSequenceKey;
     MidiCompManager::Ptr midiCompManager;
 
     //==============================================================================
@@ -400,9 +400,12 @@ AudioNode* StepClip::createAudioNode (const CreateAudioNodeParams& params)
 {
     CRASH_TRACER
     MidiMessageSequence sequence;
-    generateMidiSequence (sequence);
+    generateMidiSequence (sequence, false);
 
-    return new MidiAudioNode (std::move (sequence), { 1, 16 }, getEditTimeRange(), volumeDb, mute, *this,
+    // Beat sequences are generated in Edit beats, the node wants them from the clip start
+    sequence.addTimeToMessages (-edit.tempoSequence.timeToBeats (getPosition().getStart()));
+
+    return new MidiAudioNode (std::move (sequence), edit.tempoSequence.getTempoSections(), { 1, 16 }, getEditTimeRange(), volumeDb, mute, *this,
                               getClipIfPresentInNode (params.audioNodeToBeReplaced, *this));
 }
 
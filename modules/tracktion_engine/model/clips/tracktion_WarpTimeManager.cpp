@@ -22,207 +22,6 @@ inline int64 hashDouble (double d) noexcept
 
 int64 WarpMarker::getHash() const noexcept    { return hashDouble (sourceTime) ^ hashDouble (warpTime); }
 
-template <typename FloatingPointType>
-struct Differentiator
-{
-    void process (const FloatingPointType* inputSamples, int numSamples, FloatingPointType* outputSamples)
-    {
-        for (int i = 0; i < numSamples; ++i)
-        {
-            FloatingPointType currentSample = inputSamples[i];
-            outputSamples[i] = currentSample - lastSample;
-            lastSample = currentSample;
-        }
-    }
-
-    FloatingPointType lastSample { (FloatingPointType) 0.0 };
-};
-
-//==============================================================================
-struct TransientDetectionJob  : public RenderManager::Job
-{
-    struct Config
-    {
-        float sensitivity;
-    };
-
-    static Ptr getOrCreateDetectionJob (Engine& e, const AudioFile& file, Config config)
-    {
-        auto jobs = e.getRenderManager().getRenderJobsWithoutCreating (file);
-
-        for (auto j : jobs)
-            if (auto tdj = dynamic_cast<TransientDetectionJob*> (j))
-                if (tdj->isIdenticalTo (file, config))
-                    return j;
-
-        return new TransientDetectionJob (e, file, config);
-    }
-
-    bool isIdenticalTo (const AudioFile& f, Config c)
-    {
-        return file == f && config.sensitivity == c.sensitivity;
-    }
-
-    Array<double> getTimes() const                  { return transientTimes; }
-
-protected:
-    bool setUpRender() override                     { return reader != nullptr && totalNumSamples > 0; }
-
-    bool completeRender() override
-    {
-        if (transientTimes.size() > 1)
-        {
-            auto trimTransients = [this]() -> bool
-            {
-                const double minTime = 0.1;
-                double lastTime = transientTimes.getLast();
-                const int initialSize = transientTimes.size();
-
-                for (int i = transientTimes.size() - 1; --i >= 0;)
-                {
-                    const double t = transientTimes.getUnchecked (i);
-
-                    if ((lastTime - t) < minTime)
-                        transientTimes.remove (i);
-                    else
-                        lastTime = t;
-                }
-
-                return initialSize != transientTimes.size();
-            };
-
-            for (int i = 10; --i >= 0;)
-                if (! trimTransients())
-                    break;
-        }
-
-        return true;
-    }
-
-    bool renderNextBlock() override
-    {
-        CRASH_TRACER
-        const int64 numLeft = totalNumSamples - numSamplesRead;
-        const int numToDo = (int) jmin ((int64) 32768, numLeft);
-
-        AudioScratchBuffer scratch (numChannels, numToDo);
-        AudioChannelSet schannels = AudioChannelSet::canonicalChannelSet(numChannels);
-        reader->readSamples (numToDo, scratch.buffer, schannels, 0, AudioChannelSet::stereo(), 5000);
-
-        if (findingNormaliseLevel)
-            processNextNormaliseBuffer (scratch.buffer);
-        else
-            processNextBuffer (scratch.buffer);
-
-        numSamplesRead += numToDo;
-        progress = (numSamplesRead / (float) totalNumSamples)
-            * (findingNormaliseLevel ? 0.5f : 1.0f);
-
-        if (findingNormaliseLevel && numSamplesRead >= totalNumSamples)
-        {
-            const float peak = jmax (std::abs (fileMinMax.getStart()), std::abs (fileMinMax.getEnd()));
-            normaliseScale = peak > 0.0f ? 1.0f / peak : 1.0f;
-            reader->setReadPosition (0);
-            numSamplesRead = 0;
-            findingNormaliseLevel = false;
-        }
-
-        return ! findingNormaliseLevel && numSamplesRead >= totalNumSamples;
-    }
-
-private:
-    AudioFile file;
-    Config config;
-
-    int64 numSamplesRead = 0, totalNumSamples;
-    int numChannels;
-    double sampleRate = 0;
-    AudioFileCache::Reader::Ptr reader;
-
-    AudioFileUtils::EnvelopeFollower envelopeFollower[3];
-    Differentiator<float> differentiator;
-    Array<double> transientTimes;
-
-    Range<float> fileMinMax;
-    float normaliseScale = -1.0f;
-    const float thresh = Decibels::decibelsToGain (-25.0f);
-    int triggerTimer = 0;
-    int countDownTimer = 0;
-    bool findingNormaliseLevel = true;
-
-    TransientDetectionJob (Engine& e, const AudioFile& af, Config c)
-        : Job (e, AudioFile (e)), file (af), config (c),
-          totalNumSamples (af.getLengthInSamples()),
-          numChannels (af.getNumChannels()),
-          reader (e.getAudioFileManager().cache.createReader (af))
-    {
-        TRACKTION_ASSERT_MESSAGE_THREAD
-        // N.B. The argumnet to the Job constructor is the proxy file to use
-        // Don't send the audio file here or it will get deleted!
-        jassert (proxy.isNull());
-
-        if (reader != nullptr)
-            sampleRate = reader->getSampleRate();
-
-        triggerTimer = int (sampleRate * 50 * 0.001); // 50ms - should be linked to BPM
-        envelopeFollower[0].setCoefficients (1.0, 0.002f);
-        envelopeFollower[1].setCoefficients (1.0, 0.002f);
-        envelopeFollower[2].setCoefficients (1.0, 0.002f);
-    }
-
-    void processNextNormaliseBuffer (const juce::AudioBuffer<float>& buffer)
-    {
-        fileMinMax = fileMinMax.getUnionWith (FloatVectorOperations::findMinAndMax (buffer.getReadPointer (0), buffer.getNumSamples()));
-    }
-
-    void processNextBuffer (const juce::AudioBuffer<float>& buffer)
-    {
-        const int numSamples = buffer.getNumSamples();
-        AudioScratchBuffer scratch (1, numSamples);
-        auto& detectionBuffer = scratch.buffer;
-
-        detectionBuffer.copyFrom (0, 0, buffer, 0, 0, numSamples);
-        detectionBuffer.applyGain (0, 0, numSamples, normaliseScale);
-        float* data = detectionBuffer.getWritePointer (0);
-
-        envelopeFollower[0].processEnvelope (data, data, numSamples);
-        envelopeFollower[1].processEnvelope (data, data, numSamples);
-
-        differentiator.process (data, numSamples, data);
-        envelopeFollower[2].processEnvelope (data, data, numSamples);
-
-        for (int i = 0; i < numSamples; i++)
-        {
-            const float sample = *data++;
-
-            if (countDownTimer)
-                countDownTimer--;
-
-            if (sample > thresh)
-            {
-                if (countDownTimer == 0)
-                {
-                    int rewindIndex = int (i - sampleRate * 0.0005); //rewind by 0.05ms
-
-                    if (rewindIndex < 0)
-                        rewindIndex = 0;
-
-                    transientTimes.add (sampleToSeconds (numSamplesRead + rewindIndex));
-                }
-
-                countDownTimer = triggerTimer;
-            }
-        }
-    }
-
-    double sampleToSeconds (int64 sample) const
-    {
-        return sampleRate > 0.0 ? sample / sampleRate : 0.0;
-    }
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TransientDetectionJob)
-};
-
 //==============================================================================
 WarpTimeManager::WarpTimeManager (AudioClipBase& c)
     : edit (c.edit), clip (&c), sourceFile (c.edit.engine)
@@ -260,10 +59,9 @@ WarpTimeManager::WarpTimeManager (Edit& e, const AudioFile& f, ValueTree parentT
 
 WarpTimeManager::~WarpTimeManager()
 {
-    if (transientDetectionJob != nullptr)
-        transientDetectionJob->removeListener (this);
+    if (auto analysisCache = analysisCacheListenedTo.get())
+        analysisCache->removeListener (this);
 
-    transientDetectionJob = nullptr;
     edit.engine.getWarpTimeFactory().removeWarpTimeManager (*this);
 }
 
@@ -549,12 +347,20 @@ double WarpTimeManager::getWarpEndMarkerTime() const
 
 void WarpTimeManager::editFinishedLoading()
 {
-    TransientDetectionJob::Config config;
-    config.sensitivity = 0.5f;
-    transientDetectionJob = TransientDetectionJob::getOrCreateDetectionJob (edit.engine, getSourceFile(), config);
+    auto& analysisCache = edit.engine.getAudioFileAnalysisCache();
+    auto file = getSourceFile();
+    AudioFileAnalysisCache::Result result;
 
-    if (transientDetectionJob != nullptr)
-        transientDetectionJob->addListener (this);
+    if (analysisCache.getCachedResult (file, result))
+    {
+        transientTimes = { true, result.onsetTimes };
+    }
+    else
+    {
+        analysisCache.addListener (this);
+        analysisCacheListenedTo = &analysisCache;
+        analysisCache.analyseFileAsync (file);
+    }
 
     editLoadedCallback = nullptr;
 }
@@ -564,16 +370,19 @@ UndoManager* WarpTimeManager::getUndoManager() const
     return &edit.getUndoManager();
 }
 
-void WarpTimeManager::jobFinished (RenderManager::Job& job, bool /*completedOk*/)
+void WarpTimeManager::analysisFinished (const AudioFile& file, const AudioFileAnalysisCache::Result& result)
 {
-    if (auto tdj = dynamic_cast<TransientDetectionJob*> (&job))
-    {
-        transientTimes.second = tdj->getTimes();
-        transientTimes.first = true;
-    }
+    if (file != getSourceFile())
+        return;
+
+    // Failed analyses aren't cached, so leave the transients unknown and it'll be retried next time it's asked for
+    if (result.wasAnalysed)
+        transientTimes = { true, result.onsetTimes };
+
+    if (auto analysisCache = analysisCacheListenedTo.get())
+        analysisCache->removeListener (this);
 
-    job.removeListener (this);
-    transientDetectionJob = nullptr;
+    analysisCacheListenedTo = nullptr;
 }
 
 //==============================================================================
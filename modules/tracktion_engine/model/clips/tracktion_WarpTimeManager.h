@@ -43,7 +43,7 @@ struct WarpMarker
 /**
 */
 class WarpTimeManager : public juce::SingleThreadedReferenceCountedObject,
-                        public RenderManager::Job::Listener
+                        private AudioFileAnalysisCache::Listener
 {
 public:
     using Ptr = juce::ReferenceCountedObjectPtr<WarpTimeManager>;
@@ -140,12 +140,14 @@ private:
     bool endMarkerEnabled = true, endMarkersLimited = false;
 
     std::unique_ptr<WarpMarkerList> markers;
-    RenderManager::Job::Ptr transientDetectionJob;
     std::pair<bool, juce::Array<double>> transientTimes { false, {} };
     std::unique_ptr<Edit::LoadFinishedCallback<WarpTimeManager>> editLoadedCallback;
 
+    // The cache this is waiting on, which may be deleted first when the Engine shuts down
+    juce::WeakReference<AudioFileAnalysisCache> analysisCacheListenedTo;
+
     juce::UndoManager* getUndoManager() const;
-    void jobFinished (RenderManager::Job& job, bool completedOk) override;
+    void analysisFinished (const AudioFile&, const AudioFileAnalysisCache::Result&) override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WarpTimeManager)
 };
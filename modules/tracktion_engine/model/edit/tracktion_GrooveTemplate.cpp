@@ -191,6 +191,8 @@ GrooveTemplateManager::GrooveTemplateManager (Engine& e)
 //==============================================================================
 void GrooveTemplateManager::useParameterizedGrooves (bool use)
 {
+    // Every change to the templates ends up here
+    ++changeCount;
 	activeGrooves.clear();
 
 	useParameterized = use;
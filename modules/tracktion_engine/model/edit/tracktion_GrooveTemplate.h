@@ -94,6 +94,12 @@ public:
     /** called when usersettings change, because that's where the grooves are kept. */
     void reload();
 
+    /** Returns a number that changes whenever templates are loaded, edited or removed,
+        so anything cached from a template can tell when it's out of date.
+        The pointers returned by getTemplate() may have been reused when this changes.
+    */
+    juce::uint32 getChangeCount() const noexcept        { return changeCount; }
+
 private:
     //==============================================================================
     Engine& engine;
@@ -105,6 +111,7 @@ private:
     void reload (const juce::XmlElement*);
 
 	bool useParameterized = false;
+    juce::uint32 changeCount = 0;
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GrooveTemplateManager)
 };
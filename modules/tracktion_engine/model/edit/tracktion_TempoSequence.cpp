@@ -106,6 +106,18 @@ struct TempoSequence::TimeSigList  : public TempoAndTimeSigListBase<TimeSigSetti
 };
 
 //==============================================================================
+TempoSequence::TempoSections::TempoSections (const TempoSections& other)
+    : changeCounter (other.changeCounter), tempos (other.tempos)
+{
+}
+
+TempoSequence::TempoSections& TempoSequence::TempoSections::operator= (const TempoSections& other)
+{
+    changeCounter = other.changeCounter;
+    tempos = other.tempos;
+    return *this;
+}
+
 int TempoSequence::TempoSections::size() const
 {
     return tempos.size();
@@ -118,6 +130,7 @@ const TempoSequence::SectionDetails& TempoSequence::TempoSections::getReference
 
 void TempoSequence::TempoSections::swapWith (juce::Array<SectionDetails>& newTempos)
 {
+    const juce::SpinLock::ScopedLockType sl (lock);
     ++changeCounter;
     tempos.swapWith (newTempos);
 }
@@ -118,6 +118,10 @@ public:
 
     struct TempoSections
     {
+        TempoSections() = default;
+        TempoSections (const TempoSections&);
+        TempoSections& operator= (const TempoSections&);
+
         int size() const;
         const SectionDetails& getReference (int i) const;
 
@@ -130,9 +134,15 @@ public:
         /** Compare to cheaply determine if any changes have been made. */
         juce::uint32 getChangeCount() const;
 
+        /** The lock that's held while the sections are swapped. The message thread can read
+            them without it, but other threads, e.g. offline renders, need to hold it.
+        */
+        juce::SpinLock& getLock() const noexcept        { return lock; }
+
     private:
         juce::uint32 changeCounter = 0;
         juce::Array<SectionDetails> tempos;
+        mutable juce::SpinLock lock;
     };
 
     const TempoSections& getTempoSections() { return internalTempos; }
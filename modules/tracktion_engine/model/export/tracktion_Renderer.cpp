@@ -102,6 +102,120 @@ static Plugin::Array findAllPlugins (AudioNode& node)
     return plugins;
 }
 
+//==============================================================================
+/** Passes its input through but keeps a copy of each block so that a track's
+    output can be written to its own file at the same time as the master.
+*/
+class StemTapAudioNode  : public SingleInputAudioNode
+{
+public:
+    StemTapAudioNode (AudioNode* sourceNode, Track& t)
+        : SingleInputAudioNode (sourceNode), track (t)
+    {
+    }
+
+    void setBufferSize (int numChannels, int numSamples)
+    {
+        buffer.setSize (numChannels, numSamples);
+        buffer.clear();
+    }
+
+    juce::AudioBuffer<float>& getBuffer() noexcept                  { return buffer; }
+
+    void prepareForNextBlock (const AudioRenderContext& rc) override
+    {
+        buffer.clear();
+        SingleInputAudioNode::prepareForNextBlock (rc);
+    }
+
+    void renderOver (const AudioRenderContext& rc) override
+    {
+        input->renderOver (rc);
+
+        if (rc.destBuffer != nullptr)
+            capture (*rc.destBuffer, rc.bufferStartSample, rc.bufferStartSample, rc.bufferNumSamples);
+    }
+
+    void renderAdding (const AudioRenderContext& rc) override
+    {
+        if (rc.destBuffer == nullptr)
+            return input->renderAdding (rc);
+
+        AudioScratchBuffer scratch (rc.destBuffer->getNumChannels(), rc.bufferNumSamples);
+
+        AudioRenderContext rc2 (rc);
+        rc2.destBuffer = &scratch.buffer;
+        rc2.bufferStartSample = 0;
+
+        input->renderOver (rc2);
+        capture (scratch.buffer, 0, rc.bufferStartSample, rc.bufferNumSamples);
+
+        for (int i = rc.destBuffer->getNumChannels(); --i >= 0;)
+            rc.destBuffer->addFrom (i, rc.bufferStartSample, scratch.buffer, i, 0, rc.bufferNumSamples);
+    }
+
+    Track& track;
+
+private:
+    juce::AudioBuffer<float> buffer;
+
+    void capture (const juce::AudioBuffer<float>& source, int sourceStart, int destStart, int numSamples)
+    {
+        numSamples = jmin (numSamples, buffer.getNumSamples() - destStart);
+
+        for (int i = jmin (buffer.getNumChannels(), source.getNumChannels()); --i >= 0;)
+            buffer.copyFrom (i, destStart, source, i, sourceStart, numSamples);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StemTapAudioNode)
+};
+
+/** Writes a StemTapAudioNode's output to a file on a background thread. */
+struct StemWriter
+{
+    StemWriter (StemTapAudioNode& t, std::unique_ptr<AudioFormatWriter> w, const File& f,
+                TimeSliceThread& thread, int numChannels, int bitDepth, int64 maxNumSamples)
+        : tap (t), file (f),
+          writer (std::make_unique<AudioFormatWriter::ThreadedWriter> (w.release(), thread, 1 << 18)),
+          ditherers (numChannels, bitDepth),
+          samplesLeft (maxNumSamples)
+    {
+    }
+
+    /** Returns false if the job was cancelled before the block could be written. */
+    bool writeBlock (int numSamples, bool applyDither, const ThreadPoolJob& job)
+    {
+        if (samplesLeft >= 0)
+        {
+            numSamples = (int) jmin ((int64) numSamples, samplesLeft);
+            samplesLeft -= numSamples;
+
+            if (numSamples == 0)
+                return true;
+        }
+
+        if (applyDither)
+            ditherers.apply (tap.getBuffer(), numSamples);
+
+        // If the disk can't keep up, wait for the writer thread to catch up
+        while (! writer->write (tap.getBuffer().getArrayOfReadPointers(), numSamples))
+        {
+            if (job.shouldExit())
+                return false;
+
+            Thread::sleep (1);
+        }
+
+        return true;
+    }
+
+    StemTapAudioNode& tap;
+    const File file;
+    std::unique_ptr<AudioFormatWriter::ThreadedWriter> writer;
+    Ditherers ditherers;
+    int64 samplesLeft; // or -1 to write everything
+};
+
 //==============================================================================
 Renderer::RenderTask::RenderTask (const String& taskDescription, const Renderer::Parameters& rp, AudioNode* n)
    : ThreadPoolJobWithProgress (taskDescription),
@@ -173,6 +287,10 @@ struct Renderer::RenderTask::RendererContext
             r.shouldNormaliseByRMS = false;
         }
 
+        // Offline renders don't have to match the device, so use bigger blocks to cut the per-block overhead
+        if (r.offlineRender)
+            r.blockSizeForAudio = Renderer::offlineBlockSize;
+
         node->purgeSubNodes (true, false);
 
         numOutputChans = 2;
@@ -253,7 +371,10 @@ struct Renderer::RenderTask::RendererContext
             node->prepareAudioNodeToPlay (info);
         }
 
-        flushAllPlugins (localPlayhead, plugins, r.sampleRateForAudio, r.blockSizeForAudio);
+        flushAllPlugins (localPlayhead, plugins, r.sampleRateForAudio, r.blockSizeForAudio, r.offlineRender);
+
+        if (! createStemWriters())
+            return;
 
         samplesTrimmed = 0;
         hasStartedSavingToFile = ! r.trimSilenceAtEnds;
@@ -286,6 +407,10 @@ struct Renderer::RenderTask::RendererContext
         if (writer != nullptr)
             writer->closeForWriting();
 
+        // Deleting these flushes any remaining data to disk
+        stemWriters.clear();
+        stemWriterThread.stopThread (10000);
+
         if (node != nullptr)
             callBlocking ([this] { node->releaseAudioNodeResources(); });
 
@@ -302,6 +427,9 @@ struct Renderer::RenderTask::RendererContext
     Plugin::Array plugins;
     Result status;
 
+    TimeSliceThread stemWriterThread { "Stem Writer" };
+    OwnedArray<StemWriter> stemWriters;
+
     PlayHead localPlayhead;
     Ditherers ditherers;
     juce::AudioBuffer<float> renderingBuffer;
@@ -332,6 +460,68 @@ struct Renderer::RenderTask::RendererContext
     std::unique_ptr<TemporaryFile> intermediateFile;
     AudioFormatWriter::ThreadedWriter::IncomingDataReceiver* sourceToUpdate;
 
+    bool createStemWriters()
+    {
+        if (r.stems.isEmpty())
+            return true;
+
+        Array<StemTapAudioNode*> taps;
+
+        node->visitNodes ([&] (AudioNode& n)
+                          {
+                              if (auto tap = dynamic_cast<StemTapAudioNode*> (&n))
+                                  taps.add (tap);
+                          });
+
+        for (auto& stem : r.stems)
+        {
+            auto tap = std::find_if (taps.begin(), taps.end(),
+                                     [&stem] (StemTapAudioNode* t) { return &t->track == stem.track; });
+
+            // The track is mixed into something else before it reaches the master, or isn't
+            // being rendered at all, so writing nothing would silently lose the stem
+            if (tap == taps.end())
+            {
+                status = Result::fail (TRANS("Couldn't render track XTRKX in the same pass as the other tracks")
+                                         .replace ("XTRKX", stem.track != nullptr ? stem.track->getName().quoted() : String()));
+                deleteStemFiles();
+                return false;
+            }
+
+            // Use the original format as the master may be going to an intermediate file
+            std::unique_ptr<AudioFormatWriter> w (AudioFileUtils::createWriterFor (originalParams.audioFormat,
+                                                                                   stem.destFile, r.sampleRateForAudio,
+                                                                                   (unsigned int) numOutputChans, r.bitDepth,
+                                                                                   r.metadata, r.quality));
+
+            if (w == nullptr)
+            {
+                status = Result::fail (TRANS("Couldn't write to target file") + ": " + stem.destFile.getFileName());
+                deleteStemFiles();
+                return false;
+            }
+
+            (*tap)->setBufferSize (numOutputChans, renderingBuffer.getNumSamples());
+            const auto maxNumSamples = stem.length > 0 ? (int64) (stem.length * r.sampleRateForAudio + 0.5) : (int64) -1;
+            stemWriters.add (new StemWriter (**tap, std::move (w), stem.destFile, stemWriterThread,
+                                             numOutputChans, r.bitDepth, maxNumSamples));
+        }
+
+        stemWriterThread.startThread();
+        return true;
+    }
+
+    void deleteStemFiles()
+    {
+        for (auto stem : stemWriters)
+        {
+            stem->writer.reset();
+            stem->file.deleteFile();
+        }
+
+        stemWriters.clear();
+    }
+
     /** Returns the opening status of the render.
         If somthing went wrong during set-up this will contain the error message to display.
     */
@@ -343,7 +533,7 @@ struct Renderer::RenderTask::RendererContext
         CRASH_TRACER
         jassert (! r.edit->getTransport().isPlayContextActive());
 
-        if (--sleepCounter <= 0)
+        if (! r.offlineRender && --sleepCounter <= 0)
         {
             sleepCounter = sleepCounterMax;
             Thread::sleep (1);
@@ -356,6 +546,8 @@ struct Renderer::RenderTask::RendererContext
             writer->closeForWriting();
             r.destFile.deleteFile();
 
+            deleteStemFiles();
+
             localPlayhead.stop();
             setAllPluginsRealtime (plugins, true);
 
@@ -448,13 +640,18 @@ struct Renderer::RenderTask::RendererContext
                 sourceToUpdate->addBlock (samplesDone, buffer, 0, numSamplesDone);
             }
 
+            if (numSamplesDone > 0)
+                for (auto stem : stemWriters)
+                    if (! stem->writeBlock (numSamplesDone, r.ditheringEnabled && r.bitDepth < 32, owner))
+                        return false;
+
             // NB buffer gets trashed by this call
             if (numSamplesDone > 0 && hasStartedSavingToFile
                  && writer->isOpen()
                  && ! writer->appendBuffer (renderingBuffer, numSamplesDone))
                 return true;
         }
-        else
+        else if (! r.offlineRender)
         {
             // for the pre-count blocks, sleep to give things a chance to get going
             Thread::sleep ((int) (blockLength * 1000));
@@ -576,47 +773,77 @@ bool Renderer::RenderTask::renderAudio (Renderer::Parameters& r)
 
     context = nullptr;
     progress = 1.0f;
-    Thread::sleep (150); // no idea why this is here..
+
+    if (! r.offlineRender)
+        Thread::sleep (150); // no idea why this is here..
 
     return true;
 }
 
-void Renderer::RenderTask::flushAllPlugins (PlayHead& playhead, const Plugin::Array& plugins,
-                                            double sampleRate, int samplesPerBlock)
+static void flushPlugin (ExternalPlugin& ep, PlayHead& playhead, double sampleRate, int samplesPerBlock)
 {
     CRASH_TRACER
-    juce::AudioBuffer<float> buffer (1, samplesPerBlock);
+    ep.reset();
+
+    if (ep.getNumInputs() == 0 && ep.getNumOutputs() == 0)
+        return;
+
+    juce::AudioBuffer<float> buffer (jmax (ep.getNumInputs(), ep.getNumOutputs()), samplesPerBlock);
+    const AudioChannelSet channels = AudioChannelSet::canonicalChannelSet (buffer.getNumChannels());
 
-    for (int i = 0; i < plugins.size(); ++i)
+    auto blockLength = samplesPerBlock / (double) sampleRate;
+    auto blocks = (int) (20 / blockLength + 1);
+
+    for (int j = 0; j < blocks; j++)
     {
-        if (auto ep = dynamic_cast<ExternalPlugin*> (plugins.getUnchecked (i).get()))
-        {
+        buffer.clear();
+
+        ep.applyToBuffer (AudioRenderContext (playhead,
+                                              { -1.0, samplesPerBlock / sampleRate - 1.0 },
+                                              &buffer, channels, 0, samplesPerBlock,
+                                              nullptr, 0, true, true));
+
+        if (isAudioDataAlmostSilent (buffer.getReadPointer (0), samplesPerBlock))
+            break;
+    }
+}
+
+void Renderer::RenderTask::flushAllPlugins (PlayHead& playhead, const Plugin::Array& plugins,
+                                            double sampleRate, int samplesPerBlock, bool inParallel)
+{
+    CRASH_TRACER
+    Array<ExternalPlugin*> pluginsToFlush;
+
+    for (auto p : plugins)
+        if (auto ep = dynamic_cast<ExternalPlugin*> (p))
             if (! ep->baseClassNeedsInitialising() && ep->isEnabled())
-            {
-                ep->reset();
+                pluginsToFlush.add (ep);
 
-                if (ep->getNumInputs() == 0 && ep->getNumOutputs() == 0)
-                    continue;
+    if (! inParallel || pluginsToFlush.size() < 2)
+    {
+        for (auto ep : pluginsToFlush)
+            flushPlugin (*ep, playhead, sampleRate, samplesPerBlock);
 
-                auto blockLength = samplesPerBlock / (double) sampleRate;
-                auto blocks = (int) (20 / blockLength + 1);
+        return;
+    }
 
-                for (int j = 0; j < blocks; j++)
-                {
-                    buffer.setSize (jmax (ep->getNumInputs(), ep->getNumOutputs()), samplesPerBlock);
-                    buffer.clear();
-                    const AudioChannelSet channels = AudioChannelSet::canonicalChannelSet (buffer.getNumChannels());
+    // Each plugin is independent here so they can be run until their tails are silent
+    // in parallel, in batches of one per CPU
+    const int numThreads = jmax (1, SystemStats::getNumCpus());
 
-                    ep->applyToBuffer (AudioRenderContext (playhead,
-                                                           { -1.0, samplesPerBlock / sampleRate - 1.0 },
-                                                           &buffer, channels, 0, samplesPerBlock,
-                                                           nullptr, 0, true, true));
+    for (int start = 0; start < pluginsToFlush.size(); start += numThreads)
+    {
+        std::vector<std::future<void>> flushes;
 
-                    if (isAudioDataAlmostSilent (buffer.getReadPointer (0), samplesPerBlock))
-                        break;
-                }
-            }
-        }
+        for (int i = start; i < jmin (start + numThreads, pluginsToFlush.size()); ++i)
+            flushes.push_back (std::async (std::launch::async, [ep = pluginsToFlush.getUnchecked (i), &playhead, sampleRate, samplesPerBlock]
+                                           {
+                                               FloatVectorOperations::disableDenormalisedNumberSupport();
+                                               flushPlugin (*ep, playhead, sampleRate, samplesPerBlock);
+                                           }));
+
+        for (auto& f : flushes)
+            f.wait();
     }
 }
 
@@ -776,13 +1003,23 @@ bool Renderer::RenderTask::renderMidi (Renderer::Parameters& r)
 //==============================================================================
 static AudioNode* createRenderingNodeFromEdit (Edit& edit,
                                                const CreateAudioNodeParams& params,
-                                               bool includeMasterPlugins)
+                                               bool includeMasterPlugins,
+                                               const Array<Renderer::StemTarget>& stems = {})
 {
     CRASH_TRACER
     MixerAudioNode* mixer = nullptr;
 
     const auto allTracks = getAllTracks (edit);
 
+    auto addStemTapIfNeeded = [&stems] (Track& track, AudioNode* n) -> AudioNode*
+    {
+        for (auto& stem : stems)
+            if (stem.track == &track)
+                return new StemTapAudioNode (n, track);
+
+        return n;
+    };
+
     Array<Track*> sidechainSourceTracks;
     Array<AudioTrack*> tracksToBeRendered;
 
@@ -811,7 +1048,7 @@ static AudioNode* createRenderingNodeFromEdit (Edit& edit,
                     auto trackNode = at->createAudioNode (params);
 
                     trackNode = new TrackMutingAudioNode (*at, trackNode, false);
-                    mixer->addInput (trackNode);
+                    mixer->addInput (addStemTapIfNeeded (*at, trackNode));
 
                     // find an tracks required to feed sidechains
                     Array<AudioTrack*> todo;
@@ -841,7 +1078,7 @@ static AudioNode* createRenderingNodeFromEdit (Edit& edit,
                     if (mixer == nullptr)
                         mixer = new MixerAudioNode (true, edit.engine.getEngineBehaviour().getNumberOfCPUsToUseForAudio() > 1);
 
-                    mixer->addInput (n);
+                    mixer->addInput (addStemTapIfNeeded (*ft, n));
 
                     // find an tracks required to feed sidechains
                     auto subTracks = ft->getAllAudioSubTracks (true);
@@ -888,6 +1125,27 @@ static AudioNode* createRenderingNodeFromEdit (Edit& edit,
     return finalNode;
 }
 
+bool Renderer::canRenderAsStem (Edit& edit, const BigInteger& tracksToDo, Track& track)
+{
+    const auto allTracks = getAllTracks (edit);
+    const int index = allTracks.indexOf (&track);
+
+    // These mirror the checks createRenderingNodeFromEdit makes before tapping a track
+    if (! tracksToDo[index] || ! track.isProcessing (true))
+        return false;
+
+    if (track.isPartOfSubmix() && isTrackIncludedInRender (allTracks, &tracksToDo, *track.getParentTrack()))
+        return false;
+
+    if (auto at = dynamic_cast<AudioTrack*> (&track))
+        return ! trackLoopsBackInto (allTracks, *at, &tracksToDo);
+
+    if (auto ft = dynamic_cast<FolderTrack*> (&track))
+        return ft->isSubmixFolder();
+
+    return false;
+}
+
 AudioNode* Renderer::createRenderingAudioNode (const Parameters& r)
 {
     CreateAudioNodeParams cnp;
@@ -897,7 +1155,7 @@ AudioNode* Renderer::createRenderingAudioNode (const Parameters& r)
     cnp.includePlugins = r.usePlugins;
     cnp.addAntiDenormalisationNoise = r.addAntiDenormalisationNoise;
 
-    return createRenderingNodeFromEdit (*r.edit, cnp, r.useMasterPlugins);
+    return createRenderingNodeFromEdit (*r.edit, cnp, r.useMasterPlugins, r.stems);
 }
 
 //==============================================================================
@@ -1082,7 +1340,7 @@ ProjectItem::Ptr Renderer::renderToProjectItem (const String& taskDescription, c
 //==============================================================================
 Renderer::Statistics Renderer::measureStatistics (const String& taskDescription, Edit& edit,
                                                   EditTimeRange range, const BigInteger& tracksToDo,
-                                                  int blockSizeForAudio)
+                                                  int blockSizeForAudio, bool offlineRender)
 {
     CRASH_TRACER
     Statistics result;
@@ -1109,10 +1367,19 @@ Renderer::Statistics Renderer::measureStatistics (const String& taskDescription,
             r.blockSizeForAudio = blockSizeForAudio;
             r.time = range;
             r.addAntiDenormalisationNoise = cnp.addAntiDenormalisationNoise;
+            r.offlineRender = offlineRender;
 
             RenderTask task (taskDescription, r, node);
 
-            edit.engine.getUIBehaviour().runTaskWithProgressBar (task);
+            if (offlineRender)
+            {
+                while (task.runJob() == ThreadPoolJob::jobNeedsRunningAgain)
+                {}
+            }
+            else
+            {
+                edit.engine.getUIBehaviour().runTaskWithProgressBar (task);
+            }
 
             result.peak          = task.params.resultMagnitude;
             result.average       = task.params.resultRMS;
@@ -1125,6 +1392,23 @@ Renderer::Statistics Renderer::measureStatistics (const String& taskDescription,
     return result;
 }
 
+Renderer::RenderSpeed Renderer::measureRenderSpeed (Edit& edit, EditTimeRange range, const BigInteger& tracksToDo)
+{
+    CRASH_TRACER
+    RenderSpeed result;
+
+    if (tracksToDo.countNumberOfSetBits() > 0)
+    {
+        const auto startTime = Time::getMillisecondCounterHiRes();
+        measureStatistics ("Measuring render speed", edit, range, tracksToDo, offlineBlockSize, true);
+
+        result.renderTime = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+        result.audioDuration = range.getLength();
+    }
+
+    return result;
+}
+
 bool Renderer::checkTargetFile (Engine& e, const File& file)
 {
     auto& ui = e.getUIBehaviour();
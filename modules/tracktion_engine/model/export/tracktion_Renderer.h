@@ -17,6 +17,16 @@ namespace tracktion_engine
 class Renderer
 {
 public:
+    /** A track whose post-fader output should be written to its own file.
+        @see Parameters::stems
+    */
+    struct StemTarget
+    {
+        Track* track = nullptr;     /**< An AudioTrack or a submix FolderTrack. */
+        juce::File destFile;
+        double length = 0;          /**< If > 0, only this many seconds from the start of the render are written. */
+    };
+
     struct Parameters
     {
         Parameters() = delete;
@@ -54,10 +64,26 @@ public:
         bool usePlugins = true;
         bool useMasterPlugins = false;
         bool realTimeRender = false;
+
+        /** If true, the render never sleeps to yield to other threads and plugins are
+            pre-warmed in parallel, so it runs as fast as the CPU allows. This is intended
+            for batch renders with no UI. The render uses offlineBlockSize in place of
+            blockSizeForAudio.
+        */
+        bool offlineRender = false;
         bool ditheringEnabled = false;
         bool separateTracks = false;
         bool addAntiDenormalisationNoise = false;
 
+        /** If this isn't empty, the output of each of these tracks is tapped after its
+            fader and written to its own file in the same pass that renders the master
+            to destFile. The destFile can be empty to only write the stems.
+            Stems are taken before any master plugins and aren't normalised or trimmed.
+            Each track must also be set in tracksToDo and canRenderAsStem() must be true
+            for it, otherwise the render fails.
+        */
+        juce::Array<StemTarget> stems;
+
         int quality = 0;
         juce::StringPairArray metadata;
         ProjectItem::Category category = ProjectItem::Category::none;
@@ -109,7 +135,8 @@ public:
         bool renderAudio (Renderer::Parameters&);
         bool renderMidi (Renderer::Parameters&);
 
-        static void flushAllPlugins (PlayHead&, const Plugin::Array&, double sampleRate, int samplesPerBlock);
+        static void flushAllPlugins (PlayHead&, const Plugin::Array&, double sampleRate, int samplesPerBlock,
+                                     bool inParallel = false);
         static void setAllPluginsRealtime (const Plugin::Array&, bool realtime);
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderTask)
@@ -144,6 +171,14 @@ public:
     /** Creates an AudioNode to render the given Edit i.e. a single graph rather than split over devices. */
     static AudioNode* createRenderingAudioNode (const Parameters&);
 
+    /** Returns true if a track's output can be written as a stem when rendering these tracks.
+        Tracks that aren't processing, that feed into another track being rendered or that are
+        inside a submix being rendered don't reach the master on their own, so need to be
+        rendered in a pass of their own instead.
+        @see Parameters::stems
+    */
+    static bool canRenderAsStem (Edit&, const juce::BigInteger& tracksToDo, Track&);
+
     //==============================================================================
     /** @see measureStatistics()
     */
@@ -154,11 +189,35 @@ public:
         float audioDuration = 0;
     };
 
-    /** Renders a section of an edit to measure various details about its audio content */
+    /** Renders a section of an edit to measure various details about its audio content.
+        If offlineRender is true this runs on the calling thread rather than with a
+        progress bar, @see Parameters::offlineRender
+    */
     static Statistics measureStatistics (const juce::String& taskDescription,
                                          Edit& edit, EditTimeRange range,
                                          const juce::BigInteger& tracksToDo,
-                                         int blockSizeForAudio);
+                                         int blockSizeForAudio,
+                                         bool offlineRender = false);
+
+    /** The block size offline renders use. This is independent of the audio device. */
+    static constexpr int offlineBlockSize = 4096;
+
+    /** @see measureRenderSpeed()
+    */
+    struct RenderSpeed
+    {
+        double audioDuration = 0;   /**< The length of audio rendered in seconds. */
+        double renderTime = 0;      /**< The wall-clock time the render took in seconds. */
+
+        /** Returns how many times faster than real-time the render was. */
+        double getRealtimeFactor() const    { return renderTime > 0.0 ? audioDuration / renderTime : 0.0; }
+    };
+
+    /** Renders a section of an edit offline on the calling thread without writing a file
+        and returns how long it took. This can be used to benchmark the throughput of Edits.
+    */
+    static RenderSpeed measureRenderSpeed (Edit& edit, EditTimeRange range,
+                                           const juce::BigInteger& tracksToDo);
 
     //==============================================================================
     struct RenderResult
@@ -0,0 +1,181 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_UNIT_TESTS
+
+//==============================================================================
+//==============================================================================
+class RenderSpeedTests : public UnitTest
+{
+public:
+    RenderSpeedTests() : UnitTest ("Render Speed", "Tracktion:Longer") {}
+
+    //==============================================================================
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines()[0];
+        auto edit = Edit::createSingleTrackEdit (engine);
+        auto track = getFirstAudioTrack (*edit);
+
+        track->pluginList.insertPlugin (edit->getPluginCache().createNewPlugin (ToneGeneratorPlugin::xmlTypeName, {}), 0, nullptr);
+        track->pluginList.insertPlugin (edit->getPluginCache().createNewPlugin (DelayPlugin::xmlTypeName, {}), 1, nullptr);
+
+        BigInteger tracksToDo;
+        tracksToDo.setBit (track->getIndexInEditTrackList());
+
+        beginTest ("Offline render speed");
+        {
+            // The speed depends on the machine and its load so is only logged, not checked
+            auto speed = Renderer::measureRenderSpeed (*edit, { 0.0, 30.0 }, tracksToDo);
+            logMessage ("Realtime factor: " + String (speed.getRealtimeFactor(), 1) + "x");
+
+            expectWithinAbsoluteError (speed.audioDuration, 30.0, 0.001);
+            expectGreaterThan (speed.renderTime, 0.0);
+        }
+
+        beginTest ("Offline render statistics");
+        {
+            // The offline render should produce the same audio as a normal one
+            auto offline = Renderer::measureStatistics ("Offline", *edit, { 0.0, 5.0 }, tracksToDo, 512, true);
+            auto normal = Renderer::measureStatistics ("Normal", *edit, { 0.0, 5.0 }, tracksToDo, 512);
+
+            expectWithinAbsoluteError (offline.peak, normal.peak, 0.01f);
+            expectWithinAbsoluteError (offline.audioDuration, normal.audioDuration, 0.01f);
+        }
+
+        engine.getAudioFileManager().releaseAllFiles();
+        edit->getTempDirectory (false).deleteRecursively();
+    }
+};
+
+static RenderSpeedTests renderSpeedTests;
+
+//==============================================================================
+//==============================================================================
+class RenderStemTests : public UnitTest
+{
+public:
+    RenderStemTests() : UnitTest ("Render Stems", "Tracktion:Longer") {}
+
+    //==============================================================================
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines()[0];
+        auto edit = Edit::createSingleTrackEdit (engine);
+        edit->ensureNumberOfAudioTracks (3);
+        auto tracks = getAudioTracks (*edit);
+
+        // The second track feeds into the third so never reaches the master on its own
+        for (int i = 0; i < 2; ++i)
+            tracks[i]->pluginList.insertPlugin (edit->getPluginCache().createNewPlugin (ToneGeneratorPlugin::xmlTypeName, {}), 0, nullptr);
+
+        tracks[1]->getOutput().setOutputToTrack (tracks[2]);
+
+        BigInteger tracksToDo;
+
+        for (auto t : tracks)
+            tracksToDo.setBit (t->getIndexInEditTrackList());
+
+        auto tempDir = edit->getTempDirectory (true);
+
+        beginTest ("Tappable tracks");
+        {
+            expect (Renderer::canRenderAsStem (*edit, tracksToDo, *tracks[0]));
+            expect (! Renderer::canRenderAsStem (*edit, tracksToDo, *tracks[1]));
+            expect (Renderer::canRenderAsStem (*edit, tracksToDo, *tracks[2]));
+
+            BigInteger secondTrackOnly;
+            secondTrackOnly.setBit (tracks[1]->getIndexInEditTrackList());
+            expect (Renderer::canRenderAsStem (*edit, secondTrackOnly, *tracks[1]));
+        }
+
+        beginTest ("Stems");
+        {
+            auto files = render (*edit, tracksToDo, { tracks[0], tracks[2] }, tempDir);
+            expect (files.size() == 2);
+
+            for (auto& f : files)
+                expectGreaterThan (getPeak (engine, f), 0.01f);
+        }
+
+        beginTest ("Stems that can't be tapped fail");
+        {
+            auto files = render (*edit, tracksToDo, { tracks[0], tracks[1] }, tempDir);
+            expect (files.isEmpty(), "The render should fail rather than write an empty stem");
+
+            for (auto& f : tempDir.findChildFiles (File::findFiles, false, "stem_*"))
+                expect (! f.existsAsFile());
+        }
+
+        engine.getAudioFileManager().releaseAllFiles();
+        edit->getTempDirectory (false).deleteRecursively();
+    }
+
+    /** Renders the stems offline and returns the files written, or nothing if it failed. */
+    Array<File> render (Edit& edit, const BigInteger& tracksToDo, const Array<Track*>& stemTracks, const File& dir)
+    {
+        Renderer::Parameters r (edit);
+        r.tracksToDo = tracksToDo;
+        r.audioFormat = edit.engine.getAudioFileFormatManager().getWavFormat();
+        r.sampleRateForAudio = 44100.0;
+        r.time = { 0.0, 1.0 };
+        r.offlineRender = true;
+
+        for (int i = 0; i < stemTracks.size(); ++i)
+            r.stems.add ({ stemTracks[i], dir.getChildFile ("stem_" + String (i) + ".wav") });
+
+        for (auto& stem : r.stems)
+            stem.destFile.deleteFile();
+
+        Array<File> files;
+
+        if (auto node = Renderer::createRenderingAudioNode (r))
+        {
+            const Edit::ScopedRenderStatus srs (edit, true);
+            Renderer::RenderTask task ("Stems", r, node);
+
+            while (task.runJob() == ThreadPoolJob::jobNeedsRunningAgain)
+            {}
+
+            if (task.errorMessage.isNotEmpty())
+            {
+                logMessage (task.errorMessage);
+                return {};
+            }
+
+            for (auto& stem : r.stems)
+                if (stem.destFile.existsAsFile())
+                    files.add (stem.destFile);
+        }
+
+        return files;
+    }
+
+    static float getPeak (Engine& engine, const File& file)
+    {
+        if (auto reader = std::unique_ptr<AudioFormatReader> (AudioFileUtils::createReaderFor (engine, file)))
+        {
+            Range<float> range;
+            reader->readMaxLevels (0, reader->lengthInSamples, &range, 1);
+            return jmax (-range.getStart(), range.getEnd());
+        }
+
+        return 0.0f;
+    }
+};
+
+static RenderStemTests renderStemTests;
+
+#endif // TRACKTION_UNIT_TESTS
+
+}
@@ -819,8 +819,9 @@ void AudioTrack::valueTreePropertyChanged (ValueTree& v, const juce::Identifier&
         {
             frozenIndividually.forceUpdateOfCachedValue();
 
+            // Freezing is done by setFrozenIndividually() as the file may already have been rendered
             if (frozenIndividually)
-                freezeTrack();
+                changed();
             else
                 unFreezeTrack();
         }
@@ -1271,7 +1272,7 @@ void AudioTrack::setFrozen (bool b, FreezeType type)
             }
             else
             {
-                frozenIndividually = b;
+                setFrozenIndividually (b, true);
             }
         }
     }
@@ -1304,6 +1305,14 @@ bool AudioTrack::canContainPlugin (Plugin* p) const
                  || (isFreezePoint && (p->getOwnerTrack() == this || ! hasFreezePointPlugin())));
 }
 
+void AudioTrack::setFrozenIndividually (bool shouldBeFrozen, bool renderFreezeFile)
+{
+    frozenIndividually = shouldBeFrozen;
+
+    if (shouldBeFrozen && renderFreezeFile)
+        freezeTrack();
+}
+
 //==============================================================================
 AudioTrack::FreezePointRemovalInhibitor::FreezePointRemovalInhibitor (AudioTrack& at) : track (at)  { ++track.freezePointRemovalInhibitor; }
 AudioTrack::FreezePointRemovalInhibitor::~FreezePointRemovalInhibitor()                             { --track.freezePointRemovalInhibitor; }
@@ -1356,6 +1365,139 @@ void AudioTrack::freezeTrack()
     changed();
 }
 
+void AudioTrack::freezeTracks (const juce::Array<AudioTrack*>& tracksToFreeze)
+{
+    CRASH_TRACER
+    Array<AudioTrack*> tracks;
+
+    for (auto t : tracksToFreeze)
+        if (t != nullptr && ! t->isFrozen (individualFreeze) && t->getOutput().getDestinationTrack() == nullptr)
+            tracks.addIfNotAlreadyThere (t);
+
+    if (tracks.isEmpty())
+        return;
+
+    auto& edit = tracks.getFirst()->edit;
+
+    // Any tracks whose output can't be tapped in the shared pass, e.g. ones that aren't
+    // processing, are frozen on their own rather than ending up with no freeze file
+    {
+        BigInteger allTracks;
+
+        for (auto t : tracks)
+            allTracks.setBit (t->getIndexInEditTrackList());
+
+        for (int i = 0; i < tracks.size();)
+        {
+            if (Renderer::canRenderAsStem (edit, allTracks, *tracks.getUnchecked (i)))
+                ++i;
+            else
+                tracks.removeAndReturn (i)->setFrozen (true, individualFreeze);
+        }
+    }
+
+    if (tracks.size() < 2)
+    {
+        if (auto t = tracks.getFirst())
+            t->setFrozen (true, individualFreeze);
+
+        return;
+    }
+    auto& ui = edit.engine.getUIBehaviour();
+
+    // This is an offline render so will use Renderer::offlineBlockSize
+    Renderer::Parameters r (edit);
+    r.audioFormat = edit.engine.getAudioFileFormatManager().getFrozenFileFormat();
+    r.sampleRateForAudio = edit.engine.getDeviceManager().getSampleRate();
+    r.canRenderInMono = true;
+    r.mustRenderInMono = false;
+    r.usePlugins = true;
+    r.useMasterPlugins = false;
+    r.offlineRender = true;
+    r.addAntiDenormalisationNoise = EditPlaybackContext::shouldAddAntiDenormalisationNoise (edit.engine);
+
+    std::vector<std::unique_ptr<FreezePointPlugin::ScopedPluginDisabler>> pluginDisablers;
+    Array<bool> wasMuted;
+    double length = 0.0;
+
+    for (auto t : tracks)
+    {
+        t->insertFreezePointIfRequired();
+        pluginDisablers.push_back (std::make_unique<FreezePointPlugin::ScopedPluginDisabler> (*t, Range<int> (t->getIndexOfFreezePoint(),
+                                                                                                             t->pluginList.size())));
+        wasMuted.add (t->isMuted (true));
+        t->setMute (false);
+
+        auto freezeFile = t->getFreezeFile();
+        freezeFile.deleteFile();
+
+        // Each file is only as long as its own track, in the same way as freezeTrack()
+        auto trackLength = t->getLengthIncludingInputTracks();
+
+        if (trackLength <= 0.0)
+            continue;
+
+        r.tracksToDo.setBit (t->getIndexInEditTrackList());
+        r.stems.add ({ t, freezeFile, trackLength });
+        length = jmax (length, trackLength);
+    }
+
+    r.time = { 0.0, length };
+
+    if (length > 0.0)
+    {
+        const FreezePointPlugin::ScopedTrackUnsoloer stu (edit);
+        const Edit::ScopedRenderStatus srs (edit, true);
+
+        TransportControl::stopAllTransports (edit.engine, false, true);
+        Renderer::turnOffAllPlugins (edit);
+
+        if (auto node = Renderer::createRenderingAudioNode (r))
+        {
+            Renderer::RenderTask task (TRANS("Freezing XNX tracks").replace ("XNX", String (tracks.size())) + "...", r, node);
+            ui.runTaskWithProgressBar (task);
+
+            if (task.errorMessage.isNotEmpty())
+                ui.showWarningMessage (task.errorMessage);
+        }
+
+        Renderer::turnOffAllPlugins (edit);
+    }
+
+    auto proj = edit.engine.getProjectManager().getProject (edit);
+
+    for (int i = 0; i < tracks.size(); ++i)
+    {
+        auto t = tracks.getUnchecked (i);
+        t->freezePlugins (Range<int> (0, t->getIndexOfFreezePoint()));
+        t->setMute (wasMuted[i]);
+
+        auto freezeFile = t->getFreezeFile();
+
+        if (! freezeFile.existsAsFile())
+        {
+            // Mirror freezeTrack(), unfreezing removes the freeze point and unfreezes the plugins again
+            ui.showWarningMessage (TRANS("Nothing to freeze"));
+            t->setFrozenIndividually (true, false);
+            t->setFrozen (false, individualFreeze);
+            continue;
+        }
+
+        if (proj != nullptr && ! proj->isReadOnly())
+        {
+            String desc;
+            desc << TRANS("Rendered from edit") << edit.getName().quoted() << " "
+                 << TRANS("On") << " " << Time::getCurrentTime().toString (true, true);
+
+            proj->createNewItem (freezeFile, ProjectItem::waveItemType(),
+                                 freezeFile.getFileNameWithoutExtension().trim(),
+                                 desc, ProjectItem::Category::frozen, true);
+        }
+
+        t->setFrozenIndividually (true, false);
+    }
+}
+
 int AudioTrack::getIndexOfFreezePoint()
 {
     int i = 0;
@@ -80,6 +80,13 @@ public:
     void removeFreezePoint();
     void freezeTrackAsync() const;
 
+    /** Freezes a set of tracks together, rendering all of their freeze files in a single
+        pass of the Edit. This means any inputs they share are only processed once and the
+        tracks are mixed on multiple threads, which is much quicker than freezing them one
+        at a time. Tracks that are already frozen or output to another track are skipped.
+    */
+    static void freezeTracks (const juce::Array<AudioTrack*>&);
+
     //==============================================================================
     /** creates an audio node to play this track.
         (only creates one if this track doesn't feed into another track)
@@ -213,6 +220,7 @@ private:
     //==============================================================================
     bool canUseBufferedAudioNode();
 
+    void setFrozenIndividually (bool shouldBeFrozen, bool renderFreezeFile);
     void freezeTrack();
     bool insertFreezePointIfRequired();
     int getIndexOfDefaultFreezePoint();
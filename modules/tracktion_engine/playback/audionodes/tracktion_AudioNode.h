@@ -137,6 +137,11 @@ struct AudioRenderContext
     /** True if the rendering is happening as part of an offline render rather than live playback. */
     bool isRendering;
 
+    /** If this isn't nullptr, nodes record how long they take to render in to it.
+        @see NodeProfiler, EditPlaybackContext::setNodeProfiler
+    */
+    NodeProfiler* profiler = nullptr;
+
     //==============================================================================
     /** Returns the section of the edit that needs to be rendered by this block. */
     PlayHead::EditTimeWindow getEditTime() const;
@@ -11,51 +11,6 @@
 namespace tracktion_engine
 {
 
-ClickNode::ClickNode (bool m, Edit& ed, double endTime)
-   : edit (ed), midi (m)
-{
-    endTime = jmin (endTime, jmax (ed.getLength() * 2, 60.0 * 60.0));
-
-    TempoSequencePosition pos (ed.tempoSequence);
-    pos.setTime (1.0e-10);
-    pos.addBars (-8);
-
-    while (pos.getTime() < endTime)
-    {
-        auto barsBeats = pos.getBarsBeatsTime();
-
-        if (barsBeats.getWholeBeats() == 0)
-            loudBeats.setBit (beatTimes.size());
-
-        beatTimes.add (pos.getTime());
-        pos.addBeats (1.0);
-    }
-
-    beatTimes.add (1000000.0);
-}
-
-ClickNode::~ClickNode()
-{
-    releaseAudioNodeResources();
-}
-
-void ClickNode::getAudioNodeProperties (AudioNodeProperties& info)
-{
-    info.hasAudio = ! midi;
-    info.hasMidi = midi;
-    info.numberOfChannels = 1;
-}
-
-void ClickNode::visitNodes (const VisitorFn& v)
-{
-    v (*this);
-}
-
-bool ClickNode::purgeSubNodes (bool keepAudio, bool keepMidi)
-{
-    return (keepMidi && midi) || (keepAudio && ! midi);
-}
-
 juce::AudioBuffer<float> loadWavDataIntoMemory (const void* data, size_t size, double targetSampleRate)
 {
    auto in = new MemoryInputStream (data, size, false);
@@ -96,17 +51,109 @@ juce::AudioBuffer<float> loadWavDataIntoMemory (const File& file, double targetS
     return loadWavDataIntoMemory (mb.getData(), mb.getSize(), targetSampleRate);
 }
 
-void ClickNode::prepareAudioNodeToPlay (const PlaybackInitialisationInfo& info)
+//==============================================================================
+/** Holds the click samples resampled to each sample rate in use, so every
+    ClickNode shares the same buffers and they only get loaded once.
+*/
+struct ClickNode::ClickBank
 {
-    CRASH_TRACER
+    ClickBuffer getClick (Engine& engine, bool big, double sampleRate)
+    {
+        File file (getClickWaveFile (engine, big));
+        auto modificationTime = file.getLastModificationTime();
+
+        const ScopedLock sl (lock);
+
+        for (auto& c : clicks)
+            if (c.isBig == big && c.sampleRate == sampleRate
+                 && c.file == file && c.modificationTime == modificationTime)
+                return c.buffer;
+
+        // Drop any that are no longer used by a node
+        clicks.erase (std::remove_if (clicks.begin(), clicks.end(),
+                                      [] (const Click& c) { return c.buffer.use_count() <= 1; }),
+                      clicks.end());
+
+        juce::AudioBuffer<float> buffer;
+
+        if (file.existsAsFile())
+            buffer = loadWavDataIntoMemory (file, sampleRate);
+
+        if (buffer.getNumSamples() == 0)
+            buffer = big ? loadWavDataIntoMemory (TracktionBinaryData::bigclick_wav, TracktionBinaryData::bigclick_wavSize, sampleRate)
+                         : loadWavDataIntoMemory (TracktionBinaryData::littleclick_wav, TracktionBinaryData::littleclick_wavSize, sampleRate);
+
+        auto click = std::make_shared<const juce::AudioBuffer<float>> (std::move (buffer));
+        clicks.push_back ({ file, modificationTime, big, sampleRate, click });
+
+        return click;
+    }
+
+private:
+    struct Click
+    {
+        File file;
+        Time modificationTime;
+        bool isBig;
+        double sampleRate;
+        ClickBuffer buffer;
+    };
+
+    CriticalSection lock;
+    std::vector<Click> clicks;
+};
+
+//==============================================================================
+ClickNode::ClickNode (bool m, Edit& ed, double endTime)
+   : edit (ed), midi (m)
+{
+    endTime = jmin (endTime, jmax (ed.getLength() * 2, 60.0 * 60.0));
+
+    TempoSequencePosition pos (ed.tempoSequence);
+    pos.setTime (1.0e-10);
+    pos.addBars (-8);
 
-    if (sampleRate != info.sampleRate)
+    beats.reserve ((size_t) ed.tempoSequence.timeToBeats (endTime) + 64);
+
+    while (pos.getTime() < endTime)
     {
-        sampleRate = info.sampleRate;
-        bigClick = {};
-        littleClick = {};
+        beats.push_back ({ pos.getTime(), pos.getBarsBeatsTime().getWholeBeats() == 0 });
+        pos.addBeats (1.0);
     }
 
+    // A sentinel so the cursor never runs off the end
+    beats.push_back ({ 1000000.0, false });
+}
+
+ClickNode::~ClickNode()
+{
+    releaseAudioNodeResources();
+}
+
+void ClickNode::getAudioNodeProperties (AudioNodeProperties& info)
+{
+    info.hasAudio = ! midi;
+    info.hasMidi = midi;
+    info.numberOfChannels = 1;
+}
+
+void ClickNode::visitNodes (const VisitorFn& v)
+{
+    v (*this);
+}
+
+bool ClickNode::purgeSubNodes (bool keepAudio, bool keepMidi)
+{
+    return (keepMidi && midi) || (keepAudio && ! midi);
+}
+
+//==============================================================================
+void ClickNode::prepareAudioNodeToPlay (const PlaybackInitialisationInfo& info)
+{
+    CRASH_TRACER
+
+    sampleRate = info.sampleRate;
+
     if (midi)
     {
         bigClickMidiNote    = getMidiClickNote (edit.engine, true);
@@ -114,32 +161,12 @@ void ClickNode::prepareAudioNodeToPlay (const PlaybackInitialisationInfo& info)
     }
     else
     {
-        if (bigClick.getNumSamples() == 0)
-        {
-            File file (getClickWaveFile (edit.engine, true));
-
-            if (file.existsAsFile())
-                bigClick = loadWavDataIntoMemory (file, sampleRate);
-
-            if (bigClick.getNumSamples() == 0)
-                bigClick = loadWavDataIntoMemory (TracktionBinaryData::bigclick_wav, TracktionBinaryData::bigclick_wavSize, sampleRate);
-        }
-
-        if (littleClick.getNumSamples() == 0)
-        {
-            File file (getClickWaveFile (edit.engine, false));
-
-            if (file.existsAsFile())
-                littleClick = loadWavDataIntoMemory (file, sampleRate);
-
-            if (littleClick.getNumSamples() == 0)
-                littleClick = loadWavDataIntoMemory (TracktionBinaryData::littleclick_wav, TracktionBinaryData::littleclick_wavSize, sampleRate);
-        }
+        bigClick    = clickBank->getClick (edit.engine, true, sampleRate);
+        littleClick = clickBank->getClick (edit.engine, false, sampleRate);
     }
 
-    for (currentBeat = 0; currentBeat < beatTimes.size(); ++currentBeat)
-        if (beatTimes[currentBeat] > info.startTime)
-            break;
+    currentBeat = 0;
+    seekToTime (info.startTime);
 }
 
 bool ClickNode::isReadyToRender()
@@ -149,8 +176,8 @@ bool ClickNode::isReadyToRender()
 
 void ClickNode::releaseAudioNodeResources()
 {
-    bigClick = {};
-    littleClick = {};
+    bigClick.reset();
+    littleClick.reset();
 }
 
 void ClickNode::renderOver (const AudioRenderContext& rc)
@@ -166,46 +193,59 @@ void ClickNode::renderAdding (const AudioRenderContext& rc)
     invokeSplitRender (rc, *this);
 }
 
+void ClickNode::seekToTime (double time)
+{
+    // During normal playback the cursor will already be on the right beat or
+    // only a couple behind it so just step forwards
+    if (currentBeat == 0 || beats[currentBeat - 1].time < time)
+    {
+        for (int i = 0; i < 4 && beats[currentBeat].time < time; ++i)
+            ++currentBeat;
+
+        if (beats[currentBeat].time >= time)
+            return;
+    }
+
+    // After a loop or reposition, search for the first beat at or after the time
+    auto found = std::lower_bound (beats.begin(), beats.end(), time,
+                                   [] (const Beat& b, double t) { return b.time < t; });
+
+    currentBeat = jmin ((size_t) std::distance (beats.begin(), found), beats.size() - 1);
+}
+
 void ClickNode::renderSection (const AudioRenderContext& rc, EditTimeRange editTime)
 {
     auto gain = edit.getClickTrackVolume();
     const bool emphasis = edit.clickTrackEmphasiseBars;
 
-    while (editTime.getStart() > beatTimes[currentBeat])
-        ++currentBeat;
-
-    while (currentBeat > 1 && editTime.getStart() < beatTimes[currentBeat - 1])
-        --currentBeat;
+    seekToTime (editTime.getStart());
 
     if (midi && rc.bufferForMidiMessages != nullptr)
     {
-        double t = beatTimes.getUnchecked (currentBeat);
-
-        while (t < editTime.getEnd())
+        for (; beats[currentBeat].time < editTime.getEnd(); ++currentBeat)
         {
-            auto note = (emphasis && loudBeats[currentBeat]) ? bigClickMidiNote
-                                                             : littleClickMidiNote;
+            auto& beat = beats[currentBeat];
+            auto note = (emphasis && beat.isBarStart) ? bigClickMidiNote
+                                                      : littleClickMidiNote;
 
-            if (t >= editTime.getStart())
-                rc.bufferForMidiMessages->addMidiMessage (MidiMessage::noteOn (10, note, gain),
-                                                          t - editTime.getStart(),
-                                                          MidiMessageArray::notMPE);
-
-            t = beatTimes.getUnchecked (++currentBeat);
+            rc.bufferForMidiMessages->addMidiMessage (MidiMessage::noteOn (10, note, gain),
+                                                      beat.time - editTime.getStart(),
+                                                      MidiMessageArray::notMPE);
         }
     }
-    else if (! midi && rc.destBuffer != nullptr)
+    else if (! midi && rc.destBuffer != nullptr && bigClick != nullptr && littleClick != nullptr)
     {
-        --currentBeat;
-        double t = beatTimes[currentBeat];
+        // Start from the previous beat so the tail of its click is played
+        auto beatIndex = currentBeat > 0 ? currentBeat - 1 : currentBeat;
 
-        while (t < editTime.getEnd())
+        for (; beats[beatIndex].time < editTime.getEnd(); ++beatIndex)
         {
-            auto& b = (emphasis && loudBeats[currentBeat]) ? bigClick : littleClick;
+            auto& beat = beats[beatIndex];
+            auto& b = (emphasis && beat.isBarStart) ? *bigClick : *littleClick;
 
             if (b.getNumSamples() > 0)
             {
-                auto clickStartOffset = roundToInt ((t - editTime.getStart()) * sampleRate);
+                auto clickStartOffset = roundToInt ((beat.time - editTime.getStart()) * sampleRate);
 
                 const int dstStart = jmax (0, clickStartOffset);
                 const int srcStart = jmax (0, -clickStartOffset);
@@ -214,13 +254,13 @@ void ClickNode::renderSection (const AudioRenderContext& rc, EditTimeRange editT
 
                 if (num > 0)
                     for (int i = rc.destBuffer->getNumChannels(); --i >= 0;)
-                        rc.destBuffer->addFrom (i, rc.bufferStartSample + dstStart,
-                                                b, jmin (i, b.getNumChannels() - 1), srcStart,
-                                                num, gain);
+                        FloatVectorOperations::addWithMultiply (rc.destBuffer->getWritePointer (i, rc.bufferStartSample + dstStart),
+                                                                b.getReadPointer (jmin (i, b.getNumChannels() - 1), srcStart),
+                                                                gain, num);
             }
-
-            t = beatTimes.getUnchecked (++currentBeat);
         }
+
+        currentBeat = jmax (currentBeat, beatIndex);
     }
 }
 
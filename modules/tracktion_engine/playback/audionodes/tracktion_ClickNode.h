@@ -35,16 +35,27 @@ public:
     static void setClickWaveFile (Engine&, bool big, const juce::String& filename);
 
 private:
+    struct Beat
+    {
+        double time;
+        bool isBarStart;
+    };
+
+    struct ClickBank;
+    using ClickBuffer = std::shared_ptr<const juce::AudioBuffer<float>>;
+
     const Edit& edit;
     bool midi = false;
-    juce::Array<double> beatTimes;
-    juce::BigInteger loudBeats;
-    int currentBeat = 0;
+    std::vector<Beat> beats;
+    size_t currentBeat = 0;
 
     double sampleRate = 44100.0;
-    juce::AudioBuffer<float> bigClick, littleClick;
+    juce::SharedResourcePointer<ClickBank> clickBank;
+    ClickBuffer bigClick, littleClick;
     int bigClickMidiNote = 37, littleClickMidiNote = 76;
 
+    void seekToTime (double);
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ClickNode)
 };
 
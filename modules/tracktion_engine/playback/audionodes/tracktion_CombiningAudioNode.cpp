@@ -61,7 +61,10 @@ struct CombiningAudioNode::TimedAudioNode
         }
 
         if (context.bufferNumSamples > 0 || rc.bufferForMidiMessages != nullptr)
+        {
+            const NodeProfiler::ScopedNodeTimer timer (rc.profiler, node.get());
             node->renderAdding (context);
+        }
     }
 
     JUCE_DECLARE_NON_COPYABLE (TimedAudioNode)
@@ -30,22 +30,31 @@ FadeInOutAudioNode::~FadeInOutAudioNode()
 {
 }
 
-static int timeToSample (const AudioRenderContext& rc, EditTimeRange editTime, double t)
+static int timeToSample (int numSamples, EditTimeRange editTime, double t)
 {
-    return (int) (rc.bufferNumSamples * (t - editTime.getStart()) / editTime.getLength() + 0.5);
+    return (int) (numSamples * (t - editTime.getStart()) / editTime.getLength() + 0.5);
 }
 
 void FadeInOutAudioNode::renderSection (const AudioRenderContext& rc, EditTimeRange editTime)
+{
+    applyFades (*rc.destBuffer, rc.bufferStartSample, rc.bufferNumSamples, editTime,
+                fadeIn, fadeOut, fadeInType, fadeOutType, clearExtraSamples);
+}
+
+void FadeInOutAudioNode::applyFades (juce::AudioBuffer<float>& buffer, int bufferStartSample, int numSamples,
+                                     EditTimeRange editTime, EditTimeRange fadeIn, EditTimeRange fadeOut,
+                                     AudioFadeCurve::Type fadeInType, AudioFadeCurve::Type fadeOutType,
+                                     bool clearExtraSamples)
 {
     if (editTime.overlaps (fadeIn) && fadeIn.getLength() > 0.0)
     {
         double alpha1 = 0;
-        auto startSamp = timeToSample (rc, editTime, fadeIn.getStart());
+        auto startSamp = timeToSample (numSamples, editTime, fadeIn.getStart());
 
         if (startSamp > 0)
         {
             if (clearExtraSamples)
-                rc.destBuffer->clear (rc.bufferStartSample, startSamp);
+                buffer.clear (bufferStartSample, startSamp);
         }
         else
         {
@@ -58,18 +67,18 @@ void FadeInOutAudioNode::renderSection (const AudioRenderContext& rc, EditTimeRa
 
         if (editTime.getEnd() >= fadeIn.getEnd())
         {
-            endSamp = timeToSample (rc, editTime, fadeIn.getEnd());
+            endSamp = timeToSample (numSamples, editTime, fadeIn.getEnd());
             alpha2 = 1.0;
         }
         else
         {
-            endSamp = rc.bufferNumSamples;
+            endSamp = numSamples;
             alpha2 = jmax (0.0, (editTime.getEnd() - fadeIn.getStart()) / fadeIn.getLength());
         }
 
         if (endSamp > startSamp)
-            AudioFadeCurve::applyCrossfadeSection (*rc.destBuffer,
-                                                   rc.bufferStartSample + startSamp, endSamp - startSamp,
+            AudioFadeCurve::applyCrossfadeSection (buffer,
+                                                   bufferStartSample + startSamp, endSamp - startSamp,
                                                    fadeInType,
                                                    (float) alpha1,
                                                    (float) alpha2);
@@ -78,7 +87,7 @@ void FadeInOutAudioNode::renderSection (const AudioRenderContext& rc, EditTimeRa
     if (editTime.overlaps (fadeOut) && fadeOut.getLength() > 0.0)
     {
         double alpha1 = 0;
-        auto startSamp = timeToSample (rc, editTime, fadeOut.getStart());
+        auto startSamp = timeToSample (numSamples, editTime, fadeOut.getStart());
 
         if (startSamp <= 0)
         {
@@ -91,22 +100,22 @@ void FadeInOutAudioNode::renderSection (const AudioRenderContext& rc, EditTimeRa
 
         if (editTime.getEnd() >= fadeOut.getEnd())
         {
-            endSamp = timeToSample (rc, editTime, fadeOut.getEnd());
+            endSamp = timeToSample (numSamples, editTime, fadeOut.getEnd());
             alpha2 = 1.0;
 
-            if (clearExtraSamples && endSamp < rc.bufferNumSamples)
-                rc.destBuffer->clear (rc.bufferStartSample + endSamp,
-                                      rc.bufferNumSamples - endSamp);
+            if (clearExtraSamples && endSamp < numSamples)
+                buffer.clear (bufferStartSample + endSamp,
+                              numSamples - endSamp);
         }
         else
         {
-            endSamp = rc.bufferNumSamples;
+            endSamp = numSamples;
             alpha2 = (editTime.getEnd() - fadeOut.getStart()) / fadeOut.getLength();
         }
 
         if (endSamp > startSamp)
-            AudioFadeCurve::applyCrossfadeSection (*rc.destBuffer,
-                                                   rc.bufferStartSample + startSamp, endSamp - startSamp,
+            AudioFadeCurve::applyCrossfadeSection (buffer,
+                                                   bufferStartSample + startSamp, endSamp - startSamp,
                                                    fadeOutType,
                                                    jlimit (0.0f, 1.0f, (float) (1.0 - alpha1)),
                                                    jlimit (0.0f, 1.0f, (float) (1.0 - alpha2)));
@@ -32,6 +32,14 @@ public:
 
     void renderSection (const AudioRenderContext&, EditTimeRange editTime);
 
+    /** Applies fades to a section of a buffer that represents the given edit time.
+        This is what renderSection uses and can be used to apply the same fades outside of an AudioNode.
+    */
+    static void applyFades (juce::AudioBuffer<float>&, int startSample, int numSamples, EditTimeRange editTime,
+                            EditTimeRange fadeIn, EditTimeRange fadeOut,
+                            AudioFadeCurve::Type fadeInType, AudioFadeCurve::Type fadeOutType,
+                            bool clearSamplesOutsideFade);
+
 private:
     //==============================================================================
     EditTimeRange fadeIn, fadeOut;
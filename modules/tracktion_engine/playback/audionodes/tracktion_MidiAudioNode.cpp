@@ -11,13 +11,13 @@
 namespace tracktion_engine
 {
 
-MidiAudioNode::MidiAudioNode (MidiMessageSequence sequence,
+MidiAudioNode::MidiAudioNode (CompiledMidiSequence::Ptr sequenceToPlay,
                               Range<int> chans,
                               EditTimeRange editPos,
                               CachedValue<float>& volumeDb_,
                               CachedValue<bool>& mute_,
                               Clip& sourceClip, const MidiAudioNode* nodeToReplace)
-    : ms (std::move (sequence)),
+    : sequence (std::move (sequenceToPlay)),
       editSection (editPos),
       channelNumbers (chans),
       volumeDb (volumeDb_),
@@ -26,38 +26,97 @@ MidiAudioNode::MidiAudioNode (MidiMessageSequence sequence,
       wasMute (mute_),
       shouldCreateMessagesForTime (nodeToReplace == nullptr)
 {
+    jassert (sequence != nullptr);
     jassert (channelNumbers.getStart() > 0 && channelNumbers.getEnd() <= 16);
 
     if (nodeToReplace != nullptr)
         midiSourceID = nodeToReplace->midiSourceID;
+}
+
+MidiAudioNode::MidiAudioNode (CompiledMidiSequence::Ptr sequenceInBeats,
+                              const TempoSequence::TempoSections& sections,
+                              Range<int> chans,
+                              EditTimeRange editPos,
+                              CachedValue<float>& volumeDb_,
+                              CachedValue<bool>& mute_,
+                              Clip& sourceClip, const MidiAudioNode* nodeToReplace)
+    : MidiAudioNode (std::move (sequenceInBeats), chans, editPos, volumeDb_, mute_, sourceClip, nodeToReplace)
+{
+    jassert (sections.size() > 0);
+
+    if (sections.size() > 0)
+        tempoSections = &sections;
+}
+
+MidiAudioNode::MidiAudioNode (MidiMessageSequence sequenceToPlay,
+                              Range<int> chans,
+                              EditTimeRange editPos,
+                              CachedValue<float>& volumeDb_,
+                              CachedValue<bool>& mute_,
+                              Clip& sourceClip, const MidiAudioNode* nodeToReplace)
+    : MidiAudioNode (CompiledMidiSequence::create (std::move (sequenceToPlay)),
+                     chans, editPos, volumeDb_, mute_, sourceClip, nodeToReplace)
+{
+}
 
-    ms.updateMatchedPairs();
+MidiAudioNode::MidiAudioNode (MidiMessageSequence sequenceInBeats,
+                              const TempoSequence::TempoSections& sections,
+                              Range<int> chans,
+                              EditTimeRange editPos,
+                              CachedValue<float>& volumeDb_,
+                              CachedValue<bool>& mute_,
+                              Clip& sourceClip, const MidiAudioNode* nodeToReplace)
+    : MidiAudioNode (CompiledMidiSequence::create (std::move (sequenceInBeats)),
+                     sections, chans, editPos, volumeDb_, mute_, sourceClip, nodeToReplace)
+{
+}
+
+Range<double> MidiAudioNode::getSequenceRange (EditTimeRange editTime) const
+{
+    if (tempoSections == nullptr)
+        return { editTime.getStart() - editSection.getStart(),
+                 editTime.getEnd() - editSection.getStart() };
+
+    // The sections can be swapped by the message thread while this is rendering, and the
+    // start beat has to come from the same sections as the block's for the events to line up
+    const SpinLock::ScopedLockType sl (tempoSections->getLock());
+    const auto sectionStartBeat = tempoSections->timeToBeats (editSection.getStart());
+
+    return { tempoSections->timeToBeats (editTime.getStart()) - sectionStartBeat,
+             tempoSections->timeToBeats (editTime.getEnd()) - sectionStartBeat };
 }
 
 void MidiAudioNode::renderSection (const AudioRenderContext& rc, EditTimeRange editTime)
 {
     if (rc.bufferForMidiMessages != nullptr)
     {
-        auto localTime = editTime - editSection.getStart();
+        // For beat based sequences this is in beats, and within the block each beat is
+        // treated as lasting the same number of seconds
+        auto localTime = getSequenceRange (editTime);
+        auto secondsPerUnit = localTime.getLength() > 0.0 ? editTime.getLength() / localTime.getLength() : 1.0;
 
         if (mute)
         {
             if (mute != wasMute)
             {
                 wasMute = mute;
-                createNoteOffs (*rc.bufferForMidiMessages, ms, localTime.getStart(), rc.midiBufferOffset, rc.playhead.isPlaying());
+                createNoteOffs (*rc.bufferForMidiMessages, localTime.getStart(), rc.midiBufferOffset, rc.playhead.isPlaying());
             }
 
             return;
         }
 
+        auto& ms = *sequence;
+        auto numEvents = ms.size();
+
         if ((! rc.isContiguousWithPreviousBlock()) || localTime.getStart() <= 0.00001 || shouldCreateMessagesForTime)
         {
             createMessagesForTime (localTime.getStart(), *rc.bufferForMidiMessages, rc.midiBufferOffset);
             shouldCreateMessagesForTime = false;
-        }
 
-        auto numEvents = ms.getNumEvents();
+            // After a jump the old index could be anywhere, so search for the new one
+            currentIndex = ms.getNextIndexAtTime (localTime.getStart());
+        }
 
         if (numEvents != 0)
         {
@@ -77,37 +136,31 @@ void MidiAudioNode::renderSection (const AudioRenderContext& rc, EditTimeRange e
 
         auto volScale = dbToGain (volumeDb);
 
-        for (;;)
+        for (; currentIndex < numEvents; ++currentIndex)
         {
-            if (auto meh = ms.getEventPointer (currentIndex++))
-            {
-                auto eventTime = meh->message.getTimeStamp();
+            auto eventTime = ms.getEventTime (currentIndex);
 
-                if (eventTime >= localTime.getEnd())
-                    break;
+            if (eventTime >= localTime.getEnd())
+                break;
 
-                eventTime -= localTime.getStart();
+            eventTime -= localTime.getStart();
 
-                if (eventTime >= 0)
-                {
-                    MidiMessage m (meh->message);
-                    m.multiplyVelocity (volScale);
-                    rc.bufferForMidiMessages->addMidiMessage (m, rc.midiBufferOffset + eventTime, midiSourceID);
-                }
-            }
-            else
+            if (eventTime >= 0)
             {
-                break;
+                auto m = ms.getMessage (currentIndex);
+                m.multiplyVelocity (volScale);
+                rc.bufferForMidiMessages->addMidiMessage (m, rc.midiBufferOffset + eventTime * secondsPerUnit, midiSourceID);
             }
         }
 
         if (rc.isLastBlockOfLoop())
-            createNoteOffs (*rc.bufferForMidiMessages, ms, localTime.getEnd(), rc.midiBufferOffset + localTime.getLength(), rc.playhead.isPlaying());
+            createNoteOffs (*rc.bufferForMidiMessages, localTime.getEnd(), rc.midiBufferOffset + editTime.getLength(), rc.playhead.isPlaying());
     }
 }
 
 void MidiAudioNode::createMessagesForTime (double time, MidiMessageArray& buffer, double midiTimeOffset)
 {
+    auto& ms = *sequence;
     const auto* midiClip = dynamic_cast<MidiClip*> (clip.get());
 
     if (midiClip != nullptr && midiClip->getMPEMode())
@@ -139,56 +192,35 @@ void MidiAudioNode::createMessagesForTime (double time, MidiMessageArray& buffer
         {
             auto volScale = dbToGain (volumeDb);
 
-            for (int i = 0; i < ms.getNumEvents(); ++i)
+            ms.forEachNoteOnHeldAt (ms.getNextIndexAtTime (time), [&] (int noteOnIndex)
             {
-                if (auto meh = ms.getEventPointer (i))
+                // don't play very short notes or ones that have already finished
+                if (ms.getEventTime (ms.getNoteOffIndex (noteOnIndex)) > time + 0.0001)
                 {
-                    if (meh->noteOffObject != nullptr
-                        && meh->message.isNoteOn())
-                    {
-                        if (meh->message.getTimeStamp() >= time)
-                            break;
-
-                        // don't play very short notes or ones that have already finished
-                        if (meh->noteOffObject->message.getTimeStamp() > time + 0.0001)
-                        {
-                            MidiMessage m (meh->message);
-                            m.multiplyVelocity (volScale);
-
-                            // give these a tiny offset to make sure they're played after the controller updates
-                            buffer.addMidiMessage (m, midiTimeOffset + 0.0001, midiSourceID);
-                        }
-                    }
+                    auto m = ms.getMessage (noteOnIndex);
+                    m.multiplyVelocity (volScale);
+
+                    // give these a tiny offset to make sure they're played after the controller updates
+                    buffer.addMidiMessage (m, midiTimeOffset + 0.0001, midiSourceID);
                 }
-            }
+            });
         }
     }
 }
 
-void MidiAudioNode::createNoteOffs (MidiMessageArray& destination, const MidiMessageSequence& source,
-                                    double time, double midiTimeOffset, bool isPlaying)
+void MidiAudioNode::createNoteOffs (MidiMessageArray& destination, double time, double midiTimeOffset, bool isPlaying)
 {
-    int activeChannels = 0;
+    auto& ms = *sequence;
 
-    for (int i = 0; i < source.getNumEvents(); ++i)
+    ms.forEachNoteOnHeldAt (ms.getNextIndexAtTime (time), [&] (int noteOnIndex)
     {
-        if (auto meh = source.getEventPointer (i))
-        {
-            if (meh->message.isNoteOn())
-            {
-                activeChannels |= (1 << meh->message.getChannel());
+        const int noteOffIndex = ms.getNoteOffIndex (noteOnIndex);
 
-                if (meh->message.getTimeStamp() < time
-                     && meh->noteOffObject != nullptr
-                     && meh->noteOffObject->message.getTimeStamp() > time)
-                    destination.addMidiMessage (meh->noteOffObject->message, midiTimeOffset, midiSourceID);
-            }
-        }
-        else
-        {
-            break;
-        }
-    }
+        if (ms.getEventTime (noteOffIndex) > time)
+            destination.addMidiMessage (ms.getMessage (noteOffIndex), midiTimeOffset, midiSourceID);
+    });
+
+    const int activeChannels = ms.getNoteOnChannels();
 
     for (int i = 1; i <= 16; ++i)
     {
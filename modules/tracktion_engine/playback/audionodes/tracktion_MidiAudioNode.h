@@ -11,7 +11,7 @@
 namespace tracktion_engine
 {
 
-/** An AudioNode that plays MIDI data from a MidiMessageSequence,
+/** An AudioNode that plays MIDI data from a CompiledMidiSequence,
     at a specific MIDI channel
 */
 class MidiAudioNode   : public AudioNode
@@ -24,6 +24,42 @@ public:
                    juce::CachedValue<bool>& mute,
                    Clip&, const MidiAudioNode* nodeToReplace);
 
+    /** Creates a node that plays a sequence timestamped in beats from the start of the
+        editSection.
+        Each block's beat range is looked up in the TempoSections and the events are
+        positioned by linearly interpolating across it, so the sequence doesn't need
+        converting back to seconds. The Edit still rebuilds its nodes when the tempo is
+        edited, but until then this stays in time with the new tempo.
+    */
+    MidiAudioNode (juce::MidiMessageSequence sequenceInBeats,
+                   const TempoSequence::TempoSections&,
+                   juce::Range<int> midiChannelNumbers,
+                   EditTimeRange editSection,
+                   juce::CachedValue<float>& volumeDb,
+                   juce::CachedValue<bool>& mute,
+                   Clip&, const MidiAudioNode* nodeToReplace);
+
+    /** Creates a node that plays a sequence timestamped in seconds from the start of the
+        editSection. The sequence can be shared with other nodes.
+    */
+    MidiAudioNode (CompiledMidiSequence::Ptr sequence,
+                   juce::Range<int> midiChannelNumbers,
+                   EditTimeRange editSection,
+                   juce::CachedValue<float>& volumeDb,
+                   juce::CachedValue<bool>& mute,
+                   Clip&, const MidiAudioNode* nodeToReplace);
+
+    /** Creates a node that plays a sequence timestamped in beats from the start of the
+        editSection, following tempo changes in the same way as the constructor above.
+    */
+    MidiAudioNode (CompiledMidiSequence::Ptr sequenceInBeats,
+                   const TempoSequence::TempoSections&,
+                   juce::Range<int> midiChannelNumbers,
+                   EditTimeRange editSection,
+                   juce::CachedValue<float>& volumeDb,
+                   juce::CachedValue<bool>& mute,
+                   Clip&, const MidiAudioNode* nodeToReplace);
+
     void renderSection (const AudioRenderContext&, EditTimeRange editTime);
 
     void getAudioNodeProperties (AudioNodeProperties&) override;
@@ -38,9 +74,10 @@ public:
     Clip& getClip() const noexcept                  { return *clip; }
 
 private:
-    juce::MidiMessageSequence ms;
+    CompiledMidiSequence::Ptr sequence;
     int currentIndex = 0;
     EditTimeRange editSection;
+    const TempoSequence::TempoSections* tempoSections = nullptr;
     juce::Range<int> channelNumbers;
     juce::CachedValue<float>& volumeDb;
     juce::CachedValue<bool>& mute;
@@ -49,9 +86,9 @@ private:
     bool wasMute = false, shouldCreateMessagesForTime = false;
 
     //==============================================================================
+    juce::Range<double> getSequenceRange (EditTimeRange editTime) const;
     void createMessagesForTime (double time, MidiMessageArray&, double midiTimeOffset);
-    void createNoteOffs (MidiMessageArray& destination, const juce::MidiMessageSequence& source,
-                         double time, double midiTimeOffset, bool isPlaying);
+    void createNoteOffs (MidiMessageArray& destination, double time, double midiTimeOffset, bool isPlaying);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiAudioNode)
 };
@@ -40,12 +40,16 @@ struct MultiCPU
     //==============================================================================
     struct ParallelMixOperation
     {
-        ParallelMixOperation (const AudioRenderContext& context, OwnedArray<AudioNode>& inputs)
-            : nodes (inputs), rc (context) {}
+        ParallelMixOperation (const AudioRenderContext& context, OwnedArray<AudioNode>& inputs,
+                              const std::vector<std::vector<int>>* dependencies,
+                              std::atomic<bool>* finishedFlags)
+            : nodes (inputs), inputDependencies (dependencies), finished (finishedFlags), rc (context) {}
 
         LinkedListPointer<ParallelMixOperation> nextListItem;
 
         OwnedArray<AudioNode>& nodes;
+        const std::vector<std::vector<int>>* inputDependencies;
+        std::atomic<bool>* finished;
         CriticalSection outputBufferLock;
         Atomic<int> nextNodeToPop, pendingNodes;
         WaitableEvent pendingNodeChange;
@@ -53,9 +57,19 @@ struct MultiCPU
         const AudioRenderContext& rc;
         double** buffer64 = nullptr;
 
-        void processNode (AudioNode* node, juce::AudioBuffer<float>& buffer)
+        void processNode (int index, juce::AudioBuffer<float>& buffer)
         {
-            processNode (*node, buffer);
+            // Nodes are popped in order, so anything this one depends on is already
+            // being rendered by another thread and will finish
+            if (inputDependencies != nullptr)
+                for (auto dependency : (*inputDependencies)[(size_t) index])
+                    while (! finished[dependency].load (std::memory_order_acquire))
+                        Thread::yield();
+
+            processNode (*nodes.getUnchecked (index), buffer);
+
+            if (finished != nullptr)
+                finished[index].store (true, std::memory_order_release);
 
             if (--pendingNodes == 0)
                 pendingNodeChange.signal();
@@ -63,8 +77,12 @@ struct MultiCPU
 
         void perform()
         {
+            if (finished != nullptr)
+                for (int i = nodes.size(); --i >= 0;)
+                    finished[i].store (false, std::memory_order_relaxed);
+
             pendingNodes = nodes.size();
-            nextNodeToPop = nodes.size();
+            nextNodeToPop = 0;
             auto& threadPool = *MultiCPU::MixerThreadPool::getInstanceWithoutCreating();
 
             threadPool.addOperation (this);
@@ -72,18 +90,19 @@ struct MultiCPU
             AudioScratchBuffer scratchBuffer (rc.destBuffer != nullptr ? rc.destBuffer->getNumChannels() : 256,
                                               rc.destBuffer != nullptr ? rc.destBuffer->getNumSamples()  : 1);
 
-            while (auto node = popNextNode())
-                processNode (node, scratchBuffer.buffer);
+            for (int index = popNextNode(); index >= 0; index = popNextNode())
+                processNode (index, scratchBuffer.buffer);
 
             pendingNodeChange.wait();
 
             threadPool.removeOperation (this);
         }
 
-        AudioNode* popNextNode()
+        /** Returns the index of the next node to process, or -1 if they've all been taken. */
+        int popNextNode()
         {
-            const int i = --nextNodeToPop;
-            return i >= 0 ? nodes.getUnchecked(i) : nullptr;
+            const int i = ++nextNodeToPop - 1;
+            return i < nodes.size() ? i : -1;
         }
 
     private:
@@ -94,13 +113,19 @@ struct MultiCPU
             buffer.setSize (rc.destBuffer != nullptr ? rc.destBuffer->getNumChannels() : 256,
                             rc.destBuffer != nullptr ? rc.destBuffer->getNumSamples()  : 1);
 
-            node.renderOver (AudioRenderContext (rc.playhead,
+            {
+                AudioRenderContext localContext (rc.playhead,
                                                  rc.streamTime,
                                                  rc.destBuffer != nullptr ? &buffer : nullptr,
                                                  rc.destBufferChannels,
                                                  0, rc.bufferNumSamples,
                                                  &midiBuffer, rc.midiBufferOffset,
-                                                 rc.continuity, rc.isRendering));
+                                                 rc.continuity, rc.isRendering);
+                localContext.profiler = rc.profiler;
+
+                const NodeProfiler::ScopedNodeTimer timer (rc.profiler, &node);
+                node.renderOver (localContext);
+            }
 
             const ScopedLock sl (outputBufferLock);
 
@@ -165,24 +190,23 @@ struct MultiCPU
         bool process (juce::AudioBuffer<float>& buffer)
         {
             ParallelMixOperation* op = nullptr;
-            AudioNode* node = nullptr;
+            int index = -1;
 
             {
                 const ScopedLock sl (opLock);
 
                 for (op = opList.get(); op != nullptr; op = op->nextListItem)
                 {
-                    if (auto n = op->popNextNode())
-                    {
-                        node = n;
+                    index = op->popNextNode();
+
+                    if (index >= 0)
                         break;
-                    }
                 }
             }
 
-            if (node != nullptr)
+            if (index >= 0)
             {
-                op->processNode (node, buffer);
+                op->processNode (index, buffer);
                 return true;
             }
 
@@ -212,7 +236,14 @@ struct MultiCPU
 
                 while (! threadShouldExit())
                 {
-                    if (! owner.process (buffer))
+                    bool processedNode = false;
+
+                    {
+                        const RealtimeSafetyChecker::ScopedRealtimeThread realtimeThread;
+                        processedNode = owner.process (buffer);
+                    }
+
+                    if (! processedNode)
                         wait (1000);
                 }
             }
@@ -316,6 +347,10 @@ void MixerAudioNode::visitNodes (const VisitorFn& v)
 
 void MixerAudioNode::prepareAudioNodeToPlay (const PlaybackInitialisationInfo& info)
 {
+    // This has to happen before the inputs are prepared, as that's when any
+    // aux sends in them work out whether they're rendered before their returns
+    sortInputsByAuxBusDependencies();
+
     for (auto input : inputs)
         input->prepareAudioNodeToPlay (info);
 
@@ -327,6 +362,105 @@ void MixerAudioNode::prepareAudioNodeToPlay (const PlaybackInitialisationInfo& i
                          && MultiCPU::MixerThreadPool::getInstance()->threads.size() > 0;
 }
 
+void MixerAudioNode::sortInputsByAuxBusDependencies()
+{
+    CRASH_TRACER
+    const int numInputs = inputs.size();
+
+    struct AuxBuses
+    {
+        BigInteger sends, returns;
+    };
+
+    std::vector<AuxBuses> buses ((size_t) numInputs);
+
+    for (int i = 0; i < numInputs; ++i)
+    {
+        inputs.getUnchecked (i)->visitNodes ([&b = buses[(size_t) i]] (AudioNode& n)
+                                             {
+                                                 auto p = n.getPlugin();
+
+                                                 if (auto send = dynamic_cast<AuxSendPlugin*> (p.get()))
+                                                     b.sends.setBit (send->getBusNumber());
+                                                 else if (auto ret = dynamic_cast<AuxReturnPlugin*> (p.get()))
+                                                     b.returns.setBit (ret->busNumber);
+                                             });
+    }
+
+    // An input depends on another if it returns a bus the other one sends to
+    auto dependsOn = [&buses] (int input, int other)
+    {
+        return input != other && ! (buses[(size_t) input].returns & buses[(size_t) other].sends).isZero();
+    };
+
+    std::vector<std::vector<int>> dependencies ((size_t) numInputs);
+    std::vector<int> numUnplacedDependencies ((size_t) numInputs, 0);
+
+    for (int i = 0; i < numInputs; ++i)
+    {
+        for (int j = 0; j < numInputs; ++j)
+        {
+            if (dependsOn (i, j))
+            {
+                dependencies[(size_t) i].push_back (j);
+                ++numUnplacedDependencies[(size_t) i];
+            }
+        }
+    }
+
+    // Repeatedly take the first input whose dependencies have all been placed, so that
+    // inputs only move if they have to. If only inputs in a feedback loop remain, the
+    // first of those is taken and its returns will get the audio a block late.
+    std::vector<int> order;
+    std::vector<bool> placed ((size_t) numInputs, false);
+
+    while ((int) order.size() < numInputs)
+    {
+        int next = -1;
+
+        for (int i = 0; i < numInputs && next < 0; ++i)
+            if (! placed[(size_t) i] && numUnplacedDependencies[(size_t) i] == 0)
+                next = i;
+
+        for (int i = 0; i < numInputs && next < 0; ++i)
+            if (! placed[(size_t) i])
+                next = i;
+
+        placed[(size_t) next] = true;
+        order.push_back (next);
+
+        for (int i = 0; i < numInputs; ++i)
+            if (! placed[(size_t) i] && dependsOn (i, next))
+                --numUnplacedDependencies[(size_t) i];
+    }
+
+    std::vector<int> newIndexes ((size_t) numInputs);
+    OwnedArray<AudioNode> sortedInputs;
+
+    for (auto index : order)
+    {
+        newIndexes[(size_t) index] = sortedInputs.size();
+        sortedInputs.add (inputs.getUnchecked (index));
+    }
+
+    inputs.clearQuick (false);
+    inputs.swapWith (sortedInputs);
+
+    // Only keep dependencies on earlier inputs so that a parallel render can't deadlock
+    inputDependencies.assign ((size_t) numInputs, {});
+
+    for (int i = 0; i < numInputs; ++i)
+    {
+        const int newIndex = newIndexes[(size_t) i];
+
+        for (auto dependency : dependencies[(size_t) i])
+            if (newIndexes[(size_t) dependency] < newIndex)
+                inputDependencies[(size_t) newIndex].push_back (newIndexes[(size_t) dependency]);
+    }
+
+    inputsFinished.reset (numInputs > 0 ? new std::atomic<bool>[(size_t) numInputs] : nullptr);
+}
+
 bool MixerAudioNode::isReadyToRender()
 {
     for (auto input : inputs)
@@ -346,7 +480,11 @@ void MixerAudioNode::multiCpuRender (const AudioRenderContext& rc)
 {
     if ((hasAudio || hasMidi) && inputs.size() > 0)
     {
-        MultiCPU::ParallelMixOperation parallelOp (rc, inputs);
+        const bool hasDependencies = (int) inputDependencies.size() == inputs.size() && inputsFinished != nullptr;
+
+        MultiCPU::ParallelMixOperation parallelOp (rc, inputs,
+                                                   hasDependencies ? &inputDependencies : nullptr,
+                                                   hasDependencies ? inputsFinished.get() : nullptr);
 
         parallelOp.buffer64 = nullptr;
 
@@ -394,6 +532,7 @@ void MixerAudioNode::renderAdding (const AudioRenderContext& rc)
             return;
         }
 
+        const NodeProfiler::ScopedNodeTimer timer (rc.profiler, this);
         AudioRenderContext localContext (rc);
 
         if (use64bitMixing && rc.destBuffer != nullptr)
@@ -405,7 +544,10 @@ void MixerAudioNode::renderAdding (const AudioRenderContext& rc)
 
             for (auto input : inputs)
             {
-                input->renderOver (localContext);
+                {
+                    const NodeProfiler::ScopedNodeTimer inputTimer (rc.profiler, input);
+                    input->renderOver (localContext);
+                }
 
                 if (! rc.destBuffer->hasBeenCleared())
                 {
@@ -426,7 +568,10 @@ void MixerAudioNode::renderAdding (const AudioRenderContext& rc)
         else
         {
             for (auto input : inputs)
+            {
+                const NodeProfiler::ScopedNodeTimer inputTimer (rc.profiler, input);
                 input->renderAdding (localContext);
+            }
         }
     }
     else if (inputs.size() == 1)
@@ -28,6 +28,9 @@ public:
     /** deletes all the input nodes */
     void clear();
 
+    /** Returns true if the inputs are being rendered on multiple threads. */
+    bool isRenderingInputsInParallel() const noexcept   { return shouldUseMultiCpu; }
+
     //==============================================================================
     // AudioNode methods..
 
@@ -46,10 +49,16 @@ public:
 
 private:
     void multiCpuRender (const AudioRenderContext&);
+    void sortInputsByAuxBusDependencies();
 
     //==============================================================================
     juce::OwnedArray<AudioNode> inputs;
 
+    // For each input, the indexes of the earlier inputs whose aux sends it returns,
+    // which have to finish before it can be rendered on another thread
+    std::vector<std::vector<int>> inputDependencies;
+    std::unique_ptr<std::atomic<bool>[]> inputsFinished;
+
     bool hasAudio = false, hasMidi = false;
     int maxNumberOfChannels = 0;
 
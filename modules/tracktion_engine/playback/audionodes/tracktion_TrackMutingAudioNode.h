@@ -22,6 +22,7 @@ public:
     {
         callInputWhileMuted = t.processAudioNodesWhileMuted();
         processMidiWhileMuted = track->state.getProperty (IDs::processMidiWhenMuted, false);
+        bypassWhenOverloaded = track->state.getProperty (IDs::bypassWhenOverloaded, false);
         
         if (auto at = dynamic_cast<AudioTrack*> (&t))
             if (muteForInputsWhenRecording)
@@ -41,7 +42,8 @@ public:
     //==============================================================================
     void renderOver (const AudioRenderContext& rc) override
     {
-        const bool isPlayingNow = isBeingPlayed();
+        const bool isBypassed = isBypassedToShedLoad (rc);
+        const bool isPlayingNow = ! isBypassed && isBeingPlayed();
 
         if (wasJustMuted (isPlayingNow))
         {
@@ -69,7 +71,7 @@ public:
         {
             input->renderOver (rc);
         }
-        else if (callInputWhileMuted || processMidiWhileMuted)
+        else if ((callInputWhileMuted || processMidiWhileMuted) && ! isBypassed)
         {
             input->renderOver (rc);
 
@@ -88,7 +90,8 @@ public:
 
     void renderAdding (const AudioRenderContext& rc) override
     {
-        const bool isPlayingNow = isBeingPlayed();
+        const bool isBypassed = isBypassedToShedLoad (rc);
+        const bool isPlayingNow = ! isBypassed && isBeingPlayed();
 
         if (wasJustMuted (isPlayingNow))
         {
@@ -106,7 +109,7 @@ public:
         {
             input->renderAdding (rc);
         }
-        else if (callInputWhileMuted || processMidiWhileMuted)
+        else if ((callInputWhileMuted || processMidiWhileMuted) && ! isBypassed)
         {
             callRenderOver (rc);
         }
@@ -120,8 +123,17 @@ private:
     bool wasBeingPlayed = false;
     bool callInputWhileMuted = false;
     bool processMidiWhileMuted = false;
+    bool bypassWhenOverloaded = false;
     juce::Array<InputDeviceInstance*> inputDevicesToMuteFor;
 
+    // Low priority tracks are faded out and not rendered at all while the
+    // DeviceManager is shedding load, but never when rendering offline
+    bool isBypassedToShedLoad (const AudioRenderContext& rc) const
+    {
+        return bypassWhenOverloaded && ! rc.isRendering
+                && edit.engine.getDeviceManager().isBypassingLowPriorityTracks();
+    }
+
     bool isBeingPlayed() const
     {
         bool playing = track != nullptr ? track->shouldBePlayed() : ! edit.areAnyTracksSolo();
@@ -58,9 +58,6 @@ int64 WaveAudioNode::editTimeToFileSample (double editTime) const noexcept
 
 struct WaveAudioNode::PerChannelState
 {
-    PerChannelState()    { resampler.reset(); }
-
-    juce::LagrangeInterpolator resampler;
     float lastSample = 0;
 };
 
@@ -75,6 +72,13 @@ void WaveAudioNode::prepareAudioNodeToPlay (const PlaybackInitialisationInfo& in
     if (reader != nullptr)
         for (int i = std::max (channelsToUse.size(), reader->getNumChannels()); --i >= 0;)
             channelState.add (new PerChannelState());
+
+    // If the file's rate isn't known yet, use the one in its info to choose the filter
+    auto fileSampleRate = audioFileSampleRate > 0.0 ? audioFileSampleRate : audioFile.getSampleRate();
+    auto nominalRatio = fileSampleRate > 0.0 ? fileSampleRate * originalSpeedRatio / outputSampleRate : 1.0;
+
+    resampler.prepare (audioFile.engine->getEngineBehaviour().getResamplingQuality(), channelState.size(), nominalRatio);
+    channelGains.resize ((size_t) channelState.size());
 }
 
 bool WaveAudioNode::isReadyToRender()
@@ -156,14 +160,20 @@ void WaveAudioNode::renderSection (const AudioRenderContext& rc, EditTimeRange e
 
     localReader->setReadPosition (fileStart);
 
-    AudioScratchBuffer fileData (rc.destBufferChannels.size(), numFileSamples + 2);
+    // The resampler's history is from wherever the last block was read, so would smear that in to this one
+    if (! rc.isContiguousWithPreviousBlock())
+        resampler.reset();
+
+    // The resampler needs to see a few samples past the ones it'll use
+    const auto numFileSamplesToRead = numFileSamples + resampler.getNumLookaheadSamples() + 1;
+    AudioScratchBuffer fileData (rc.destBufferChannels.size(), numFileSamplesToRead);
 
     int lastSampleFadeLength = 0;
 
     {
         SCOPED_REALTIME_CHECK
 
-        if (localReader->readSamples (numFileSamples + 2, fileData.buffer, rc.destBufferChannels, 0,
+        if (localReader->readSamples (numFileSamplesToRead, fileData.buffer, rc.destBufferChannels, 0,
                                       channelsToUse,
                                       rc.isRendering ? 5000 : 3))
         {
@@ -198,15 +208,22 @@ void WaveAudioNode::renderSection (const AudioRenderContext& rc, EditTimeRange e
         auto numDestChannels = std::min (rc.destBuffer->getNumChannels(), fileData.buffer.getNumChannels());
         jassert (numDestChannels <= channelState.size()); // this should always have been made big enough
 
+        auto numChannelsToResample = std::min (numDestChannels, channelState.size());
+
+        for (int channel = 0; channel < numChannelsToResample; ++channel)
+            channelGains[(size_t) channel] = gains[channel & 1];
+
+        // All the channels are resampled together so the filter coefficients are only worked out once
+        resampler.processAdding (ratio, fileData.buffer, numFileSamplesToRead,
+                                 *rc.destBuffer, rc.bufferStartSample, rc.bufferNumSamples,
+                                 channelGains.data());
+
         for (int channel = 0; channel < numDestChannels; ++channel)
         {
-            if (channel < channelState.size())
+            if (channel < numChannelsToResample)
             {
-                const auto src = fileData.buffer.getReadPointer (channel);
                 const auto dest = rc.destBuffer->getWritePointer (channel, rc.bufferStartSample);
-
                 auto& state = *channelState.getUnchecked (channel);
-                state.resampler.processAdding (ratio, src, dest, rc.bufferNumSamples, gains[channel & 1]);
 
                 if (lastSampleFadeLength > 0)
                 {
@@ -233,7 +250,40 @@ void WaveAudioNode::prepareForNextBlock (const AudioRenderContext& rc)
 
     // keep a local copy, because releaseAudioNodeResources may remove the reader halfway through..
     if (auto localReader = reader)
-        localReader->setReadPosition (editTimeToFileSample (rc.getEditTime().editRange1.getStart()));
+    {
+        auto time = rc.getEditTime().editRange1.getStart();
+        localReader->setReadPosition (editTimeToFileSample (time));
+
+        if (rc.playhead.isPlaying())
+            prefetchUpcomingReads (*localReader, rc, time);
+    }
+}
+
+void WaveAudioNode::prefetchUpcomingReads (AudioFileCache::Reader& r, const AudioRenderContext& rc, double time)
+{
+    // This is about as far ahead as the CombiningAudioNode will prepare us
+    const double prefetchTime = 4.0;
+
+    // If the playhead's approaching the clip, get its start ready..
+    const auto timeUntilStart = editPosition.getStart() - time;
+
+    if (timeUntilStart > 0.0 && timeUntilStart < prefetchTime)
+        r.prefetch (editTimeToFileSample (editPosition.getStart()), timeUntilStart);
+
+    // ..and if it's about to loop back, the part of the clip it'll jump to
+    if (rc.playhead.isLooping())
+    {
+        const auto loopTimes = rc.playhead.getLoopTimes();
+        const auto resumeTime = jmax (loopTimes.getStart(), editPosition.getStart());
+
+        if (time < loopTimes.getEnd() && resumeTime < jmin (loopTimes.getEnd(), editPosition.getEnd()))
+        {
+            const auto timeUntilNeeded = (loopTimes.getEnd() - time) + (resumeTime - loopTimes.getStart());
+
+            if (timeUntilNeeded < prefetchTime)
+                r.prefetch (editTimeToFileSample (resumeTime), timeUntilNeeded);
+        }
+    }
 }
 
 }
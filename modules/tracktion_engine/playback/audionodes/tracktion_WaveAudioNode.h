@@ -92,9 +92,12 @@ private:
 
     struct PerChannelState;
     juce::OwnedArray<PerChannelState> channelState;
+    SincResampler resampler;
+    std::vector<float> channelGains;
 
     juce::int64 editTimeToFileSample (double) const noexcept;
     bool updateFileSampleRate();
+    void prefetchUpcomingReads (AudioFileCache::Reader&, const AudioRenderContext&, double time);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveAudioNode)
 };
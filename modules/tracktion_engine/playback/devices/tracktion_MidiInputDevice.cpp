@@ -970,6 +970,7 @@ public:
             double start;
             double length = retrospective->lengthInSeconds;
             double offset = 0;
+            const double pausedTime = mi.getMasterStreamTime() - lastPlayingStreamTime;
 
             if (context.playhead.isPlaying())
             {
@@ -1025,12 +1026,8 @@ public:
     {
         if (context.playhead.isPlaying())
         {
-            pausedTime = 0;
             lastEditTime = context.playhead.streamTimeToSourceTime (time);
-        }
-        else
-        {
-            pausedTime += edit.engine.getDeviceManager().getBlockSizeMs() / 1000.0;
+            lastPlayingStreamTime = time;
         }
     }
 
@@ -1054,10 +1051,9 @@ private:
     struct InputAudioNode  : public AudioNode
     {
         InputAudioNode (MidiInputDeviceInstanceBase& m, MidiMessageArray::MPESourceID msi)
-            : owner (m), midiSourceID (msi)
+            : owner (m), incomingMessages (maxNumMessagesPerBlock, maxNumSysexBytesPerBlock), midiSourceID (msi)
         {
-            for (int i = 256; --i >= 0;)
-                incomingMessages.add (new MidiMessage (0x80, 0, 0));
+            blockMessages.reserve (maxNumMessagesPerBlock, maxNumSysexBytesPerBlock);
         }
 
         ~InputAudioNode() override
@@ -1085,22 +1081,16 @@ private:
         void prepareAudioNodeToPlay (const PlaybackInitialisationInfo& info) override
         {
             lastPlayheadTime = 0.0;
-            numMessages = 0;
             maxExpectedMsPerBuffer = (unsigned int) (((info.blockSizeSamples * 1000) / info.sampleRate) * 2 + 100);
-            auto& mi = getMidiInput();
 
             {
-                const ScopedLock sl (bufferLock);
-
-                auto channelToUse = mi.getChannelToUse();
-                auto programToUse = mi.getProgramToUse();
-
-                if (channelToUse.isValid() && programToUse > 0)
-                    handleIncomingMidiMessage (MidiMessage::programChange (channelToUse.getChannelNumber(), programToUse - 1));
+                // Stops any messages being pushed while the fifo is reset
+                const ScopedLock sl (owner.nodeLock);
+                incomingMessages.reset();
             }
 
             {
-                const ScopedLock sl (bufferLock);
+                const ScopedLock sl (liveInputLock);
                 liveRecordedMessages.clear();
                 numLiveMessagesToPlay = 0;
             }
@@ -1115,10 +1105,10 @@ private:
 
         void releaseAudioNodeResources() override
         {
+            // Once this has been removed nothing else can push to the fifo
             owner.remove (this);
 
-            const ScopedLock sl (bufferLock);
-            numMessages = 0;
+            incomingMessages.reset();
             numLiveMessagesToPlay = 0;
         }
 
@@ -1140,47 +1130,64 @@ private:
 
         void renderAdding (const AudioRenderContext& rc) override
         {
+            collectIncomingMessages (rc);
             invokeSplitRender (rc, *this);
         }
 
-        void renderSection (const AudioRenderContext& rc, EditTimeRange editTime)
+        // Pops the messages that arrived during the previous block from the fifo
+        void collectIncomingMessages (const AudioRenderContext& rc)
         {
-            if (rc.bufferForMidiMessages != nullptr)
+            blockMessages.clear();
+            nextBlockMessage = 0;
+            blockStreamTime = rc.streamTime;
+
+            const auto timeNow = Time::getApproximateMillisecondCounter();
+            const bool hasBeenLongTimeSinceLastBlock = timeNow > lastReadTime + maxExpectedMsPerBuffer;
+            lastReadTime = timeNow;
+
+            // if it's been a long time since the last block, clear the buffer because
+            // it means we were muted or glitching
+            if (hasBeenLongTimeSinceLastBlock)
             {
-                const auto timeNow = Time::getApproximateMillisecondCounter();
+                incomingMessages.discardAll();
+                return;
+            }
 
-                const ScopedLock sl (bufferLock);
+            // The messages are timestamped relative to the device's master time, which is
+            // updated at the start of each block
+            incomingMessages.popPreviousBlock (getMidiInput().getMasterStreamTime(), rc.streamTime.getLength(),
+                                               [this] (const juce::uint8* data, int numBytes, double timeInBlock)
+                                               {
+                                                   blockMessages.add (data, numBytes, timeInBlock, midiSourceID);
+                                               });
 
+            // Driver timestamps from different sources aren't always in order
+            blockMessages.sortByTimestamp();
+        }
+
+        void renderSection (const AudioRenderContext& rc, EditTimeRange editTime)
+        {
+            if (rc.bufferForMidiMessages != nullptr)
+            {
                 if (! rc.isContiguousWithPreviousBlock())
                     createProgramChanges (*rc.bufferForMidiMessages);
 
-                // if it's been a long time since the last block, clear the buffer because
-                // it means we were muted or glitching
-                if (timeNow > lastReadTime + maxExpectedMsPerBuffer)
-                {
-                    //jassertfalse
-                    numMessages = 0;
-                }
-
-                lastReadTime = timeNow;
-
-                jassert (numMessages <= incomingMessages.size());
+                // If the block is split, only the messages that fall in this section are added
+                const auto sectionStart = rc.streamTime.getStart() - blockStreamTime.getStart();
+                const auto sectionEnd = rc.streamTime.getEnd() - blockStreamTime.getStart();
+                const bool isLastSection = rc.streamTime.getEnd() >= blockStreamTime.getEnd();
 
-                if (int num = jmin (numMessages, incomingMessages.size()))
+                for (; nextBlockMessage < blockMessages.size(); ++nextBlockMessage)
                 {
-                    // not quite right as the first event won't be at the start of the buffer, but near enough for live stuff
-                    auto timeAdjust = incomingMessages.getUnchecked (0)->getTimeStamp();
+                    auto& e = blockMessages[nextBlockMessage];
 
-                    for (int i = 0; i < num; ++i)
-                    {
-                        auto* m = incomingMessages.getUnchecked (i);
-                        rc.bufferForMidiMessages->addMidiMessage (*m,
-                                                                  jlimit (0.0, jmax (0.0, editTime.getLength()), m->getTimeStamp() - timeAdjust),
-                                                                  midiSourceID);
-                    }
-                }
+                    if (e.timestamp >= sectionEnd && ! isLastSection)
+                        break;
 
-                numMessages = 0;
+                    rc.bufferForMidiMessages->addMidiMessage (blockMessages.getMessage (e),
+                                                              rc.midiBufferOffset + jmax (0.0, e.timestamp - sectionStart),
+                                                              midiSourceID);
+                }
 
                 if (lastPlayheadTime > editTime.getStart())
                     // when we loop, we can assume all the messages in here are now from the previous time round, so are playable
@@ -1215,19 +1222,15 @@ private:
             auto& mi = getMidiInput();
             auto channelToUse = mi.getChannelToUse().getChannelNumber();
 
+            if (channelToUse > 0)
             {
-                const ScopedLock sl (bufferLock);
-
-                if (numMessages < incomingMessages.size())
-                {
-                    auto& m = *incomingMessages.getUnchecked (numMessages);
-                    m = message;
-
-                    if (channelToUse > 0)
-                        m.setChannel (channelToUse);
-
-                    ++numMessages;
-                }
+                MidiMessage m (message);
+                m.setChannel (channelToUse);
+                incomingMessages.push (m);
+            }
+            else
+            {
+                incomingMessages.push (message);
             }
 
             if (owner.livePlayOver)
@@ -1264,9 +1267,14 @@ private:
     private:
         MidiInputDeviceInstanceBase& owner;
 
-        CriticalSection bufferLock;
-        OwnedArray<MidiMessage> incomingMessages;
-        int numMessages = 0;
+        // These are pushed by the instance with its nodeLock held, so there's only ever one
+        // producer, and popped by the audio thread at the start of each block
+        enum { maxNumMessagesPerBlock = 1024, maxNumSysexBytesPerBlock = 8192 };
+        MidiMessageFifo incomingMessages;
+        MidiEventBuffer blockMessages;
+        int nextBlockMessage = 0;
+        EditTimeRange blockStreamTime;
+
         MidiMessageArray liveRecordedMessages;
         int numLiveMessagesToPlay = 0; // the index of the first message that's been recorded in the current loop
         MidiMessageArray::MPESourceID midiSourceID = MidiMessageArray::notMPE;
@@ -1279,8 +1287,7 @@ private:
 
     CriticalSection nodeLock;
     Array<InputAudioNode*> nodes;
-    double lastEditTime = -1.0;
-    double pausedTime = 0;
+    std::atomic<double> lastEditTime { -1.0 }, lastPlayingStreamTime { 0.0 };
     MidiMessageArray::MPESourceID midiSourceID = MidiMessageArray::createUniqueMPESourceID();
 
     void add (InputAudioNode* node)     { ScopedLock sl (nodeLock); nodes.addIfNotAlreadyThere (node); }
@@ -1294,11 +1301,15 @@ private:
 void MidiInputDevice::masterTimeUpdate (double time)
 {
     adjustSecs = time - Time::getMillisecondCounterHiRes() * 0.001;
+    masterStreamTime = time;
 
-    const ScopedLock sl (instanceLock);
+    // This is called on the audio thread, so if a message is being sent to the instances
+    // they'll just have to pick up the time in the next block rather than us waiting
+    const ScopedTryLock sl (instanceLock);
 
-    for (auto instance : instances)
-        instance->masterTimeUpdate (time);
+    if (sl.isLocked())
+        for (auto instance : instances)
+            instance->masterTimeUpdate (time);
 }
 
 void MidiInputDevice::sendMessageToInstances (const MidiMessage& message)
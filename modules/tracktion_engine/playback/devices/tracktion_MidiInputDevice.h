@@ -50,7 +50,14 @@ public:
 
     //==============================================================================
     void flipEndToEnd() override;
+
+    /** Called on the audio thread at the start of each block with the stream time the
+        block will be heard at. Incoming messages are timestamped relative to this.
+    */
     void masterTimeUpdate (double time) override;
+
+    /** Returns the time last passed to masterTimeUpdate. */
+    double getMasterStreamTime() const noexcept     { return masterStreamTime; }
     void connectionStateChanged();
 
     //==============================================================================
@@ -110,7 +117,7 @@ public:
 protected:
     class MidiEventSnifferNode;
 
-    std::atomic<double> adjustSecs { 0 };
+    std::atomic<double> adjustSecs { 0 }, masterStreamTime { 0 };
     double manualAdjustMs = 0;
     bool overrideNoteVels = false, eventReceivedFromDevice = false;
     juce::BigInteger disallowedChannels;
@@ -123,6 +130,8 @@ protected:
     juce::uint8 keyDownVelocities[128];
     juce::SharedResourcePointer<MidiKeyChangeDispatcher> midiKeyChangeDispatcher;
 
+    // This is only held by the threads that send messages to the instances and the message
+    // thread, the audio thread only ever tries to take it
     juce::CriticalSection instanceLock;
     juce::Array<MidiInputDeviceInstanceBase*> instances;
     std::unique_ptr<RetrospectiveMidiBuffer> retrospectiveBuffer;
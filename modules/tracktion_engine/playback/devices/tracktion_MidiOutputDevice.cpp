@@ -694,6 +694,7 @@ MidiMessageArray& MidiOutputDeviceInstance::refillBuffer (PlayHead& playhead, Ed
                                    &dummyBuffer.buffer, dummyChannelSet, 0, blockSize,
                                    &midiMessages, 0,
                                    AudioRenderContext::contiguous, false);
+            rc.profiler = context.getNodeProfiler();
 
             {
                 SCOPED_REALTIME_CHECK_LONGER
@@ -701,6 +702,7 @@ MidiMessageArray& MidiOutputDeviceInstance::refillBuffer (PlayHead& playhead, Ed
             }
 
             SCOPED_REALTIME_CHECK_LONGER
+            const NodeProfiler::ScopedNodeTimer timer (rc.profiler, audioNode.get());
             audioNode->renderAdding (rc);
         }
     }
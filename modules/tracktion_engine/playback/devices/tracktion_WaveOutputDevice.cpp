@@ -140,6 +140,7 @@ void WaveOutputDeviceInstance::fillNextAudioBlock (PlayHead& playhead, EditTimeR
                                &outputBuffer, channelSet, 0, numSamples,
                                &midiBuffer, 0,
                                AudioRenderContext::contiguous, false);
+        rc.profiler = context.getNodeProfiler();
 
         {
             SCOPED_REALTIME_CHECK_LONGER
@@ -147,6 +148,7 @@ void WaveOutputDeviceInstance::fillNextAudioBlock (PlayHead& playhead, EditTimeR
         }
 
         SCOPED_REALTIME_CHECK_LONGER
+        const NodeProfiler::ScopedNodeTimer timer (rc.profiler, audioNode.get());
         audioNode->renderOver (rc);
 
         if (wo.ditheringEnabled)
@@ -169,6 +169,486 @@ private:
     }
 };
 
+//==============================================================================
+/** Renders a set of contexts concurrently, each in to its own buffer which is then
+    mixed in to the device outputs in the order of the contexts.
+    The audio thread renders contexts too so the pool only needs one fewer thread
+    than the number of CPUs to use.
+
+    Contexts are claimed with a compare-and-swap on a single 64-bit value holding the
+    job's generation, its number of contexts and the next index, so a thread that's
+    late from one job can never claim a context from the next. Waking the workers and
+    the audio thread goes through Semaphores so neither side takes a lock.
+
+    This is a template so it can be tested without an EditPlaybackContext. The context
+    type just needs a fillNextAudioBlock (EditTimeRange, float**, int) method.
+*/
+template<typename ContextType>
+struct ParallelRenderer
+{
+    ParallelRenderer() = default;
+
+    ~ParallelRenderer()
+    {
+        setNumThreads (0);
+    }
+
+    /** Sets the number of worker threads. Not to be called on the audio thread. */
+    void setNumThreads (int numThreads)
+    {
+        if (workers.size() != numThreads)
+        {
+            for (auto w : workers)
+                w->signalThreadShouldExit();
+
+            // Each worker is either running, so will see it should exit, or needs waking
+            for (int i = workers.size(); --i >= 0;)
+                workAvailable.signal();
+
+            workers.clear();
+
+            while (workers.size() < numThreads)
+                workers.add (new Worker (*this));
+        }
+    }
+
+    /** Makes sure there are buffers for a number of contexts.
+        This allocates so should be called under the contextLock on the message thread.
+    */
+    void prepare (int numContexts, int numChannels, int maxNumSamples)
+    {
+        while (buffers.size() < numContexts)
+            buffers.add (new juce::AudioBuffer<float>());
+
+        if ((int) contextTicks.size() < numContexts)
+            contextTicks.resize ((size_t) numContexts);
+
+        for (auto b : buffers)
+            if (b->getNumChannels() < numChannels || b->getNumSamples() < maxNumSamples)
+                b->setSize (jmax (numChannels, b->getNumChannels()), jmax (maxNumSamples, b->getNumSamples()));
+    }
+
+    bool canRender (int numContexts, int numChannels, int numSamples) const noexcept
+    {
+        if (workers.isEmpty() || numContexts < 2 || numContexts > maxNumContexts
+             || buffers.size() < numContexts || (int) contextTicks.size() < numContexts)
+            return false;
+
+        for (int i = 0; i < numContexts; ++i)
+            if (buffers.getUnchecked (i)->getNumChannels() < numChannels
+                 || buffers.getUnchecked (i)->getNumSamples() < numSamples)
+                return false;
+
+        return true;
+    }
+
+    void render (const juce::Array<ContextType*>& contexts, EditTimeRange streamTime,
+                 float** outputChannelData, int numChannels, int numSamples)
+    {
+        jassert (canRender (contexts.size(), numChannels, numSamples));
+
+        // No thread can be reading the job now as the last one has finished, and the
+        // release store of the new claim publishes it to any thread that claims from it
+        job = { &contexts, streamTime, numSamples };
+        numContextsLeft.store (contexts.size(), std::memory_order_relaxed);
+
+        generation = (generation + 1) & 0xffffffffu;
+        claim.store (packClaim (generation, (juce::uint64) contexts.size(), 0), std::memory_order_release);
+
+        for (int i = workers.size(); --i >= 0;)
+            workAvailable.signal();
+
+        bool renderedLast = false;
+
+        for (;;)
+        {
+            auto result = renderNextContext();
+
+            if (result == RenderResult::none)
+                break;
+
+            if (result == RenderResult::last)
+                renderedLast = true;
+        }
+
+        // If a worker finished the last context it signals this exactly once for the job
+        if (! renderedLast)
+            jobFinished.wait();
+
+        for (int i = 0; i < contexts.size(); ++i)
+        {
+            auto& buffer = *buffers.getUnchecked (i);
+
+            for (int chan = 0; chan < numChannels; ++chan)
+                if (auto dest = outputChannelData[chan])
+                    FloatVectorOperations::add (dest, buffer.getReadPointer (chan), numSamples);
+        }
+    }
+
+    /** Returns how long a context took to render in the last call to render(). */
+    juce::int64 getContextTicks (int index) const noexcept
+    {
+        return contextTicks[(size_t) index];
+    }
+
+private:
+    struct Worker  : public juce::Thread
+    {
+        Worker (ParallelRenderer& o)
+            : Thread ("Edit renderer"), owner (o)
+        {
+            startThread (Thread::realtimeAudioPriority);
+        }
+
+        ~Worker() override
+        {
+            stopThread (5000);
+        }
+
+        void run() override
+        {
+            FloatVectorOperations::disableDenormalisedNumberSupport();
+
+            while (! threadShouldExit())
+            {
+                {
+                    const RealtimeSafetyChecker::ScopedRealtimeThread realtimeThread;
+
+                    for (;;)
+                    {
+                        auto result = owner.renderNextContext();
+
+                        if (result == RenderResult::none)
+                            break;
+
+                        if (result == RenderResult::last)
+                            owner.jobFinished.signal();
+                    }
+                }
+
+                owner.workAvailable.wait();
+            }
+        }
+
+        ParallelRenderer& owner;
+    };
+
+    struct Job
+    {
+        const juce::Array<ContextType*>* contexts = nullptr;
+        EditTimeRange streamTime;
+        int numSamples = 0;
+    };
+
+    enum class RenderResult { none, rendered, last };
+
+    static constexpr int maxNumContexts = 0xffff;
+
+    juce::OwnedArray<Worker> workers;
+    juce::OwnedArray<juce::AudioBuffer<float>> buffers;
+    std::vector<juce::int64> contextTicks;
+    Semaphore workAvailable, jobFinished;
+
+    // Only written by the audio thread between jobs
+    Job job;
+    juce::uint64 generation = 0;
+
+    // The generation in the top 32 bits, the number of contexts in the next 16 and the next index in the bottom 16
+    std::atomic<juce::uint64> claim { 0 };
+    std::atomic<int> numContextsLeft { 0 };
+
+    static juce::uint64 packClaim (juce::uint64 gen, juce::uint64 numContexts, juce::uint64 index) noexcept
+    {
+        return (gen << 32) | (numContexts << 16) | index;
+    }
+
+    RenderResult renderNextContext()
+    {
+        auto current = claim.load (std::memory_order_acquire);
+        int index;
+
+        for (;;)
+        {
+            const auto numContexts = (current >> 16) & 0xffff;
+            const auto nextIndex = current & 0xffff;
+
+            if (nextIndex >= numContexts)
+                return RenderResult::none;
+
+            if (claim.compare_exchange_weak (current, current + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                index = (int) nextIndex;
+                break;
+            }
+        }
+
+        auto& buffer = *buffers.getUnchecked (index);
+
+        for (int i = buffer.getNumChannels(); --i >= 0;)
+            FloatVectorOperations::clear (buffer.getWritePointer (i), job.numSamples);
+
+        const auto startTicks = Time::getHighResolutionTicks();
+        job.contexts->getUnchecked (index)->fillNextAudioBlock (job.streamTime, buffer.getArrayOfWritePointers(), job.numSamples);
+        contextTicks[(size_t) index] = Time::getHighResolutionTicks() - startTicks;
+
+        return numContextsLeft.fetch_sub (1, std::memory_order_acq_rel) == 1 ? RenderResult::last
+                                                                             : RenderResult::rendered;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParallelRenderer)
+};
+
+struct DeviceManager::ParallelContextRenderer  : public ParallelRenderer<EditPlaybackContext>
+{
+};
+
+//==============================================================================
+/** The audio thread pushes the timings of each callback in to a lock-free FIFO and
+    this aggregates them on a background thread. From there it reports them to the
+    CPUUsageListeners and decides how much load needs to be shed.
+*/
+struct DeviceManager::CallbackTelemetry  : private juce::Thread
+{
+    struct BlockStats
+    {
+        /** Adds the render time of a context. The space for these is reserved by
+            setMaxNumContexts() so this never allocates on the audio thread.
+        */
+        void addContext (const EditPlaybackContext* c, juce::int64 ticks) noexcept
+        {
+            if (contexts.size() < contexts.capacity())
+                contexts.push_back ({ c, ticks });
+            else
+                ++numContextsDropped;
+        }
+
+        struct ContextTicks
+        {
+            const EditPlaybackContext* context;
+            juce::int64 ticks;
+        };
+
+        juce::int64 durationTicks = 0;
+        double blockSeconds = 0;
+        int numXRuns = -1; // -1 if the device can't report them
+        std::vector<ContextTicks> contexts;
+        int numContextsDropped = 0;
+    };
+
+    using ReportFunction = std::function<void (float cpuAvg, float cpuMin, float cpuMax, int numGlitches)>;
+    using LoadSheddingFunction = std::function<void (LoadSheddingLevel)>;
+
+    CallbackTelemetry (const std::atomic<double>& cpuLimit, ReportFunction reportFn, LoadSheddingFunction loadSheddingFn)
+        : Thread ("CPU telemetry"), cpuLimitBeforeShedding (cpuLimit),
+          report (std::move (reportFn)), setLoadSheddingLevel (std::move (loadSheddingFn)),
+          fifoSlots ((size_t) fifo.getTotalSize())
+    {
+        setMaxNumContexts (8);
+        startThread (3);
+    }
+
+    ~CallbackTelemetry() override
+    {
+        stopThread (5000);
+    }
+
+    /** Makes sure the stats for a block can hold this many contexts.
+        This must be called while the audio callback isn't running.
+    */
+    void setMaxNumContexts (int numContexts)
+    {
+        const auto num = (size_t) jmax (1, numContexts);
+
+        if (num <= currentBlock.contexts.capacity())
+            return;
+
+        const ScopedLock sl (fifoSlotLock);
+        currentBlock.contexts.reserve (num);
+
+        for (auto& slot : fifoSlots)
+            slot.contexts.reserve (num);
+    }
+
+    /** Called by the audio thread at the start of each callback.
+        Returns the stats to fill in before calling endBlock().
+    */
+    BlockStats& beginBlock (double blockSeconds) noexcept
+    {
+        currentBlock.durationTicks = 0;
+        currentBlock.blockSeconds = blockSeconds;
+        currentBlock.numXRuns = -1;
+        currentBlock.contexts.clear();
+        currentBlock.numContextsDropped = 0;
+        return currentBlock;
+    }
+
+    /** Called by the audio thread at the end of each callback to queue its stats.
+        Returns false if the FIFO was full and they had to be dropped.
+    */
+    bool endBlock() noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        // If the background thread is starved the statistics are just dropped
+        if (size1 + size2 == 0)
+            return false;
+
+        auto& slot = fifoSlots[(size_t) (size1 > 0 ? start1 : start2)];
+        slot.durationTicks = currentBlock.durationTicks;
+        slot.blockSeconds = currentBlock.blockSeconds;
+        slot.numXRuns = currentBlock.numXRuns;
+        slot.numContextsDropped = currentBlock.numContextsDropped;
+
+        // This is within the capacity reserved by setMaxNumContexts so doesn't allocate
+        slot.contexts.clear();
+        slot.contexts.insert (slot.contexts.end(), currentBlock.contexts.begin(), currentBlock.contexts.end());
+
+        fifo.finishedWrite (1);
+        return true;
+    }
+
+    /** Sets how many blocks the CPU usage reports are averaged over and starts a new interval. */
+    void restart (int numBlocksPerReport) noexcept
+    {
+        reportingInterval = jmax (1, numBlocksPerReport);
+        restartPending = true;
+    }
+
+    float getCpuUsage (const EditPlaybackContext& c) const
+    {
+        const ScopedLock sl (contextUsageLock);
+        auto found = contextUsage.find (&c);
+        return found != contextUsage.end() ? found->second : 0.0f;
+    }
+
+private:
+    const std::atomic<double>& cpuLimitBeforeShedding;
+    const ReportFunction report;
+    const LoadSheddingFunction setLoadSheddingLevel;
+
+    juce::AbstractFifo fifo { 512 };
+    std::vector<BlockStats> fifoSlots;
+    juce::CriticalSection fifoSlotLock;
+    BlockStats currentBlock; // Only used on the audio thread
+    std::atomic<int> reportingInterval { 1 };
+    std::atomic<bool> restartPending { false };
+
+    struct Interval
+    {
+        int numBlocks = 0, numGlitches = 0;
+        float total = 0.0f, min = 1.0f, max = 0.0f;
+        std::map<const EditPlaybackContext*, double> contextTotals;
+    };
+
+    // These are only used on the telemetry thread
+    Interval interval;
+    double smoothedUsage = 0.0, secondsSinceLevelChange = 0.0;
+    LoadSheddingLevel loadSheddingLevel = LoadSheddingLevel::none;
+
+    juce::CriticalSection contextUsageLock;
+    std::map<const EditPlaybackContext*, float> contextUsage;
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            wait (20);
+
+            if (restartPending.exchange (false))
+            {
+                interval = {};
+                smoothedUsage = 0.0;
+                secondsSinceLevelChange = 0.0;
+                loadSheddingLevel = LoadSheddingLevel::none;
+            }
+
+            const ScopedLock sl (fifoSlotLock);
+            int start1, size1, start2, size2;
+            fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+            for (int i = start1; i < start1 + size1; ++i)
+                addBlock (fifoSlots[(size_t) i]);
+
+            for (int i = start2; i < start2 + size2; ++i)
+                addBlock (fifoSlots[(size_t) i]);
+
+            fifo.finishedRead (size1 + size2);
+        }
+    }
+
+    void addBlock (const BlockStats& stats)
+    {
+        if (stats.blockSeconds <= 0.0)
+            return;
+
+        // The contexts should have been reserved for when they were added
+        jassert (stats.numContextsDropped == 0);
+
+        const double ticksToUsage = 1.0 / (Time::getHighResolutionTicksPerSecond() * stats.blockSeconds);
+        const auto usage = (float) (stats.durationTicks * ticksToUsage);
+
+        interval.total += usage;
+        interval.min = jmin (interval.min, usage);
+        interval.max = jmax (interval.max, usage);
+
+        // If the device counts its xruns they're the real number of glitches, otherwise
+        // a block that took longer than its own length is the best guess
+        if (stats.numXRuns >= 0)
+            interval.numGlitches += stats.numXRuns;
+        else if (usage > 1.0f)
+            ++interval.numGlitches;
+
+        for (auto& c : stats.contexts)
+            interval.contextTotals[c.context] += c.ticks * ticksToUsage;
+
+        updateLoadShedding (usage, stats.blockSeconds);
+
+        if (++interval.numBlocks >= reportingInterval)
+            reportInterval();
+    }
+
+    void updateLoadShedding (float usage, double blockSeconds)
+    {
+        // Smoothing over a few blocks stops a single slow one shedding anything. Going up a
+        // level happens quickly but going back down waits for things to settle first.
+        smoothedUsage += 0.1 * (usage - smoothedUsage);
+        secondsSinceLevelChange += blockSeconds;
+
+        const double limit = cpuLimitBeforeShedding;
+        auto level = loadSheddingLevel;
+
+        if (smoothedUsage > limit && level != LoadSheddingLevel::muteOutput && secondsSinceLevelChange > 0.1)
+            level = level == LoadSheddingLevel::none ? LoadSheddingLevel::bypassLowPriorityTracks
+                                                     : LoadSheddingLevel::muteOutput;
+        else if (smoothedUsage < limit * 0.75 && level != LoadSheddingLevel::none && secondsSinceLevelChange > 1.0)
+            level = level == LoadSheddingLevel::muteOutput ? LoadSheddingLevel::bypassLowPriorityTracks
+                                                           : LoadSheddingLevel::none;
+        else
+            return;
+
+        loadSheddingLevel = level;
+        secondsSinceLevelChange = 0.0;
+        setLoadSheddingLevel (level);
+    }
+
+    void reportInterval()
+    {
+        {
+            const ScopedLock sl (contextUsageLock);
+            contextUsage.clear();
+
+            for (auto& c : interval.contextTotals)
+                contextUsage[c.first] = (float) (c.second / interval.numBlocks);
+        }
+
+        report (interval.total / (float) interval.numBlocks, interval.min, interval.max, interval.numGlitches);
+        interval = {};
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CallbackTelemetry)
+};
+
 
 //==============================================================================
 //==============================================================================
@@ -177,6 +657,15 @@ DeviceManager::DeviceManager (Engine& e) : engine (e)
     CRASH_TRACER
 
     contextDeviceClearer = std::make_unique<ContextDeviceClearer> (*this);
+    parallelContextRenderer = std::make_unique<ParallelContextRenderer>();
+    callbackTelemetry = std::make_unique<CallbackTelemetry> (cpuLimitBeforeMuting,
+                                                             [this] (float cpuAvg, float cpuMin, float cpuMax, int numGlitches)
+                                                             {
+                                                                 const ScopedLock sl (cpuUsageListenerLock);
+                                                                 cpuUsageListeners.call (&CPUUsageListener::reportCPUUsage,
+                                                                                         cpuAvg, cpuMin, cpuMax, numGlitches);
+                                                             },
+                                                             [this] (LoadSheddingLevel level) { loadSheddingLevel = level; });
     setInternalBufferMultiplier (engine.getPropertyStorage().getProperty (SettingID::internalBuffer, 1));
 
     deviceManager.addChangeListener (this);
@@ -190,6 +679,11 @@ DeviceManager::~DeviceManager()
 
     CRASH_TRACER
     deviceManager.removeChangeListener (this);
+
+    // The audio callback pushes to the telemetry so it has to be stopped first
+    deviceManager.removeAudioCallback (this);
+    deviceManager.closeAudioDevice();
+    callbackTelemetry.reset();
 }
 
 HostedAudioDeviceInterface& DeviceManager::getHostedAudioDeviceInterface()
@@ -971,11 +1465,14 @@ MidiInputDevice* DeviceManager::getMidiInDevice (int index) const
 
 void DeviceManager::broadcastStreamTimeToMidiDevices (double timeToBroadcast)
 {
-    const ScopedLock sl (midiInputs.getLock());
+    // The list is only locked by the message thread while devices are being added or removed,
+    // so rather than wait for it, the devices can keep the previous block's time
+    const ScopedTryLock sl (midiInputs.getLock());
 
-    for (auto mi : midiInputs)
-        if (mi->isEnabled())
-            mi->masterTimeUpdate (timeToBroadcast);
+    if (sl.isLocked())
+        for (auto mi : midiInputs)
+            if (mi->isEnabled())
+                mi->masterTimeUpdate (timeToBroadcast);
 }
 
 int DeviceManager::getNumInputDevices() const
@@ -1060,6 +1557,7 @@ void DeviceManager::audioDeviceIOCallback (const float** inputChannelData, int n
 {
     CRASH_TRACER
     FloatVectorOperations::disableDenormalisedNumberSupport();
+    const RealtimeSafetyChecker::ScopedRealtimeThread realtimeThread;
 
     {
        #if JUCE_ANDROID
@@ -1067,15 +1565,13 @@ void DeviceManager::audioDeviceIOCallback (const float** inputChannelData, int n
        #endif
 
         const auto startTimeTicks = Time::getHighResolutionTicks();
+        auto& stats = callbackTelemetry->beginBlock (numSamples / currentSampleRate);
 
-        if (currentCpuUsage > cpuLimitBeforeMuting)
+        if (loadSheddingLevel == LoadSheddingLevel::muteOutput)
         {
             for (int i = 0; i < totalNumOutputChannels; ++i)
                 if (auto dest = outputChannelData[i])
                     FloatVectorOperations::clear (dest, numSamples);
-
-            currentCpuUsage = jmin (0.9, currentCpuUsage * 0.99);
-            Thread::sleep (1);
         }
         else
         {
@@ -1100,8 +1596,22 @@ void DeviceManager::audioDeviceIOCallback (const float** inputChannelData, int n
 
                 blockStreamTime = { streamTime, streamTime + blockLength };
 
-                for (auto c : activeContexts)
-                    c->fillNextAudioBlock (blockStreamTime, outputChannelData, numSamples);
+                if (parallelContextRenderer->canRender (activeContexts.size(), totalNumOutputChannels, numSamples))
+                {
+                    parallelContextRenderer->render (activeContexts, blockStreamTime, outputChannelData, totalNumOutputChannels, numSamples);
+
+                    for (int i = 0; i < activeContexts.size(); ++i)
+                        stats.addContext (activeContexts.getUnchecked (i), parallelContextRenderer->getContextTicks (i));
+                }
+                else
+                {
+                    for (auto c : activeContexts)
+                    {
+                        const auto contextStartTicks = Time::getHighResolutionTicks();
+                        c->fillNextAudioBlock (blockStreamTime, outputChannelData, numSamples);
+                        stats.addContext (c, Time::getHighResolutionTicks() - contextStartTicks);
+                    }
+                }
             }
 
            #if JUCE_MAC
@@ -1120,35 +1630,23 @@ void DeviceManager::audioDeviceIOCallback (const float** inputChannelData, int n
         if (globalOutputAudioProcessor != nullptr)
         {
             AudioBuffer<float> ab (outputChannelData, totalNumOutputChannels, numSamples);
-            MidiBuffer mb;
-            globalOutputAudioProcessor->processBlock (ab, mb);
+            globalOutputMidiBuffer.clear();
+            globalOutputAudioProcessor->processBlock (ab, globalOutputMidiBuffer);
         }
 
+        if (auto device = deviceManager.getCurrentAudioDevice())
         {
-            const auto timeWindowSec = numSamples / static_cast<float> (currentSampleRate);
-
-            const auto currentCpuUtilisation = float (Time::getHighResolutionTicks() - startTimeTicks) / Time::getHighResolutionTicksPerSecond() / timeWindowSec;
-
-            cpuAvg += currentCpuUtilisation;
-            cpuMin = jmin (cpuMin, currentCpuUtilisation);
-            cpuMax = jmax (cpuMax, currentCpuUtilisation);
-
-            if (currentCpuUtilisation > 1)
-                ++glitchCntr;
+            const int xRunCount = device->getXRunCount();
 
-            if (--cpuAvgCounter == 0)
+            if (xRunCount >= 0)
             {
-                cpuAvg /= static_cast<float> (cpuReportingInterval);
-
-                cpuUsageListeners.call (&CPUUsageListener::reportCPUUsage, cpuAvg, cpuMin, cpuMax, glitchCntr);
-
-                cpuAvg = 0;
-                cpuMin = 1;
-                cpuMax = 0;
-                glitchCntr = 0;
-                cpuAvgCounter = cpuReportingInterval;
+                stats.numXRuns = jmax (0, xRunCount - lastXRunCount);
+                lastXRunCount = xRunCount;
             }
         }
+
+        stats.durationTicks = Time::getHighResolutionTicks() - startTimeTicks;
+        callbackTelemetry->endBlock();
     }
 }
 
@@ -1159,6 +1657,7 @@ void DeviceManager::audioDeviceAboutToStart (AudioIODevice* device)
 
     streamTime = 0;
     currentCpuUsage = 0.0f;
+    lastXRunCount = jmax (0, device->getXRunCount());
     currentSampleRate = device->getCurrentSampleRate();
     currentLatencyMs  = device->getCurrentBufferSizeSamples() * 1000.0f / currentSampleRate;
     outputLatencyTime = device->getOutputLatencyInSamples() / currentSampleRate;
@@ -1171,6 +1670,7 @@ void DeviceManager::audioDeviceAboutToStart (AudioIODevice* device)
     reloadAllContextDevices();
 
     const ScopedLock sl (contextLock);
+    prepareParallelContextRenderer (device);
 
     for (auto c : activeContexts)
     {
@@ -1181,10 +1681,15 @@ void DeviceManager::audioDeviceAboutToStart (AudioIODevice* device)
     if (globalOutputAudioProcessor != nullptr)
         globalOutputAudioProcessor->prepareToPlay (currentSampleRate, device->getCurrentBufferSizeSamples());
 
+    globalOutputMidiBuffer.ensureSize (2048);
+
+    // Report the CPU usage about once a second
+    loadSheddingLevel = LoadSheddingLevel::none;
+
     if (device->getCurrentBufferSizeSamples() > 0)
-        cpuAvgCounter = cpuReportingInterval = jmax (1, static_cast<int> (device->getCurrentSampleRate()) / device->getCurrentBufferSizeSamples());
+        callbackTelemetry->restart (static_cast<int> (device->getCurrentSampleRate()) / device->getCurrentBufferSizeSamples());
     else
-        cpuAvgCounter = cpuReportingInterval = 1;
+        callbackTelemetry->restart (1);
 
    #if JUCE_ANDROID
     steadyLoadContext.setSampleRate (device->getCurrentSampleRate());
@@ -1200,10 +1705,47 @@ void DeviceManager::audioDeviceStopped()
         globalOutputAudioProcessor->releaseResources();
 }
 
+float DeviceManager::getCpuUsage (const EditPlaybackContext& context) const
+{
+    return callbackTelemetry->getCpuUsage (context);
+}
+
+void DeviceManager::addCPUUsageListener (CPUUsageListener* listener)
+{
+    const ScopedLock sl (cpuUsageListenerLock);
+    cpuUsageListeners.add (listener);
+}
+
+void DeviceManager::removeCPUUsageListener (CPUUsageListener* listener)
+{
+    const ScopedLock sl (cpuUsageListenerLock);
+    cpuUsageListeners.remove (listener);
+}
+
 void DeviceManager::updateNumCPUs()
 {
-    const ScopedLock sl (deviceManager.getAudioCallbackLock());
-    MixerAudioNode::updateNumCPUs (engine);
+    {
+        const ScopedLock sl (deviceManager.getAudioCallbackLock());
+        MixerAudioNode::updateNumCPUs (engine);
+    }
+
+    const auto& behaviour = engine.getEngineBehaviour();
+    const int numThreads = behaviour.shouldRenderEditsInParallel() ? behaviour.getNumberOfCPUsToUseForAudio() - 1 : 0;
+
+    // The audio thread might be rendering with the workers so stop it whilst they're changed
+    const ScopedLock sl (contextLock);
+    parallelContextRenderer->setNumThreads (numThreads);
+}
+
+void DeviceManager::prepareParallelContextRenderer (juce::AudioIODevice* device)
+{
+    if (device == nullptr)
+        device = deviceManager.getCurrentAudioDevice();
+
+    if (device != nullptr)
+        parallelContextRenderer->prepare (activeContexts.size(),
+                                          device->getActiveOutputChannels().getHighestBit() + 1,
+                                          device->getCurrentBufferSizeSamples());
 }
 
 void DeviceManager::addContext (EditPlaybackContext* c)
@@ -1213,9 +1755,13 @@ void DeviceManager::addContext (EditPlaybackContext* c)
     double lastStreamTime;
 
     {
+        // The telemetry's space for the contexts can only change while the audio callback isn't running
+        const ScopedLock acl (deviceManager.getAudioCallbackLock());
         const ScopedLock sl (contextLock);
         lastStreamTime = streamTime;
         activeContexts.addIfNotAlreadyThere (c);
+        prepareParallelContextRenderer (nullptr);
+        callbackTelemetry->setMaxNumContexts (activeContexts.size());
     }
 
     for (int i = 200; --i >= 0;)
@@ -1258,4 +1804,255 @@ void DeviceManager::setGlobalOutputAudioProcessor (juce::AudioProcessor* newProc
             globalOutputAudioProcessor->prepareToPlay (currentSampleRate, audioIODevice->getCurrentBufferSizeSamples());
 }
 
+//==============================================================================
+#if TRACKTION_UNIT_TESTS
+
+class ParallelRendererTests  : public juce::UnitTest
+{
+public:
+    ParallelRendererTests() : juce::UnitTest ("ParallelRenderer", "Tracktion") {}
+
+    struct TestContext
+    {
+        TestContext (float v) : value (v) {}
+
+        void fillNextAudioBlock (EditTimeRange, float** channels, int numSamples)
+        {
+            ++numBlocksRendered;
+
+            for (int chan = 0; chan < numChannels; ++chan)
+                FloatVectorOperations::fill (channels[chan], value, numSamples);
+        }
+
+        const float value;
+        std::atomic<int> numBlocksRendered { 0 };
+    };
+
+    void runTest() override
+    {
+        beginTest ("Each context is rendered once per block");
+        {
+            constexpr int maxNumContexts = 8, numSamples = 64;
+
+            ParallelRenderer<TestContext> renderer;
+            renderer.setNumThreads (3);
+            renderer.prepare (maxNumContexts, numChannels, numSamples);
+
+            // Each context adds a different bit so a context that's missed or rendered twice shows up in the sum
+            OwnedArray<TestContext> contexts;
+            std::vector<int> expectedNumBlocks (maxNumContexts, 0);
+
+            for (int i = 0; i < maxNumContexts; ++i)
+                contexts.add (new TestContext ((float) (1 << i)));
+
+            juce::AudioBuffer<float> output (numChannels, numSamples);
+            auto& r = getRandom();
+            int numWrongBlocks = 0;
+
+            // The number of contexts changes between blocks so a late claim from one
+            // block would pick the wrong context in the next
+            for (int block = 0; block < 5000; ++block)
+            {
+                const int numContexts = r.nextInt ({ 2, maxNumContexts + 1 });
+                juce::Array<TestContext*> active;
+
+                for (int i = 0; i < numContexts; ++i)
+                {
+                    active.add (contexts.getUnchecked (i));
+                    ++expectedNumBlocks[(size_t) i];
+                }
+
+                expect (renderer.canRender (numContexts, numChannels, numSamples));
+
+                output.clear();
+                renderer.render (active, { block * 0.001, (block + 1) * 0.001 },
+                                 output.getArrayOfWritePointers(), numChannels, numSamples);
+
+                const auto expected = (float) ((1 << numContexts) - 1);
+
+                if (output.getSample (0, 0) != expected || output.getSample (numChannels - 1, numSamples - 1) != expected)
+                    ++numWrongBlocks;
+            }
+
+            expectEquals (numWrongBlocks, 0);
+
+            for (int i = 0; i < maxNumContexts; ++i)
+                expectEquals (contexts.getUnchecked (i)->numBlocksRendered.load(), expectedNumBlocks[(size_t) i]);
+        }
+
+        beginTest ("Changing the number of threads");
+        {
+            ParallelRenderer<TestContext> renderer;
+            renderer.prepare (2, numChannels, 32);
+            expect (! renderer.canRender (2, numChannels, 32));
+
+            TestContext c1 (1.0f), c2 (2.0f);
+            juce::Array<TestContext*> active { &c1, &c2 };
+            juce::AudioBuffer<float> output (numChannels, 32);
+
+            for (int numThreads : { 1, 4, 2 })
+            {
+                renderer.setNumThreads (numThreads);
+                expect (renderer.canRender (2, numChannels, 32));
+
+                output.clear();
+                renderer.render (active, { 0.0, 0.001 }, output.getArrayOfWritePointers(), numChannels, 32);
+                expectEquals (output.getSample (0, 0), 3.0f);
+            }
+        }
+    }
+
+    static constexpr int numChannels = 2;
+};
+
+static ParallelRendererTests parallelRendererTests;
+
+//==============================================================================
+class CallbackTelemetryTests  : public juce::UnitTest
+{
+public:
+    CallbackTelemetryTests() : juce::UnitTest ("CallbackTelemetry", "Tracktion") {}
+
+    using LoadSheddingLevel = DeviceManager::LoadSheddingLevel;
+
+    struct Report
+    {
+        float cpuAvg, cpuMin, cpuMax;
+        int numGlitches;
+    };
+
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines()[0];
+        auto edit = Edit::createSingleTrackEdit (engine);
+        edit->getTransport().ensureContextAllocated();
+        auto context = edit->getCurrentPlaybackContext();
+        expect (context != nullptr);
+
+        if (context == nullptr)
+            return;
+
+        std::atomic<double> cpuLimit { 0.95 };
+        CriticalSection lock;
+        Array<Report> reports;
+        Array<LoadSheddingLevel> levels;
+
+        DeviceManager::CallbackTelemetry telemetry (cpuLimit,
+                                                    [&] (float cpuAvg, float cpuMin, float cpuMax, int numGlitches)
+                                                    {
+                                                        const ScopedLock sl (lock);
+                                                        reports.add ({ cpuAvg, cpuMin, cpuMax, numGlitches });
+                                                    },
+                                                    [&] (LoadSheddingLevel level)
+                                                    {
+                                                        const ScopedLock sl (lock);
+                                                        levels.add (level);
+                                                    });
+
+        const double blockSeconds = 0.01;
+        const auto ticksPerSecond = (double) Time::getHighResolutionTicksPerSecond();
+
+        auto pushBlock = [&] (float usage, int numXRuns, float contextUsage)
+        {
+            for (;;)
+            {
+                auto& stats = telemetry.beginBlock (blockSeconds);
+                stats.durationTicks = (juce::int64) (usage * blockSeconds * ticksPerSecond);
+                stats.numXRuns = numXRuns;
+                stats.addContext (context, (juce::int64) (contextUsage * blockSeconds * ticksPerSecond));
+
+                if (telemetry.endBlock())
+                    return;
+
+                Thread::sleep (5);
+            }
+        };
+
+        auto waitFor = [&] (std::function<bool()> isDone)
+        {
+            for (int i = 0; i < 200; ++i)
+            {
+                {
+                    const ScopedLock sl (lock);
+
+                    if (isDone())
+                        return true;
+                }
+
+                Thread::sleep (10);
+            }
+
+            return false;
+        };
+
+        // Gives the telemetry thread time to start the new interval before any blocks are pushed
+        auto restart = [&] (int numBlocksPerReport)
+        {
+            telemetry.restart (numBlocksPerReport);
+            Thread::sleep (100);
+        };
+
+        beginTest ("Blocks are aggregated in to reports");
+        {
+            restart (4);
+            pushBlock (0.2f, 0, 0.1f);
+            pushBlock (0.4f, 1, 0.1f);
+            pushBlock (0.6f, 0, 0.1f);
+            pushBlock (0.8f, 2, 0.1f);
+
+            expect (waitFor ([&] { return reports.size() == 1; }));
+
+            const ScopedLock sl (lock);
+            auto report = reports.getLast();
+            expectWithinAbsoluteError (report.cpuAvg, 0.5f, 0.01f);
+            expectWithinAbsoluteError (report.cpuMin, 0.2f, 0.01f);
+            expectWithinAbsoluteError (report.cpuMax, 0.8f, 0.01f);
+            expectEquals (report.numGlitches, 3, "The device's xruns should be used as the glitch count");
+            expectWithinAbsoluteError (telemetry.getCpuUsage (*context), 0.1f, 0.01f);
+            expect (levels.isEmpty());
+        }
+
+        beginTest ("Glitches are inferred without xrun counts");
+        {
+            pushBlock (0.5f, -1, 0.1f);
+            pushBlock (1.5f, -1, 0.1f);
+            pushBlock (0.5f, -1, 0.1f);
+            pushBlock (0.5f, -1, 0.1f);
+
+            expect (waitFor ([&] { return reports.size() == 2; }));
+
+            const ScopedLock sl (lock);
+            expectEquals (reports.getLast().numGlitches, 1);
+            expect (levels.isEmpty());
+        }
+
+        beginTest ("Load is shed in steps and restored");
+        {
+            restart (1000);
+
+            // Overloaded for half a second is enough to go through both levels
+            for (int i = 0; i < 50; ++i)
+                pushBlock (2.0f, 0, 0.0f);
+
+            expect (waitFor ([&] { return levels.size() >= 2; }));
+
+            // Recovering needs the load to settle for a second at each level
+            for (int i = 0; i < 300; ++i)
+                pushBlock (0.1f, 0, 0.0f);
+
+            expect (waitFor ([&] { return levels.size() >= 4; }));
+
+            const ScopedLock sl (lock);
+            expect (levels == Array<LoadSheddingLevel> { LoadSheddingLevel::bypassLowPriorityTracks,
+                                                         LoadSheddingLevel::muteOutput,
+                                                         LoadSheddingLevel::bypassLowPriorityTracks,
+                                                         LoadSheddingLevel::none });
+        }
+    }
+};
+
+static CallbackTelemetryTests callbackTelemetryTests;
+
+#endif
+
 }
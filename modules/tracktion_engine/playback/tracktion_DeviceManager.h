@@ -49,10 +49,33 @@ public:
     //==============================================================================
     float getCpuUsage() const noexcept                  { return (float) currentCpuUsage; }
 
-    // Sets an upper limit on the proportion of CPU time being used - if getCpuUsage() exceeds this,
-    // the processing will be muted to keep the system running. Defaults to 0.95
+    // Sets an upper limit on the proportion of CPU time being used - if the audio callback exceeds this,
+    // load will be shed to keep the system running. Defaults to 0.95
+    // @see LoadSheddingLevel
     void setCpuLimitBeforeMuting (double newLimit)      { jassert (newLimit > 0); cpuLimitBeforeMuting = newLimit; }
 
+    /** The steps taken to reduce the load on the audio thread when it goes over the CPU limit.
+        Each step is taken in turn while the load stays over the limit and they're undone
+        once it drops well below it again.
+    */
+    enum class LoadSheddingLevel
+    {
+        none,
+        bypassLowPriorityTracks,    /**< Tracks with the IDs::bypassWhenOverloaded property set aren't rendered. */
+        muteOutput                  /**< Nothing is rendered and the outputs are silent. */
+    };
+
+    LoadSheddingLevel getLoadSheddingLevel() const noexcept     { return loadSheddingLevel; }
+    bool isBypassingLowPriorityTracks() const noexcept          { return loadSheddingLevel != LoadSheddingLevel::none; }
+
+    /** Returns the proportion of the block time spent rendering an EditPlaybackContext,
+        averaged over the last CPU reporting interval.
+    */
+    float getCpuUsage (const EditPlaybackContext&) const;
+
+    /** Aggregates the audio callback timings and decides the LoadSheddingLevel. */
+    struct CallbackTelemetry;
+
     void updateNumCPUs(); // should be called when active num CPUs is changed
 
     //==============================================================================
@@ -60,13 +83,13 @@ public:
     {
         virtual ~CPUUsageListener() {}
 
-        // this is called from the audio thread and therefore musn't allocate, lock or
-        // throw exceptions
+        // this is called from a background thread about once a second with the
+        // statistics for the audio callbacks since the last call
         virtual void reportCPUUsage (float cpuAvg, float cpuMin, float cpuMax, int numGlitches) = 0;
     };
 
-    void addCPUUsageListener (CPUUsageListener* listener)       { cpuUsageListeners.add (listener); }
-    void removeCPUUsageListener (CPUUsageListener* listener)    { cpuUsageListeners.remove (listener); }
+    void addCPUUsageListener (CPUUsageListener*);
+    void removeCPUUsageListener (CPUUsageListener*);
 
     //==============================================================================
     double getSampleRate() const;
@@ -187,14 +210,16 @@ public:
 private:
     struct WaveDeviceList;
     struct ContextDeviceClearer;
+    struct ParallelContextRenderer;
     bool finishedInitialising = false;
     bool sendMidiTimecode = false;
 
     std::atomic<double> currentCpuUsage { 0 }, streamTime { 0 };
-    double cpuLimitBeforeMuting = 0.95;
+    std::atomic<double> cpuLimitBeforeMuting { 0.95 };
+    std::atomic<LoadSheddingLevel> loadSheddingLevel { LoadSheddingLevel::none };
     double currentLatencyMs = 0, outputLatencyTime = 0, currentSampleRate = 0;
     double speedCompensation = 0;
-    int internalBufferMultiplier = 1;
+    int internalBufferMultiplier = 1, lastXRunCount = 0;
     juce::Array<EditPlaybackContext*> contextsToRestart;
 
     juce::StringArray lastMidiOutNames, lastMidiInNames;
@@ -205,21 +230,26 @@ private:
 
     std::unique_ptr<WaveDeviceList> lastWaveDeviceList;
     std::unique_ptr<ContextDeviceClearer> contextDeviceClearer;
+    std::unique_ptr<ParallelContextRenderer> parallelContextRenderer;
+    std::unique_ptr<CallbackTelemetry> callbackTelemetry;
 
     juce::CriticalSection contextLock;
     juce::Array<EditPlaybackContext*> activeContexts;
     std::unique_ptr<juce::AudioProcessor> globalOutputAudioProcessor;
+    juce::MidiBuffer globalOutputMidiBuffer;
 
    #if JUCE_ANDROID
     ScopedSteadyLoad::Context steadyLoadContext;
    #endif
 
+    juce::CriticalSection cpuUsageListenerLock;
     juce::ListenerList<CPUUsageListener> cpuUsageListeners;
 
     void initialiseMidi();
     void rebuildWaveDeviceList();
     bool waveDeviceListNeedsRebuilding();
     void sanityCheckEnabledChannels();
+    void prepareParallelContextRenderer (juce::AudioIODevice*);
 
     void loadSettings();
 
@@ -230,14 +260,6 @@ private:
     void audioDeviceAboutToStart (juce::AudioIODevice*) override;
     void audioDeviceStopped() override;
 
-    //==============================================================================
-    int cpuReportingInterval = 1;
-    int cpuAvgCounter = 0;
-    int glitchCntr = 0;
-    float cpuAvg = 0;
-    float cpuMin = 0;
-    float cpuMax = 0;
-
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeviceManager)
 };
 
@@ -396,6 +396,7 @@ void EditPlaybackContext::createAudioNodes (double startTime, bool addAntiDenorm
                                                             addAntiDenormalisationNoise), false));
 
     prepareNodesToPlay (edit.engine, allNodes, startTime, playhead);
+    updateProfilerGraph (allNodes);
 
     const auto& tempoSections = edit.tempoSequence.getTempoSections();
     const bool hasTempoChanged = tempoSections.getChangeCount() != lastTempoSections.getChangeCount();
@@ -429,6 +430,85 @@ void EditPlaybackContext::createAudioNodes (double startTime, bool addAntiDenorm
         lastTempoSections = tempoSections;
 }
 
+//==============================================================================
+static NodeProfiler::GraphNode createProfilerGraphNode (AudioNode& node)
+{
+    NodeProfiler::GraphNode graphNode;
+    graphNode.node = &node;
+    graphNode.name = NodeProfiler::getTypeName (typeid (node));
+
+    if (auto plugin = node.getPlugin())
+        graphNode.name << ": " << plugin->getName();
+
+    // AudioNodes render their own inputs so unless they're spread over the mixer
+    // threads they're rendered one after the other
+    if (auto mixer = dynamic_cast<MixerAudioNode*> (&node))
+        graphNode.inputsCanBeProcessedInParallel = mixer->isRenderingInputsInParallel();
+    else
+        graphNode.inputsCanBeProcessedInParallel = false;
+
+    return graphNode;
+}
+
+static void addToProfilerGraph (AudioNode& rootNode, std::vector<NodeProfiler::GraphNode>& graph)
+{
+    // AudioNodes can only be visited recursively so rebuild the tree from the preorder
+    // and the number of nodes under each one
+    std::vector<AudioNode*> preorder;
+    rootNode.visitNodes ([&] (AudioNode& n) { preorder.push_back (&n); });
+
+    std::vector<size_t> subtreeSizes;
+    subtreeSizes.reserve (preorder.size());
+
+    for (auto n : preorder)
+    {
+        size_t size = 0;
+        n->visitNodes ([&] (AudioNode&) { ++size; });
+        subtreeSizes.push_back (std::max ((size_t) 1, size));
+    }
+
+    const auto firstIndex = graph.size();
+
+    for (auto n : preorder)
+        graph.push_back (createProfilerGraphNode (*n));
+
+    for (size_t i = 0; i < preorder.size(); ++i)
+        for (size_t child = i + 1; child < std::min (i + subtreeSizes[i], preorder.size()); child += subtreeSizes[child])
+            graph[firstIndex + i].inputs.push_back (preorder[child]);
+}
+
+void EditPlaybackContext::updateProfilerGraph (const Array<AudioNode*>& rootNodes)
+{
+    CRASH_TRACER
+
+    if (auto profiler = getNodeProfiler())
+    {
+        std::vector<NodeProfiler::GraphNode> graph;
+
+        for (auto n : rootNodes)
+            if (n != nullptr)
+                addToProfilerGraph (*n, graph);
+
+        profiler->setGraph (std::move (graph));
+    }
+}
+
+void EditPlaybackContext::setNodeProfiler (NodeProfiler* newProfiler)
+{
+    TRACKTION_ASSERT_MESSAGE_THREAD
+    nodeProfiler = newProfiler;
+
+    Array<AudioNode*> rootNodes;
+
+    for (auto mo : midiOutputs)
+        rootNodes.add (mo->getAudioNode());
+
+    for (auto wo : waveOutputs)
+        rootNodes.add (wo->getAudioNode());
+
+    updateProfilerGraph (rootNodes);
+}
+
 void EditPlaybackContext::createPlayAudioNodes (double startTime)
 {
     createAudioNodes (startTime, shouldAddAntiDenormalisationNoise (edit.engine));
@@ -629,6 +709,11 @@ void EditPlaybackContext::fillNextAudioBlock (EditTimeRange streamTime, float**
 
     SCOPED_REALTIME_CHECK
 
+    auto profiler = getNodeProfiler();
+
+    if (profiler != nullptr)
+        profiler->beginBlock();
+
     // update stream time for track inputs
     for (auto in : midiInputs)
         if (in->owner.getDeviceType() == InputDevice::trackMidiDevice)
@@ -695,6 +780,9 @@ void EditPlaybackContext::fillNextAudioBlock (EditTimeRange streamTime, float**
 
     for (auto wo : waveOutputs)
         wo->fillNextAudioBlock (playhead, streamTime, allChannels, numSamples);
+
+    if (profiler != nullptr)
+        profiler->endBlock();
 }
 
 InputDeviceInstance* EditPlaybackContext::getInputFor (InputDevice* d) const
@@ -42,6 +42,15 @@ public:
     juce::Array<InputDeviceInstance*> getAllInputs();
     InputDeviceInstance* getInputFor (InputDevice*) const;
 
+    /** Sets a profiler to record how long the clips, tracks, plugins, meters and mixers
+        in the playback graph take to render. Pass nullptr to stop profiling.
+        The profiler must outlive this context or be removed from it first.
+    */
+    void setNodeProfiler (NodeProfiler*);
+
+    /** Returns the profiler set with setNodeProfiler, if any. */
+    NodeProfiler* getNodeProfiler() const noexcept      { return nodeProfiler.load (std::memory_order_relaxed); }
+
     Edit& edit;
     TransportControl& transport;
     PlayHead playhead;
@@ -93,11 +102,13 @@ private:
     juce::OwnedArray<MidiOutputDeviceInstance> midiOutputs;
 
     TempoSequence::TempoSections lastTempoSections;
+    std::atomic<NodeProfiler*> nodeProfiler { nullptr };
 
     void releaseDeviceList();
     void rebuildDeviceList();
 
     void createAudioNodes (double startTime, bool addAntiDenormalisationNoise);
+    void updateProfilerGraph (const juce::Array<AudioNode*>&);
     void prepareOutputDevices (double start);
     void startRecording (double start, double punchIn);
     void startPlaying (double start);
@@ -335,6 +335,8 @@ void LevelMeasuringAudioNode::renderOver (const AudioRenderContext& rc)
 {
     input->renderOver (rc);
 
+    const NodeProfiler::ScopedNodeTimer timer (rc.profiler, this);
+
     if (levelMeasurer != nullptr)
         levelMeasurer->addBuffer (*rc.destBuffer, rc.bufferStartSample, rc.bufferNumSamples);
 }
@@ -40,6 +40,45 @@ struct MPEStartTrimmer
         const auto initial = searchBackForExpression (data, lastNoteOnIndex, channel, MessageToStopAt::noteOff);
         const auto mostRecent = searchBackForExpression (data, trimIndex, channel, MessageToStopAt::noteOn);
 
+        addMessages (mpeMessagesToAddAtStart, channel, noteOn, initial, mostRecent);
+    }
+
+    /** Reconstructs note expression using the index of a CompiledMidiSequence, so this
+        doesn't need to search back through the sequence.
+        @see CompiledMidiSequence::getChannelState
+    */
+    static void reconstructExpression (Array<MidiMessage>& mpeMessagesToAddAtStart,
+                                       const CompiledMidiSequence& data,
+                                       int trimIndex, int channel)
+    {
+        jassert (trimIndex <= data.size());
+
+        // A note-on with a velocity of 0 counts as both, but like searchBackForNoteOn this treats it as a note-on
+        const auto mostRecentState = data.getChannelState (channel, trimIndex);
+        const int lastNoteOnIndex = mostRecentState.noteOn;
+
+        if (! wasFound (lastNoteOnIndex) || mostRecentState.noteOff > lastNoteOnIndex)
+            return;
+
+        const auto noteOn = data.getMessage (lastNoteOnIndex);
+        const auto initialState = data.getChannelState (channel, lastNoteOnIndex);
+
+        addMessages (mpeMessagesToAddAtStart, channel, noteOn,
+                     getExpression (data, initialState, initialState.noteOff),
+                     getExpression (data, mostRecentState, lastNoteOnIndex));
+    }
+
+private:
+    struct ExpressionData
+    {
+        int timbre;
+        int pressure;
+        int pitchBend;
+    };
+
+    static void addMessages (Array<MidiMessage>& mpeMessagesToAddAtStart, int channel, const MidiMessage& noteOn,
+                             const ExpressionData& initial, const ExpressionData& mostRecent)
+    {
         const int centrePitchbend = MidiMessage::pitchbendToPitchwheelPos (0.0f, 12.f);
 
         mpeMessagesToAddAtStart.add (MidiMessage::controllerEvent       (channel, 74, wasFound (initial.timbre)    ? initial.timbre    : 64));
@@ -57,7 +96,6 @@ struct MPEStartTrimmer
             mpeMessagesToAddAtStart.add (MidiMessage::pitchWheel (channel, mostRecent.pitchBend));
     }
 
-private:
     static int searchBackForNoteOn (const juce::MidiMessageSequence& data, int startIndex, int channel)
     {
         while (--startIndex >= 0)
@@ -77,12 +115,16 @@ private:
         return notFound;
     }
 
-    struct ExpressionData
+    /** Returns the expression values from a state that come after the event at stopIndex. */
+    static ExpressionData getExpression (const CompiledMidiSequence& data,
+                                         const CompiledMidiSequence::ChannelState& state, int stopIndex)
     {
-        int timbre;
-        int pressure;
-        int pitchBend;
-    };
+        auto isAfterStop = [stopIndex] (int index) { return wasFound (index) && index > stopIndex; };
+
+        return { isAfterStop (state.controllers[74]) ? data.getMessage (state.controllers[74]).getControllerValue() : notFound,
+                 isAfterStop (state.channelPressure) ? data.getMessage (state.channelPressure).getChannelPressureValue() : notFound,
+                 isAfterStop (state.pitchWheel)      ? data.getMessage (state.pitchWheel).getPitchWheelValue() : notFound };
+    }
 
     enum MessageToStopAt
     {
@@ -11,18 +11,86 @@
 namespace tracktion_engine
 {
 
+juce::uint32 MidiNoteDispatcher::JitterHistogram::getTotal() const noexcept
+{
+    juce::uint32 total = 0;
+
+    for (auto c : counts)
+        total += c;
+
+    return total;
+}
+
+//==============================================================================
+MidiNoteDispatcher::DeviceState::DeviceState (MidiOutputDeviceInstance* d)
+    : device (d)
+{
+    for (auto& c : jitterCounts)
+        c = 0;
+}
+
+bool MidiNoteDispatcher::DeviceState::push (const MidiMessage& m) noexcept
+{
+    if (! fifo.push (m))
+        return false;
+
+    ++numPushed;
+    return true;
+}
+
+void MidiNoteDispatcher::DeviceState::pushAllNotesOff() noexcept
+{
+    allNotesOffIndex.store (numPushed, std::memory_order_relaxed);
+    allNotesOffPending.store (true, std::memory_order_release);
+}
+
+void MidiNoteDispatcher::DeviceState::pullPendingMessages()
+{
+    fifo.popAll ([this] (const uint8* data, int numBytes, double timestamp)
+    {
+        QueuedMessage m { MidiMessage (data, numBytes, timestamp), numPulled++ };
+
+        // Messages almost always arrive in order so this is usually an append
+        auto pos = std::upper_bound (queue.begin(), queue.end(), m,
+                                     [] (const QueuedMessage& a, const QueuedMessage& b)
+                                     { return a.message.getTimeStamp() < b.message.getTimeStamp(); });
+        queue.insert (pos, std::move (m));
+    });
+}
+
+void MidiNoteDispatcher::DeviceState::removeNotesBefore (uint32 index)
+{
+    // The indexes wrap so compare them by their difference
+    queue.erase (std::remove_if (queue.begin(), queue.end(),
+                                 [index] (const QueuedMessage& m)
+                                 {
+                                     return (int32) (m.index - index) < 0 && m.message.isNoteOnOrOff();
+                                 }),
+                 queue.end());
+}
+
+void MidiNoteDispatcher::DeviceState::addLateness (double seconds) noexcept
+{
+    auto bucket = jlimit (0, JitterHistogram::numBuckets - 1,
+                          (int) (seconds * 1000.0 / JitterHistogram::bucketWidthMs));
+    jitterCounts[(size_t) bucket].fetch_add (1, std::memory_order_relaxed);
+}
+
+//==============================================================================
 MidiNoteDispatcher::MidiNoteDispatcher()
+    : Thread ("MIDI Dispatcher")
 {
 }
 
 MidiNoteDispatcher::~MidiNoteDispatcher()
 {
-    stopTimer();
+    stopDispatchThread();
 }
 
 void MidiNoteDispatcher::nextBlockStarted (PlayHead& playhead, EditTimeRange streamTime, int blockSize)
 {
     ScopedLock s (deviceLock);
+    bool anyMessagesAdded = false;
 
     for (auto state : devices)
     {
@@ -31,28 +99,51 @@ void MidiNoteDispatcher::nextBlockStarted (PlayHead& playhead, EditTimeRange str
         state->device->context.masterLevels.processMidi (buffer, nullptr);
         
         if (! state->device->sendMessages (playhead, buffer, streamTime - delay))
-            state->buffer.mergeFromAndClear (buffer);
+        {
+            if (buffer.isAllNotesOff)
+            {
+                state->pushAllNotesOff();
+                anyMessagesAdded = true;
+            }
+
+            for (auto& m : buffer)
+            {
+                if (! state->push (m))
+                {
+                    jassertfalse; // the dispatch thread isn't keeping up
+                    break;
+                }
+
+                anyMessagesAdded = true;
+            }
+
+            buffer.clear();
+        }
     }
+
+    if (anyMessagesAdded)
+        wakeUpEvent.signal();
 }
 
 void MidiNoteDispatcher::masterTimeUpdate (PlayHead& playhead, double streamTime)
 {
-    const ScopedLock s (timeLock);
-    masterTime = playhead.streamTimeToSourceTime (streamTime);
-    hiResClockOfMasterTime = Time::getMillisecondCounterHiRes();
+    setMasterTime (playhead.streamTimeToSourceTime (streamTime));
 }
 
 void MidiNoteDispatcher::prepareToPlay (PlayHead& playhead, double start)
 {
-    const ScopedLock s (timeLock);
-    masterTime = playhead.streamTimeToSourceTime (start);
-    hiResClockOfMasterTime = Time::getMillisecondCounterHiRes();
+    setMasterTime (playhead.streamTimeToSourceTime (start));
 }
 
-double MidiNoteDispatcher::getCurrentTime() const
+void MidiNoteDispatcher::setMasterTime (double sourceTime) noexcept
 {
-    const ScopedLock s (timeLock);
-    return masterTime + (Time::getMillisecondCounterHiRes() - hiResClockOfMasterTime) * 0.001;
+    // Storing this as an offset from the hi-res clock means the time can be read without a lock
+    masterTimeOffset = sourceTime - Time::getMillisecondCounterHiRes() * 0.001;
+}
+
+double MidiNoteDispatcher::getCurrentTime() const noexcept
+{
+    return masterTimeOffset + Time::getMillisecondCounterHiRes() * 0.001;
 }
 
 void MidiNoteDispatcher::setMidiDeviceList (const OwnedArray<MidiOutputDeviceInstance>& newList)
@@ -63,75 +154,323 @@ void MidiNoteDispatcher::setMidiDeviceList (const OwnedArray<MidiOutputDeviceIns
     for (auto* d : newList)
         newDevices.add (new DeviceState (d));
 
-    if (newList.isEmpty())
-        stopTimer();
-
-    bool startTimerFlag = false;
+    // The dispatch thread uses the device states without a lock so must be stopped whilst they're swapped
+    stopDispatchThread();
 
     {
         const ScopedLock sl (deviceLock);
         newDevices.swapWith (devices);
-        startTimerFlag = ! devices.isEmpty();
     }
 
-    if (startTimerFlag)
-        startTimer (1);
+    if (! devices.isEmpty())
+        startThread (Thread::realtimeAudioPriority);
+}
+
+//==============================================================================
+MidiNoteDispatcher::JitterHistogram MidiNoteDispatcher::getJitterHistogram (MidiOutputDevice& d) const
+{
+    JitterHistogram h;
+    const ScopedLock sl (deviceLock);
+
+    for (auto state : devices)
+        if (&state->device->getMidiOutput() == &d)
+            for (size_t i = 0; i < h.counts.size(); ++i)
+                h.counts[i] += state->jitterCounts[i].load (std::memory_order_relaxed);
+
+    return h;
 }
 
-void MidiNoteDispatcher::hiResTimerCallback()
+void MidiNoteDispatcher::resetJitterHistograms()
 {
-    struct MessageToSend
+    const ScopedLock sl (deviceLock);
+
+    for (auto state : devices)
+        for (auto& c : state->jitterCounts)
+            c = 0;
+}
+
+//==============================================================================
+void MidiNoteDispatcher::stopDispatchThread()
+{
+    // The thread waits on the semaphore rather than the Thread's own event so needs waking to exit
+    signalThreadShouldExit();
+    wakeUpEvent.signal();
+    stopThread (1000);
+}
+
+void MidiNoteDispatcher::run()
+{
+    while (! threadShouldExit())
     {
-        MidiOutputDeviceInstance* device;
-        MidiMessage message;
-    };
+        double nextMessageTime = std::numeric_limits<double>::max();
 
-    Array<MessageToSend> messagesToSend;
-    messagesToSend.ensureStorageAllocated (32);
+        for (auto state : devices)
+            nextMessageTime = jmin (nextMessageTime, dispatchDueMessages (*state));
 
+        if (nextMessageTime == std::numeric_limits<double>::max())
+        {
+            wakeUpEvent.wait();
+            continue;
+        }
+
+        auto secondsToWait = nextMessageTime - getCurrentTime();
+
+        if (secondsToWait > 0.0)
+            wakeUpEvent.timedWait (secondsToWait);
+    }
+}
+
+double MidiNoteDispatcher::dispatchDueMessages (DeviceState& state)
+{
+    auto& midiOut = state.device->getMidiOutput();
+
+    // This is checked before pulling so every message pushed before the all-notes-off is in the queue
+    const bool allNotesOff = state.allNotesOffPending.exchange (false, std::memory_order_acquire);
+    state.pullPendingMessages();
+
+    if (allNotesOff)
     {
-        const ScopedLock sl (deviceLock);
+        state.removeNotesBefore (state.allNotesOffIndex.load (std::memory_order_relaxed));
+        midiOut.sendNoteOffMessages();
+    }
+
+    while (! state.queue.empty())
+    {
+        auto& message = state.queue.front().message;
+        auto noteTime = message.getTimeStamp();
+        auto currentTime = getCurrentTime();
+
+        if (noteTime > currentTime + 0.2)
+        {
+            state.queue.pop_front();
+        }
+        else if (noteTime <= currentTime)
+        {
+            midiOut.fireMessage (message);
+            state.addLateness (currentTime - noteTime);
+            state.queue.pop_front();
+        }
+        else
+        {
+            return noteTime;
+        }
+    }
+
+    return std::numeric_limits<double>::max();
+}
+
+//==============================================================================
+//==============================================================================
+#if TRACKTION_UNIT_TESTS
+
+class MidiNoteDispatcherTests  : public UnitTest
+{
+public:
+    MidiNoteDispatcherTests() : UnitTest ("MidiNoteDispatcher", "Tracktion") {}
+
+    //==============================================================================
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines()[0];
+        auto edit = Edit::createSingleTrackEdit (engine);
+        edit->getTransport().ensureContextAllocated();
+        auto context = edit->getCurrentPlaybackContext();
+        expect (context != nullptr);
+
+        if (context == nullptr)
+            return;
 
-        for (auto d : devices)
+        TestMidiOutputDevice device (engine);
+        OwnedArray<MidiOutputDeviceInstance> instances;
+        auto node = new TestMidiAudioNode();
+        instances.add (new MidiOutputDeviceInstance (device, *context))->replaceAudioNode (std::unique_ptr<AudioNode> (node));
+
+        MidiNoteDispatcher dispatcher;
+        dispatcher.setMidiDeviceList (instances);
+
+        PlayHead playhead;
+        playhead.playLockedToEngine ({ 0.0, 60.0 });
+
+        const int blockSize = 441;
+        const double blockLength = blockSize / 44100.0;
+        double streamTime = 0.0, startTime = 0.0;
+
+        auto start = [&]
         {
-            auto* device = d->device;
-            auto& buffer = d->buffer;
-            auto& midiOut = device->getMidiOutput();
+            device.clear();
+            dispatcher.resetJitterHistograms();
+            streamTime = 0.0;
+            startTime = Time::getMillisecondCounterHiRes() * 0.001;
+            dispatcher.prepareToPlay (playhead, streamTime);
+        };
 
-            if (buffer.isAllNotesOff)
+        auto renderBlock = [&]
+        {
+            dispatcher.nextBlockStarted (playhead, { streamTime, streamTime + blockLength }, blockSize);
+            streamTime += blockLength;
+        };
+
+        beginTest ("Messages are sent in time order");
+        {
+            start();
+            node->add (MidiMessage::noteOn (1, 62, 1.0f), 0.1);
+            renderBlock();
+            node->add (MidiMessage::noteOn (1, 60, 1.0f), 0.05);
+            renderBlock();
+
+            auto received = device.waitForMessages (2);
+            expectEquals (received.size(), 2);
+
+            if (received.size() == 2)
             {
-                buffer.clear();
-                midiOut.sendNoteOffMessages();
+                expectEquals (received[0].message.getNoteNumber(), 60);
+                expectEquals (received[1].message.getNoteNumber(), 62);
             }
-            else
+        }
+
+        beginTest ("Messages are sent at their timestamps");
+        {
+            start();
+            const double times[] = { 0.02, 0.04, 0.08, 0.16 };
+
+            for (auto t : times)
+                node->add (MidiMessage::controllerEvent (1, 7, 100), t);
+
+            renderBlock();
+
+            auto received = device.waitForMessages (numElementsInArray (times));
+            expectEquals (received.size(), numElementsInArray (times));
+
+            for (int i = 0; i < received.size(); ++i)
+            {
+                auto sendTime = received[i].time - startTime;
+
+                // The master time is set after startTime so a message can never be early against it
+                expectGreaterOrEqual (sendTime, times[i]);
+                expectLessThan (sendTime - times[i], 0.05, "Message sent too late");
+            }
+
+            expectEquals ((int) dispatcher.getJitterHistogram (device).getTotal(), numElementsInArray (times));
+        }
+
+        beginTest ("All notes off removes the notes queued before it");
+        {
+            start();
+            node->add (MidiMessage::noteOn (1, 60, 1.0f), 0.1);
+            node->add (MidiMessage::controllerEvent (1, 7, 100), 0.1);
+            renderBlock();
+
+            // Messages in the same block as the all-notes-off come after it
+            node->allNotesOff = true;
+            node->add (MidiMessage::noteOn (1, 64, 1.0f), 0.1);
+            renderBlock();
+
+            auto received = device.waitForMessages (3);
+            expectEquals (received.size(), 2);
+
+            for (auto& r : received)
+                expect (! (r.message.isNoteOn() && r.message.getNoteNumber() == 60), "Note queued before all-notes-off was sent");
+        }
+
+        dispatcher.setMidiDeviceList ({});
+    }
+
+private:
+    //==============================================================================
+    /** Records the messages it's sent rather than passing them to a real port. */
+    struct TestMidiOutputDevice  : public MidiOutputDevice
+    {
+        TestMidiOutputDevice (Engine& e)  : MidiOutputDevice (e, "Test MIDI Output", -1) {}
+
+        struct ReceivedMessage
+        {
+            MidiMessage message;
+            double time;
+        };
+
+        void clear()
+        {
+            const ScopedLock sl (lock);
+            received.clear();
+        }
+
+        /** Waits up to a second for the given number of messages to arrive and returns the ones that did. */
+        Array<ReceivedMessage> waitForMessages (int num)
+        {
+            for (int i = 0; i < 100; ++i)
             {
-                while (buffer.isNotEmpty())
                 {
-                    auto& message = buffer[0];
-
-                    auto noteTime = message.getTimeStamp();
-                    auto currentTime = getCurrentTime();
-
-                    if (noteTime > currentTime + 0.2)
-                    {
-                        buffer.remove (0);
-                    }
-                    else if (noteTime <= currentTime)
-                    {
-                        messagesToSend.add ({ device, message });
-                        buffer.remove (0);
-                    }
-                    else
-                    {
+                    const ScopedLock sl (lock);
+
+                    if (received.size() >= num)
                         break;
-                    }
                 }
+
+                Thread::sleep (10);
             }
+
+            const ScopedLock sl (lock);
+            return received;
         }
-    }
 
-    for (auto& m : messagesToSend)
-        m.device->getMidiOutput().fireMessage (m.message);
-}
+    protected:
+        void sendMessageNow (const MidiMessage& m) override
+        {
+            const ScopedLock sl (lock);
+            received.add ({ m, Time::getMillisecondCounterHiRes() * 0.001 });
+        }
+
+    private:
+        CriticalSection lock;
+        Array<ReceivedMessage> received;
+    };
+
+    //==============================================================================
+    /** Adds whatever messages the test gives it to the next block. */
+    struct TestMidiAudioNode  : public AudioNode
+    {
+        void add (const MidiMessage& m, double time)
+        {
+            pending.addMidiMessage (m, time, mpeSource);
+        }
+
+        void getAudioNodeProperties (AudioNodeProperties& p) override
+        {
+            p.hasAudio = false;
+            p.hasMidi  = true;
+            p.numberOfChannels = 0;
+        }
+
+        void prepareAudioNodeToPlay (const PlaybackInitialisationInfo&) override   {}
+        bool purgeSubNodes (bool, bool keepMidi) override                           { return keepMidi; }
+        void releaseAudioNodeResources() override                                   {}
+        void visitNodes (const VisitorFn& v) override                               { v (*this); }
+        bool isReadyToRender() override                                             { return true; }
+
+        void renderOver (const AudioRenderContext& rc) override
+        {
+            rc.clearMidiBuffer();
+            callRenderAdding (rc);
+        }
+
+        void renderAdding (const AudioRenderContext& rc) override
+        {
+            if (rc.bufferForMidiMessages != nullptr)
+            {
+                rc.bufferForMidiMessages->mergeFromAndClear (pending);
+                rc.bufferForMidiMessages->isAllNotesOff = rc.bufferForMidiMessages->isAllNotesOff || allNotesOff;
+                allNotesOff = false;
+            }
+        }
+
+        MidiMessageArray pending;
+        bool allNotesOff = false;
+        MidiMessageArray::MPESourceID mpeSource { MidiMessageArray::createUniqueMPESourceID() };
+    };
+};
+
+static MidiNoteDispatcherTests midiNoteDispatcherTests;
+
+#endif
 
 }
@@ -11,7 +11,16 @@
 namespace tracktion_engine
 {
 
-class MidiNoteDispatcher   : private juce::HighResolutionTimer
+/**
+    Sends the timestamped messages that MIDI output devices couldn't send themselves
+    at the right time.
+
+    The audio thread hands messages to a dedicated thread via a lock-free FIFO of raw
+    bytes per device, and wakes it with a Semaphore, so it never allocates or takes a
+    lock. That thread keeps a time-ordered queue for each device and sleeps until the
+    next message is due, so it doesn't use any CPU when there's no MIDI to send.
+*/
+class MidiNoteDispatcher   : private juce::Thread
 {
 public:
     MidiNoteDispatcher();
@@ -24,24 +33,76 @@ public:
     void masterTimeUpdate (PlayHead& playhead, double streamTime);
     void prepareToPlay (PlayHead& playhead, double start);
 
-    void hiResTimerCallback() override;
+    //==============================================================================
+    /** Counts how late messages were sent compared to their timestamps. */
+    struct JitterHistogram
+    {
+        static constexpr int numBuckets = 32;
+        static constexpr double bucketWidthMs = 0.25;
+
+        /** The number of messages sent in each bucketWidthMs of lateness.
+            The last bucket also holds any messages that were later than that.
+        */
+        std::array<juce::uint32, numBuckets> counts {};
+
+        juce::uint32 getTotal() const noexcept;
+    };
+
+    /** Returns the lateness histogram for a device, or an empty one if it isn't in use. */
+    JitterHistogram getJitterHistogram (MidiOutputDevice&) const;
+
+    /** Clears the histograms of all the devices. */
+    void resetJitterHistograms();
 
 private:
     //==============================================================================
     struct DeviceState
     {
-        DeviceState (MidiOutputDeviceInstance* d) : device (d) {}
+        DeviceState (MidiOutputDeviceInstance* d);
+
+        bool push (const juce::MidiMessage&) noexcept;
+        void pullPendingMessages();
+        void addLateness (double seconds) noexcept;
+
+        void pushAllNotesOff() noexcept;
+        void removeNotesBefore (juce::uint32 index);
 
         MidiOutputDeviceInstance* device;
-        MidiMessageArray buffer;
+
+        // Written by the audio thread, read by the dispatch thread
+        MidiMessageFifo fifo;
+        std::atomic<juce::uint32> allNotesOffIndex { 0 };
+        std::atomic<bool> allNotesOffPending { false };
+
+        // Only touched by the audio thread
+        juce::uint32 numPushed = 0;
+
+        // Only touched by the dispatch thread. Each message keeps the order it was
+        // pushed in so an all-notes-off only removes the notes that came before it.
+        struct QueuedMessage
+        {
+            juce::MidiMessage message;
+            juce::uint32 index;
+        };
+
+        std::deque<QueuedMessage> queue;
+        juce::uint32 numPulled = 0;
+
+        std::array<std::atomic<juce::uint32>, JitterHistogram::numBuckets> jitterCounts;
     };
 
     //==============================================================================
     juce::OwnedArray<DeviceState> devices;
-    juce::CriticalSection timeLock, deviceLock;
-    double masterTime = 0, hiResClockOfMasterTime = 0;
+    juce::CriticalSection deviceLock;
+    std::atomic<double> masterTimeOffset { 0.0 };
+    Semaphore wakeUpEvent;
+
+    void setMasterTime (double sourceTime) noexcept;
+    double getCurrentTime() const noexcept;
 
-    double getCurrentTime() const;
+    void stopDispatchThread();
+    void run() override;
+    double dispatchDueMessages (DeviceState&);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiNoteDispatcher)
 };
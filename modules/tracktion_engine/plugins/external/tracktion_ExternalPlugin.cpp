@@ -879,7 +879,14 @@ void ExternalPlugin::restorePluginStateFromValueTree (const juce::ValueTree& v)
         chunk.fromBase64Encoding (s);
 
         if (chunk.getSize() > 0)
-            callBlocking ([this, &chunk]() { pluginInstance->setStateInformation (chunk.getData(), (int) chunk.getSize()); });
+        {
+            callBlocking ([this, &chunk]
+                          {
+                              // The audio thread will skip blocks rather than wait while this is held
+                              const ScopedLock sl (lock);
+                              pluginInstance->setStateInformation (chunk.getData(), (int) chunk.getSize());
+                          });
+        }
     }
 }
 
@@ -1024,6 +1031,15 @@ void ExternalPlugin::initialise (const PlaybackInitialisationInfo& info)
         pluginInstance->prepareToPlay (info.sampleRate, info.blockSizeSamples);
         isInstancePrepared = true;
 
+        {
+            const ScopedLock csl (contentionStateLock);
+            lastBlock.setSize (jmax (2, pluginInstance->getTotalNumInputChannels(), pluginInstance->getTotalNumOutputChannels()),
+                               info.blockSizeSamples);
+            lastBlockNumSamples = 0;
+            deferredMidi.clear();
+            deferredMidi.reserve (maxNumDeferredMidiMessages);
+        }
+
         latencySamples = pluginInstance->getLatencySamples();
         latencySeconds = latencySamples / info.sampleRate;
 
@@ -1180,8 +1196,16 @@ void ExternalPlugin::applyToBuffer (const AudioRenderContext& fc)
     if (pluginInstance != nullptr && isEnabled())
     {
         CRASH_TRACER_PLUGIN (getDebugName());
-        const ScopedLock sl (lock);
+        const ScopedTryLock sl (lock);
+
+        if (! sl.isLocked())
+        {
+            applyContentionFallback (fc);
+            return;
+        }
+
         jassert (isInstancePrepared);
+        ++numBlocksProcessed;
 
         if (playhead != nullptr)
             playhead->setCurrentContext (&fc);
@@ -1189,7 +1213,13 @@ void ExternalPlugin::applyToBuffer (const AudioRenderContext& fc)
         midiBuffer.clear();
 
         if (fc.bufferForMidiMessages != nullptr)
+        {
+            // The MIDI from skipped blocks is older, so it goes before any of this block's events at the same time
+            if (deferredMidi.isNotEmpty() || deferredMidi.isAllNotesOff)
+                prepareIncomingMidiMessages (deferredMidi, fc.bufferNumSamples, fc.playhead.isPlaying());
+
             prepareIncomingMidiMessages (*fc.bufferForMidiMessages, fc.bufferNumSamples, fc.playhead.isPlaying());
+        }
 
         if (fc.destBuffer != nullptr)
         {
@@ -1272,9 +1302,117 @@ void ExternalPlugin::applyToBuffer (const AudioRenderContext& fc)
                                                               midiSourceID);
             }
         }
+
+        storeLastBlock (fc);
+    }
+}
+
+void ExternalPlugin::applyContentionFallback (const AudioRenderContext& fc)
+{
+    ++numBlocksSkipped;
+
+    const ScopedTryLock csl (contentionStateLock);
+
+    // If that's held, the plugin's being re-prepared so there's nothing worth holding on to
+    if (! csl.isLocked())
+    {
+        if (fc.bufferForMidiMessages != nullptr)
+            fc.bufferForMidiMessages->clear();
+
+        if (fc.destBuffer != nullptr)
+            fc.destBuffer->clear (fc.bufferStartSample, fc.bufferNumSamples);
+
+        return;
+    }
+
+    // Hold on to the MIDI so note-offs etc. aren't lost, it will be sent at the start of the next block
+    if (fc.bufferForMidiMessages != nullptr)
+    {
+        auto& incoming = *fc.bufferForMidiMessages;
+        deferredMidi.isAllNotesOff = deferredMidi.isAllNotesOff || incoming.isAllNotesOff;
+
+        for (auto& m : incoming)
+        {
+            // Stop everything rather than grow the list on the audio thread and risk leaving notes hanging
+            if (deferredMidi.size() >= maxNumDeferredMidiMessages)
+            {
+                deferredMidi.isAllNotesOff = true;
+                break;
+            }
+
+            deferredMidi.add (std::move (m), 0.0);
+        }
+
+        incoming.clear();
+    }
+
+    if (fc.destBuffer == nullptr)
+        return;
+
+    auto& dest = *fc.destBuffer;
+
+    if (contentionFallback == ContentionFallback::repeatLastBlock && lastBlockNumSamples > 0)
+    {
+        for (int i = 0; i < dest.getNumChannels(); ++i)
+        {
+            if (i >= lastBlock.getNumChannels())
+            {
+                dest.clear (i, fc.bufferStartSample, fc.bufferNumSamples);
+                continue;
+            }
+
+            // Loop the last block if this one is longer
+            for (int done = 0; done < fc.bufferNumSamples;)
+            {
+                auto numThisTime = jmin (lastBlockNumSamples, fc.bufferNumSamples - done);
+                dest.copyFrom (i, fc.bufferStartSample + done, lastBlock, i, 0, numThisTime);
+                done += numThisTime;
+            }
+        }
+    }
+    else
+    {
+        dest.clear (fc.bufferStartSample, fc.bufferNumSamples);
     }
 }
 
+void ExternalPlugin::storeLastBlock (const AudioRenderContext& fc)
+{
+    if (contentionFallback != ContentionFallback::repeatLastBlock || fc.destBuffer == nullptr)
+    {
+        lastBlockNumSamples = 0;
+        return;
+    }
+
+    lastBlockNumSamples = jmin (fc.bufferNumSamples, lastBlock.getNumSamples());
+    auto numChans = jmin (lastBlock.getNumChannels(), fc.destBuffer->getNumChannels());
+
+    for (int i = 0; i < numChans; ++i)
+        lastBlock.copyFrom (i, 0, *fc.destBuffer, i, fc.bufferStartSample, lastBlockNumSamples);
+
+    for (int i = numChans; i < lastBlock.getNumChannels(); ++i)
+        lastBlock.clear (i, 0, lastBlockNumSamples);
+}
+
+void ExternalPlugin::setContentionFallback (ContentionFallback newFallback) noexcept
+{
+    contentionFallback = newFallback;
+}
+
+ExternalPlugin::ContentionStats ExternalPlugin::getContentionStats() const noexcept
+{
+    ContentionStats stats;
+    stats.numBlocksProcessed = numBlocksProcessed;
+    stats.numBlocksSkipped = numBlocksSkipped;
+    return stats;
+}
+
+void ExternalPlugin::resetContentionStats() noexcept
+{
+    numBlocksProcessed = 0;
+    numBlocksSkipped = 0;
+}
+
 void ExternalPlugin::processPluginBlock (const AudioRenderContext& fc)
 {
     juce::AudioBuffer<float> asb (fc.destBuffer->getArrayOfWritePointers(), fc.destBuffer->getNumChannels(),
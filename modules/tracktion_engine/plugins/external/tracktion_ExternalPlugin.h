@@ -113,6 +113,37 @@ public:
 
     ActiveNoteList getActiveNotes() const           { return activeNotes; }
 
+    //==============================================================================
+    /** The audio thread never waits for the plugin lock. If a message thread operation
+        such as a state restore or re-initialisation is holding it, the block is skipped
+        and this determines what is output in its place. Any incoming MIDI is deferred
+        to the next block that can be processed.
+    */
+    enum class ContentionFallback
+    {
+        outputSilence,      /**< Clears the output for the skipped block. */
+        repeatLastBlock     /**< Repeats the last successfully processed block. */
+    };
+
+    /** Sets what happens when the audio thread can't process a block. */
+    void setContentionFallback (ContentionFallback) noexcept;
+
+    /** Returns the current ContentionFallback mode. */
+    ContentionFallback getContentionFallback() const noexcept   { return contentionFallback; }
+
+    /** Counts the blocks processed and skipped due to lock contention. */
+    struct ContentionStats
+    {
+        juce::uint64 numBlocksProcessed = 0;
+        juce::uint64 numBlocksSkipped = 0;
+    };
+
+    /** Returns the number of blocks processed and skipped since the last reset. */
+    ContentionStats getContentionStats() const noexcept;
+
+    /** Resets the contention counters. */
+    void resetContentionStats() noexcept;
+
 private:
     //==============================================================================
     juce::CriticalSection lock;
@@ -127,6 +158,16 @@ private:
     bool isInstancePrepared = false;
 
     juce::MidiBuffer midiBuffer;
+
+    // Used by the audio thread when it can't get the lock. These are only resized in
+    // initialise() while holding contentionStateLock, so skipped blocks can't see them change.
+    juce::CriticalSection contentionStateLock;
+    MidiMessageArray deferredMidi;
+    juce::AudioBuffer<float> lastBlock;
+    int lastBlockNumSamples = 0;
+    static constexpr int maxNumDeferredMidiMessages = 256;
+    std::atomic<ContentionFallback> contentionFallback { ContentionFallback::outputSilence };
+    std::atomic<juce::uint64> numBlocksProcessed { 0 }, numBlocksSkipped { 0 };
     MidiMessageArray::MPESourceID midiSourceID = MidiMessageArray::createUniqueMPESourceID();
 
     ActiveNoteList activeNotes;
@@ -157,6 +198,8 @@ private:
     void refreshParameterValues();
     void updateDebugName();
     void processPluginBlock (const AudioRenderContext&);
+    void applyContentionFallback (const AudioRenderContext&);
+    void storeLastBlock (const AudioRenderContext&);
 
     std::unique_ptr<juce::PluginDescription> findMatchingPlugin() const;
     std::unique_ptr<juce::PluginDescription> findDescForUID (int uid) const;
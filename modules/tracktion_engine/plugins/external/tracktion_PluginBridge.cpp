@@ -0,0 +1,1404 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+#if JUCE_LINUX
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <sys/syscall.h>
+ #include <linux/futex.h>
+ #include <fcntl.h>
+ #include <signal.h>
+ #include <unistd.h>
+ #include <ctime>
+#endif
+
+namespace tracktion_engine
+{
+
+static const char* bridgeCommandLineUID = "PluginBridge";
+
+static constexpr int bridgeNumSlots = 4;
+static constexpr int bridgeMaxMidiBytes = 16384;
+static constexpr int bridgeReplyTimeoutMs = 10000;
+static constexpr int bridgeProcessTimeoutMs = 2000;
+static constexpr int bridgeWatchdogIntervalMs = 500;
+
+#if TRACKTION_UNIT_TESTS
+static std::atomic<bool> bridgeTestPluginEnabled { false };
+#endif
+
+static size_t alignBridgeSize (size_t size) noexcept
+{
+    return (size + 63) & ~(size_t) 63;
+}
+
+//==============================================================================
+PluginBridge::BlockRing::BlockRing (SharedHeader& h, char* firstSlot,
+                                    std::atomic<uint32>& w, std::atomic<uint32>& r) noexcept
+    : header (h), slots (firstSlot), writeIndex (w), readIndex (r),
+      slotSize (getSlotSize (h.numChannels, h.maxBlockSize, h.maxMidiBytes))
+{
+}
+
+size_t PluginBridge::BlockRing::getSlotSize (int numChannels, int maxBlockSize, int maxMidiBytes) noexcept
+{
+    return alignBridgeSize (2 * sizeof (int32)
+                             + sizeof (float) * (size_t) numChannels * (size_t) maxBlockSize
+                             + (size_t) maxMidiBytes);
+}
+
+char* PluginBridge::BlockRing::getSlot (uint32 index) const noexcept
+{
+    return slots + slotSize * (index % (uint32) header.numSlots);
+}
+
+bool PluginBridge::BlockRing::write (const AudioBuffer<float>& buffer, int numSamples, const MidiBuffer& midi) noexcept
+{
+    const auto w = writeIndex.load (std::memory_order_relaxed);
+
+    if (w - readIndex.load (std::memory_order_acquire) >= (uint32) header.numSlots)
+        return false;
+
+    jassert (numSamples <= header.maxBlockSize);
+    numSamples = jmin (numSamples, header.maxBlockSize);
+
+    auto slot = getSlot (w);
+    auto audio = reinterpret_cast<float*> (slot + 2 * sizeof (int32));
+    auto midiData = reinterpret_cast<uint8*> (audio + header.numChannels * header.maxBlockSize);
+
+    for (int i = 0; i < header.numChannels; ++i)
+    {
+        auto dest = audio + i * header.maxBlockSize;
+
+        if (i < buffer.getNumChannels())
+            FloatVectorOperations::copy (dest, buffer.getReadPointer (i), numSamples);
+        else
+            FloatVectorOperations::clear (dest, numSamples);
+    }
+
+    // Events are packed as [int32 position][uint16 size][data]
+    int numMidiBytes = 0;
+    const uint8* eventData;
+    int eventSize, eventPos;
+
+    for (MidiBuffer::Iterator iter (midi); iter.getNextEvent (eventData, eventSize, eventPos);)
+    {
+        const int bytesNeeded = (int) (sizeof (int32) + sizeof (uint16)) + eventSize;
+
+        if (numMidiBytes + bytesNeeded > header.maxMidiBytes)
+            break;
+
+        const auto pos = (int32) eventPos;
+        const auto size = (uint16) eventSize;
+        std::memcpy (midiData + numMidiBytes, &pos, sizeof (pos));
+        std::memcpy (midiData + numMidiBytes + sizeof (pos), &size, sizeof (size));
+        std::memcpy (midiData + numMidiBytes + sizeof (pos) + sizeof (size), eventData, (size_t) eventSize);
+        numMidiBytes += bytesNeeded;
+    }
+
+    const int32 sizes[] = { (int32) numSamples, (int32) numMidiBytes };
+    std::memcpy (slot, sizes, sizeof (sizes));
+
+    writeIndex.store (w + 1, std::memory_order_release);
+    return true;
+}
+
+bool PluginBridge::BlockRing::read (AudioBuffer<float>& buffer, int& numSamples, MidiBuffer& midi) noexcept
+{
+    const auto r = readIndex.load (std::memory_order_relaxed);
+
+    if (r == writeIndex.load (std::memory_order_acquire))
+        return false;
+
+    auto slot = getSlot (r);
+    int32 sizes[2];
+    std::memcpy (sizes, slot, sizeof (sizes));
+    numSamples = jlimit (0, header.maxBlockSize, (int) sizes[0]);
+    const int numMidiBytes = jlimit (0, header.maxMidiBytes, (int) sizes[1]);
+
+    auto audio = reinterpret_cast<const float*> (slot + 2 * sizeof (int32));
+    auto midiData = reinterpret_cast<const uint8*> (audio + header.numChannels * header.maxBlockSize);
+
+    jassert (buffer.getNumSamples() >= numSamples);
+
+    for (int i = 0; i < buffer.getNumChannels(); ++i)
+    {
+        if (i < header.numChannels)
+            buffer.copyFrom (i, 0, audio + i * header.maxBlockSize, numSamples);
+        else
+            buffer.clear (i, 0, numSamples);
+    }
+
+    midi.clear();
+
+    for (int offset = 0; offset + (int) (sizeof (int32) + sizeof (uint16)) <= numMidiBytes;)
+    {
+        int32 pos;
+        uint16 size;
+        std::memcpy (&pos, midiData + offset, sizeof (pos));
+        std::memcpy (&size, midiData + offset + sizeof (pos), sizeof (size));
+        offset += (int) (sizeof (pos) + sizeof (size));
+
+        if (offset + size > numMidiBytes)
+            break;
+
+        midi.addEvent (midiData + offset, size, (int) pos);
+        offset += size;
+    }
+
+    readIndex.store (r + 1, std::memory_order_release);
+    return true;
+}
+
+int PluginBridge::BlockRing::getNumReady() const noexcept
+{
+    return (int) (writeIndex.load (std::memory_order_acquire) - readIndex.load (std::memory_order_acquire));
+}
+
+void PluginBridge::BlockRing::reset() noexcept
+{
+    readIndex = 0;
+    writeIndex = 0;
+}
+
+//==============================================================================
+size_t PluginBridge::getSharedMemorySize (int numSlots, int numChannels, int maxBlockSize, int maxMidiBytes, int numParameters) noexcept
+{
+    return alignBridgeSize (sizeof (SharedHeader))
+            + alignBridgeSize (sizeof (std::atomic<float>) * (size_t) numParameters)
+            + 2 * (size_t) numSlots * BlockRing::getSlotSize (numChannels, maxBlockSize, maxMidiBytes);
+}
+
+PluginBridge::SharedHeader& PluginBridge::initialiseSharedMemory (void* memory, int numSlots, int numChannels,
+                                                                  int maxBlockSize, int maxMidiBytes, int numParameters) noexcept
+{
+    auto header = new (memory) SharedHeader();
+    header->numSlots = numSlots;
+    header->numChannels = numChannels;
+    header->maxBlockSize = maxBlockSize;
+    header->maxMidiBytes = maxMidiBytes;
+    header->numParameters = numParameters;
+
+    auto params = getParameterValues (*header);
+
+    for (int i = 0; i < numParameters; ++i)
+        new (params + i) std::atomic<float> (0.0f);
+
+    return *header;
+}
+
+std::atomic<float>* PluginBridge::getParameterValues (SharedHeader& header) noexcept
+{
+    return reinterpret_cast<std::atomic<float>*> (reinterpret_cast<char*> (&header) + alignBridgeSize (sizeof (SharedHeader)));
+}
+
+static char* getFirstBridgeSlot (PluginBridge::SharedHeader& header, int ringIndex) noexcept
+{
+    return reinterpret_cast<char*> (&header)
+            + alignBridgeSize (sizeof (PluginBridge::SharedHeader))
+            + alignBridgeSize (sizeof (std::atomic<float>) * (size_t) header.numParameters)
+            + (size_t) ringIndex * (size_t) header.numSlots
+                * PluginBridge::BlockRing::getSlotSize (header.numChannels, header.maxBlockSize, header.maxMidiBytes);
+}
+
+PluginBridge::BlockRing PluginBridge::getInputRing (SharedHeader& header) noexcept
+{
+    return { header, getFirstBridgeSlot (header, 0), header.inputWrite, header.inputRead };
+}
+
+PluginBridge::BlockRing PluginBridge::getOutputRing (SharedHeader& header) noexcept
+{
+    return { header, getFirstBridgeSlot (header, 1), header.outputWrite, header.outputRead };
+}
+
+void PluginBridge::wakeChild (SharedHeader& header) noexcept
+{
+    header.childWakeCounter.fetch_add (1, std::memory_order_release);
+
+   #if JUCE_LINUX
+    syscall (SYS_futex, reinterpret_cast<int32*> (&header.childWakeCounter), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+   #endif
+}
+
+void PluginBridge::waitForWake (SharedHeader& header, int32 lastWakeCount, int timeoutMs) noexcept
+{
+   #if JUCE_LINUX
+    timespec timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_nsec = (timeoutMs % 1000) * 1000000;
+    syscall (SYS_futex, reinterpret_cast<int32*> (&header.childWakeCounter), FUTEX_WAIT, lastWakeCount, &timeout, nullptr, 0);
+   #else
+    if (header.childWakeCounter.load() == lastWakeCount)
+        Thread::sleep (jmin (timeoutMs, 1));
+   #endif
+}
+
+//==============================================================================
+#if JUCE_LINUX
+
+/** A POSIX shared memory segment mapped in to this process. */
+struct SharedMemorySegment
+{
+    SharedMemorySegment() = default;
+
+    ~SharedMemorySegment()
+    {
+        if (data != nullptr)
+            munmap (data, size);
+
+        if (ownsName)
+            shm_unlink (name.toRawUTF8());
+    }
+
+    static std::unique_ptr<SharedMemorySegment> create (size_t numBytes)
+    {
+        static std::atomic<int> segmentCounter { 0 };
+        auto name = "/tracktion_bridge_" + String ((int) getpid()) + "_" + String (++segmentCounter);
+        auto fd = shm_open (name.toRawUTF8(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+        if (fd < 0)
+            return {};
+
+        std::unique_ptr<SharedMemorySegment> s (new SharedMemorySegment());
+        s->name = name;
+        s->ownsName = true;
+
+        if (ftruncate (fd, (off_t) numBytes) == 0)
+            s->map (fd, numBytes);
+
+        close (fd);
+
+        if (s->data == nullptr)
+            return {};
+
+        std::memset (s->data, 0, numBytes);
+        return s;
+    }
+
+    static std::unique_ptr<SharedMemorySegment> open (const String& name, size_t numBytes)
+    {
+        auto fd = shm_open (name.toRawUTF8(), O_RDWR, 0600);
+
+        if (fd < 0)
+            return {};
+
+        std::unique_ptr<SharedMemorySegment> s (new SharedMemorySegment());
+        s->name = name;
+        s->map (fd, numBytes);
+        close (fd);
+
+        if (s->data == nullptr)
+            return {};
+
+        return s;
+    }
+
+    String name;
+    void* data = nullptr;
+    size_t size = 0;
+    bool ownsName = false;
+
+private:
+    void map (int fd, size_t numBytes)
+    {
+        auto d = mmap (nullptr, numBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        if (d != MAP_FAILED)
+        {
+            data = d;
+            size = numBytes;
+            mlock (data, size);
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (SharedMemorySegment)
+};
+
+//==============================================================================
+static MemoryBlock createBridgeMessage (const XmlElement& xml)
+{
+    MemoryOutputStream mo;
+    xml.writeTo (mo, XmlElement::TextFormat().withoutHeader().singleLine());
+    return mo.getMemoryBlock();
+}
+
+//==============================================================================
+/** The host's end of the connection to a child process. */
+struct PluginBridgeMasterProcess  : private ChildProcessMaster
+{
+    PluginBridgeMasterProcess (std::function<void()> onCrash)
+        : crashCallback (std::move (onCrash))
+    {
+    }
+
+    ~PluginBridgeMasterProcess() override
+    {
+        crashCallback = nullptr;
+    }
+
+    bool launch()
+    {
+        // don't get stdout or strerr from the child process, it fills up the pipe and hangs
+        launched = launchSlaveProcess (File::getSpecialLocation (File::currentExecutableFile),
+                                       bridgeCommandLineUID, 5000, 0);
+        return launched;
+    }
+
+    /** Sends a request and waits for the reply with the same ID.
+        If the child doesn't reply in time it's assumed to have hung and is killed.
+    */
+    std::unique_ptr<XmlElement> sendRequest (XmlElement& request)
+    {
+        const int requestID = ++nextRequestID;
+        request.setAttribute ("id", requestID);
+
+        if (! launched || crashed || ! sendMessageToSlave (createBridgeMessage (request)))
+            return {};
+
+        const auto endTime = Time::getMillisecondCounter() + (uint32) bridgeReplyTimeoutMs;
+
+        while (! crashed && Time::getMillisecondCounter() < endTime)
+        {
+            {
+                const ScopedLock sl (replyLock);
+
+                for (int i = replies.size(); --i >= 0;)
+                    if (replies.getUnchecked (i)->getIntAttribute ("id") == requestID)
+                        return std::unique_ptr<XmlElement> (replies.removeAndReturn (i));
+            }
+
+            replyEvent.wait (20);
+        }
+
+        if (! crashed)
+        {
+            TRACKTION_LOG_ERROR ("Plugin bridge process didn't reply to " + request.getTagName());
+            killChild();
+        }
+
+        return {};
+    }
+
+    /** Kills the child process. The connection will then be lost and the crash
+        callback called, in the same way as if it had crashed.
+    */
+    void killChild()
+    {
+        if (auto pid = childProcessID.load())
+            ::kill ((pid_t) pid, SIGKILL);
+    }
+
+    std::atomic<bool> launched { false }, crashed { false };
+
+private:
+    std::function<void()> crashCallback;
+    OwnedArray<XmlElement> replies;
+    CriticalSection replyLock;
+    WaitableEvent replyEvent;
+    int nextRequestID = 0;
+    std::atomic<int> childProcessID { 0 };
+
+    void handleMessageFromSlave (const MemoryBlock& mb) override
+    {
+        if (auto xml = std::unique_ptr<XmlElement> (XmlDocument::parse (mb.toString())))
+        {
+            // The child sends its process ID as soon as it's connected so it can be killed if it hangs
+            if (xml->hasTagName ("HELLO"))
+            {
+                childProcessID = xml->getIntAttribute ("pid");
+                return;
+            }
+
+            const ScopedLock sl (replyLock);
+            replies.add (xml.release());
+        }
+
+        replyEvent.signal();
+    }
+
+    void handleConnectionLost() override
+    {
+        crashed = true;
+        replyEvent.signal();
+
+        if (crashCallback)
+            crashCallback();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginBridgeMasterProcess)
+};
+
+//==============================================================================
+/** The properties of a plugin loaded in a child process. */
+struct BridgedPluginInfo
+{
+    bool loadFromReply (const XmlElement& reply)
+    {
+        if (! reply.hasTagName ("LOADED"))
+            return false;
+
+        name = reply.getStringAttribute ("name");
+        numInputChannels = reply.getIntAttribute ("ins");
+        numOutputChannels = reply.getIntAttribute ("outs");
+        acceptsMidi = reply.getBoolAttribute ("acceptsMidi");
+        producesMidi = reply.getBoolAttribute ("producesMidi");
+        tailLengthSeconds = reply.getDoubleAttribute ("tail");
+        currentProgram = reply.getIntAttribute ("program");
+
+        programNames.clear();
+        parameters.clear();
+
+        forEachXmlChildElementWithTagName (reply, e, "PROGRAM")
+            programNames.add (e->getStringAttribute ("name"));
+
+        forEachXmlChildElementWithTagName (reply, e, "PARAM")
+            parameters.add ({ e->getStringAttribute ("name"), e->getStringAttribute ("label"),
+                              (float) e->getDoubleAttribute ("default"), (float) e->getDoubleAttribute ("value"),
+                              e->getIntAttribute ("steps") });
+
+        return true;
+    }
+
+    struct Parameter
+    {
+        String name, label;
+        float defaultValue, value;
+        int numSteps;
+    };
+
+    String name;
+    int numInputChannels = 0, numOutputChannels = 0, currentProgram = 0;
+    bool acceptsMidi = false, producesMidi = false;
+    double tailLengthSeconds = 0.0;
+    StringArray programNames;
+    Array<Parameter> parameters;
+};
+
+//==============================================================================
+/** An AudioPluginInstance that forwards everything to a plugin running in a child process. */
+class BridgedPluginInstance  : public AudioPluginInstance,
+                               private AsyncUpdater,
+                               private Timer
+{
+public:
+    BridgedPluginInstance (const PluginDescription& d, std::unique_ptr<PluginBridgeMasterProcess> c,
+                           const BridgedPluginInfo& i)
+        : AudioPluginInstance (createBuses (i)),
+          desc (d), info (i), connection (std::move (c))
+    {
+        for (int index = 0; index < info.parameters.size(); ++index)
+            addParameter (new BridgedParameter (*this, info.parameters.getReference (index)));
+
+        isChildRunning = true;
+        startTimer (bridgeWatchdogIntervalMs);
+    }
+
+    ~BridgedPluginInstance() override
+    {
+        stopTimer();
+        cancelPendingUpdate();
+
+        const ScopedLock sl (processLock);
+        isChildRunning = false;
+        connection.reset();
+        sharedMemory.reset();
+    }
+
+    static std::unique_ptr<PluginBridgeMasterProcess> launchAndLoad (const PluginDescription& d, BridgedPluginInfo& i,
+                                                                     std::function<void()> onCrash, String& error)
+    {
+        auto c = std::make_unique<PluginBridgeMasterProcess> (std::move (onCrash));
+
+        if (! c->launch())
+        {
+            error = TRANS("Failed to launch the plugin bridge process");
+            return {};
+        }
+
+        XmlElement request ("LOAD");
+
+       #if TRACKTION_UNIT_TESTS
+        if (bridgeTestPluginEnabled)
+            request.setAttribute ("testPlugin", true);
+       #endif
+
+        if (auto descXml = d.createXml())
+            request.addChildElement (descXml.release());
+
+        auto reply = c->sendRequest (request);
+
+        if (reply == nullptr)
+        {
+            error = TRANS("The plugin bridge process didn't respond");
+            return {};
+        }
+
+        if (! i.loadFromReply (*reply))
+        {
+            error = reply->getStringAttribute ("error", TRANS("Failed to load plugin in the bridge process"));
+            return {};
+        }
+
+        return c;
+    }
+
+    std::function<void()> createCrashCallback()
+    {
+        return [this]
+        {
+            isChildRunning = false;
+            triggerAsyncUpdate();
+        };
+    }
+
+    //==============================================================================
+    const String getName() const override                       { return info.name; }
+    double getTailLengthSeconds() const override                { return info.tailLengthSeconds; }
+    bool acceptsMidi() const override                           { return info.acceptsMidi; }
+    bool producesMidi() const override                          { return info.producesMidi; }
+    AudioProcessorEditor* createEditor() override               { return nullptr; }
+    bool hasEditor() const override                             { return false; }
+    int getNumPrograms() override                               { return info.programNames.size(); }
+    int getCurrentProgram() override                            { return info.currentProgram; }
+    const String getProgramName (int index) override            { return info.programNames[index]; }
+
+    void fillInPluginDescription (PluginDescription& d) const override
+    {
+        d = desc;
+    }
+
+    void setCurrentProgram (int index) override
+    {
+        info.currentProgram = index;
+
+        XmlElement request ("SET_PROGRAM");
+        request.setAttribute ("index", index);
+
+        if (auto reply = sendRequestIfRunning (request))
+            updateParameterValues (*reply);
+    }
+
+    void changeProgramName (int index, const String& newName) override
+    {
+        if (isPositiveAndBelow (index, info.programNames.size()))
+            info.programNames.set (index, newName);
+
+        XmlElement request ("SET_PROGRAM_NAME");
+        request.setAttribute ("index", index);
+        request.setAttribute ("name", newName);
+        sendRequestIfRunning (request);
+    }
+
+    void getStateInformation (MemoryBlock& destData) override
+    {
+        XmlElement request ("GET_STATE");
+
+        if (auto reply = sendRequestIfRunning (request))
+            lastState.fromBase64Encoding (reply->getStringAttribute ("data"));
+
+        destData = lastState;
+    }
+
+    void setStateInformation (const void* data, int sizeInBytes) override
+    {
+        lastState.replaceWith (data, (size_t) sizeInBytes);
+
+        XmlElement request ("SET_STATE");
+        request.setAttribute ("data", lastState.toBase64Encoding());
+
+        if (auto reply = sendRequestIfRunning (request))
+            updateParameterValues (*reply);
+    }
+
+    void reset() override
+    {
+        XmlElement request ("RESET");
+        sendRequestIfRunning (request);
+    }
+
+    //==============================================================================
+    void prepareToPlay (double sampleRate, int blockSize) override
+    {
+        const ScopedLock sl (processLock);
+
+        preparedSampleRate = sampleRate;
+        preparedBlockSize = jmax (1, blockSize);
+        numChannels = jmax (1, getTotalNumInputChannels(), getTotalNumOutputChannels());
+
+        const auto numBytes = PluginBridge::getSharedMemorySize (bridgeNumSlots, numChannels, preparedBlockSize,
+                                                                 bridgeMaxMidiBytes, info.parameters.size());
+        sharedMemory = SharedMemorySegment::create (numBytes);
+
+        if (sharedMemory == nullptr)
+        {
+            jassertfalse;
+            header = nullptr;
+            return;
+        }
+
+        header = &PluginBridge::initialiseSharedMemory (sharedMemory->data, bridgeNumSlots, numChannels, preparedBlockSize,
+                                                        bridgeMaxMidiBytes, info.parameters.size());
+
+        scratchBuffer.setSize (numChannels, preparedBlockSize);
+        scratchMidi.ensureSize (bridgeMaxMidiBytes);
+        pendingOutputMidi.ensureSize (bridgeMaxMidiBytes);
+        outputFifo.setSize (numChannels, preparedBlockSize * (bridgeNumSlots + 2));
+
+        sendPrepareMessage();
+    }
+
+    void releaseResources() override
+    {
+        const ScopedLock sl (processLock);
+
+        XmlElement request ("RELEASE");
+        sendRequestIfRunning (request);
+
+        header = nullptr;
+        sharedMemory.reset();
+    }
+
+    void processBlock (AudioBuffer<float>& buffer, MidiBuffer& midi) override
+    {
+        const ScopedTryLock sl (processLock);
+        const int numSamples = buffer.getNumSamples();
+
+        if (! sl.isLocked() || ! isChildRunning || header == nullptr || numSamples > preparedBlockSize)
+        {
+            buffer.clear();
+            midi.clear();
+            return;
+        }
+
+        auto inputRing = PluginBridge::getInputRing (*header);
+        auto outputRing = PluginBridge::getOutputRing (*header);
+
+        if (parametersChanged.exchange (false))
+            writeParameterValues();
+
+        const auto now = Time::getMillisecondCounter();
+
+        // Collect anything the child has finished
+        for (int numRead = 0; outputRing.read (scratchBuffer, numRead, scratchMidi);)
+        {
+            lastBlockReceivedTime = now;
+            int numToSkip = jmin (samplesToSkip, numRead);
+            samplesToSkip -= numToSkip;
+
+            if (numRead > numToSkip)
+                outputFifo.write (scratchBuffer, numToSkip, numRead - numToSkip);
+
+            pendingOutputMidi.addEvents (scratchMidi, 0, -1, 0);
+        }
+
+        // Then pass this block on
+        if (inputRing.write (buffer, numSamples, midi))
+            PluginBridge::wakeChild (*header);
+        else
+            ++stats.numOverruns;
+
+        lastBlockSentTime = now;
+
+        ++stats.numBlocksProcessed;
+        midi.clear();
+
+        if (outputFifo.getNumReady() >= numSamples)
+        {
+            outputFifo.read (buffer, 0, numSamples);
+
+            // MIDI is passed back at the same position in the block it was produced in
+            const uint8* eventData;
+            int eventSize, eventPos;
+
+            for (MidiBuffer::Iterator iter (pendingOutputMidi); iter.getNextEvent (eventData, eventSize, eventPos);)
+                midi.addEvent (eventData, eventSize, jlimit (0, numSamples - 1, eventPos));
+        }
+        else
+        {
+            // The child is late so output silence and skip the same amount when
+            // it catches up to keep the latency constant
+            ++stats.numUnderruns;
+            samplesToSkip += numSamples - outputFifo.getNumReady();
+            outputFifo.reset();
+            buffer.clear();
+        }
+
+        pendingOutputMidi.clear();
+    }
+
+    PluginBridge::Stats getStats() const
+    {
+        return stats;
+    }
+
+private:
+    //==============================================================================
+    struct BridgedParameter  : public AudioProcessorParameter
+    {
+        BridgedParameter (BridgedPluginInstance& o, const BridgedPluginInfo::Parameter& p)
+            : owner (o), details (p), value (p.value)
+        {
+        }
+
+        float getValue() const override                     { return value; }
+        float getDefaultValue() const override              { return details.defaultValue; }
+        String getName (int maximumStringLength) const override { return details.name.substring (0, maximumStringLength); }
+        String getLabel() const override                    { return details.label; }
+        int getNumSteps() const override                    { return details.numSteps > 0 ? details.numSteps : AudioProcessor::getDefaultNumParameterSteps(); }
+        float getValueForText (const String& text) const override { return text.getFloatValue(); }
+
+        void setValue (float newValue) override
+        {
+            value = newValue;
+            owner.parametersChanged = true;
+        }
+
+        BridgedPluginInstance& owner;
+        const BridgedPluginInfo::Parameter details;
+        std::atomic<float> value;
+    };
+
+    PluginDescription desc;
+    BridgedPluginInfo info;
+    std::unique_ptr<PluginBridgeMasterProcess> connection;
+    std::unique_ptr<SharedMemorySegment> sharedMemory;
+    PluginBridge::SharedHeader* header = nullptr;
+
+    CriticalSection processLock;
+    std::atomic<bool> isChildRunning { false }, parametersChanged { false };
+    std::atomic<uint32> lastBlockSentTime { 0 }, lastBlockReceivedTime { 0 };
+    double preparedSampleRate = 0.0;
+    int preparedBlockSize = 0, numChannels = 0, samplesToSkip = 0;
+
+    AudioBuffer<float> scratchBuffer;
+    MidiBuffer scratchMidi, pendingOutputMidi;
+    AudioFifo outputFifo { 1, 32 };
+    MemoryBlock lastState;
+
+    struct AtomicStats
+    {
+        std::atomic<uint64> numBlocksProcessed { 0 }, numUnderruns { 0 }, numOverruns { 0 };
+        std::atomic<int> numRestarts { 0 };
+
+        operator PluginBridge::Stats() const
+        {
+            PluginBridge::Stats s;
+            s.numBlocksProcessed = numBlocksProcessed;
+            s.numUnderruns = numUnderruns;
+            s.numOverruns = numOverruns;
+            s.numRestarts = numRestarts;
+            return s;
+        }
+    };
+
+    AtomicStats stats;
+
+    static BusesProperties createBuses (const BridgedPluginInfo& i)
+    {
+        BusesProperties buses;
+
+        if (i.numInputChannels > 0)
+            buses = buses.withInput ("Input", AudioChannelSet::canonicalChannelSet (i.numInputChannels), true);
+
+        if (i.numOutputChannels > 0)
+            buses = buses.withOutput ("Output", AudioChannelSet::canonicalChannelSet (i.numOutputChannels), true);
+
+        return buses;
+    }
+
+    std::unique_ptr<XmlElement> sendRequestIfRunning (XmlElement& request)
+    {
+        if (isChildRunning && connection != nullptr)
+            return connection->sendRequest (request);
+
+        return {};
+    }
+
+    /** Copies the parameter values to the shared memory for the child to pick up.
+        Must be called with the processLock held.
+    */
+    void writeParameterValues() noexcept
+    {
+        auto values = PluginBridge::getParameterValues (*header);
+        auto& params = getParameters();
+
+        for (int i = jmin (header->numParameters, params.size()); --i >= 0;)
+            values[i].store (params.getUnchecked (i)->getValue(), std::memory_order_relaxed);
+
+        header->parameterChangeCounter.fetch_add (1, std::memory_order_release);
+    }
+
+    /** Updates the parameters to the values the child reports after its state or program
+        has changed, without sending them back to it.
+    */
+    void updateParameterValues (const XmlElement& reply)
+    {
+        int index = 0;
+
+        forEachXmlChildElementWithTagName (reply, e, "PARAM")
+            updateParameterValue (index++, (float) e->getDoubleAttribute ("value"));
+    }
+
+    void updateParameterValue (int index, float newValue)
+    {
+        if (auto p = dynamic_cast<BridgedParameter*> (getParameters()[index]))
+            if (p->value.exchange (newValue) != newValue)
+                p->sendValueChangedMessageToListeners (newValue);
+    }
+
+    /** Must be called with the processLock held. The child starts with its plugin's current
+        parameter values, so any changes made while it wasn't prepared are sent with the next block.
+    */
+    void sendPrepareMessage()
+    {
+        PluginBridge::getInputRing (*header).reset();
+        PluginBridge::getOutputRing (*header).reset();
+
+        // Prime the output with one block of silence, this is the latency the bridge adds
+        outputFifo.reset();
+        outputFifo.writeSilence (preparedBlockSize);
+        samplesToSkip = 0;
+
+        // Give the child the full timeout to produce its first block
+        lastBlockReceivedTime = lastBlockSentTime = Time::getMillisecondCounter();
+
+        XmlElement request ("PREPARE");
+        request.setAttribute ("shm", sharedMemory->name);
+        request.setAttribute ("size", (int) sharedMemory->size);
+        request.setAttribute ("rate", preparedSampleRate);
+        request.setAttribute ("blockSize", preparedBlockSize);
+
+        if (auto reply = sendRequestIfRunning (request))
+            setLatencySamples (reply->getIntAttribute ("latency") + preparedBlockSize);
+        else
+            setLatencySamples (preparedBlockSize);
+    }
+
+    //==============================================================================
+    void handleAsyncUpdate() override
+    {
+        relaunchChild();
+    }
+
+    void timerCallback() override
+    {
+        if (isChildRunning)
+            checkForHang();
+        else
+            relaunchChild();
+    }
+
+    /** Kills the child if it's been sent blocks but hasn't returned any for a while.
+        Losing the connection will then relaunch it in the same way as a crash.
+    */
+    void checkForHang()
+    {
+        const auto lastSent = lastBlockSentTime.load();
+
+        if (connection == nullptr || (int32) (lastSent - lastBlockReceivedTime.load()) < bridgeProcessTimeoutMs)
+            return;
+
+        TRACKTION_LOG_ERROR ("Plugin bridge process for " + desc.name + " stopped processing, killing it");
+        lastBlockReceivedTime = lastSent;
+        connection->killChild();
+    }
+
+    void relaunchChild()
+    {
+        if (isChildRunning)
+            return;
+
+        // Keep the audio thread out while we swap the connection over, it will output silence
+        const ScopedLock sl (processLock);
+        ++stats.numRestarts;
+        TRACKTION_LOG_ERROR ("Plugin bridge process for " + desc.name + " died, relaunching");
+
+        connection.reset();
+
+        BridgedPluginInfo newInfo;
+        String error;
+        connection = launchAndLoad (desc, newInfo, createCrashCallback(), error);
+
+        if (connection == nullptr)
+        {
+            TRACKTION_LOG_ERROR (error);
+            startTimer (2000);
+            return;
+        }
+
+        isChildRunning = true;
+        startTimer (bridgeWatchdogIntervalMs);
+
+        // The new child starts with the plugin's default values, or those of the last state
+        for (int i = 0; i < newInfo.parameters.size(); ++i)
+            updateParameterValue (i, newInfo.parameters.getReference (i).value);
+
+        if (lastState.getSize() > 0)
+        {
+            XmlElement request ("SET_STATE");
+            request.setAttribute ("data", lastState.toBase64Encoding());
+
+            if (auto reply = sendRequestIfRunning (request))
+                updateParameterValues (*reply);
+        }
+
+        if (sharedMemory != nullptr && header != nullptr)
+            sendPrepareMessage();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BridgedPluginInstance)
+};
+
+#if TRACKTION_UNIT_TESTS
+//==============================================================================
+/** A plugin the child process can load without any plugin formats, used by the tests.
+    It applies a gain, crashes the process when its "crash" parameter is turned on and
+    stops processing altogether when its "hang" parameter is.
+
+    As it can take down the child on request it can only be loaded when the host has
+    called PluginBridge::setTestPluginEnabled().
+*/
+struct BridgeTestPlugin  : public AudioPluginInstance
+{
+    BridgeTestPlugin()
+        : AudioPluginInstance (BusesProperties().withInput  ("Input",  AudioChannelSet::stereo(), true)
+                                                .withOutput ("Output", AudioChannelSet::stereo(), true))
+    {
+        addParameter (gain = new AudioParameterFloat ("gain", "Gain", 0.0f, 1.0f, 1.0f));
+        addParameter (crash = new AudioParameterBool ("crash", "Crash", false));
+        addParameter (hang = new AudioParameterBool ("hang", "Hang", false));
+    }
+
+    static constexpr const char* formatName = "BridgeTest";
+
+    const String getName() const override                       { return "Bridge Test"; }
+    double getTailLengthSeconds() const override                { return 0.0; }
+    bool acceptsMidi() const override                           { return false; }
+    bool producesMidi() const override                          { return false; }
+    AudioProcessorEditor* createEditor() override               { return nullptr; }
+    bool hasEditor() const override                             { return false; }
+    int getNumPrograms() override                               { return 1; }
+    int getCurrentProgram() override                            { return 0; }
+    void setCurrentProgram (int) override                       {}
+    const String getProgramName (int) override                  { return {}; }
+    void changeProgramName (int, const String&) override        {}
+    void prepareToPlay (double, int) override                   {}
+    void releaseResources() override                            {}
+
+    void fillInPluginDescription (PluginDescription& d) const override
+    {
+        d.name = getName();
+        d.pluginFormatName = formatName;
+        d.fileOrIdentifier = formatName;
+        d.numInputChannels = 2;
+        d.numOutputChannels = 2;
+    }
+
+    void getStateInformation (MemoryBlock& destData) override
+    {
+        MemoryOutputStream (destData, false).writeFloat (*gain);
+    }
+
+    void setStateInformation (const void* data, int sizeInBytes) override
+    {
+        *gain = MemoryInputStream (data, (size_t) sizeInBytes, false).readFloat();
+    }
+
+    void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override
+    {
+        if (*crash)
+            std::abort();
+
+        while (*hang)
+            Thread::sleep (10);
+
+        buffer.applyGain (*gain);
+    }
+
+    AudioParameterFloat* gain;
+    AudioParameterBool* crash;
+    AudioParameterBool* hang;
+};
+#endif
+
+//==============================================================================
+/** The child process end of the bridge. This loads the plugin and processes blocks
+    from the shared memory on a high priority thread.
+*/
+struct PluginBridgeSlaveProcess  : public ChildProcessSlave,
+                                   private AsyncUpdater,
+                                   private Thread
+{
+    PluginBridgeSlaveProcess()  : Thread ("Plugin Bridge")
+    {
+        pluginFormatManager.addDefaultFormats();
+    }
+
+    ~PluginBridgeSlaveProcess() override
+    {
+        stopThread (2000);
+    }
+
+    void handleConnectionMade() override {}
+
+    /** Tells the host this process's ID so it can kill it if the plugin hangs. */
+    void sendProcessID()
+    {
+        XmlElement hello ("HELLO");
+        hello.setAttribute ("pid", (int) getpid());
+        sendMessageToMaster (createBridgeMessage (hello));
+    }
+
+    void handleConnectionLost() override
+    {
+        // This is called on the connection's thread, so shut down from the message thread
+        MessageManager::callAsync ([this]
+        {
+            stopProcessing();
+            plugin.reset();
+            JUCEApplicationBase::quit();
+        });
+    }
+
+private:
+    AudioPluginFormatManager pluginFormatManager;
+    std::unique_ptr<AudioPluginInstance> plugin;
+    OwnedArray<XmlElement, CriticalSection> pendingMessages;
+
+    CriticalSection processLock;
+    std::unique_ptr<SharedMemorySegment> sharedMemory;
+    PluginBridge::SharedHeader* header = nullptr;
+    AudioBuffer<float> buffer;
+    MidiBuffer midi;
+    HeapBlock<float> lastParameterValues;
+    uint32 lastParameterChangeCount = 0;
+
+    //==============================================================================
+    void handleMessageFromMaster (const MemoryBlock& mb) override
+    {
+        if (auto xml = std::unique_ptr<XmlElement> (XmlDocument::parse (mb.toString())))
+        {
+            pendingMessages.add (xml.release());
+            triggerAsyncUpdate();
+        }
+    }
+
+    void handleAsyncUpdate() override
+    {
+        while (pendingMessages.size() > 0)
+            if (auto xml = std::unique_ptr<XmlElement> (pendingMessages.removeAndReturn (0)))
+                handleMessage (*xml);
+    }
+
+    void sendReply (XmlElement& reply, const XmlElement& request)
+    {
+        reply.setAttribute ("id", request.getIntAttribute ("id"));
+        sendMessageToMaster (createBridgeMessage (reply));
+    }
+
+    void handleMessage (const XmlElement& m)
+    {
+        if (m.hasTagName ("LOAD"))              return handleLoad (m);
+        if (m.hasTagName ("PREPARE"))           return handlePrepare (m);
+
+        XmlElement reply ("DONE");
+
+        if (plugin != nullptr)
+        {
+            if (m.hasTagName ("RELEASE"))
+            {
+                stopProcessing();
+                plugin->releaseResources();
+            }
+            else if (m.hasTagName ("GET_STATE"))
+            {
+                MemoryBlock state;
+
+                {
+                    const ScopedLock sl (processLock);
+                    plugin->getStateInformation (state);
+                }
+
+                reply.setAttribute ("data", state.toBase64Encoding());
+            }
+            else
+            {
+                const ScopedLock sl (processLock);
+
+                if (m.hasTagName ("SET_STATE"))
+                {
+                    MemoryBlock state;
+                    state.fromBase64Encoding (m.getStringAttribute ("data"));
+                    plugin->setStateInformation (state.getData(), (int) state.getSize());
+                    addParameterValues (reply);
+                }
+                else if (m.hasTagName ("SET_PROGRAM"))
+                {
+                    plugin->setCurrentProgram (m.getIntAttribute ("index"));
+                    addParameterValues (reply);
+                }
+                else if (m.hasTagName ("SET_PROGRAM_NAME"))
+                {
+                    plugin->changeProgramName (m.getIntAttribute ("index"), m.getStringAttribute ("name"));
+                }
+                else if (m.hasTagName ("RESET"))
+                {
+                    plugin->reset();
+                }
+            }
+        }
+
+        sendReply (reply, m);
+    }
+
+    /** Sends the plugin's parameter values back after its state has changed, so the
+        host's copies don't go stale. Must be called with the processLock held.
+    */
+    void addParameterValues (XmlElement& reply)
+    {
+        for (auto p : plugin->getParameters())
+            reply.createNewChildElement ("PARAM")->setAttribute ("value", p->getValue());
+
+        updateLastParameterValues();
+    }
+
+    void updateLastParameterValues()
+    {
+        if (header == nullptr)
+            return;
+
+        auto& params = plugin->getParameters();
+
+        for (int i = jmin (header->numParameters, params.size()); --i >= 0;)
+            lastParameterValues[i] = params.getUnchecked (i)->getValue();
+    }
+
+    std::unique_ptr<AudioPluginInstance> createPlugin (const PluginDescription& desc, bool allowTestPlugin, String& error)
+    {
+       #if TRACKTION_UNIT_TESTS
+        if (allowTestPlugin && desc.pluginFormatName == BridgeTestPlugin::formatName)
+            return std::make_unique<BridgeTestPlugin>();
+       #else
+        ignoreUnused (allowTestPlugin);
+       #endif
+
+        return std::unique_ptr<AudioPluginInstance> (pluginFormatManager.createPluginInstance (desc, 44100.0, 512, error));
+    }
+
+    void handleLoad (const XmlElement& m)
+    {
+        XmlElement reply ("LOADED");
+        PluginDescription desc;
+        String error;
+
+        if (auto descXml = m.getFirstChildElement())
+            if (desc.loadFromXml (*descXml))
+                plugin = createPlugin (desc, m.getBoolAttribute ("testPlugin"), error);
+
+        if (plugin == nullptr)
+        {
+            XmlElement failed ("FAILED");
+            failed.setAttribute ("error", error.isNotEmpty() ? error : String ("Unable to load plugin"));
+            return sendReply (failed, m);
+        }
+
+        reply.setAttribute ("name", plugin->getName());
+        reply.setAttribute ("ins", plugin->getTotalNumInputChannels());
+        reply.setAttribute ("outs", plugin->getTotalNumOutputChannels());
+        reply.setAttribute ("acceptsMidi", plugin->acceptsMidi());
+        reply.setAttribute ("producesMidi", plugin->producesMidi());
+        reply.setAttribute ("tail", plugin->getTailLengthSeconds());
+        reply.setAttribute ("program", plugin->getCurrentProgram());
+
+        for (int i = 0; i < plugin->getNumPrograms(); ++i)
+            reply.createNewChildElement ("PROGRAM")->setAttribute ("name", plugin->getProgramName (i));
+
+        for (auto p : plugin->getParameters())
+        {
+            auto e = reply.createNewChildElement ("PARAM");
+            e->setAttribute ("name", p->getName (1024));
+            e->setAttribute ("label", p->getLabel());
+            e->setAttribute ("default", p->getDefaultValue());
+            e->setAttribute ("value", p->getValue());
+            e->setAttribute ("steps", p->getNumSteps());
+        }
+
+        sendReply (reply, m);
+    }
+
+    void handlePrepare (const XmlElement& m)
+    {
+        XmlElement reply ("PREPARED");
+        stopProcessing();
+
+        sharedMemory = SharedMemorySegment::open (m.getStringAttribute ("shm"), (size_t) m.getIntAttribute ("size"));
+
+        if (plugin != nullptr && sharedMemory != nullptr)
+        {
+            header = static_cast<PluginBridge::SharedHeader*> (sharedMemory->data);
+            buffer.setSize (header->numChannels, header->maxBlockSize);
+            midi.ensureSize ((size_t) header->maxMidiBytes);
+
+            // Only values the host changes from here on are applied
+            lastParameterValues.calloc ((size_t) header->numParameters);
+            updateLastParameterValues();
+            lastParameterChangeCount = header->parameterChangeCounter.load();
+
+            plugin->setRateAndBufferSizeDetails (m.getDoubleAttribute ("rate"), header->maxBlockSize);
+            plugin->prepareToPlay (m.getDoubleAttribute ("rate"), header->maxBlockSize);
+            reply.setAttribute ("latency", plugin->getLatencySamples());
+
+            startThread (9);
+        }
+
+        sendReply (reply, m);
+    }
+
+    void stopProcessing()
+    {
+        stopThread (2000);
+        header = nullptr;
+        sharedMemory.reset();
+    }
+
+    //==============================================================================
+    void applyParameterChanges()
+    {
+        const auto changeCount = header->parameterChangeCounter.load (std::memory_order_acquire);
+
+        if (changeCount == lastParameterChangeCount)
+            return;
+
+        lastParameterChangeCount = changeCount;
+        auto values = PluginBridge::getParameterValues (*header);
+        auto& params = plugin->getParameters();
+
+        for (int i = jmin (header->numParameters, params.size()); --i >= 0;)
+        {
+            const float newValue = values[i].load (std::memory_order_relaxed);
+
+            if (newValue != lastParameterValues[i])
+            {
+                lastParameterValues[i] = newValue;
+                params.getUnchecked (i)->setValue (newValue);
+            }
+        }
+    }
+
+    void run() override
+    {
+        ScopedNoDenormals noDenormals;
+        auto inputRing = PluginBridge::getInputRing (*header);
+        auto outputRing = PluginBridge::getOutputRing (*header);
+
+        while (! threadShouldExit())
+        {
+            const auto wakeCount = header->childWakeCounter.load (std::memory_order_acquire);
+            int numSamples = 0;
+
+            if (! inputRing.read (buffer, numSamples, midi))
+            {
+                PluginBridge::waitForWake (*header, wakeCount, 50);
+                continue;
+            }
+
+            {
+                const ScopedLock sl (processLock);
+                applyParameterChanges();
+                AudioBuffer<float> block (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numSamples);
+                plugin->processBlock (block, midi);
+            }
+
+            // If the host has fallen behind the block is dropped, it will output silence
+            outputRing.write (buffer, numSamples, midi);
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginBridgeSlaveProcess)
+};
+
+#endif
+
+//==============================================================================
+bool PluginBridge::isSupported()
+{
+   #if JUCE_LINUX
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+std::unique_ptr<AudioPluginInstance> PluginBridge::createBridgedInstance (const PluginDescription& desc,
+                                                                          double sampleRate, int blockSize,
+                                                                          String& errorMessage)
+{
+   #if JUCE_LINUX
+    BridgedPluginInfo info;
+
+    // The crash callback is set once the instance exists, until then a crash just fails the load
+    auto crashed = std::make_shared<std::function<void()>>();
+
+    auto connection = BridgedPluginInstance::launchAndLoad (desc, info, [crashed] { if (*crashed) (*crashed)(); },
+                                                            errorMessage);
+
+    if (connection == nullptr)
+        return {};
+
+    auto bridged = std::make_unique<BridgedPluginInstance> (desc, std::move (connection), info);
+    *crashed = bridged->createCrashCallback();
+
+    bridged->setRateAndBufferSizeDetails (sampleRate, blockSize);
+    return bridged;
+   #else
+    ignoreUnused (desc, sampleRate, blockSize);
+    errorMessage = TRANS("Bridged plugin hosting isn't supported on this platform");
+    return {};
+   #endif
+}
+
+bool PluginBridge::startChildProcess (const String& commandLine)
+{
+   #if JUCE_LINUX
+    auto slave = std::make_unique<PluginBridgeSlaveProcess>();
+
+    if (slave->initialiseFromCommandLine (commandLine, bridgeCommandLineUID))
+    {
+        slave->sendProcessID();
+        slave.release(); // allow the slave object to stay alive - it'll handle its own deletion.
+        return true;
+    }
+   #else
+    ignoreUnused (commandLine);
+   #endif
+
+    return false;
+}
+
+#if TRACKTION_UNIT_TESTS
+void PluginBridge::setTestPluginEnabled (bool shouldBeEnabled)
+{
+    bridgeTestPluginEnabled = shouldBeEnabled;
+}
+#endif
+
+PluginBridge::Stats PluginBridge::getStats (AudioPluginInstance& instance)
+{
+   #if JUCE_LINUX
+    if (auto bridged = dynamic_cast<BridgedPluginInstance*> (&instance))
+        return bridged->getStats();
+   #else
+    ignoreUnused (instance);
+   #endif
+
+    return {};
+}
+
+} // namespace tracktion_engine
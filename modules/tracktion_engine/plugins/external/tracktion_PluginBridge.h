@@ -0,0 +1,141 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+//==============================================================================
+/**
+    Hosts external plugins in a separate child process so that a crashing or
+    misbehaving plugin can't take down the host.
+
+    The child process is this same executable, launched with a special command
+    line. Your app must pass its command line to PluginManager::startChildProcessPluginBridge()
+    early in its start-up, in the same way as PluginManager::startChildProcessPluginScan().
+
+    Control messages (loading, state, programs) are sent over a juce::ChildProcessMaster
+    connection. Audio and MIDI are passed through a lock-free ring of blocks in shared
+    memory, with futex wake-ups for the child's processing thread, so the host's audio
+    thread never waits on the child. This adds one block of latency which is included
+    in the instance's getLatencySamples().
+
+    If the child crashes, or stops replying to requests or processing blocks for a
+    couple of seconds, it is killed, silence is output and the child is relaunched and
+    restored to its last known state.
+
+    Only supported on Linux at the moment.
+*/
+struct PluginBridge
+{
+    /** Returns true if bridged hosting is available on this platform. */
+    static bool isSupported();
+
+    /** Launches a child process, loads the plugin in it and returns an AudioPluginInstance
+        that proxies to it. Returns nullptr and fills in the errorMessage on failure.
+    */
+    static std::unique_ptr<juce::AudioPluginInstance> createBridgedInstance (const juce::PluginDescription&,
+                                                                              double sampleRate, int blockSize,
+                                                                              juce::String& errorMessage);
+
+    /** Call this from your app's start-up code. If the command line is for a bridge child
+        process this returns true and the child will run until the host disconnects.
+    */
+    static bool startChildProcess (const juce::String& commandLine);
+
+   #if TRACKTION_UNIT_TESTS
+    /** Lets child processes load the plugin the tests use, which can crash or hang on
+        request. This is off by default and should only be turned on by the tests.
+    */
+    static void setTestPluginEnabled (bool);
+   #endif
+
+    /** Counters reported by bridged instances. */
+    struct Stats
+    {
+        juce::uint64 numBlocksProcessed = 0;    /**< Blocks passed to the child. */
+        juce::uint64 numUnderruns = 0;          /**< Blocks where the child's output wasn't ready. */
+        juce::uint64 numOverruns = 0;           /**< Blocks dropped because the input ring was full. */
+        int numRestarts = 0;                    /**< The number of times the child has been relaunched. */
+    };
+
+    /** Returns the stats for an instance created with createBridgedInstance, or an empty
+        Stats object if the instance isn't bridged.
+    */
+    static Stats getStats (juce::AudioPluginInstance&);
+
+    //==============================================================================
+    /** The shared memory layout used to move blocks between the processes.
+        This is exposed here so it can be tested directly.
+    */
+    struct SharedHeader
+    {
+        std::atomic<juce::uint32> inputWrite { 0 }, inputRead { 0 };
+        std::atomic<juce::uint32> outputWrite { 0 }, outputRead { 0 };
+        std::atomic<juce::int32> childWakeCounter { 0 };
+        std::atomic<juce::uint32> parameterChangeCounter { 0 };
+        juce::int32 numSlots = 0, numChannels = 0, maxBlockSize = 0, maxMidiBytes = 0, numParameters = 0;
+    };
+
+    /** A single-producer, single-consumer ring of audio/MIDI blocks living in shared memory. */
+    class BlockRing
+    {
+    public:
+        BlockRing (SharedHeader&, char* firstSlot, std::atomic<juce::uint32>& writeIndex, std::atomic<juce::uint32>& readIndex) noexcept;
+
+        /** Returns the number of bytes a single slot needs. */
+        static size_t getSlotSize (int numChannels, int maxBlockSize, int maxMidiBytes) noexcept;
+
+        /** Writes a block, returning false if the ring is full. MIDI that doesn't fit is dropped. */
+        bool write (const juce::AudioBuffer<float>&, int numSamples, const juce::MidiBuffer&) noexcept;
+
+        /** Reads the next block, returning false if the ring is empty.
+            The buffer must have at least the header's number of channels and maxBlockSize samples.
+        */
+        bool read (juce::AudioBuffer<float>&, int& numSamples, juce::MidiBuffer&) noexcept;
+
+        /** Returns the number of blocks waiting to be read. */
+        int getNumReady() const noexcept;
+
+        /** Empties the ring. Only safe to call when neither end is being used. */
+        void reset() noexcept;
+
+    private:
+        SharedHeader& header;
+        char* slots;
+        std::atomic<juce::uint32>& writeIndex;
+        std::atomic<juce::uint32>& readIndex;
+        size_t slotSize;
+
+        char* getSlot (juce::uint32 index) const noexcept;
+    };
+
+    /** Returns the total number of bytes needed for a shared block with these properties. */
+    static size_t getSharedMemorySize (int numSlots, int numChannels, int maxBlockSize, int maxMidiBytes, int numParameters) noexcept;
+
+    /** Constructs a header in the given memory and returns it. */
+    static SharedHeader& initialiseSharedMemory (void* memory, int numSlots, int numChannels, int maxBlockSize, int maxMidiBytes, int numParameters) noexcept;
+
+    /** Returns the parameter values stored after the header. */
+    static std::atomic<float>* getParameterValues (SharedHeader&) noexcept;
+
+    /** Returns the ring that carries blocks from the host to the child. */
+    static BlockRing getInputRing (SharedHeader&) noexcept;
+
+    /** Returns the ring that carries processed blocks from the child back to the host. */
+    static BlockRing getOutputRing (SharedHeader&) noexcept;
+
+    /** Wakes the child's processing thread after a block has been written. */
+    static void wakeChild (SharedHeader&) noexcept;
+
+    /** Blocks the calling thread until wakeChild is called or the timeout expires. */
+    static void waitForWake (SharedHeader&, juce::int32 lastWakeCount, int timeoutMs) noexcept;
+};
+
+} // namespace tracktion_engine
@@ -43,164 +43,103 @@ String AuxReturnPlugin::getShortName (int)
     return "Ret:" + String (busNumber + 1);
 }
 
-void AuxReturnPlugin::initialise (const PlaybackInitialisationInfo& info)
+void AuxReturnPlugin::initialise (const PlaybackInitialisationInfo&)
 {
-    previousBuffer.reset (new juce::AudioBuffer<float> (2, info.blockSizeSamples * 2));
-    currentBuffer.reset (new juce::AudioBuffer<float> (2, info.blockSizeSamples * 2));
-    samplesInPreviousBuffer = 0;
-    samplesInCurrentBuffer = 0;
-
-    initialised = true;
 }
 
 void AuxReturnPlugin::deinitialise()
 {
-    initialised = false;
-
-    previousBuffer = nullptr;
-    currentBuffer = nullptr;
 }
 
-void AuxReturnPlugin::prepareForNextBlock (const AudioRenderContext&)
+std::shared_ptr<AuxReturnPlugin::SendSlot> AuxReturnPlugin::addSendSlot (int blockSizeSamples)
 {
-    const ScopedLock sl (addingAudioLock);
+    auto slot = std::make_shared<SendSlot> (2, blockSizeSamples);
 
-    std::swap (previousBuffer, currentBuffer);
-    samplesInPreviousBuffer = samplesInCurrentBuffer;
-    samplesInCurrentBuffer = 0;
+    const SpinLock::ScopedLockType sl (sendSlotLock);
+    sendSlots.push_back (slot);
+    return slot;
 }
 
-void AuxReturnPlugin::applyAudioFromSend (const juce::AudioBuffer<float>& buffer,
-                                          int startSample, int numSamples,
-                                          float gain1, float gain2)
+void AuxReturnPlugin::removeSendSlot (const std::shared_ptr<SendSlot>& slot)
 {
-    const ScopedLock sl (addingAudioLock);
-
-    if (initialised)
-    {
-        const int numChansToUse = jmin (currentBuffer->getNumChannels(), buffer.getNumChannels());
-
-        if (samplesInCurrentBuffer == 0)
-        {
-            samplesInCurrentBuffer = numSamples;
-
-            if (currentBuffer->getNumSamples() < numSamples)
-                currentBuffer->setSize (numChansToUse, numSamples, false);
-
-            int iSrcChan = numChansToUse - 1;
-
-            for (int iDstChan = currentBuffer->getNumChannels(); --iDstChan >= 0;)
-            {
-                currentBuffer->copyFrom (iDstChan, 0, buffer, iSrcChan, startSample, numSamples);
-
-                if (iSrcChan > 0)
-                    --iSrcChan;
-            }
-
-            AudioFadeCurve::applyCrossfadeSection (*currentBuffer, 0, numSamples, AudioFadeCurve::linear, gain1, gain2);
-        }
-        else
-        {
-            // very nasty if this gets called with different block sizes..
-            jassert (numSamples == samplesInCurrentBuffer);
-
-            numSamples = jmin (numSamples, samplesInCurrentBuffer);
-
-            int iSrcChan = numChansToUse - 1;
-
-            for (int iDstChan = currentBuffer->getNumChannels(); --iDstChan >= 0;)
-            {
-                AudioFadeCurve::addWithCrossfade (*currentBuffer, buffer,
-                                                  iDstChan, 0, iSrcChan, startSample, numSamples,
-                                                  AudioFadeCurve::linear, gain1, gain2);
-
-                if (iSrcChan > 0)
-                    --iSrcChan;
-            }
-        }
-    }
+    const SpinLock::ScopedLockType sl (sendSlotLock);
+    sendSlots.erase (std::remove (sendSlots.begin(), sendSlots.end(), slot), sendSlots.end());
 }
 
-void AuxReturnPlugin::applyAudioFromSend (const juce::AudioBuffer<float>& buffer,
-                                          int startSample, int numSamples,
-                                          const float gain)
+void AuxReturnPlugin::applyToBuffer (const AudioRenderContext& fc)
 {
-    const ScopedLock sl (addingAudioLock);
+    if (fc.destBuffer == nullptr)
+        return;
 
-    if (initialised)
-    {
-        const int numChansToUse = jmin (currentBuffer->getNumChannels(), buffer.getNumChannels());
+    SCOPED_REALTIME_CHECK
 
-        if (samplesInCurrentBuffer == 0)
-        {
-            samplesInCurrentBuffer = numSamples;
+    // The lock is only ever held by the message thread for as long as it takes to
+    // add or remove a slot, so rather than wait we'll pick the audio up next block
+    const SpinLock::ScopedTryLockType sl (sendSlotLock);
 
-            if (currentBuffer->getNumSamples() < numSamples)
-                currentBuffer->setSize (numChansToUse, numSamples, false);
+    if (sl.isLocked())
+        for (auto& slot : sendSlots)
+            slot->addTo (fc);
+}
 
-            int iSrcChan = numChansToUse - 1;
+//==============================================================================
+AuxReturnPlugin::SendSlot::SendSlot (int numChannels, int numSamples)
+{
+    for (auto& b : buffers)
+        b.setSize (numChannels, numSamples);
+}
 
-            for (int iDstChan = currentBuffer->getNumChannels(); --iDstChan >= 0;)
-            {
-                currentBuffer->copyFrom (iDstChan, 0, buffer, iSrcChan, startSample, numSamples);
+void AuxReturnPlugin::SendSlot::write (const juce::AudioBuffer<float>& source,
+                                       int startSample, int numSamples,
+                                       float gain1, float gain2)
+{
+    auto& buffer = buffers[nextBufferToWrite];
 
-                if (iSrcChan > 0)
-                    --iSrcChan;
-            }
+    // the buffers are sized for the block size the send was initialised with
+    jassert (numSamples <= buffer.getNumSamples());
+    numSamples = jmin (numSamples, buffer.getNumSamples());
 
-            currentBuffer->applyGain (0, numSamples, gain);
-        }
-        else
-        {
-            // very nasty if this gets called with different block sizes..
-            jassert (numSamples == samplesInCurrentBuffer);
+    const int numSrcChans = source.getNumChannels();
 
-            numSamples = jmin (numSamples, samplesInCurrentBuffer);
+    if (numSrcChans == 0)
+        return;
 
-            int iSrcChan = numChansToUse - 1;
+    for (int i = buffer.getNumChannels(); --i >= 0;)
+        buffer.copyFrom (i, 0, source, jmin (i, numSrcChans - 1), startSample, numSamples);
 
-            for (int iDstChan = currentBuffer->getNumChannels(); --iDstChan >= 0;)
-            {
-                currentBuffer->addFrom (iDstChan, 0, buffer, iSrcChan, startSample, numSamples, gain);
+    if (gain1 != gain2)
+        AudioFadeCurve::applyCrossfadeSection (buffer, 0, numSamples, AudioFadeCurve::linear, gain1, gain2);
+    else
+        buffer.applyGain (0, numSamples, gain2);
 
-                if (iSrcChan > 0)
-                    --iSrcChan;
-            }
-        }
-    }
+    numSamplesInBuffer[nextBufferToWrite] = numSamples;
+    readyBuffer.store (nextBufferToWrite, std::memory_order_release);
+    nextBufferToWrite ^= 1;
 }
 
-void AuxReturnPlugin::applyToBuffer (const AudioRenderContext& fc)
+void AuxReturnPlugin::SendSlot::addTo (const AudioRenderContext& fc)
 {
-    if (fc.destBuffer == nullptr)
+    const int index = readyBuffer.exchange (-1, std::memory_order_acq_rel);
+
+    if (index < 0)
         return;
 
-    SCOPED_REALTIME_CHECK
+    auto& buffer = buffers[index];
+    auto& dest = *fc.destBuffer;
+    const int sampsToCopy = jmin (fc.bufferNumSamples, numSamplesInBuffer[index]);
 
-    if (samplesInPreviousBuffer > 0)
+    if (dest.getNumChannels() == 1)
+    {
+        // stereo -> mono
+        for (int i = buffer.getNumChannels(); --i >= 0;)
+            dest.addFrom (0, fc.bufferStartSample, buffer, i, 0, sampsToCopy);
+    }
+    else
     {
-        const int sampsToCopy = jmin (fc.bufferNumSamples, samplesInPreviousBuffer);
-
-        if (fc.destBuffer->getNumChannels() == 1 && previousBuffer->getNumChannels() >= 1)
-        {
-            // stereo -> mono
-            for (int i = previousBuffer->getNumChannels(); --i >= 0;)
-            {
-                // stereo -> mono
-                fc.destBuffer->addFrom (0, fc.bufferStartSample, *previousBuffer, i, 0, sampsToCopy);
-            }
-        }
-        else
-        {
-            for (int i = jmin (previousBuffer->getNumChannels(),
-                               fc.destBuffer->getNumChannels()); --i >= 0;)
-            {
-                // stereo -> stereo
-                // mono   -> mono
-                // mono   -> stereo
-                fc.destBuffer->addFrom (i, fc.bufferStartSample, *previousBuffer, i, 0, sampsToCopy);
-            }
-        }
+        // stereo -> stereo
+        // mono   -> stereo
+        for (int i = jmin (buffer.getNumChannels(), dest.getNumChannels()); --i >= 0;)
+            dest.addFrom (i, fc.bufferStartSample, buffer, i, 0, sampsToCopy);
     }
 }
 
@@ -28,7 +28,6 @@ public:
 
     void initialise (const PlaybackInitialisationInfo&) override;
     void deinitialise() override;
-    void prepareForNextBlock (const AudioRenderContext&) override;
     void applyToBuffer (const AudioRenderContext&) override;
 
     bool takesAudioInput() override                  { return true; }
@@ -38,18 +37,49 @@ public:
     bool canBeAddedToRack() override                 { return false; }
     bool needsConstantBufferSize() override          { return true; }
 
-    void applyAudioFromSend (const juce::AudioBuffer<float>&, int startSample, int numSamples, float gain1, float gain2);
-    void applyAudioFromSend (const juce::AudioBuffer<float>&, int startSample, int numSamples, float gain);
+    //==============================================================================
+    /** The buffer that a single AuxSendPlugin fills with its signal for this return.
+
+        Each send owns one of these per return it feeds, so sends never contend with each
+        other and can be rendered on different threads. A block is handed over by
+        publishing the index of the buffer just written, and the return takes it by
+        swapping that index out, so neither side ever needs a lock.
+    */
+    struct SendSlot
+    {
+        SendSlot (int numChannels, int numSamples);
+
+        /** Called by the send on the audio thread to deliver a block. */
+        void write (const juce::AudioBuffer<float>& source, int startSample, int numSamples, float gain1, float gain2);
+
+        /** Called by the return to add the most recently delivered block, if it hasn't already been used. */
+        void addTo (const AudioRenderContext&);
+
+    private:
+        juce::AudioBuffer<float> buffers[2];
+        int numSamplesInBuffer[2] = { 0, 0 };
+        std::atomic<int> readyBuffer { -1 };
+        int nextBufferToWrite = 0;
+
+        JUCE_DECLARE_NON_COPYABLE (SendSlot)
+    };
+
+    /** Registers a send that will deliver audio to this return.
+        This is called by the AuxSendPlugin when it is initialised, and the slot it
+        returns stays valid until the send calls removeSendSlot.
+    */
+    std::shared_ptr<SendSlot> addSendSlot (int blockSizeSamples);
+
+    /** Unregisters a slot that was previously returned by addSendSlot. */
+    void removeSendSlot (const std::shared_ptr<SendSlot>&);
 
     void restorePluginStateFromValueTree (const juce::ValueTree&) override;
 
     juce::CachedValue<int> busNumber;
 
 private:
-    std::unique_ptr<juce::AudioBuffer<float>> previousBuffer, currentBuffer;
-    int samplesInPreviousBuffer, samplesInCurrentBuffer;
-    bool initialised = false;
-    juce::CriticalSection addingAudioLock;
+    std::vector<std::shared_ptr<SendSlot>> sendSlots;
+    juce::SpinLock sendSlotLock;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AuxReturnPlugin)
 };
@@ -75,34 +75,110 @@ void AuxSendPlugin::initialise (const PlaybackInitialisationInfo& info)
     delayBuffer.setSize (2, info.blockSizeSamples, false);
     delayBuffer.clear();
     lastGain = volumeFaderPositionToGain (gain->getCurrentValue());
-    latencySeconds = info.blockSizeSamples / info.sampleRate;
 
+    // The slots are sized for the block size, so they need recreating
+    removeAllReturnConnections();
     initialiseWithoutStopping (info);
+
+    // If every return on our bus is rendered after us it gets our audio in the same block,
+    // otherwise it'll be a block late so we have to delay our own output to line up with it
+    isDelayingOutput = false;
+
+    for (auto& c : returnConnections)
+        if (c.plugin->busNumber == busNumber && ! c.isRenderedAfterSend)
+            isDelayingOutput = true;
+
+    latencySeconds = isDelayingOutput ? info.blockSizeSamples / info.sampleRate : 0.0;
 }
 
 void AuxSendPlugin::initialiseWithoutStopping (const PlaybackInitialisationInfo& info)
 {
+    CRASH_TRACER
     ownerTrack = getOwnerTrack();
 
-    juce::Array<AuxReturnPlugin*> result;
+    // Find the position of each plugin's node in the graph. Nodes that wrap a plugin node
+    // also report its plugin but come before it, so the last node found is the plugin's own.
+    struct PluginNode
+    {
+        AudioNode* node = nullptr;
+        int index = 0, lastIndexInSubtree = 0;
+    };
+
+    std::unordered_map<Plugin*, PluginNode> pluginNodes;
+    int index = 0;
 
     for (auto node : *info.rootNodes)
         node->visitNodes ([&] (AudioNode& visitedNode)
                           {
-                              if (auto ar = dynamic_cast<AuxReturnPlugin*> (visitedNode.getPlugin().get()))
-                                  result.add (ar);
+                              auto p = visitedNode.getPlugin();
+
+                              if (p == this || dynamic_cast<AuxReturnPlugin*> (p.get()) != nullptr)
+                                  pluginNodes[p.get()] = { &visitedNode, index, index };
+
+                              ++index;
                           });
 
+    for (auto& pn : pluginNodes)
+    {
+        int numNodes = 0;
+        pn.second.node->visitNodes ([&numNodes] (AudioNode&) { ++numNodes; });
+        pn.second.lastIndexInSubtree = pn.second.index + numNodes - 1;
+    }
+
+    // Nodes render their inputs before themselves, so a node is rendered before another one
+    // if it's inside the other's subtree or if its own subtree ends before the other starts
+    auto sendNode = pluginNodes.find (this);
+
+    auto isRenderedBefore = [] (const PluginNode& a, const PluginNode& b)
+    {
+        return (a.index >= b.index && a.index <= b.lastIndexInSubtree)
+                || a.lastIndexInSubtree < b.index;
+    };
 
-    allAuxReturns.swapWith (result);
+    std::vector<ReturnConnection> newConnections;
+
+    for (auto& pn : pluginNodes)
+    {
+        if (auto ar = dynamic_cast<AuxReturnPlugin*> (pn.first))
+        {
+            ReturnConnection c;
+            c.plugin = ar;
+            c.isRenderedAfterSend = sendNode == pluginNodes.end() || isRenderedBefore (sendNode->second, pn.second);
+
+            // Keep the existing slot so that any audio in it isn't lost
+            for (auto& existing : returnConnections)
+                if (existing.plugin == ar)
+                    c.slot = existing.slot;
+
+            if (c.slot == nullptr)
+                c.slot = ar->addSendSlot (info.blockSizeSamples);
+
+            newConnections.push_back (std::move (c));
+        }
+    }
+
+    for (auto& existing : returnConnections)
+        if (std::none_of (newConnections.begin(), newConnections.end(),
+                          [&] (const ReturnConnection& c) { return c.slot == existing.slot; }))
+            existing.plugin->removeSendSlot (existing.slot);
+
+    std::swap (returnConnections, newConnections);
 }
 
 void AuxSendPlugin::deinitialise()
 {
-    allAuxReturns.clear();
+    removeAllReturnConnections();
     delayBuffer.setSize (2, 32, false);
 }
 
+void AuxSendPlugin::removeAllReturnConnections()
+{
+    for (auto& c : returnConnections)
+        c.plugin->removeSendSlot (c.slot);
+
+    returnConnections.clear();
+}
+
 void AuxSendPlugin::applyToBuffer (const AudioRenderContext& fc)
 {
     if (fc.destBuffer == nullptr)
@@ -112,28 +188,31 @@ void AuxSendPlugin::applyToBuffer (const AudioRenderContext& fc)
 
     auto gainScalar = volumeFaderPositionToGain (gain->getCurrentValue());
 
+    if (isDelayingOutput)
+        delayBuffer.setSize (fc.destBuffer->getNumChannels(),
+                             jmax (fc.bufferNumSamples, delayBuffer.getNumSamples()),
+                             true, false, true);
+
     if (shouldProcess())
     {
-        for (auto f : allAuxReturns)
+        for (auto& c : returnConnections)
         {
-            if (f->busNumber == busNumber)
+            if (c.plugin->busNumber == busNumber)
             {
-                if (lastGain != gainScalar)
-                {
-                    f->applyAudioFromSend (*fc.destBuffer, fc.bufferStartSample, fc.bufferNumSamples, lastGain, gainScalar);
-                    lastGain = gainScalar;
-                }
+                // When our output is delayed, the returns that get our audio in the same
+                // block need the delayed signal too so that they all stay in line
+                if (isDelayingOutput && c.isRenderedAfterSend)
+                    c.slot->write (delayBuffer, 0, fc.bufferNumSamples, lastGain, gainScalar);
                 else
-                {
-                    f->applyAudioFromSend (*fc.destBuffer, fc.bufferStartSample, fc.bufferNumSamples, gainScalar);
-                }
+                    c.slot->write (*fc.destBuffer, fc.bufferStartSample, fc.bufferNumSamples, lastGain, gainScalar);
             }
         }
     }
 
-    delayBuffer.setSize (jmax (fc.destBuffer->getNumChannels(), delayBuffer.getNumChannels()),
-                         jmax (fc.bufferNumSamples, delayBuffer.getNumSamples()),
-                         true);
+    lastGain = gainScalar;
+
+    if (! isDelayingOutput)
+        return;
 
     for (int i = jmin (fc.destBuffer->getNumChannels(), delayBuffer.getNumChannels()); --i >= 0;)
     {
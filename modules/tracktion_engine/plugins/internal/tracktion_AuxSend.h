@@ -62,12 +62,22 @@ public:
 
 private:
     bool shouldProcess();
+    void removeAllReturnConnections();
+
     //==============================================================================
-    juce::Array<AuxReturnPlugin*> allAuxReturns;
+    struct ReturnConnection
+    {
+        juce::ReferenceCountedObjectPtr<AuxReturnPlugin> plugin;
+        std::shared_ptr<AuxReturnPlugin::SendSlot> slot;
+        bool isRenderedAfterSend = true;
+    };
+
+    std::vector<ReturnConnection> returnConnections;
     juce::CachedValue<float> lastVolumeBeforeMute;
     float lastGain = 1.0f;
     juce::AudioBuffer<float> delayBuffer { 2, 32 };
     double latencySeconds = 0.0;
+    bool isDelayingOutput = false;
     Track* ownerTrack = nullptr;
 
     //==============================================================================
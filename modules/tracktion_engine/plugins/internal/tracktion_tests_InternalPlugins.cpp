@@ -24,6 +24,7 @@ public:
     void runTest() override
     {
         runRestoreStateTests();
+        runAuxSendReturnTests();
     }
 
 private:
@@ -82,6 +83,38 @@ private:
                     });
     }
 
+    void runAuxSendReturnTests()
+    {
+        beginTest ("Aux send to a return on an earlier track");
+
+        auto& engine = *Engine::getEngines()[0];
+        auto edit = Edit::createSingleTrackEdit (engine);
+        edit->ensureNumberOfAudioTracks (2);
+
+        auto returnTrack = getAudioTracks (*edit)[0];
+        auto sendTrack = getAudioTracks (*edit)[1];
+
+        auto returnPlugin = edit->getPluginCache().createNewPlugin (AuxReturnPlugin::xmlTypeName, {});
+        auto sendPlugin = edit->getPluginCache().createNewPlugin (AuxSendPlugin::xmlTypeName, {});
+        returnTrack->pluginList.insertPlugin (returnPlugin, 0, nullptr);
+        sendTrack->pluginList.insertPlugin (edit->getPluginCache().createNewPlugin (ToneGeneratorPlugin::xmlTypeName, {}), 0, nullptr);
+        sendTrack->pluginList.insertPlugin (sendPlugin, 1, nullptr);
+
+        // Silence the send track's own output so that only the return is heard
+        sendTrack->getVolumePlugin()->setVolumeDb (-100.0f);
+
+        BigInteger tracksToDo;
+        tracksToDo.setRange (0, 2, true);
+
+        auto stats = Renderer::measureStatistics ("Aux", *edit, { 0.0, 1.0 }, tracksToDo, 512);
+
+        // The mixer should render the send's track first, so it doesn't need to delay itself
+        expectGreaterThan (stats.peak, 0.1f);
+        expectEquals (sendPlugin->getLatencySeconds(), 0.0);
+
+        edit->getTempDirectory (false).deleteRecursively();
+    }
+
     struct ParamTest
     {
         const char* paramID;
@@ -173,11 +173,15 @@ public:
                 rc2.streamTime = rc2.streamTime + latencySeconds;
 
                 input->renderOver (rc2);
+
+                const NodeProfiler::ScopedNodeTimer timer (rc.profiler, this);
                 renderPlugin (rc2);
             }
             else
             {
                 input->renderOver (rc);
+
+                const NodeProfiler::ScopedNodeTimer timer (rc.profiler, this);
                 renderPlugin (rc);
             }
         }
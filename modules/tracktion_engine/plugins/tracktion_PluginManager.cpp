@@ -296,6 +296,11 @@ bool PluginManager::startChildProcessPluginScan (const String& commandLine)
     return false;
 }
 
+bool PluginManager::startChildProcessPluginBridge (const String& commandLine)
+{
+    return PluginBridge::startChildProcess (commandLine);
+}
+
 //==============================================================================
 struct CustomScanner  : public KnownPluginList::CustomScanner
 {
@@ -396,6 +401,15 @@ PluginManager::PluginManager (Engine& e)
 {
     createPluginInstance = [this] (const PluginDescription& description, double rate, int blockSize, String& errorMessage)
                            {
+                               if (PluginBridge::isSupported() && usesBridgedPluginHosting())
+                               {
+                                   if (auto bridged = PluginBridge::createBridgedInstance (description, rate, blockSize, errorMessage))
+                                       return bridged;
+
+                                   TRACKTION_LOG_ERROR ("Failed to bridge " + description.name + ": " + errorMessage);
+                                   errorMessage.clear();
+                               }
+
                                return std::unique_ptr<AudioPluginInstance> (pluginFormatManager.createPluginInstance (description, rate, blockSize, errorMessage));
                            };
 }
@@ -764,6 +778,16 @@ void PluginManager::setUsesSeparateProcessForScanning (bool b)
     engine.getPropertyStorage().setProperty (SettingID::useSeparateProcessForScanning, b);
 }
 
+bool PluginManager::usesBridgedPluginHosting()
+{
+    return engine.getPropertyStorage().getProperty (SettingID::useBridgedPluginHosting, false);
+}
+
+void PluginManager::setUsesBridgedPluginHosting (bool b)
+{
+    engine.getPropertyStorage().setProperty (SettingID::useBridgedPluginHosting, b);
+}
+
 Plugin::Ptr PluginManager::createPlugin (Edit& ed, const juce::ValueTree& v, bool isNew)
 {
     jassert (initialised); // must call PluginManager::initialise() before this!
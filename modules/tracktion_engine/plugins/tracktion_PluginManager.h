@@ -26,6 +26,11 @@ public:
     //==============================================================================
     static bool startChildProcessPluginScan (const juce::String& commandLine);
 
+    /** Call this from your app's start-up code to allow plugins to be hosted out of process.
+        @see PluginBridge
+    */
+    static bool startChildProcessPluginBridge (const juce::String& commandLine);
+
     bool areGUIsLockedByDefault();
     void setGUIsLockedByDefault (bool);
 
@@ -38,6 +43,12 @@ public:
     bool usesSeparateProcessForScanning();
     void setUsesSeparateProcessForScanning (bool);
 
+    /** If enabled, external plugins are loaded in a child process where supported.
+        @see PluginBridge
+    */
+    bool usesBridgedPluginHosting();
+    void setUsesBridgedPluginHosting (bool);
+
     //==============================================================================
     Plugin::Ptr createExistingPlugin (Edit&, const juce::ValueTree&);
     Plugin::Ptr createNewPlugin (Edit&, const juce::ValueTree&);
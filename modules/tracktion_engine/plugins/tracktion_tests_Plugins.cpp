@@ -130,7 +130,7 @@ public:
     }
 
     template<typename AudioFormatType>
-    std::unique_ptr<TemporaryFile> getSinFile (double sampleRate)
+    static std::unique_ptr<TemporaryFile> getSinFile (double sampleRate)
     {
         // Create a 1s sin buffer
         AudioBuffer<float> buffer (1, (int) sampleRate);
@@ -167,6 +167,238 @@ public:
 
 static PDCTests pdcTests;
 
+//==============================================================================
+//==============================================================================
+class FreezeTests  : public UnitTest
+{
+public:
+    FreezeTests()
+        : UnitTest ("Freeze", "Tracktion:Longer")
+    {
+    }
+
+    void runTest() override
+    {
+        auto& engine = *Engine::getEngines()[0];
+        auto sinFile = PDCTests::getSinFile<WavAudioFormat> (44100.0);
+
+        beginTest ("Freeze tracks together");
+        {
+            auto edit = PDCTests::createTestEdit (engine);
+            edit->ensureNumberOfAudioTracks (3);
+            auto tracks = getAudioTracks (*edit);
+            expectEquals (tracks.size(), 3);
+
+            // Two tracks of different lengths and one with nothing on it
+            AudioFile af (engine, sinFile->getFile());
+            tracks[0]->insertWaveClip ("sin", af.getFile(), {{ 0.0, 1.0 }}, false);
+            tracks[1]->insertWaveClip ("sin", af.getFile(), {{ 0.0, 0.5 }}, false);
+
+            AudioTrack::freezeTracks (tracks);
+
+            expect (tracks[0]->isFrozen (Track::individualFreeze));
+            expect (tracks[1]->isFrozen (Track::individualFreeze));
+            expect (! tracks[2]->isFrozen (Track::individualFreeze), "A track with nothing to freeze shouldn't be frozen");
+            expect (! tracks[2]->hasFreezePointPlugin());
+
+            // Each freeze file should be the length of its own track
+            expectWithinAbsoluteError (getFileLength (engine, TemporaryFileManager::getFreezeFileForTrack (*tracks[0])), 1.0, 0.001);
+            expectWithinAbsoluteError (getFileLength (engine, TemporaryFileManager::getFreezeFileForTrack (*tracks[1])), 0.5, 0.001);
+
+            for (auto t : tracks)
+                t->setFrozen (false, Track::individualFreeze);
+
+            expect (! tracks[0]->isFrozen (Track::anyFreeze));
+
+            engine.getAudioFileManager().releaseAllFiles();
+            edit->getTempDirectory (false).deleteRecursively();
+        }
+    }
+
+    static double getFileLength (Engine& engine, const File& file)
+    {
+        if (auto reader = std::unique_ptr<AudioFormatReader> (AudioFileUtils::createReaderFor (engine, file)))
+            if (reader->sampleRate > 0.0)
+                return reader->lengthInSamples / reader->sampleRate;
+
+        return 0.0;
+    }
+};
+
+static FreezeTests freezeTests;
+
+//==============================================================================
+//==============================================================================
+class PluginBridgeTests  : public UnitTest
+{
+public:
+    PluginBridgeTests()
+        : UnitTest ("PluginBridge", "Tracktion")
+    {
+    }
+
+    void runTest() override
+    {
+        const int numSlots = 2, numChannels = 2, blockSize = 64, maxMidiBytes = 256;
+        HeapBlock<char> memory (PluginBridge::getSharedMemorySize (numSlots, numChannels, blockSize, maxMidiBytes, 4), true);
+        auto& header = PluginBridge::initialiseSharedMemory (memory.get(), numSlots, numChannels, blockSize, maxMidiBytes, 4);
+        auto inputRing = PluginBridge::getInputRing (header);
+        auto outputRing = PluginBridge::getOutputRing (header);
+
+        beginTest ("Block ring");
+        {
+            AudioBuffer<float> in (numChannels, blockSize), out (numChannels, blockSize);
+            MidiBuffer inMidi, outMidi;
+
+            for (int i = 0; i < blockSize; ++i)
+            {
+                in.setSample (0, i, (float) i);
+                in.setSample (1, i, (float) -i);
+            }
+
+            inMidi.addEvent (MidiMessage::noteOn (1, 60, 0.5f), 10);
+            inMidi.addEvent (MidiMessage::noteOff (1, 60), 20);
+
+            expect (inputRing.write (in, 32, inMidi));
+            expect (inputRing.write (in, blockSize, {}));
+            expect (! inputRing.write (in, blockSize, {}), "Ring should be full");
+            expectEquals (inputRing.getNumReady(), 2);
+            expectEquals (outputRing.getNumReady(), 0);
+
+            int numSamples = 0;
+            expect (inputRing.read (out, numSamples, outMidi));
+            expectEquals (numSamples, 32);
+            expectEquals (out.getSample (0, 31), 31.0f);
+            expectEquals (out.getSample (1, 31), -31.0f);
+            expectEquals (outMidi.getNumEvents(), 2);
+            expectEquals (outMidi.getFirstEventTime(), 10);
+            expectEquals (outMidi.getLastEventTime(), 20);
+
+            expect (inputRing.read (out, numSamples, outMidi));
+            expectEquals (numSamples, blockSize);
+            expect (outMidi.isEmpty());
+            expect (! inputRing.read (out, numSamples, outMidi));
+        }
+
+        beginTest ("Wake");
+        {
+            const auto wakeCount = header.childWakeCounter.load();
+            PluginBridge::wakeChild (header);
+            expect (header.childWakeCounter.load() != wakeCount);
+
+            // Should return immediately as the counter has already moved on
+            const auto startTime = Time::getMillisecondCounter();
+            PluginBridge::waitForWake (header, wakeCount, 5000);
+            expect (Time::getMillisecondCounter() - startTime < 1000);
+        }
+
+       #if JUCE_LINUX && JUCE_MODAL_LOOPS_PERMITTED
+        // This needs the test app to start the bridge's child process from its command line
+        beginTest ("Child process");
+        {
+            PluginDescription desc;
+            desc.name = "Bridge Test";
+            desc.pluginFormatName = "BridgeTest";
+            desc.fileOrIdentifier = "BridgeTest";
+
+            String error;
+            expect (PluginBridge::createBridgedInstance (desc, 44100.0, 512, error) == nullptr,
+                    "The test plugin shouldn't load unless the host enables it");
+
+            PluginBridge::setTestPluginEnabled (true);
+            auto instance = PluginBridge::createBridgedInstance (desc, 44100.0, 512, error);
+            PluginBridge::setTestPluginEnabled (false);
+            expect (instance != nullptr, error);
+
+            if (instance != nullptr)
+                testChildProcess (*instance);
+        }
+       #endif
+    }
+
+   #if JUCE_LINUX && JUCE_MODAL_LOOPS_PERMITTED
+    void testChildProcess (AudioPluginInstance& instance)
+    {
+        auto& params = instance.getParameters();
+        expectEquals (params.size(), 3);
+
+        if (params.size() != 3)
+            return;
+
+        // The host's copy of the parameter should be updated from the child
+        MemoryBlock state;
+        MemoryOutputStream (state, false).writeFloat (0.5f);
+        instance.setStateInformation (state.getData(), (int) state.getSize());
+        expectWithinAbsoluteError (params[0]->getValue(), 0.5f, 0.001f);
+
+        instance.prepareToPlay (44100.0, 512);
+        expect (processUntilOutputIs (instance, 0.5f, [] { return true; }), "Gain not applied");
+
+        beginTest ("Crash recovery");
+        {
+            // The relaunched child is restored to the last state, which doesn't include the
+            // crash parameter, so it shouldn't get sent again and crash the new child
+            params[1]->setValue (1.0f);
+            expect (processUntilOutputIs (instance, 0.5f, [&] { return PluginBridge::getStats (instance).numRestarts > 0; }),
+                    "Child not restored after crashing");
+            expectEquals (params[1]->getValue(), 0.0f);
+            expectWithinAbsoluteError (params[0]->getValue(), 0.5f, 0.001f);
+
+            processUntilOutputIs (instance, 0.5f, [] { return false; }, 100);
+            expectEquals (PluginBridge::getStats (instance).numRestarts, 1);
+        }
+
+        beginTest ("Hang recovery");
+        {
+            // The child's processing thread stops, so the watchdog should kill and relaunch it
+            params[2]->setValue (1.0f);
+            expect (processUntilOutputIs (instance, 0.5f, [&] { return PluginBridge::getStats (instance).numRestarts > 1; }),
+                    "Child not restored after hanging");
+            expectEquals (params[2]->getValue(), 0.0f);
+            expectWithinAbsoluteError (params[0]->getValue(), 0.5f, 0.001f);
+
+            // A request to a hung child should time out and relaunch it too
+            params[2]->setValue (1.0f);
+            processUntilOutputIs (instance, 0.0f, [] { return true; });
+
+            MemoryBlock hungState;
+            instance.getStateInformation (hungState);
+            expect (processUntilOutputIs (instance, 0.5f, [&] { return PluginBridge::getStats (instance).numRestarts > 2; }),
+                    "Child not restored after a request timed out");
+        }
+
+        instance.releaseResources();
+    }
+
+    /** Processes blocks of 1s until the output matches the level, giving the
+        message thread time to relaunch the child in between.
+    */
+    static bool processUntilOutputIs (AudioPluginInstance& instance, float level,
+                                      std::function<bool()> condition, int maxNumBlocks = 4000)
+    {
+        AudioBuffer<float> buffer (2, 512);
+        MidiBuffer midi;
+
+        for (int i = 0; i < maxNumBlocks; ++i)
+        {
+            MessageManager::getInstance()->runDispatchLoopUntil (5);
+
+            for (int chan = 0; chan < buffer.getNumChannels(); ++chan)
+                FloatVectorOperations::fill (buffer.getWritePointer (chan), 1.0f, buffer.getNumSamples());
+
+            instance.processBlock (buffer, midi);
+
+            if (condition() && std::abs (buffer.getSample (0, buffer.getNumSamples() - 1) - level) < 0.001f)
+                return true;
+        }
+
+        return false;
+    }
+   #endif
+};
+
+static PluginBridgeTests pluginBridgeTests;
+
 #endif
 
 } // namespace tracktion_engine
@@ -0,0 +1,377 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+constexpr double AudioFileAnalysisCache::onsetSensitivity;
+constexpr double AudioFileAnalysisCache::minimumOnsetInterval;
+
+static const int analysisFileMagic = (int) ByteOrder::littleEndianInt ("TKAN");
+static const int analysisFileVersion = 2;
+
+//==============================================================================
+static bool performAnalysis (Engine& engine, const AudioFile& file, AudioFileAnalysisCache::Result& result,
+                             const std::function<bool (float)>& progressCallback)
+{
+    CRASH_TRACER
+    std::unique_ptr<AudioFormatReader> reader (AudioFileUtils::createReaderFor (engine, file.getFile()));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0)
+        return false;
+
+    const auto numChannels = (int) reader->numChannels;
+    const auto numSamples = reader->lengthInSamples;
+    const auto sampleRate = reader->sampleRate;
+
+    BeatDetect beatDetect;
+    beatDetect.setSampleRate (sampleRate);
+    beatDetect.setSensitivity (AudioFileAnalysisCache::onsetSensitivity);
+
+    TempoDetect tempoDetect (numChannels, sampleRate);
+
+    // Read in large chunks that are a whole number of BeatDetect hops so the
+    // file only needs to be read once for both detectors
+    const int hopSize = beatDetect.getBlockSize();
+    const int readSize = hopSize * jmax (1, 65536 / hopSize);
+    AudioBuffer<float> buffer (numChannels, readSize);
+
+    for (int64 startSample = 0; startSample < numSamples; startSample += readSize)
+    {
+        if (progressCallback && ! progressCallback (startSample / (float) numSamples))
+            return false;
+
+        const int numThisTime = (int) jmin ((int64) readSize, numSamples - startSample);
+        reader->read (&buffer, 0, numThisTime, startSample, true, true);
+
+        if (numThisTime < readSize)
+            buffer.clear (numThisTime, readSize - numThisTime);
+
+        tempoDetect.processSection (buffer, numThisTime);
+
+        for (int hopStart = 0; hopStart < numThisTime; hopStart += hopSize)
+        {
+            AudioBuffer<float> hop (buffer.getArrayOfWritePointers(), numChannels, hopStart, hopSize);
+            beatDetect.audioProcess (hop.getArrayOfReadPointers(), numChannels);
+        }
+    }
+
+    result.bpm = tempoDetect.finishAndDetect();
+    result.onsetTimes.clearQuick();
+
+    for (int i = 0; i < beatDetect.getNumBeats(); ++i)
+    {
+        const double time = beatDetect.getBeat (i) / sampleRate;
+
+        if (result.onsetTimes.isEmpty()
+             || (time - result.onsetTimes.getLast()) >= AudioFileAnalysisCache::minimumOnsetInterval)
+            result.onsetTimes.add (time);
+    }
+
+    result.wasAnalysed = true;
+
+    if (progressCallback)
+        progressCallback (1.0f);
+
+    return true;
+}
+
+//==============================================================================
+struct AudioFileAnalysisCache::AnalysisJob  : public juce::ThreadPoolJob
+{
+    AnalysisJob (AudioFileAnalysisCache& o, const AudioFile& f)
+        : ThreadPoolJob ("Analysing: " + f.getFile().getFileName()),
+          owner (o), file (f)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        // Taken before reading so a file that changes during analysis is analysed again next time
+        const auto stamp = FileStamp::forFile (file);
+
+        Result result;
+        bool completedOk = owner.readFromDisk (file, stamp, result);
+
+        if (! completedOk)
+        {
+            completedOk = performAnalysis (owner.engine, file, result,
+                                           [this] (float) { return ! shouldExit(); });
+
+            if (completedOk)
+                owner.writeToDisk (file, result, stamp);
+        }
+
+        if (completedOk)
+            owner.addResult (file, result, stamp);
+
+        owner.jobFinished (file, completedOk);
+
+        return jobHasFinished;
+    }
+
+    AudioFileAnalysisCache& owner;
+    const AudioFile file;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisJob)
+};
+
+//==============================================================================
+bool AudioFileAnalysisCache::Result::isBpmSensible() const
+{
+    return TempoDetect::getSensibleRange().contains (bpm);
+}
+
+AudioFileAnalysisCache::FileStamp AudioFileAnalysisCache::FileStamp::forFile (const AudioFile& file)
+{
+    auto& f = file.getFile();
+    return { f.getLastModificationTime().toMilliseconds(), f.getSize() };
+}
+
+bool AudioFileAnalysisCache::FileStamp::operator== (const FileStamp& other) const noexcept
+{
+    return modificationTime == other.modificationTime && fileSize == other.fileSize;
+}
+
+//==============================================================================
+AudioFileAnalysisCache::AudioFileAnalysisCache (Engine& e)
+    : engine (e), pool (jmax (1, SystemStats::getNumCpus() - 1))
+{
+}
+
+AudioFileAnalysisCache::~AudioFileAnalysisCache()
+{
+    pool.removeAllJobs (true, 10000);
+    cancelPendingUpdate();
+}
+
+//==============================================================================
+bool AudioFileAnalysisCache::getCachedResult (const AudioFile& file, Result& result)
+{
+    if (file.isNull())
+        return false;
+
+    if (findResult (file, &result))
+        return true;
+
+    const auto stamp = FileStamp::forFile (file);
+
+    if (! readFromDisk (file, stamp, result))
+        return false;
+
+    addResult (file, result, stamp);
+    return true;
+}
+
+void AudioFileAnalysisCache::analyseFileAsync (const AudioFile& file)
+{
+    if (file.isNull() || findResult (file, nullptr))
+        return;
+
+    {
+        const ScopedLock sl (resultsLock);
+        const auto hash = file.getHash();
+
+        if (pendingHashes.find (hash) != pendingHashes.end())
+            return;
+
+        pendingHashes.insert (hash);
+    }
+
+    pool.addJob (new AnalysisJob (*this, file), true);
+}
+
+void AudioFileAnalysisCache::analyseFilesAsync (const juce::Array<AudioFile>& files)
+{
+    for (auto& f : files)
+        analyseFileAsync (f);
+}
+
+AudioFileAnalysisCache::Result AudioFileAnalysisCache::analyseFile (const AudioFile& file,
+                                                                    std::function<bool (float)> progressCallback)
+{
+    Result result;
+
+    if (getCachedResult (file, result))
+        return result;
+
+    const auto stamp = FileStamp::forFile (file);
+
+    if (performAnalysis (engine, file, result, progressCallback))
+    {
+        writeToDisk (file, result, stamp);
+        addResult (file, result, stamp);
+        return result;
+    }
+
+    return {};
+}
+
+int AudioFileAnalysisCache::getNumJobsPending() const
+{
+    return pool.getNumJobs();
+}
+
+bool AudioFileAnalysisCache::waitForAllJobs (int timeoutMs)
+{
+    const auto endTime = Time::getMillisecondCounter() + (uint32) timeoutMs;
+
+    while (getNumJobsPending() > 0)
+    {
+        if (Time::getMillisecondCounter() > endTime)
+            return false;
+
+        Thread::sleep (10);
+    }
+
+    return true;
+}
+
+void AudioFileAnalysisCache::clear()
+{
+    const ScopedLock sl (resultsLock);
+    results.clear();
+    getCacheFolder().deleteRecursively();
+}
+
+//==============================================================================
+juce::File AudioFileAnalysisCache::getCacheFolder() const
+{
+    return engine.getTemporaryFileManager().getTempDirectory().getChildFile ("analysis");
+}
+
+juce::File AudioFileAnalysisCache::getCacheFileFor (const AudioFile& file) const
+{
+    return getCacheFolder().getChildFile ("analysis_" + file.getHashString() + ".tkan");
+}
+
+bool AudioFileAnalysisCache::findResult (const AudioFile& file, Result* result)
+{
+    const auto stamp = FileStamp::forFile (file);
+
+    const ScopedLock sl (resultsLock);
+    auto found = results.find (file.getHash());
+
+    if (found == results.end())
+        return false;
+
+    // The file has been overwritten since it was analysed
+    if (found->second.stamp != stamp)
+    {
+        results.erase (found);
+        return false;
+    }
+
+    if (result != nullptr)
+        *result = found->second.result;
+
+    return true;
+}
+
+bool AudioFileAnalysisCache::readFromDisk (const AudioFile& file, FileStamp stamp, Result& result) const
+{
+    FileInputStream in (getCacheFileFor (file));
+
+    if (in.failedToOpen()
+         || in.readInt() != analysisFileMagic
+         || in.readInt() != analysisFileVersion
+         || in.readInt64() != file.getHash())
+        return false;
+
+    FileStamp storedStamp;
+    storedStamp.modificationTime = in.readInt64();
+    storedStamp.fileSize = in.readInt64();
+
+    if (storedStamp != stamp)
+        return false;
+
+    result.bpm = in.readFloat();
+    const int numOnsets = in.readInt();
+
+    if (numOnsets < 0 || in.getNumBytesRemaining() < (int64) numOnsets * (int64) sizeof (double))
+        return false;
+
+    result.onsetTimes.clearQuick();
+    result.onsetTimes.ensureStorageAllocated (numOnsets);
+
+    for (int i = 0; i < numOnsets; ++i)
+        result.onsetTimes.add (in.readDouble());
+
+    result.wasAnalysed = true;
+    return true;
+}
+
+void AudioFileAnalysisCache::writeToDisk (const AudioFile& file, const Result& result, FileStamp stamp) const
+{
+    auto cacheFile = getCacheFileFor (file);
+    cacheFile.getParentDirectory().createDirectory();
+
+    // Write to a temporary first so a partially written file can never be read back
+    TemporaryFile temp (cacheFile);
+
+    {
+        FileOutputStream out (temp.getFile());
+
+        if (! out.openedOk())
+            return;
+
+        out.writeInt (analysisFileMagic);
+        out.writeInt (analysisFileVersion);
+        out.writeInt64 (file.getHash());
+        out.writeInt64 (stamp.modificationTime);
+        out.writeInt64 (stamp.fileSize);
+        out.writeFloat (result.bpm);
+        out.writeInt (result.onsetTimes.size());
+
+        for (auto t : result.onsetTimes)
+            out.writeDouble (t);
+    }
+
+    temp.overwriteTargetFileWithTemporary();
+}
+
+void AudioFileAnalysisCache::addResult (const AudioFile& file, const Result& result, FileStamp stamp)
+{
+    const ScopedLock sl (resultsLock);
+    results[file.getHash()] = { result, stamp };
+}
+
+void AudioFileAnalysisCache::jobFinished (const AudioFile& file, bool /*completedOk*/)
+{
+    {
+        const ScopedLock sl (resultsLock);
+        pendingHashes.erase (file.getHash());
+        finishedFiles.add (file);
+    }
+
+    triggerAsyncUpdate();
+}
+
+void AudioFileAnalysisCache::handleAsyncUpdate()
+{
+    juce::Array<AudioFile> files;
+    std::vector<Result> fileResults;
+
+    {
+        const ScopedLock sl (resultsLock);
+        files.swapWith (finishedFiles);
+
+        for (auto& f : files)
+        {
+            auto found = results.find (f.getHash());
+            fileResults.push_back (found != results.end() ? found->second.result : Result());
+        }
+    }
+
+    for (int i = 0; i < files.size(); ++i)
+        listeners.call (&Listener::analysisFinished, files.getReference (i), fileResults[(size_t) i]);
+}
+
+} // namespace tracktion_engine
@@ -0,0 +1,136 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+//==============================================================================
+/**
+    Analyses audio files for onsets and tempo on a pool of background threads.
+
+    Each file is read once and streamed through a spectral-flux BeatDetect and a
+    TempoDetect. Results are kept in memory and written to the temp directory,
+    keyed by the AudioFile hash, so asking for a file that has been analysed
+    before (even in a previous session) returns immediately. The file's
+    modification time and size are stored with each result so a file that's
+    been overwritten in place gets analysed again.
+
+    You shouldn't need to create one of these, use Engine::getAudioFileAnalysisCache().
+*/
+class AudioFileAnalysisCache   : private juce::AsyncUpdater
+{
+public:
+    AudioFileAnalysisCache (Engine&);
+    ~AudioFileAnalysisCache() override;
+
+    //==============================================================================
+    /** The results of analysing a file. */
+    struct Result
+    {
+        juce::Array<double> onsetTimes;     /**< Onset times in seconds from the start of the file. */
+        float bpm = -1.0f;                  /**< The detected tempo or -1 if none could be found. */
+        bool wasAnalysed = false;
+
+        bool isBpmSensible() const;
+    };
+
+    /** Returns the result for a file if it has been analysed before, either in
+        this session or a previous one.
+        @returns true if a result was found
+    */
+    bool getCachedResult (const AudioFile&, Result& result);
+
+    /** Starts analysing a file on the worker pool if it hasn't already been
+        analysed. Listeners will be called on the message thread when it completes.
+    */
+    void analyseFileAsync (const AudioFile&);
+
+    /** Queues a batch of files to be analysed on the worker pool. */
+    void analyseFilesAsync (const juce::Array<AudioFile>&);
+
+    /** Analyses a file on the calling thread, returning the cached result if
+        there is one.
+        The callback is called periodically with the progress and should return
+        false to abort the analysis, in which case nothing is cached.
+    */
+    Result analyseFile (const AudioFile&, std::function<bool (float)> progressCallback = {});
+
+    /** Returns the number of files queued or being analysed. */
+    int getNumJobsPending() const;
+
+    /** Blocks until all the queued files have been analysed or the timeout expires.
+        @returns true if all jobs completed
+    */
+    bool waitForAllJobs (int timeoutMs);
+
+    /** Removes all the in-memory and on-disk results. */
+    void clear();
+
+    //==============================================================================
+    struct Listener
+    {
+        virtual ~Listener() = default;
+
+        /** Called on the message thread when a file has finished being analysed. */
+        virtual void analysisFinished (const AudioFile&, const Result&) = 0;
+    };
+
+    void addListener (Listener* l)          { listeners.add (l); }
+    void removeListener (Listener* l)       { listeners.remove (l); }
+
+    //==============================================================================
+    /** The sensitivity passed to BeatDetect. */
+    static constexpr double onsetSensitivity = 0.5;
+
+    /** Onsets closer together than this are merged. */
+    static constexpr double minimumOnsetInterval = 0.1;
+
+private:
+    Engine& engine;
+    juce::ThreadPool pool;
+
+    struct FileStamp
+    {
+        juce::int64 modificationTime = 0, fileSize = 0;
+
+        static FileStamp forFile (const AudioFile&);
+        bool operator== (const FileStamp& other) const noexcept;
+        bool operator!= (const FileStamp& other) const noexcept   { return ! operator== (other); }
+    };
+
+    struct Entry
+    {
+        Result result;
+        FileStamp stamp;
+    };
+
+    mutable juce::CriticalSection resultsLock;
+    std::unordered_map<juce::int64, Entry> results;
+    std::unordered_set<juce::int64> pendingHashes;
+    juce::Array<AudioFile> finishedFiles;
+    juce::ListenerList<Listener> listeners;
+
+    struct AnalysisJob;
+
+    juce::File getCacheFolder() const;
+    juce::File getCacheFileFor (const AudioFile&) const;
+    bool findResult (const AudioFile&, Result*);
+    bool readFromDisk (const AudioFile&, FileStamp, Result&) const;
+    void writeToDisk (const AudioFile&, const Result&, FileStamp) const;
+    void addResult (const AudioFile&, const Result&, FileStamp);
+    void jobFinished (const AudioFile&, bool completedOk);
+
+    void handleAsyncUpdate() override;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (AudioFileAnalysisCache)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioFileAnalysisCache)
+};
+
+} // namespace tracktion_engine
@@ -11,6 +11,15 @@
 namespace tracktion_engine
 {
 
+/**
+    Detects onsets in a stream of audio using spectral flux.
+
+    Audio is fed in hops of getBlockSize() samples. Each hop is mixed to mono and
+    appended to a Hann-windowed analysis frame which is transformed with a
+    juce::dsp::FFT. The positive change in log-magnitude across all bins is then
+    compared to an adaptive threshold built from the recent flux history, and
+    local peaks above the threshold are reported as beats.
+*/
 struct BeatDetect
 {
     BeatDetect() {}
@@ -18,8 +27,29 @@ struct BeatDetect
     void setSampleRate (double sampleRate)
     {
         blockSize = juce::roundToInt (sampleRate / 43.06640625);
+
+        const int order = juce::jlimit (8, 16, (int) std::ceil (std::log2 (blockSize * 2.0)));
+        fft = std::make_unique<juce::dsp::FFT> (order);
+        fftSize = fft->getSize();
+        numBins = fftSize / 2;
+        window = std::make_unique<juce::dsp::WindowingFunction<float>> ((size_t) fftSize,
+                                                                        juce::dsp::WindowingFunction<float>::hann,
+                                                                        false);
+
+        frame.calloc ((size_t) fftSize);
+        fftData.calloc ((size_t) fftSize * 2);
+        previousMagnitudes.calloc ((size_t) numBins);
+
+        minBeatInterval = (juce::int64) (blockSize * 2);
+        std::fill (std::begin (flux), std::end (flux), 0.0f);
+        curBlock = 0;
+        beats.clearQuick();
     }
 
+    /** Sets how far above the recent average flux a peak has to be to count as an
+        onset. 0 to 1 maps to 0.8 to 4 times the average, the same range as the old
+        energy detector so existing sensitivity settings keep their meaning.
+    */
     void setSensitivity (double newSensitivity)
     {
         const double C_MIN = 0.8f;
@@ -28,78 +58,104 @@ struct BeatDetect
         sensitivity = C_MIN + newSensitivity * (C_MAX - C_MIN);
     }
 
+    /** Processes a hop of getBlockSize() samples on each of the given channels. */
     void audioProcess (const float** inputs, int numChans)
     {
-        double blockEnergy = 0;
+        jassert (fft != nullptr);
+        const int overlap = fftSize - blockSize;
+        float* const newest = frame + overlap;
 
-        for (int chan = numChans; --chan >= 0;)
-        {
-            const float* const c = inputs[chan];
+        std::memmove (frame, frame + blockSize, sizeof (float) * (size_t) overlap);
+        juce::FloatVectorOperations::copy (newest, inputs[0], blockSize);
 
-            for (int i = 0; i < blockSize; ++i)
-                blockEnergy += c[i] * c[i];
-        }
+        for (int chan = 1; chan < numChans; ++chan)
+            juce::FloatVectorOperations::add (newest, inputs[chan], blockSize);
+
+        if (numChans > 1)
+            juce::FloatVectorOperations::multiply (newest, 1.0f / numChans, blockSize);
 
-        pushEnergy (blockEnergy);
+        pushFlux (calculateFlux());
     }
 
     int getBlockSize()                      { return blockSize; }
-    int getNumBeats()                       { return beatBlocks.size(); }
-    juce::int64 getBeat (int idx) const     { return beatBlocks[idx] * blockSize; }
+    int getNumBeats()                       { return beats.size(); }
+    juce::int64 getBeat (int idx) const     { return beats[idx]; }
 
 private:
     enum { historyLength = 43 };
-    double energy [historyLength];
+    float flux[historyLength] = {};
     int curBlock = 0;
-    int lastBlock = -2;
-    int blockSize = 0;
-    juce::Array<int> beatBlocks;
-    double sensitivity = 0;
+    int blockSize = 0, fftSize = 0, numBins = 0;
+    juce::int64 minBeatInterval = 0;
+    juce::Array<juce::int64> beats;
+    double sensitivity = 1.5;
 
-    void pushEnergy (double e)
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    juce::HeapBlock<float> frame, fftData, previousMagnitudes;
+
+    float calculateFlux()
     {
-        if (curBlock < historyLength)
-        {
-            energy [curBlock++] = e;
+        juce::FloatVectorOperations::copy (fftData, frame, fftSize);
+        window->multiplyWithWindowingTable (fftData, (size_t) fftSize);
+        fft->performFrequencyOnlyForwardTransform (fftData);
 
-            if (curBlock == historyLength)
-            {
-                double ave = getAverageEnergy();
+        // Normalise so a full-scale sine peaks at 1 then log-compress so quiet
+        // transients aren't swamped by sustained loud partials
+        juce::FloatVectorOperations::multiply (fftData, 4.0f / fftSize, numBins);
 
-                for (int i = 0; i < historyLength; ++i)
-                    if (energy[i] > sensitivity * ave)
-                        addBlock(i);
-            }
-        }
-        else
+        float total = 0.0f;
+
+        for (int i = 0; i < numBins; ++i)
         {
-            energy[curBlock % historyLength] = e;
+            const float mag = std::log1p (100.0f * fftData[i]);
+            total += juce::jmax (0.0f, mag - previousMagnitudes[i]);
+            previousMagnitudes[i] = mag;
+        }
+
+        return total / numBins;
+    }
+
+    void pushFlux (float f)
+    {
+        flux[curBlock % historyLength] = f;
 
-            if (e > sensitivity * getAverageEnergy())
-                addBlock(curBlock);
+        // Peaks are picked with a one block delay so we can check the following block is lower
+        if (curBlock >= 2)
+        {
+            const float candidate = flux[(curBlock - 1) % historyLength];
+            const float previous  = flux[(curBlock - 2) % historyLength];
+            const float threshold = (float) (sensitivity * getAverageFlux()) + minimumFlux;
 
-            curBlock++;
+            if (candidate > previous && candidate >= f && candidate > threshold)
+                addBlock (curBlock - 1);
         }
+
+        ++curBlock;
     }
 
     void addBlock (int i)
     {
-        if (i - 1 != lastBlock)
-            beatBlocks.add(i);
+        // The onset will be roughly in the middle of the window when it produces a peak
+        auto pos = juce::jmax ((juce::int64) 0, (juce::int64) (i + 1) * blockSize - fftSize / 2);
 
-        lastBlock = i;
+        if (beats.isEmpty() || pos - beats.getLast() >= minBeatInterval)
+            beats.add (pos);
     }
 
-    double getAverageEnergy() const noexcept
+    float getAverageFlux() const noexcept
     {
-        double avEnergy = 0;
+        const int num = juce::jmin ((int) historyLength, curBlock + 1);
+        float total = 0.0f;
 
-        for (int i = 0; i < historyLength; ++i)
-            avEnergy += energy[i];
+        for (int i = 0; i < num; ++i)
+            total += flux[i];
 
-        return avEnergy / historyLength;
+        return total / num;
     }
 
+    static constexpr float minimumFlux = 0.01f;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BeatDetect)
 };
 
@@ -44,6 +44,8 @@
 #include <unordered_map>
 #include <atomic>
 #include <random>
+#include <array>
+#include <deque>
 
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_audio_utils/juce_audio_utils.h>
@@ -149,6 +151,16 @@
  #define TRACKTION_CHECK_FOR_SLOW_RENDERING 0
 #endif
 
+/** Config: TRACKTION_CHECK_REALTIME_SAFETY
+    Enabling this intercepts memory allocations, locks and sleeps and records any made on
+    audio threads so you can check the audio callback is real-time safe.
+    This has a large overhead so should only be used for testing.
+    @see RealtimeSafetyChecker
+*/
+#ifndef TRACKTION_CHECK_REALTIME_SAFETY
+ #define TRACKTION_CHECK_REALTIME_SAFETY 0
+#endif
+
 /** Config: TRACKTION_AIR_WINDOWS
     Adds AirWindows effect plugins. Requires complaiance with AirWindows MIT license.
  */
@@ -194,6 +206,7 @@ namespace tracktion_engine
     class AudioNode;
     struct AudioRenderContext;
     class AudioFile;
+    class AudioFileAnalysisCache;
     class PlayHead;
     class Project;
     class InputDevice;
@@ -259,6 +272,7 @@ namespace tracktion_engine
     class MidiInputDeviceInstanceBase;
     struct RetrospectiveMidiBuffer;
     struct MidiMessageArray;
+    class NodeProfiler;
     struct ModifierTimer;
     class MidiLearnState;
     struct EditDeleter;
@@ -304,6 +318,8 @@ namespace tracktion_engine
 #include "utilities/tracktion_CrashTracer.h"
 #include "utilities/tracktion_AsyncFunctionUtils.h"
 #include "utilities/tracktion_CpuMeasurement.h"
+#include "utilities/tracktion_RealtimeSafetyChecker.h"
+#include "utilities/tracktion_Semaphore.h"
 #include "utilities/tracktion_ConstrainedCachedValue.h"
 #include "utilities/tracktion_FileUtilities.h"
 #include "utilities/tracktion_AudioUtilities.h"
@@ -311,6 +327,7 @@ namespace tracktion_engine
 #include "utilities/tracktion_AudioFadeCurve.h"
 #include "utilities/tracktion_Spline.h"
 #include "utilities/tracktion_Ditherer.h"
+#include "utilities/tracktion_SincResampler.h"
 #include "utilities/tracktion_ExternalPlayheadSynchroniser.h"
 #include "selection/tracktion_Selectable.h"
 #include "selection/tracktion_SelectableClass.h"
@@ -356,6 +373,9 @@ namespace tracktion_engine
 #include "midi/tracktion_Musicality.h"
 #include "midi/tracktion_MidiNote.h"
 #include "../tracktion_graph/utilities/tracktion_MidiMessageArray.h"
+#include "../tracktion_graph/utilities/tracktion_MidiEventBuffer.h"
+#include "../tracktion_graph/utilities/tracktion_MidiMessageFifo.h"
+#include "../tracktion_graph/utilities/tracktion_NodeProfiler.h"
 #include "midi/tracktion_ActiveNoteList.h"
 
 #include "plugins/tracktion_PluginWindowState.h"
@@ -378,6 +398,7 @@ namespace tracktion_engine
 
 #include "plugins/external/tracktion_VSTXML.h"
 #include "plugins/external/tracktion_ExternalPlugin.h"
+#include "plugins/external/tracktion_PluginBridge.h"
 
 #include "plugins/internal/tracktion_VCA.h"
 #include "plugins/internal/tracktion_VolumeAndPan.h"
@@ -413,6 +434,7 @@ namespace tracktion_engine
 #include "model/clips/tracktion_Clip.h"
 #include "model/edit/tracktion_EditUtilities.h"
 
+#include "audio_files/tracktion_StreamingAudioReader.h"
 #include "audio_files/tracktion_AudioFileCache.h"
 #include "audio_files/tracktion_Thumbnail.h"
 #include "audio_files/tracktion_SmartThumbnail.h"
@@ -436,6 +458,7 @@ namespace tracktion_engine
 #include "midi/tracktion_MidiExpression.h"
 #include "midi/tracktion_MidiChannel.h"
 #include "midi/tracktion_MidiList.h"
+#include "midi/tracktion_CompiledMidiSequence.h"
 #include "midi/tracktion_SelectedMidiEvents.h"
 
 #include "model/automation/tracktion_AutomationRecordManager.h"
@@ -449,6 +472,7 @@ namespace tracktion_engine
 #include "model/tracks/tracktion_AudioTrack.h"
 
 #include "timestretch/tracktion_BeatDetect.h"
+#include "timestretch/tracktion_AudioFileAnalysisCache.h"
 #include "timestretch/tracktion_TimeStretch.h"
 
 #include "model/export/tracktion_ArchiveFile.h"
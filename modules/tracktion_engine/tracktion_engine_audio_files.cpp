@@ -27,18 +27,21 @@ extern "C"
 #include "tracktion_engine.h"
 
 #include <string>
+#include <future>
 
 #include "audio_files/formats/tracktion_FloatAudioFileFormat.cpp"
 #include "audio_files/formats/tracktion_RexFileFormat.cpp"
 #include "audio_files/formats/tracktion_LAMEManager.cpp"
 
 #include "audio_files/tracktion_Thumbnail.cpp"
+#include "audio_files/tracktion_StreamingAudioReader.cpp"
 #include "audio_files/tracktion_AudioFileCache.cpp"
 #include "audio_files/tracktion_AudioFile.cpp"
 #include "audio_files/tracktion_AudioFileUtils.cpp"
 #include "audio_files/tracktion_AudioFormatManager.cpp"
 
 #include "midi/tracktion_MidiList.cpp"
+#include "midi/tracktion_CompiledMidiSequence.cpp"
 #include "midi/tracktion_MidiProgramManager.cpp"
 #include "midi/tracktion_Musicality.cpp"
 #include "midi/tracktion_SelectedMidiEvents.cpp"
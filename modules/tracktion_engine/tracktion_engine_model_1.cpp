@@ -15,7 +15,6 @@
 
 using namespace juce;
 
-#include "timestretch/tracktion_TempoDetect.h"
 #include "model/automation/modifiers/tracktion_ModifierInternal.h"
 
 #include "model/edit/tracktion_OldEditConversion.h"
@@ -49,6 +49,7 @@ using namespace juce;
 #include "model/export/tracktion_RenderManager.cpp"
 #include "model/export/tracktion_ArchiveFile.cpp"
 #include "model/export/tracktion_RenderOptions.cpp"
+#include "model/export/tracktion_tests_Renderer.cpp"
 #include "model/clips/tracktion_EditClipRenderJob.cpp"
 #include "model/clips/tracktion_AudioSegmentList.cpp"
 #include "audio_files/tracktion_LoopInfo.cpp"
@@ -39,6 +39,8 @@ using namespace juce;
 #endif
 
 #include "timestretch/tracktion_TimeStretch.cpp"
+#include "timestretch/tracktion_TempoDetect.h"
+#include "timestretch/tracktion_AudioFileAnalysisCache.cpp"
 
 namespace tracktion_engine
 {
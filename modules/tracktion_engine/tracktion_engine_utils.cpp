@@ -69,9 +69,12 @@ using namespace juce;
 #include "utilities/tracktion_FileUtilities.cpp"
 #include "utilities/tracktion_Oscillators.cpp"
 #include "utilities/tracktion_PropertyStorage.cpp"
+#include "utilities/tracktion_RealtimeSafetyChecker.cpp"
+#include "utilities/tracktion_SincResampler.cpp"
 #include "utilities/tracktion_UIBehaviour.cpp"
 #include "utilities/tracktion_TemporaryFileManager.cpp"
 #include "utilities/tracktion_Engine.cpp"
 #include "utilities/tracktion_BinaryData.cpp"
+#include "utilities/tracktion_Semaphore.cpp"
 
 #endif
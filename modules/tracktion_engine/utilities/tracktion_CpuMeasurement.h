@@ -21,7 +21,7 @@ struct ScopedCpuMeter
     ~ScopedCpuMeter() noexcept
     {
         const double msTaken = juce::Time::getMillisecondCounterHiRes() - callbackStartTime;
-        valueToUpdate.store (filterAmount * (msTaken - valueToUpdate));
+        valueToUpdate.store (valueToUpdate + filterAmount * (msTaken - valueToUpdate));
     }
 
 private:
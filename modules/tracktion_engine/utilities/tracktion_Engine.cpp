@@ -81,6 +81,7 @@ Engine::~Engine()
     getExternalControllerManager().shutdown();
     getDeviceManager().closeDevices();
     getBackgroundJobs().stopAndDeleteAllRunningJobs();
+    audioFileAnalysisCache.reset();
 
     temporaryFileManager->cleanUp();
 
@@ -255,4 +256,12 @@ WarpTimeFactory& Engine::getWarpTimeFactory() const
     return *warpTimeFactory;
 }
 
+AudioFileAnalysisCache& Engine::getAudioFileAnalysisCache()
+{
+    if (! audioFileAnalysisCache)
+        audioFileAnalysisCache = std::make_unique<AudioFileAnalysisCache> (*this);
+
+    return *audioFileAnalysisCache;
+}
+
 }
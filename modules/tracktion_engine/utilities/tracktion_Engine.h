@@ -53,6 +53,7 @@ public:
     GrooveTemplateManager& getGrooveTemplateManager();
     CompFactory& getCompFactory() const;
     WarpTimeFactory& getWarpTimeFactory() const;
+    AudioFileAnalysisCache& getAudioFileAnalysisCache();
     ProjectManager& getProjectManager() const;
 
     using WeakRef = juce::WeakReference<Engine>;
@@ -81,6 +82,7 @@ private:
     mutable std::unique_ptr<GrooveTemplateManager> grooveTemplateManager;
     mutable std::unique_ptr<CompFactory> compFactory;
     mutable std::unique_ptr<WarpTimeFactory> warpTimeFactory;
+    std::unique_ptr<AudioFileAnalysisCache> audioFileAnalysisCache;
 
     JUCE_DECLARE_WEAK_REFERENCEABLE (Engine)
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Engine)
@@ -84,6 +84,20 @@ public:
 
     virtual int getNumberOfCPUsToUseForAudio()                                      { return juce::jmax (1, juce::SystemStats::getNumCpus()); }
 
+    /** If this returns true and more than one Edit is playing at once, the Edits will be
+        rendered concurrently on getNumberOfCPUsToUseForAudio() threads rather than one after
+        the other on the audio device thread.
+        Only enable this if your Edits don't share anything that's used whilst rendering,
+        e.g. plugin instances or any of your own state accessed from the audio thread.
+        This is checked in DeviceManager::updateNumCPUs.
+    */
+    virtual bool shouldRenderEditsInParallel()                                      { return false; }
+
+    /** Should return the quality of resampler to use when playing audio clips whose sample
+        rate doesn't match the output's.
+    */
+    virtual SincResampler::Quality getResamplingQuality()                          { return SincResampler::Quality::medium; }
+
     virtual bool areAudioClipsRemappedWhenTempoChanges()                            { return true; }
     virtual void setAudioClipsRemappedWhenTempoChanges (bool)                       {}
     virtual bool areAutoTempoClipsRemappedWhenTempoChanges()                        { return true; }
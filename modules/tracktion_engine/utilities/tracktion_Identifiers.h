@@ -366,6 +366,7 @@ namespace IDs
     DECLARE_ID (currentCurve)
     DECLARE_ID (hash)
     DECLARE_ID (processMidiWhenMuted)
+    DECLARE_ID (bypassWhenOverloaded)
     DECLARE_ID (LOOPINFO)
     DECLARE_ID (numBeats)
     DECLARE_ID (rootNote)
@@ -125,6 +125,7 @@ String PropertyStorage::settingToString (SettingID setting)
         case SettingID::virtualmididevices:            return "virtualmididevices";
         case SettingID::virtualmidiin:                 return "virtualmidiin";
         case SettingID::useSeparateProcessForScanning: return "useSeparateProcessForScanning";
+        case SettingID::useBridgedPluginHosting:       return "useBridgedPluginHosting";
         case SettingID::useRealtime:                   return "useRealtime";
         case SettingID::wavein:                        return "wavein";
         case SettingID::waveout:                       return "waveout";
@@ -0,0 +1,291 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+#if TRACKTION_CHECK_REALTIME_SAFETY
+namespace RealtimeSafetyCheckerHelpers
+{
+    // These are plain ints so reading them from inside malloc can't allocate
+    static thread_local int realtimeDepth = 0;
+    static thread_local int allowDepth = 0;
+    static thread_local bool isRecording = false;
+
+    struct Recorder
+    {
+        juce::SpinLock lock;
+        std::map<std::pair<int, juce::String>, int> counts;
+    };
+
+    static Recorder& getRecorder()
+    {
+        static Recorder recorder;
+        return recorder;
+    }
+}
+
+RealtimeSafetyChecker::ScopedRealtimeThread::ScopedRealtimeThread() noexcept     { ++RealtimeSafetyCheckerHelpers::realtimeDepth; }
+RealtimeSafetyChecker::ScopedRealtimeThread::~ScopedRealtimeThread() noexcept    { --RealtimeSafetyCheckerHelpers::realtimeDepth; }
+
+RealtimeSafetyChecker::ScopedAllowViolations::ScopedAllowViolations() noexcept   { ++RealtimeSafetyCheckerHelpers::allowDepth; }
+RealtimeSafetyChecker::ScopedAllowViolations::~ScopedAllowViolations() noexcept  { --RealtimeSafetyCheckerHelpers::allowDepth; }
+#endif
+
+//==============================================================================
+juce::String RealtimeSafetyChecker::getDescription (ViolationType type)
+{
+    switch (type)
+    {
+        case ViolationType::allocation:     return "allocation";
+        case ViolationType::deallocation:   return "deallocation";
+        case ViolationType::lock:           return "lock";
+        case ViolationType::blockingCall:   return "blocking call";
+        default:                            break;
+    }
+
+    jassertfalse;
+    return {};
+}
+
+void RealtimeSafetyChecker::recordViolation (ViolationType type) noexcept
+{
+   #if TRACKTION_CHECK_REALTIME_SAFETY
+    using namespace RealtimeSafetyCheckerHelpers;
+
+    if (realtimeDepth == 0 || allowDepth > 0 || isRecording)
+        return;
+
+    // Capturing the stack allocates so anything that happens in here mustn't be recorded
+    isRecording = true;
+
+    {
+        auto stackTrace = juce::SystemStats::getStackBacktrace();
+        auto& recorder = getRecorder();
+        const juce::SpinLock::ScopedLockType sl (recorder.lock);
+        ++recorder.counts[{ (int) type, stackTrace }];
+    }
+
+    isRecording = false;
+   #else
+    juce::ignoreUnused (type);
+   #endif
+}
+
+RealtimeSafetyChecker::Report RealtimeSafetyChecker::getReport()
+{
+    Report report;
+
+   #if TRACKTION_CHECK_REALTIME_SAFETY
+    auto& recorder = RealtimeSafetyCheckerHelpers::getRecorder();
+    const juce::SpinLock::ScopedLockType sl (recorder.lock);
+
+    for (auto& c : recorder.counts)
+        report.entries.push_back ({ (ViolationType) c.first.first, c.first.second, c.second });
+   #endif
+
+    return report;
+}
+
+void RealtimeSafetyChecker::reset()
+{
+   #if TRACKTION_CHECK_REALTIME_SAFETY
+    auto& recorder = RealtimeSafetyCheckerHelpers::getRecorder();
+    const juce::SpinLock::ScopedLockType sl (recorder.lock);
+    recorder.counts.clear();
+   #endif
+}
+
+//==============================================================================
+int RealtimeSafetyChecker::Report::getNumViolations (ViolationType type) const
+{
+    int total = 0;
+
+    for (auto& e : entries)
+        if (e.type == type)
+            total += e.count;
+
+    return total;
+}
+
+juce::String RealtimeSafetyChecker::Report::toString() const
+{
+    juce::String s;
+
+    for (auto& e : entries)
+        s << getDescription (e.type) << " x " << e.count << ":" << juce::newLine
+          << e.stackTrace << juce::newLine;
+
+    return s;
+}
+
+//==============================================================================
+//==============================================================================
+#if TRACKTION_UNIT_TESTS && TRACKTION_CHECK_REALTIME_SAFETY
+
+class RealtimeSafetyCheckerTests  : public juce::UnitTest
+{
+public:
+    RealtimeSafetyCheckerTests() : juce::UnitTest ("RealtimeSafetyChecker", "Tracktion") {}
+
+    void runTest() override
+    {
+        using Type = RealtimeSafetyChecker::ViolationType;
+
+        beginTest ("Non real-time threads");
+        {
+            RealtimeSafetyChecker::reset();
+            allocateAndLock();
+            expect (RealtimeSafetyChecker::getReport().isClean());
+        }
+
+        beginTest ("Real-time threads");
+        {
+            RealtimeSafetyChecker::reset();
+
+            {
+                const RealtimeSafetyChecker::ScopedRealtimeThread realtimeThread;
+                allocateAndLock();
+            }
+
+            auto report = RealtimeSafetyChecker::getReport();
+            expect (report.getNumViolations (Type::allocation) > 0);
+            expect (report.getNumViolations (Type::deallocation) > 0);
+
+           #if JUCE_LINUX
+            expect (report.getNumViolations (Type::lock) > 0);
+           #endif
+        }
+
+        beginTest ("Allowed violations");
+        {
+            RealtimeSafetyChecker::reset();
+
+            {
+                const RealtimeSafetyChecker::ScopedRealtimeThread realtimeThread;
+                const RealtimeSafetyChecker::ScopedAllowViolations allowViolations;
+                allocateAndLock();
+            }
+
+            expect (RealtimeSafetyChecker::getReport().isClean());
+        }
+
+        RealtimeSafetyChecker::reset();
+    }
+
+private:
+    juce::CriticalSection lock;
+
+    void allocateAndLock()
+    {
+        const juce::ScopedLock sl (lock);
+        juce::String s ("allocated string ");
+        s << getRandom().nextInt();
+    }
+};
+
+static RealtimeSafetyCheckerTests realtimeSafetyCheckerTests;
+
+#endif
+
+} // namespace tracktion_engine
+
+//==============================================================================
+#if TRACKTION_CHECK_REALTIME_SAFETY
+ #if JUCE_LINUX
+  #include <pthread.h>
+  #include <time.h>
+  #include <unistd.h>
+
+  // Interposes the glibc allocation, locking and sleeping functions so calls from anywhere
+  // in the process, including plugins, are seen. These forward to glibc's own entry points.
+  extern "C"
+  {
+      void* __libc_malloc (size_t);
+      void* __libc_calloc (size_t, size_t);
+      void* __libc_realloc (void*, size_t);
+      void __libc_free (void*);
+      int __pthread_mutex_lock (pthread_mutex_t*);
+      int __nanosleep (const struct timespec*, struct timespec*);
+
+      void* malloc (size_t size) noexcept
+      {
+          tracktion_engine::RealtimeSafetyChecker::recordViolation (tracktion_engine::RealtimeSafetyChecker::ViolationType::allocation);
+          return __libc_malloc (size);
+      }
+
+      void* calloc (size_t num, size_t size) noexcept
+      {
+          tracktion_engine::RealtimeSafetyChecker::recordViolation (tracktion_engine::RealtimeSafetyChecker::ViolationType::allocation);
+          return __libc_calloc (num, size);
+      }
+
+      void* realloc (void* ptr, size_t size) noexcept
+      {
+          tracktion_engine::RealtimeSafetyChecker::recordViolation (tracktion_engine::RealtimeSafetyChecker::ViolationType::allocation);
+          return __libc_realloc (ptr, size);
+      }
+
+      void free (void* ptr) noexcept
+      {
+          if (ptr != nullptr)
+              tracktion_engine::RealtimeSafetyChecker::recordViolation (tracktion_engine::RealtimeSafetyChecker::ViolationType::deallocation);
+
+          __libc_free (ptr);
+      }
+
+      int pthread_mutex_lock (pthread_mutex_t* mutex) noexcept
+      {
+          tracktion_engine::RealtimeSafetyChecker::recordViolation (tracktion_engine::RealtimeSafetyChecker::ViolationType::lock);
+          return __pthread_mutex_lock (mutex);
+      }
+
+      int nanosleep (const struct timespec* duration, struct timespec* remaining)
+      {
+          tracktion_engine::RealtimeSafetyChecker::recordViolation (tracktion_engine::RealtimeSafetyChecker::ViolationType::blockingCall);
+          return __nanosleep (duration, remaining);
+      }
+
+      int usleep (useconds_t microseconds)
+      {
+          tracktion_engine::RealtimeSafetyChecker::recordViolation (tracktion_engine::RealtimeSafetyChecker::ViolationType::blockingCall);
+          const struct timespec duration { (time_t) (microseconds / 1000000), (long) (microseconds % 1000000) * 1000 };
+          return __nanosleep (&duration, nullptr);
+      }
+  }
+ #else
+  void* operator new (size_t size)
+  {
+      tracktion_engine::RealtimeSafetyChecker::recordViolation (tracktion_engine::RealtimeSafetyChecker::ViolationType::allocation);
+
+      if (auto ptr = std::malloc (size > 0 ? size : 1))
+          return ptr;
+
+      throw std::bad_alloc();
+  }
+
+  void* operator new[] (size_t size)
+  {
+      return operator new (size);
+  }
+
+  void operator delete (void* ptr) noexcept
+  {
+      if (ptr != nullptr)
+          tracktion_engine::RealtimeSafetyChecker::recordViolation (tracktion_engine::RealtimeSafetyChecker::ViolationType::deallocation);
+
+      std::free (ptr);
+  }
+
+  void operator delete[] (void* ptr) noexcept                 { operator delete (ptr); }
+  void operator delete (void* ptr, size_t) noexcept           { operator delete (ptr); }
+  void operator delete[] (void* ptr, size_t) noexcept         { operator delete (ptr); }
+ #endif
+#endif
@@ -0,0 +1,116 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+/**
+    Records operations that aren't safe to perform on a real-time thread.
+
+    When TRACKTION_CHECK_REALTIME_SAFETY is enabled, memory allocations, mutex
+    locks and sleeps made by any thread inside a ScopedRealtimeThread are
+    counted along with the call stack they came from. Use getReport() to see
+    what happened, e.g. after playing back an Edit, to prove that the audio
+    callback doesn't allocate or lock.
+
+    On Linux the malloc family, pthread_mutex_lock, nanosleep and usleep are
+    intercepted. On other platforms only operator new and delete are.
+
+    When the flag is disabled none of this is compiled and the report is always empty.
+*/
+struct RealtimeSafetyChecker
+{
+    enum class ViolationType
+    {
+        allocation,
+        deallocation,
+        lock,
+        blockingCall
+    };
+
+    static juce::String getDescription (ViolationType);
+
+    //==============================================================================
+    /** Marks the calling thread as real-time for the lifetime of this object.
+        These can be nested.
+    */
+    struct ScopedRealtimeThread
+    {
+       #if TRACKTION_CHECK_REALTIME_SAFETY
+        ScopedRealtimeThread() noexcept;
+        ~ScopedRealtimeThread() noexcept;
+       #else
+        ScopedRealtimeThread() noexcept {}
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtimeThread)
+    };
+
+    /** Ignores any violations on the calling thread for the lifetime of this object.
+        Use this sparingly for sections that are known to be safe in practice.
+    */
+    struct ScopedAllowViolations
+    {
+       #if TRACKTION_CHECK_REALTIME_SAFETY
+        ScopedAllowViolations() noexcept;
+        ~ScopedAllowViolations() noexcept;
+       #else
+        ScopedAllowViolations() noexcept {}
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedAllowViolations)
+    };
+
+    //==============================================================================
+    /** The violations recorded since the last call to reset(). */
+    struct Report
+    {
+        struct Entry
+        {
+            ViolationType type;
+            juce::String stackTrace;
+            int count = 0;
+        };
+
+        std::vector<Entry> entries;
+
+        /** Returns the total number of times a type of violation happened. */
+        int getNumViolations (ViolationType) const;
+
+        /** Returns true if nothing was recorded. */
+        bool isClean() const        { return entries.empty(); }
+
+        /** Returns a description of each violation with its call stack. */
+        juce::String toString() const;
+    };
+
+    /** Returns true if the checks have been compiled in. */
+    static constexpr bool isEnabled()
+    {
+       #if TRACKTION_CHECK_REALTIME_SAFETY
+        return true;
+       #else
+        return false;
+       #endif
+    }
+
+    /** Returns the violations recorded so far. */
+    static Report getReport();
+
+    /** Clears any recorded violations. */
+    static void reset();
+
+    /** Records a violation if the calling thread is real-time.
+        This is called by the interceptors but can also be used to flag custom operations.
+    */
+    static void recordViolation (ViolationType) noexcept;
+};
+
+} // namespace tracktion_engine
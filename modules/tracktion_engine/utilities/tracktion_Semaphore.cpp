@@ -0,0 +1,209 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+// This is included last in its unity file so the Windows macros can't affect the rest of the engine
+#if JUCE_WINDOWS
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN 1
+ #endif
+ #ifndef NOMINMAX
+  #define NOMINMAX 1
+ #endif
+ #include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#else
+ #include <semaphore.h>
+ #include <time.h>
+ #include <errno.h>
+#endif
+
+namespace tracktion_engine
+{
+
+#if JUCE_WINDOWS
+struct Semaphore::Pimpl
+{
+    Pimpl()
+    {
+        // A high-resolution timer is only available from Windows 10 1803, otherwise
+        // waits fall back to WaitForSingleObject's millisecond timeout
+       #ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+        constexpr DWORD CREATE_WAITABLE_TIMER_HIGH_RESOLUTION = 0x00000002;
+       #endif
+        timer = CreateWaitableTimerExW (nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    }
+
+    ~Pimpl()
+    {
+        if (timer != nullptr)
+            CloseHandle (timer);
+
+        CloseHandle (semaphore);
+    }
+
+    void signal() noexcept
+    {
+        ReleaseSemaphore (semaphore, 1, nullptr);
+    }
+
+    void wait() noexcept
+    {
+        WaitForSingleObject (semaphore, INFINITE);
+    }
+
+    bool timedWait (double timeoutSeconds) noexcept
+    {
+        if (timer == nullptr)
+            return WaitForSingleObject (semaphore, (DWORD) std::ceil (timeoutSeconds * 1000.0)) == WAIT_OBJECT_0;
+
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -(LONGLONG) (timeoutSeconds * 1.0e7); // relative, in 100ns units
+
+        if (! SetWaitableTimer (timer, &dueTime, 0, nullptr, nullptr, FALSE))
+            return WaitForSingleObject (semaphore, (DWORD) std::ceil (timeoutSeconds * 1000.0)) == WAIT_OBJECT_0;
+
+        HANDLE handles[] = { semaphore, timer };
+        auto result = WaitForMultipleObjects (2, handles, FALSE, INFINITE);
+        CancelWaitableTimer (timer);
+
+        return result == WAIT_OBJECT_0;
+    }
+
+    HANDLE semaphore = CreateSemaphoreW (nullptr, 0, std::numeric_limits<LONG>::max(), nullptr);
+    HANDLE timer = nullptr;
+};
+
+#elif JUCE_MAC || JUCE_IOS
+struct Semaphore::Pimpl
+{
+    ~Pimpl()
+    {
+        dispatch_release (semaphore);
+    }
+
+    void signal() noexcept
+    {
+        dispatch_semaphore_signal (semaphore);
+    }
+
+    void wait() noexcept
+    {
+        dispatch_semaphore_wait (semaphore, DISPATCH_TIME_FOREVER);
+    }
+
+    bool timedWait (double timeoutSeconds) noexcept
+    {
+        auto timeout = dispatch_time (DISPATCH_TIME_NOW, (int64_t) (timeoutSeconds * 1.0e9));
+        return dispatch_semaphore_wait (semaphore, timeout) == 0;
+    }
+
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create (0);
+};
+
+#else
+struct Semaphore::Pimpl
+{
+    Pimpl()
+    {
+        sem_init (&semaphore, 0, 0);
+    }
+
+    ~Pimpl()
+    {
+        sem_destroy (&semaphore);
+    }
+
+    void signal() noexcept
+    {
+        sem_post (&semaphore);
+    }
+
+    void wait() noexcept
+    {
+        while (sem_wait (&semaphore) != 0 && errno == EINTR)
+        {}
+    }
+
+    bool timedWait (double timeoutSeconds) noexcept
+    {
+        // sem_timedwait takes an absolute CLOCK_REALTIME deadline
+        timespec deadline;
+        clock_gettime (CLOCK_REALTIME, &deadline);
+
+        auto ns = (juce::int64) deadline.tv_nsec + (juce::int64) (juce::jmax (0.0, timeoutSeconds) * 1.0e9);
+        deadline.tv_sec += (time_t) (ns / 1000000000);
+        deadline.tv_nsec = (long) (ns % 1000000000);
+
+        for (;;)
+        {
+            if (sem_timedwait (&semaphore, &deadline) == 0)
+                return true;
+
+            if (errno != EINTR)
+                return false;
+        }
+    }
+
+    sem_t semaphore;
+};
+#endif
+
+//==============================================================================
+Semaphore::Semaphore()  : pimpl (std::make_unique<Pimpl>()) {}
+Semaphore::~Semaphore() {}
+
+void Semaphore::signal() noexcept                           { pimpl->signal(); }
+void Semaphore::wait() noexcept                             { pimpl->wait(); }
+bool Semaphore::timedWait (double timeoutSeconds) noexcept  { return pimpl->timedWait (timeoutSeconds); }
+
+//==============================================================================
+#if TRACKTION_UNIT_TESTS
+
+class SemaphoreTests  : public juce::UnitTest
+{
+public:
+    SemaphoreTests() : juce::UnitTest ("Semaphore", "Tracktion") {}
+
+    void runTest() override
+    {
+        beginTest ("Timed waits");
+        {
+            Semaphore s;
+            expect (! s.timedWait (0.0));
+
+            s.signal();
+            s.signal();
+            expect (s.timedWait (0.0));
+            expect (s.timedWait (0.0));
+            expect (! s.timedWait (0.0));
+
+            // A wait that isn't signalled should last for at least its timeout
+            auto start = juce::Time::getHighResolutionTicks();
+            expect (! s.timedWait (0.002));
+            auto elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+            expectGreaterOrEqual (elapsed, 0.0015);
+        }
+
+        beginTest ("Signal from another thread");
+        {
+            Semaphore s;
+            std::thread t ([&s] { juce::Thread::sleep (10); s.signal(); });
+            expect (s.timedWait (5.0));
+            t.join();
+        }
+    }
+};
+
+static SemaphoreTests semaphoreTests;
+
+#endif
+
+} // namespace tracktion_engine
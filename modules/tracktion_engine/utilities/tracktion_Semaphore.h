@@ -0,0 +1,47 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+/**
+    A counting semaphore built on the OS primitive.
+
+    Unlike juce::WaitableEvent, signalling doesn't take a mutex so it can be used to
+    wake a thread from the audio thread, and timed waits aren't rounded to whole
+    milliseconds.
+*/
+class Semaphore
+{
+public:
+    Semaphore();
+    ~Semaphore();
+
+    /** Increments the count, waking a waiting thread if there is one.
+        This doesn't block or allocate so is safe to call from the audio thread.
+    */
+    void signal() noexcept;
+
+    /** Waits until the count is non-zero and then decrements it. */
+    void wait() noexcept;
+
+    /** Waits for up to the given number of seconds for the count to be non-zero.
+        @returns true if the count was decremented, false if the wait timed out
+    */
+    bool timedWait (double timeoutSeconds) noexcept;
+
+private:
+    struct Pimpl;
+    std::unique_ptr<Pimpl> pimpl;
+
+    JUCE_DECLARE_NON_COPYABLE (Semaphore)
+};
+
+} // namespace tracktion_engine
@@ -94,6 +94,7 @@ enum class SettingID
     virtualmididevices,
     virtualmidiin,
     useSeparateProcessForScanning,
+    useBridgedPluginHosting,
     useRealtime,
     wavein,
     waveout,
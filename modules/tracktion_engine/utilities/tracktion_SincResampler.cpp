@@ -0,0 +1,400 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+namespace SincResamplerHelpers
+{
+    static int getNumTaps (SincResampler::Quality quality) noexcept
+    {
+        switch (quality)
+        {
+            case SincResampler::Quality::low:       return 8;
+            case SincResampler::Quality::high:      return 32;
+            case SincResampler::Quality::medium:
+            default:                                return 16;
+        }
+    }
+
+    static double getKaiserBeta (SincResampler::Quality quality) noexcept
+    {
+        switch (quality)
+        {
+            case SincResampler::Quality::low:       return 5.0;
+            case SincResampler::Quality::high:      return 9.0;
+            case SincResampler::Quality::medium:
+            default:                                return 7.0;
+        }
+    }
+
+    /** The cutoff as a proportion of Nyquist. Longer filters have a sharper transition
+        so can keep more of the top end.
+    */
+    static double getRolloff (SincResampler::Quality quality) noexcept
+    {
+        switch (quality)
+        {
+            case SincResampler::Quality::low:       return 0.85;
+            case SincResampler::Quality::high:      return 0.95;
+            case SincResampler::Quality::medium:
+            default:                                return 0.9;
+        }
+    }
+
+    /** The zeroth order modified Bessel function of the first kind, used by the Kaiser window. */
+    static double besselI0 (double x) noexcept
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 64; ++k)
+        {
+            auto t = x / (2.0 * k);
+            term *= t * t;
+            sum += term;
+
+            if (term < sum * 1.0e-12)
+                break;
+        }
+
+        return sum;
+    }
+
+    static inline float dotProduct (const float* a, const float* b, int num) noexcept
+    {
+        float result = 0.0f;
+        int i = 0;
+
+       #if JUCE_USE_SSE_INTRINSICS
+        auto sum = _mm_setzero_ps();
+
+        for (; i + 4 <= num; i += 4)
+            sum = _mm_add_ps (sum, _mm_mul_ps (_mm_loadu_ps (a + i), _mm_loadu_ps (b + i)));
+
+        sum = _mm_add_ps (sum, _mm_movehl_ps (sum, sum));
+        sum = _mm_add_ss (sum, _mm_shuffle_ps (sum, sum, 1));
+        result = _mm_cvtss_f32 (sum);
+       #elif JUCE_USE_ARM_NEON
+        auto sum = vdupq_n_f32 (0.0f);
+
+        for (; i + 4 <= num; i += 4)
+            sum = vmlaq_f32 (sum, vld1q_f32 (a + i), vld1q_f32 (b + i));
+
+        auto pairs = vadd_f32 (vget_low_f32 (sum), vget_high_f32 (sum));
+        result = vget_lane_f32 (vpadd_f32 (pairs, pairs), 0);
+       #endif
+
+        for (; i < num; ++i)
+            result += a[i] * b[i];
+
+        return result;
+    }
+}
+
+//==============================================================================
+struct SincResampler::CoefficientTable
+{
+    static constexpr int numPhases = 256;
+
+    CoefficientTable (Quality quality, double cutoff)
+        : numTaps (SincResamplerHelpers::getNumTaps (quality))
+    {
+        const int half = numTaps / 2;
+        const auto beta = SincResamplerHelpers::getKaiserBeta (quality);
+        const auto windowScale = 1.0 / SincResamplerHelpers::besselI0 (beta);
+
+        // Phase p is the filter for a position p / numPhases of the way between two
+        // samples. The extra one is only needed to interpolate the last phase.
+        std::vector<double> phases ((size_t) ((numPhases + 1) * numTaps));
+
+        for (int phase = 0; phase <= numPhases; ++phase)
+        {
+            auto row = phases.data() + phase * numTaps;
+            double sum = 0.0;
+
+            for (int tap = 0; tap < numTaps; ++tap)
+            {
+                auto x = (tap - (half - 1)) - phase / (double) numPhases;
+                auto u = x / half;
+                auto window = std::abs (u) < 1.0 ? SincResamplerHelpers::besselI0 (beta * std::sqrt (1.0 - u * u)) * windowScale : 0.0;
+                auto arg = juce::MathConstants<double>::pi * cutoff * x;
+                auto sinc = arg == 0.0 ? 1.0 : std::sin (arg) / arg;
+
+                row[tap] = cutoff * sinc * window;
+                sum += row[tap];
+            }
+
+            // Normalise each phase so a constant signal comes out at the same level
+            for (int tap = 0; tap < numTaps; ++tap)
+                row[tap] /= sum;
+        }
+
+        // Each phase is stored as its coefficients followed by the difference to the next one
+        data.resize ((size_t) (numPhases * numTaps * 2));
+
+        for (int phase = 0; phase < numPhases; ++phase)
+        {
+            auto row = phases.data() + phase * numTaps;
+            auto dest = data.data() + phase * numTaps * 2;
+
+            for (int tap = 0; tap < numTaps; ++tap)
+            {
+                dest[tap] = (float) row[tap];
+                dest[numTaps + tap] = (float) (row[numTaps + tap] - row[tap]);
+            }
+        }
+    }
+
+    const float* getPhase (int phase) const noexcept    { return data.data() + phase * numTaps * 2; }
+
+    const int numTaps;
+    std::vector<float> data;
+};
+
+std::shared_ptr<const SincResampler::CoefficientTable> SincResampler::getCoefficientTable (Quality quality, double cutoff)
+{
+    static juce::CriticalSection lock;
+    static std::map<std::pair<int, int>, std::weak_ptr<const CoefficientTable>> tables;
+
+    // Cutoffs are rounded so that nodes playing at nearly the same ratio can share a table
+    const auto cutoffKey = juce::roundToInt (cutoff * 1000.0);
+    const auto key = std::make_pair ((int) quality, cutoffKey);
+
+    const juce::ScopedLock sl (lock);
+
+    if (auto existing = tables[key].lock())
+        return existing;
+
+    auto newTable = std::make_shared<const CoefficientTable> (quality, cutoffKey / 1000.0);
+    tables[key] = newTable;
+
+    return newTable;
+}
+
+//==============================================================================
+void SincResampler::prepare (Quality quality, int numChannels, double nominalRatio)
+{
+    numTaps = SincResamplerHelpers::getNumTaps (quality);
+
+    // When speeding up, the cutoff needs to come down to the new Nyquist
+    auto cutoff = SincResamplerHelpers::getRolloff (quality);
+
+    if (nominalRatio > 1.0)
+        cutoff /= nominalRatio;
+
+    table = getCoefficientTable (quality, cutoff);
+
+    history.setSize (numChannels, numTaps);
+    edge.setSize (numChannels, numTaps * 2);
+    coefficients.allocate ((size_t) numTaps, true);
+
+    reset();
+}
+
+void SincResampler::reset() noexcept
+{
+    history.clear();
+    subSamplePos = 0.0;
+}
+
+int SincResampler::getNumSourceSamplesConsumed (double ratio, int numDestSamples) const noexcept
+{
+    return (int) (subSamplePos + numDestSamples * ratio);
+}
+
+int SincResampler::processAdding (double ratio,
+                                  const juce::AudioBuffer<float>& source, int numSourceSamples,
+                                  juce::AudioBuffer<float>& dest, int destStartSample, int numDestSamples,
+                                  const float* channelGains) noexcept
+{
+    jassert (table != nullptr);
+    jassert (ratio > 0.0);
+
+    const int numChannels = std::min (getNumChannels(), std::min (source.getNumChannels(), dest.getNumChannels()));
+    const auto endPos = subSamplePos + numDestSamples * ratio;
+    const int numConsumed = (int) endPos;
+
+    if (ratio == 1.0 && subSamplePos == 0.0)
+    {
+        // Nothing to interpolate so this is just a copy
+        jassert (numSourceSamples >= numDestSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::addWithMultiply (dest.getWritePointer (channel, destStartSample),
+                                                          source.getReadPointer (channel),
+                                                          channelGains[channel], numDestSamples);
+
+        updateHistory (source, numConsumed);
+        return numConsumed;
+    }
+
+    const int half = numTaps / 2;
+    jassert (numSourceSamples >= numConsumed + getNumLookaheadSamples());
+
+    // The windows for the first few samples start in the history, so for those this
+    // holds the history followed by the start of the source
+    const int numEdgeSourceSamples = std::min (numTaps, numSourceSamples);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        edge.copyFrom (channel, 0, history, channel, 0, numTaps);
+        edge.copyFrom (channel, numTaps, source, channel, 0, numEdgeSourceSamples);
+
+        if (numEdgeSourceSamples < numTaps)
+            edge.clear (channel, numTaps + numEdgeSourceSamples, numTaps - numEdgeSourceSamples);
+    }
+
+    auto sourceChannels = source.getArrayOfReadPointers();
+    auto edgeChannels = edge.getArrayOfReadPointers();
+    auto destChannels = dest.getArrayOfWritePointers();
+    auto coeffs = coefficients.get();
+
+    for (int i = 0; i < numDestSamples; ++i)
+    {
+        const auto pos = subSamplePos + i * ratio;
+        const int index = (int) pos;
+        const auto phasePos = (pos - index) * CoefficientTable::numPhases;
+        const int phase = std::min ((int) phasePos, CoefficientTable::numPhases - 1);
+
+        // The coefficients are worked out once and then used for all the channels
+        auto row = table->getPhase (phase);
+        juce::FloatVectorOperations::copy (coeffs, row, numTaps);
+        juce::FloatVectorOperations::addWithMultiply (coeffs, row + numTaps, (float) (phasePos - phase), numTaps);
+
+        const int windowStart = index - half + 1;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto window = windowStart >= 0 ? sourceChannels[channel] + windowStart
+                                           : edgeChannels[channel] + numTaps + windowStart;
+
+            destChannels[channel][destStartSample + i] += channelGains[channel] * SincResamplerHelpers::dotProduct (window, coeffs, numTaps);
+        }
+    }
+
+    updateHistory (source, numConsumed);
+    subSamplePos = endPos - numConsumed;
+
+    return numConsumed;
+}
+
+void SincResampler::updateHistory (const juce::AudioBuffer<float>& source, int numConsumed) noexcept
+{
+    const int numChannels = std::min (history.getNumChannels(), source.getNumChannels());
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto dest = history.getWritePointer (channel);
+
+        if (numConsumed >= numTaps)
+        {
+            juce::FloatVectorOperations::copy (dest, source.getReadPointer (channel, numConsumed - numTaps), numTaps);
+        }
+        else
+        {
+            std::memmove (dest, dest + numConsumed, sizeof (float) * (size_t) (numTaps - numConsumed));
+            juce::FloatVectorOperations::copy (dest + numTaps - numConsumed, source.getReadPointer (channel), numConsumed);
+        }
+    }
+}
+
+//==============================================================================
+#if TRACKTION_UNIT_TESTS
+
+class SincResamplerTests   : public juce::UnitTest
+{
+public:
+    SincResamplerTests()
+        : juce::UnitTest ("SincResampler", "Tracktion") {}
+
+    //==============================================================================
+    void runTest() override
+    {
+        beginTest ("Unity ratio");
+        {
+            SincResampler resampler;
+            resampler.prepare (SincResampler::Quality::medium, 1, 1.0);
+
+            juce::AudioBuffer<float> source (1, 600), dest (1, 512);
+            dest.clear();
+
+            for (int i = 0; i < source.getNumSamples(); ++i)
+                source.setSample (0, i, (float) i);
+
+            const float gain = 0.5f;
+            expectEquals (resampler.processAdding (1.0, source, source.getNumSamples(), dest, 0, 512, &gain), 512);
+            expectEquals (dest.getSample (0, 100), 50.0f);
+        }
+
+        for (auto quality : { SincResampler::Quality::low, SincResampler::Quality::medium, SincResampler::Quality::high })
+        {
+            beginTest ("Sine at 44.1KHz to 48KHz, quality " + juce::String ((int) quality));
+            expectLessThan (getMaxErrorResamplingSine (quality, 44100.0, 48000.0, 1000.0), 0.002f);
+
+            beginTest ("Sine at 96KHz to 44.1KHz, quality " + juce::String ((int) quality));
+            expectLessThan (getMaxErrorResamplingSine (quality, 96000.0, 44100.0, 1000.0), 0.002f);
+        }
+    }
+
+    /** Resamples a stereo sine in blocks of varying sizes and compares it to the ideal output. */
+    float getMaxErrorResamplingSine (SincResampler::Quality quality, double sourceRate, double destRate, double frequency)
+    {
+        const auto ratio = sourceRate / destRate;
+        const int numDestSamples = (int) destRate;
+        const float gains[] = { 1.0f, 0.5f };
+
+        SincResampler resampler;
+        resampler.prepare (quality, 2, ratio);
+
+        juce::AudioBuffer<float> source, dest (2, numDestSamples);
+        dest.clear();
+
+        auto getSine = [&] (juce::int64 sourceSample)
+        {
+            return (float) std::sin (juce::MathConstants<double>::twoPi * frequency * sourceSample / sourceRate);
+        };
+
+        juce::int64 sourcePosition = 0;
+
+        for (int destPosition = 0, blockIndex = 0; destPosition < numDestSamples; ++blockIndex)
+        {
+            const int numThisTime = std::min (numDestSamples - destPosition, 100 + (blockIndex * 37) % 400);
+            const int numSourceSamples = resampler.getNumSourceSamplesConsumed (ratio, numThisTime) + resampler.getNumLookaheadSamples();
+            source.setSize (2, numSourceSamples, false, false, true);
+
+            for (int i = 0; i < numSourceSamples; ++i)
+                for (int channel = 0; channel < 2; ++channel)
+                    source.setSample (channel, i, getSine (sourcePosition + i));
+
+            sourcePosition += resampler.processAdding (ratio, source, numSourceSamples, dest, destPosition, numThisTime, gains);
+            destPosition += numThisTime;
+        }
+
+        float maxError = 0.0f;
+
+        // Skip the start, where the filter's history is still empty
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            for (int i = 1000; i < numDestSamples; ++i)
+            {
+                auto expected = gains[channel] * (float) std::sin (juce::MathConstants<double>::twoPi * frequency * i * ratio / sourceRate);
+                maxError = std::max (maxError, std::abs (expected - dest.getSample (channel, i)));
+            }
+        }
+
+        return maxError;
+    }
+};
+
+static SincResamplerTests sincResamplerTests;
+
+#endif // TRACKTION_UNIT_TESTS
+
+} // namespace tracktion_engine
@@ -0,0 +1,93 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+namespace tracktion_engine
+{
+
+/**
+    A polyphase windowed-sinc resampler which processes all the channels of a stream
+    in one pass.
+
+    The filter for each fractional position is interpolated from a table of phases.
+    The tables are shared between all the resamplers using the same quality and cutoff,
+    so having lots of these doesn't use lots of memory. The coefficients for each output
+    sample are worked out once and used for every channel, and the dot products are
+    done with SIMD where it's available. A gain per channel is applied as the result is
+    added to the destination, so gain and pan don't need a separate pass.
+
+    Like juce::LagrangeInterpolator this keeps the last few input samples between calls,
+    so consecutive blocks of a stream can be passed to it one after the other. Unlike it,
+    it also needs to see a few samples past the ones it consumes, see getNumLookaheadSamples().
+*/
+class SincResampler
+{
+public:
+    enum class Quality
+    {
+        low,        /**< 8 taps, cheapest. */
+        medium,     /**< 16 taps. */
+        high        /**< 32 taps, for rendering. */
+    };
+
+    SincResampler() = default;
+
+    /** Prepares to resample a number of channels at roughly the given ratio of input
+        samples to output samples.
+        The ratio is used to lower the filter's cutoff when the stream is being sped up,
+        so that it doesn't alias. This allocates, so call it before playback starts.
+    */
+    void prepare (Quality, int numChannels, double nominalRatio);
+
+    /** Clears the stored input samples and fractional position. */
+    void reset() noexcept;
+
+    int getNumChannels() const noexcept                 { return history.getNumChannels(); }
+
+    /** Returns the number of samples that each source must hold beyond the ones a
+        call to processAdding will consume.
+    */
+    int getNumLookaheadSamples() const noexcept         { return numTaps / 2 + 1; }
+
+    /** Returns the number of source samples a call to processAdding will consume. */
+    int getNumSourceSamplesConsumed (double ratio, int numDestSamples) const noexcept;
+
+    /** Resamples the source channels and adds them to the destination, multiplied by
+        the gain for each channel.
+
+        The ratio is the number of source samples per destination sample. The source
+        must hold at least getNumSourceSamplesConsumed() + getNumLookaheadSamples()
+        samples, and the next call should carry on from the first sample that wasn't
+        consumed.
+
+        @returns the number of source samples consumed
+    */
+    int processAdding (double ratio,
+                       const juce::AudioBuffer<float>& source, int numSourceSamples,
+                       juce::AudioBuffer<float>& dest, int destStartSample, int numDestSamples,
+                       const float* channelGains) noexcept;
+
+private:
+    //==============================================================================
+    struct CoefficientTable;
+    static std::shared_ptr<const CoefficientTable> getCoefficientTable (Quality, double cutoff);
+
+    std::shared_ptr<const CoefficientTable> table;
+    int numTaps = 0;
+    double subSamplePos = 0.0;
+
+    juce::AudioBuffer<float> history, edge;
+    juce::HeapBlock<float> coefficients;
+
+    void updateHistory (const juce::AudioBuffer<float>& source, int numConsumed) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SincResampler)
+};
+
+} // namespace tracktion_engine
@@ -22,6 +22,10 @@
 //==============================================================================
 #include "tracktion_graph/tracktion_graph_tests_Utilities.h"
 #include "tracktion_graph/tracktion_graph_tests_TestNodes.h"
+#include "tracktion_graph/tracktion_graph_tests_Benchmark.h"
 
 #include "tracktion_graph/tracktion_graph_tests_Node.cpp"
+#include "tracktion_graph/tracktion_graph_tests_MidiEventBuffer.cpp"
+#include "tracktion_graph/tracktion_graph_tests_MidiMessageFifo.cpp"
 #include "tracktion_graph/tracktion_graph_tests_NodeVisiting.cpp"
+#include "tracktion_graph/tracktion_graph_tests_Performance.cpp"
@@ -54,6 +54,9 @@
 //==============================================================================
 #include "utilities/tracktion_AudioFifo.h"
 #include "utilities/tracktion_MidiMessageArray.h"
+#include "utilities/tracktion_MidiEventBuffer.h"
+#include "utilities/tracktion_MidiMessageFifo.h"
+#include "utilities/tracktion_NodeProfiler.h"
 
 #include "tracktion_graph/tracktion_graph_Utility.h"
 #include "tracktion_graph/tracktion_graph_Node.h"
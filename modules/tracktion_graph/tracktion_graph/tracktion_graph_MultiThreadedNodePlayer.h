@@ -11,6 +11,7 @@
 #pragma once
 
 #include <thread>
+#include <unordered_map>
 #include <emmintrin.h>
 
 namespace tracktion_graph
@@ -18,6 +19,12 @@ namespace tracktion_graph
 
 /**
     Plays back a node with mutiple threads.
+
+    Nodes are handed to the threads in order of their longest remaining path to
+    the root Node (the "upward rank" used by HEFT list scheduling). This is based
+    on how long each Node has recently taken to process so that the chains that
+    determine when the block can finish get started first and cheap Nodes fill in
+    the gaps on the other threads.
 */
 class MultiThreadedNodePlayer
 {
@@ -46,6 +53,33 @@ public:
         prepareToPlay (sampleRate, blockSize, oldNode.get());
     }
 
+    /** Sets the maximum number of threads to process the graph with, including the
+        thread that calls process. 0 means use as many as there are CPU cores.
+    */
+    void setMaxNumThreads (size_t newMaxNumThreads)
+    {
+        maxNumThreads = newMaxNumThreads;
+
+        if (! allNodes.empty())
+        {
+            clearThreads();
+            createThreads();
+        }
+    }
+
+    /** Sets a profiler to record the time spent processing each Node and how busy
+        each thread is. Pass nullptr to stop profiling.
+        This can be called whilst processing and takes effect from the next block, but
+        the old profiler must outlive the block that's currently being processed.
+    */
+    void setProfiler (tracktion_engine::NodeProfiler* newProfiler)
+    {
+        if (newProfiler != nullptr && ! allNodes.empty())
+            newProfiler->setGraph (createProfilerGraph (allNodes));
+
+        profiler = newProfiler;
+    }
+
     void prepareToPlay (double sampleRateToUse, int blockSizeToUse, Node* oldNode = nullptr)
     {
         sampleRate = sampleRateToUse;
@@ -58,12 +92,31 @@ public:
         
         // Then find all the nodes as it might have changed after initialisation
         allNodes = tracktion_graph::getNodes (*rootNode, tracktion_graph::VertexOrdering::postordering);
+        buildSchedule();
+
+        if (auto p = profiler.load())
+            p->setGraph (createProfilerGraph (allNodes));
 
         createThreads();
     }
 
+    /** Sets how quickly the measured Node processing times adapt to changes.
+        This is the weight given to each new measurement so should be between 0 and 1.
+    */
+    void setCostSmoothing (double newSmoothing)
+    {
+        jassert (newSmoothing > 0.0 && newSmoothing <= 1.0);
+        costSmoothing = juce::jlimit (0.0001, 1.0, newSmoothing);
+    }
+
     int process (const Node::ProcessContext& pc)
     {
+        // The worker threads use the same profiler for the whole block
+        blockProfiler = profiler.load();
+
+        if (blockProfiler != nullptr)
+            blockProfiler->beginBlock();
+
         // Reset the stream range
         streamSampleRange = pc.streamSampleRange;
         
@@ -71,9 +124,18 @@ public:
         for (auto node : allNodes)
             node->prepareForNextBlock();
 
+        // Re-prioritise the nodes with their latest costs. This is safe as none of the
+        // other threads can touch the order until numNodesLeftToProcess is set below
+        if (++numBlocksSinceScheduling >= numBlocksBetweenScheduling)
+        {
+            numBlocksSinceScheduling = 0;
+            updateProcessingOrder();
+        }
+
         // Then set the vector to be processed
         // Threads are always running so will process as soon numNodesLeftToProcess is non-zero
-        numNodesLeftToProcess = allNodes.size();
+        numNodesProcessed = 0;
+        numNodesLeftToProcess = processingOrder.size();
         
         // Try to process Nodes until they're all processed
         for (;;)
@@ -82,13 +144,20 @@ public:
                 break;
         }
         
-        // Wait for any threads to finish processing
-        while (! rootNode->hasProcessed())
+        // Wait for any threads to finish processing. The root Node can have processed before
+        // the other threads have stopped their timers so this waits for every Node to be
+        // completely done, otherwise their times could be pushed after endBlock
+        while (numNodesProcessed.load (std::memory_order_acquire) < processingOrder.size())
             pause();
 
+        jassert (rootNode->hasProcessed());
+
         auto output = rootNode->getProcessedOutput();
         pc.buffers.audio.copyFrom (output.audio);
         pc.buffers.midi.copyFrom (output.midi);
+
+        if (blockProfiler != nullptr)
+            blockProfiler->endBlock();
         
         return -1;
     }
@@ -98,15 +167,124 @@ private:
     std::unique_ptr<Node> rootNode;
     std::vector<std::thread> threads;
     std::vector<Node*> allNodes;
+    std::atomic<tracktion_engine::NodeProfiler*> profiler { nullptr };
+    tracktion_engine::NodeProfiler* blockProfiler = nullptr; // Set before numNodesLeftToProcess is published
+
+    /** The scheduling state of a Node. */
+    struct NodeInfo
+    {
+        Node* node = nullptr;
+        size_t nodeID = 0, postorderIndex = 0;
+        std::vector<size_t> outputs;        // Indexes of the Nodes that use this as an input
+        std::atomic<double> cost { 0.0 };   // Smoothed processing time in seconds
+        double rank = 0.0;                  // Longest path from the start of this Node to the end of the root
+    };
+
+    std::vector<std::unique_ptr<NodeInfo>> nodeInfos;   // In postorder
+    std::vector<NodeInfo*> processingOrder;
+    double costSmoothing = 0.1;
+    static constexpr int numBlocksBetweenScheduling = 16;
+    int numBlocksSinceScheduling = 0;
     
     juce::Range<int64_t> streamSampleRange;
     std::atomic<bool> threadsShouldExit { false };
-    std::atomic<size_t> numNodesLeftToProcess { 0 };
+    std::atomic<size_t> numNodesLeftToProcess { 0 }, numNodesProcessed { 0 };
 
     //==============================================================================
     double sampleRate = 44100.0;
     int blockSize = 512;
+    size_t maxNumThreads = 0;
     
+    //==============================================================================
+    /** Rebuilds the dependencies between the Nodes after the graph has changed,
+        keeping the measured costs of any Nodes that are still present.
+    */
+    void buildSchedule()
+    {
+        std::unordered_map<size_t, double> previousCosts;
+
+        for (auto& info : nodeInfos)
+            if (info->nodeID != 0)
+                previousCosts[info->nodeID] = info->cost.load (std::memory_order_relaxed);
+
+        std::unordered_map<Node*, size_t> indexes;
+        nodeInfos.clear();
+        nodeInfos.reserve (allNodes.size());
+
+        for (auto node : allNodes)
+        {
+            indexes[node] = nodeInfos.size();
+
+            auto info = std::make_unique<NodeInfo>();
+            info->node = node;
+            info->nodeID = node->getNodeProperties().nodeID;
+            info->postorderIndex = nodeInfos.size();
+
+            if (info->nodeID != 0)
+            {
+                auto found = previousCosts.find (info->nodeID);
+
+                if (found != previousCosts.end())
+                    info->cost = found->second;
+            }
+
+            nodeInfos.push_back (std::move (info));
+        }
+
+        for (auto& info : nodeInfos)
+            for (auto input : info->node->getDirectInputNodes())
+            {
+                auto found = indexes.find (input);
+
+                if (found != indexes.end())
+                    nodeInfos[found->second]->outputs.push_back (info->postorderIndex);
+            }
+
+        processingOrder.clear();
+
+        for (auto& info : nodeInfos)
+            processingOrder.push_back (info.get());
+
+        numBlocksSinceScheduling = 0;
+        updateProcessingOrder();
+    }
+
+    /** Sorts the Nodes by their upward rank.
+        A Node's rank is always at least that of the Nodes it outputs to so this is
+        still a valid topological order and threads never wait on a Node that can't
+        yet be picked up. Ties keep the postorder which also preserves this.
+        This doesn't allocate so can be called on the audio thread.
+    */
+    void updateProcessingOrder()
+    {
+        // Postorder visits inputs first so the reverse visits all a Node's outputs before it
+        for (auto i = nodeInfos.size(); i > 0;)
+        {
+            auto& info = *nodeInfos[--i];
+            double longestOutputRank = 0.0;
+
+            for (auto output : info.outputs)
+                longestOutputRank = std::max (longestOutputRank, nodeInfos[output]->rank);
+
+            info.rank = std::max (0.0, info.cost.load (std::memory_order_relaxed)) + longestOutputRank;
+        }
+
+        std::sort (processingOrder.begin(), processingOrder.end(),
+                   [] (const NodeInfo* a, const NodeInfo* b)
+                   {
+                       if (a->rank != b->rank)
+                           return a->rank > b->rank;
+
+                       return a->postorderIndex < b->postorderIndex;
+                   });
+    }
+
+    void updateCost (NodeInfo& info, double secondsTaken) noexcept
+    {
+        const auto cost = info.cost.load (std::memory_order_relaxed);
+        info.cost.store (cost + costSmoothing * (secondsTaken - cost), std::memory_order_relaxed);
+    }
+
     //==============================================================================
     void clearThreads()
     {
@@ -120,13 +298,15 @@ private:
     
     void createThreads()
     {
+        threadsShouldExit = false;
         size_t numThreadsToUse = 0;
         
         for (auto node : allNodes)
             if (node->isReadyToProcess())
                 ++numThreadsToUse;
         
-        numThreadsToUse = std::min (numThreadsToUse, (size_t) std::thread::hardware_concurrency()) - 1;
+        const auto maxThreads = maxNumThreads > 0 ? maxNumThreads : (size_t) std::thread::hardware_concurrency();
+        numThreadsToUse = std::max (std::min (numThreadsToUse, maxThreads), (size_t) 1) - 1;
              
         for (size_t i = 0; i < numThreadsToUse; ++i)
             threads.emplace_back ([this] { processNextFreeNodeOrWait(); });
@@ -168,16 +348,25 @@ private:
 
         if (numNodesLeftToProcess.compare_exchange_strong (expectedNumNodesLeft, nodeToReserve))
         {
-            const size_t nodeIndex = allNodes.size() - nodeToReserve - 1;
-            auto node = allNodes[nodeIndex];
+            const size_t nodeIndex = processingOrder.size() - nodeToReserve - 1;
+            auto& info = *processingOrder[nodeIndex];
+            auto node = info.node;
 
             // Wait until this node is actually ready to be processed
             // It might be waiting for other Nodes
             while (! node->isReadyToProcess())
                 pause();
-            
-            node->process (streamSampleRange);
-            
+
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+
+            {
+                const tracktion_engine::NodeProfiler::ScopedNodeTimer timer (blockProfiler, node);
+                node->process (streamSampleRange);
+            }
+
+            updateCost (info, juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks));
+            numNodesProcessed.fetch_add (1, std::memory_order_release);
+
             return true;
         }
         
@@ -213,6 +213,9 @@ enum class VertexOrdering
 /** Returns all the nodes in a Node graph in the order given by vertexOrdering. */
 static inline std::vector<Node*> getNodes (Node&, VertexOrdering);
 
+/** Returns a description of a set of nodes and their direct inputs to pass to NodeProfiler::setGraph. */
+static inline std::vector<tracktion_engine::NodeProfiler::GraphNode> createProfilerGraph (const std::vector<Node*>&);
+
 
 //==============================================================================
 //==============================================================================
@@ -318,5 +321,25 @@ inline std::vector<Node*> getNodes (Node& node, VertexOrdering vertexOrdering)
     return visitedNodes;
 }
 
+inline std::vector<tracktion_engine::NodeProfiler::GraphNode> createProfilerGraph (const std::vector<Node*>& nodes)
+{
+    std::vector<tracktion_engine::NodeProfiler::GraphNode> graph;
+    graph.reserve (nodes.size());
+
+    for (auto node : nodes)
+    {
+        tracktion_engine::NodeProfiler::GraphNode graphNode;
+        graphNode.node = node;
+        graphNode.name = tracktion_engine::NodeProfiler::getTypeName (typeid (*node));
+
+        for (auto input : node->getDirectInputNodes())
+            graphNode.inputs.push_back (input);
+
+        graph.push_back (std::move (graphNode));
+    }
+
+    return graph;
+}
+
 
 }
@@ -43,6 +43,17 @@ public:
         input = std::move (newNode);
         prepareToPlay (sampleRate, blockSize, oldNode.get());
     }
+
+    /** Sets a profiler to record the time spent processing each Node.
+        Pass nullptr to stop profiling. This shouldn't be called whilst processing.
+    */
+    void setProfiler (tracktion_engine::NodeProfiler* newProfiler)
+    {
+        profiler = newProfiler;
+
+        if (profiler != nullptr && ! allNodes.empty())
+            profiler->setGraph (createProfilerGraph (allNodes));
+    }
     
     /** Prepares the processor to be played. */
     void prepareToPlay (double sampleRateToUse, int blockSizeToUse, Node* oldNode = nullptr)
@@ -57,6 +68,9 @@ public:
         
         // Then find all the nodes as it might have changed after initialisation
         allNodes = tracktion_graph::getNodes (*input, tracktion_graph::VertexOrdering::postordering);
+
+        if (profiler != nullptr)
+            profiler->setGraph (createProfilerGraph (allNodes));
     }
 
     /** Processes a block of audio and MIDI data.
@@ -64,19 +78,29 @@ public:
     */
     int process (const Node::ProcessContext& pc)
     {
-        return processPostorderedNodes (*input, allNodes, pc);
+        if (profiler != nullptr)
+            profiler->beginBlock();
+
+        auto numMisses = processPostorderedNodes (*input, allNodes, pc, profiler);
+
+        if (profiler != nullptr)
+            profiler->endBlock();
+
+        return numMisses;
     }
     
 private:
     std::unique_ptr<Node> input;
     std::vector<Node*> allNodes;
+    tracktion_engine::NodeProfiler* profiler = nullptr;
     double sampleRate = 44100.0;
     int blockSize = 512;
 
     /** Processes a group of Nodes assuming a postordering VertexOrdering.
         If these conditions are met the Nodes should be processed in a single loop iteration.
     */
-    static int processPostorderedNodes (Node& rootNode, const std::vector<Node*>& allNodes, const Node::ProcessContext& pc)
+    static int processPostorderedNodes (Node& rootNode, const std::vector<Node*>& allNodes, const Node::ProcessContext& pc,
+                                        tracktion_engine::NodeProfiler* profiler = nullptr)
     {
         for (auto node : allNodes)
             node->prepareForNextBlock();
@@ -90,6 +114,7 @@ private:
             {
                 if (! node->hasProcessed() && node->isReadyToProcess())
                 {
+                    const tracktion_engine::NodeProfiler::ScopedNodeTimer timer (profiler, node);
                     node->process (pc.streamSampleRange);
                     ++numNodesProcessed;
                 }
@@ -0,0 +1,220 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <numeric>
+
+namespace tracktion_graph
+{
+
+//==============================================================================
+namespace benchmark_utilities
+{
+    /** Describes the shape of a synthetic graph to benchmark. */
+    struct GraphShape
+    {
+        int numTracks = 8;                  /**< The number of parallel branches. */
+        int numNodesPerTrack = 4;           /**< The number of gain stages after each track's source. */
+        int numChannels = 2;
+        int numTracksPerSubmix = 8;         /**< Tracks are summed in groups of this size before the master. */
+        bool addSendsAndReturns = false;    /**< If true, every other track sends to a return on the next track. */
+        bool addLatency = false;            /**< If true, every third track has some latency to compensate for. */
+
+        juce::String getDescription() const
+        {
+            return juce::String (numTracks) + "x" + juce::String (numNodesPerTrack)
+                    + (addSendsAndReturns ? " sends" : "")
+                    + (addLatency ? " latency" : "");
+        }
+    };
+
+    /** Builds a graph from the test Nodes with the given shape.
+        Each track is a SinNode followed by a chain of gain Nodes. The tracks are
+        summed in submixes with BasicSummingNodes and those are then summed by a
+        latency compensating SummingNode.
+    */
+    static inline std::unique_ptr<Node> createGraph (const GraphShape& shape)
+    {
+        std::vector<std::unique_ptr<Node>> submixes, tracksInSubmix;
+
+        for (int track = 0; track < shape.numTracks; ++track)
+        {
+            auto node = makeNode<SinNode> (110.0f * (1 + (track % 8)), shape.numChannels);
+
+            for (int i = 0; i < shape.numNodesPerTrack; ++i)
+                node = makeGainNode (std::move (node), 0.99f);
+
+            if (shape.addLatency && (track % 3) == 0)
+                node = makeNode<LatencyNode> (std::move (node), 64 * (1 + (track % 4)));
+
+            if (shape.addSendsAndReturns)
+            {
+                const int busID = track / 2;
+
+                if ((track % 2) == 0)
+                    node = makeNode<SendNode> (std::move (node), busID);
+                else
+                    node = makeNode<ReturnNode> (std::move (node), busID);
+            }
+
+            tracksInSubmix.push_back (std::move (node));
+
+            if ((int) tracksInSubmix.size() >= shape.numTracksPerSubmix || track == shape.numTracks - 1)
+            {
+                submixes.push_back (std::make_unique<BasicSummingNode> (std::move (tracksInSubmix)));
+                tracksInSubmix.clear();
+            }
+        }
+
+        return makeNode<SummingNode> (std::move (submixes));
+    }
+
+    //==============================================================================
+    /** The measurements from processing a graph. */
+    struct Result
+    {
+        juce::String graphDescription, playerName;
+        int numThreads = 1;
+        size_t numNodes = 0;
+        double sampleRate = 44100.0;
+        int blockSize = 512;
+        int numBlocks = 0;
+
+        double nsPerNode = 0;               /**< The average time to process each Node. */
+        double blockTimeP50Us = 0;          /**< The median time to process a block in microseconds. */
+        double blockTimeP90Us = 0;
+        double blockTimeP99Us = 0;
+        double blockTimeMaxUs = 0;
+        double realtimeFactor = 0;          /**< How many times faster than real-time the graph was processed. */
+        int64_t numMisses = -1;             /**< The misses reported by the player or -1 if it doesn't report them. */
+
+        juce::var toVar() const
+        {
+            auto o = new juce::DynamicObject();
+            o->setProperty ("graph", graphDescription);
+            o->setProperty ("player", playerName);
+            o->setProperty ("threads", numThreads);
+            o->setProperty ("nodes", (int) numNodes);
+            o->setProperty ("sampleRate", sampleRate);
+            o->setProperty ("blockSize", blockSize);
+            o->setProperty ("blocks", numBlocks);
+            o->setProperty ("nsPerNode", nsPerNode);
+            o->setProperty ("blockUsP50", blockTimeP50Us);
+            o->setProperty ("blockUsP90", blockTimeP90Us);
+            o->setProperty ("blockUsP99", blockTimeP99Us);
+            o->setProperty ("blockUsMax", blockTimeMaxUs);
+            o->setProperty ("realtimeFactor", realtimeFactor);
+            o->setProperty ("misses", numMisses >= 0 ? juce::var ((juce::int64) numMisses) : juce::var());
+
+            return juce::var (o);
+        }
+    };
+
+    /** Returns a set of Results as a JSON array. */
+    static inline juce::String toJSON (const std::vector<Result>& results)
+    {
+        juce::Array<juce::var> array;
+
+        for (auto& r : results)
+            array.add (r.toVar());
+
+        return juce::JSON::toString (juce::var (array));
+    }
+
+    //==============================================================================
+    /** Processes a graph in a player for a number of blocks and measures how long each block takes.
+        The player must have been created with the graph but not prepared.
+    */
+    template<typename PlayerType>
+    static inline Result measure (PlayerType& player, const GraphShape& shape,
+                                  double sampleRate, int blockSize, double durationInSeconds)
+    {
+        using Clock = std::chrono::high_resolution_clock;
+
+        player.prepareToPlay (sampleRate, blockSize);
+
+        Result result;
+        result.graphDescription = shape.getDescription();
+        result.numNodes = getNodes (player.getNode(), VertexOrdering::postordering).size();
+        result.sampleRate = sampleRate;
+        result.blockSize = blockSize;
+        result.numBlocks = std::max (1, juce::roundToInt (durationInSeconds * sampleRate / blockSize));
+
+        juce::AudioBuffer<float> buffer (shape.numChannels, blockSize);
+        tracktion_engine::MidiMessageArray midi;
+        std::vector<double> blockTimesNs;
+        blockTimesNs.reserve ((size_t) result.numBlocks);
+        int64_t numMisses = 0;
+        bool playerReportsMisses = true;
+
+        for (int block = 0; block < result.numBlocks; ++block)
+        {
+            midi.clear();
+            const auto range = juce::Range<int64_t>::withStartAndLength ((int64_t) block * blockSize, (int64_t) blockSize);
+
+            const auto start = Clock::now();
+            const int misses = player.process ({ range, { { buffer }, midi } });
+            const auto end = Clock::now();
+
+            blockTimesNs.push_back ((double) std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count());
+
+            if (misses < 0)
+                playerReportsMisses = false;
+            else
+                numMisses += misses;
+        }
+
+        const double totalNs = std::accumulate (blockTimesNs.begin(), blockTimesNs.end(), 0.0);
+        std::sort (blockTimesNs.begin(), blockTimesNs.end());
+
+        auto getPercentileUs = [&blockTimesNs] (double percentile)
+        {
+            auto index = std::min (blockTimesNs.size() - 1, (size_t) (percentile * (double) blockTimesNs.size()));
+            return blockTimesNs[index] / 1000.0;
+        };
+
+        result.nsPerNode        = totalNs / ((double) result.numBlocks * (double) std::max ((size_t) 1, result.numNodes));
+        result.blockTimeP50Us   = getPercentileUs (0.5);
+        result.blockTimeP90Us   = getPercentileUs (0.9);
+        result.blockTimeP99Us   = getPercentileUs (0.99);
+        result.blockTimeMaxUs   = blockTimesNs.back() / 1000.0;
+        result.realtimeFactor   = totalNs > 0.0 ? (result.numBlocks * blockSize / sampleRate) / (totalNs * 1.0e-9) : 0.0;
+        result.numMisses        = playerReportsMisses ? numMisses : -1;
+
+        return result;
+    }
+
+    /** Builds a graph and measures it with a single threaded NodePlayer. */
+    static inline Result measureNodePlayer (const GraphShape& shape, double sampleRate, int blockSize, double durationInSeconds)
+    {
+        NodePlayer player (createGraph (shape));
+        auto result = measure (player, shape, sampleRate, blockSize, durationInSeconds);
+        result.playerName = "NodePlayer";
+
+        return result;
+    }
+
+    /** Builds a graph and measures it with a MultiThreadedNodePlayer using a given number of threads. */
+    static inline Result measureMultiThreadedNodePlayer (const GraphShape& shape, size_t numThreads,
+                                                         double sampleRate, int blockSize, double durationInSeconds)
+    {
+        MultiThreadedNodePlayer player (createGraph (shape));
+        player.setMaxNumThreads (numThreads);
+        auto result = measure (player, shape, sampleRate, blockSize, durationInSeconds);
+        result.playerName = "MultiThreadedNodePlayer";
+        result.numThreads = (int) numThreads;
+
+        return result;
+    }
+}
+
+}
@@ -0,0 +1,217 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+
+namespace tracktion_graph
+{
+
+//==============================================================================
+//==============================================================================
+class MidiEventBufferTests : public juce::UnitTest
+{
+public:
+    MidiEventBufferTests()
+        : juce::UnitTest ("MidiEventBuffer", "tracktion_graph")
+    {
+    }
+    
+    void runTest() override
+    {
+        runLongMessageTests();
+        runMergeTests();
+        runConversionTests();
+    }
+
+private:
+    using MidiEventBuffer = tracktion_engine::MidiEventBuffer;
+
+    //==============================================================================
+    void runLongMessageTests()
+    {
+        beginTest ("Short and long messages");
+        {
+            MidiEventBuffer buffer;
+            buffer.add (juce::MidiMessage::noteOn (1, 60, 0.5f).withTimeStamp (0.1), 3);
+
+            const juce::uint8 sysexData[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a };
+            buffer.add (juce::MidiMessage::createSysExMessage (sysexData, (int) sizeof (sysexData)).withTimeStamp (0.2), 0);
+            buffer.add (juce::MidiMessage::programChange (1, 10).withTimeStamp (0.3), 0);
+
+            expectEquals (buffer.size(), 3);
+            expect (! buffer[0].isLongMessage());
+            expect (buffer[1].isLongMessage());
+            expect (! buffer[2].isLongMessage());
+
+            auto noteOn = buffer.getMessage (buffer[0]);
+            expect (noteOn.isNoteOn());
+            expectEquals (noteOn.getNoteNumber(), 60);
+            expectEquals ((int) buffer[0].mpeSourceID, 3);
+
+            auto sysex = buffer.getMessage (buffer[1]);
+            expect (sysex.isSysEx());
+            expectEquals (sysex.getSysExDataSize(), (int) sizeof (sysexData));
+            expect (std::equal (sysexData, sysexData + sizeof (sysexData), sysex.getSysExData()));
+            expectEquals (sysex.getTimeStamp(), 0.2);
+
+            expectEquals (buffer.getRawDataSize (buffer[2]), 2);
+            expect (buffer.getMessage (buffer[2]).isProgramChange());
+        }
+    }
+
+    void runMergeTests()
+    {
+        beginTest ("Stable k-way merge");
+        {
+            MidiEventBuffer a, b, c, merged;
+
+            for (int i = 0; i < 4; ++i)
+                a.add (juce::MidiMessage::noteOn (1, i, 1.0f).withTimeStamp (i * 0.1), 1);
+
+            // b has an event at the same time as each of a's, added after them
+            for (int i = 0; i < 4; ++i)
+                b.add (juce::MidiMessage::noteOff (1, i).withTimeStamp (i * 0.1), 2);
+
+            // c has a long message in the middle
+            const juce::uint8 sysexData[] = { 0x7e, 0x7f, 0x09, 0x01 };
+            c.add (juce::MidiMessage::createSysExMessage (sysexData, (int) sizeof (sysexData)).withTimeStamp (0.15), 3);
+
+            const MidiEventBuffer* sources[] = { &a, &b, &c };
+            merged.mergeSorted (sources, 3);
+
+            expectEquals (merged.size(), 9);
+            expect (merged.isSorted());
+
+            // Events at the same time come from the earlier source first
+            expect (merged.getMessage (merged[0]).isNoteOn());
+            expect (merged.getMessage (merged[1]).isNoteOff());
+            expectEquals ((int) merged[0].mpeSourceID, 1);
+            expectEquals ((int) merged[1].mpeSourceID, 2);
+
+            expect (merged.getMessage (merged[4]).isSysEx());
+            expectEquals (merged.getMessage (merged[4]).getSysExDataSize(), (int) sizeof (sysexData));
+        }
+
+        beginTest ("Stable sort");
+        {
+            MidiEventBuffer buffer;
+            buffer.add (juce::MidiMessage::noteOn (1, 1, 1.0f).withTimeStamp (0.2), 0);
+            buffer.add (juce::MidiMessage::noteOff (1, 2).withTimeStamp (0.1), 0);
+            buffer.add (juce::MidiMessage::noteOn (1, 2, 1.0f).withTimeStamp (0.1), 0);
+
+            buffer.sortByTimestamp();
+
+            expect (buffer.isSorted());
+            expect (buffer.getMessage (buffer[0]).isNoteOff());
+            expect (buffer.getMessage (buffer[1]).isNoteOn());
+            expectEquals (buffer.getMessage (buffer[2]).getNoteNumber(), 1);
+        }
+
+        beginTest ("Stable sort of MidiMessageArray");
+        {
+            const juce::uint8 sysexData[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+
+            const auto notMPE = tracktion_engine::MidiMessageArray::notMPE;
+            tracktion_engine::MidiMessageArray array;
+            array.addMidiMessage (juce::MidiMessage::noteOn (1, 1, 1.0f).withTimeStamp (0.2), notMPE);
+            array.addMidiMessage (juce::MidiMessage::noteOff (1, 2).withTimeStamp (0.1), notMPE);
+            array.addMidiMessage (juce::MidiMessage::createSysExMessage (sysexData, (int) sizeof (sysexData)).withTimeStamp (0.1), notMPE);
+            array.addMidiMessage (juce::MidiMessage::noteOn (1, 3, 1.0f).withTimeStamp (0.0), notMPE);
+
+            array.sortByTimestamp();
+
+            expect (array[0].isNoteOn() && array[0].getNoteNumber() == 3);
+            expect (array[1].isNoteOff());
+            expect (array[2].isSysEx());
+            expectEquals (array[2].getSysExDataSize(), (int) sizeof (sysexData));
+            expect (array[3].isNoteOn() && array[3].getNoteNumber() == 1);
+        }
+
+        beginTest ("Sorting merged runs of MidiMessageArray");
+        {
+            juce::Random r (42);
+            tracktion_engine::MidiMessageArray array;
+            array.reserve (1000);
+            juce::uint32 index = 0;
+
+            // Four sources each adding their messages in order, with plenty of equal times.
+            // The source IDs are used to record the order they were added in.
+            for (int source = 0; source < 4; ++source)
+            {
+                double time = 0.0;
+
+                for (int i = 0; i < 250; ++i)
+                {
+                    time += r.nextInt (3) * 0.001;
+                    array.addMidiMessage (juce::MidiMessage::noteOn (1, 60, 1.0f).withTimeStamp (time), ++index);
+                }
+            }
+
+            array.sortByTimestamp();
+            expectEquals (array.size(), 1000);
+            expect (isSortedAndStable (array));
+
+            // And the worst case of every message being its own run
+            tracktion_engine::MidiMessageArray reversed;
+
+            for (int i = 0; i < 100; ++i)
+                reversed.addMidiMessage (juce::MidiMessage::noteOn (1, 60, 1.0f).withTimeStamp ((100 - i) * 0.001), (juce::uint32) i);
+
+            reversed.sortByTimestamp();
+            expectEquals (reversed.size(), 100);
+            expect (isSortedAndStable (reversed));
+        }
+    }
+
+    static bool isSortedAndStable (const tracktion_engine::MidiMessageArray& array)
+    {
+        for (int i = 1; i < array.size(); ++i)
+        {
+            auto previousTime = array[i - 1].getTimeStamp(), time = array[i].getTimeStamp();
+
+            if (time < previousTime || (time == previousTime && array[i].mpeSourceID < array[i - 1].mpeSourceID))
+                return false;
+        }
+
+        return true;
+    }
+
+    void runConversionTests()
+    {
+        beginTest ("Conversion");
+        {
+            const double sampleRate = 44100.0;
+            juce::MidiBuffer midiBuffer;
+            midiBuffer.addEvent (juce::MidiMessage::noteOn (1, 60, 1.0f), 0);
+            midiBuffer.addEvent (juce::MidiMessage::allNotesOff (1), 441);
+
+            MidiEventBuffer buffer;
+            buffer.addFromMidiBuffer (midiBuffer, sampleRate, 0);
+            expectEquals (buffer.size(), 2);
+            expectWithinAbsoluteError (buffer[1].timestamp, 0.01, 0.000001);
+
+            tracktion_engine::MidiMessageArray array;
+            buffer.addToMidiMessageArray (array);
+            expectEquals (array.size(), 2);
+            expect (array[0].isNoteOn());
+
+            MidiEventBuffer roundTripped;
+            roundTripped.addFromMidiMessageArray (array);
+
+            juce::MidiBuffer dest;
+            roundTripped.addToMidiBuffer (dest, sampleRate, 512);
+            expectEquals (dest.getNumEvents(), 2);
+            expectEquals (dest.getLastEventTime(), 441);
+        }
+    }
+};
+
+static MidiEventBufferTests midiEventBufferTests;
+
+}
@@ -0,0 +1,408 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+
+namespace tracktion_graph
+{
+
+//==============================================================================
+//==============================================================================
+class MidiMessageFifoTests : public juce::UnitTest
+{
+public:
+    MidiMessageFifoTests()
+        : juce::UnitTest ("MidiMessageFifo", "tracktion_graph")
+    {
+    }
+
+    void runTest() override
+    {
+        runOrderingTests();
+        runBlockPlacementTests();
+        runThreadedTests();
+    }
+
+private:
+    using MidiMessageFifo = tracktion_engine::MidiMessageFifo;
+
+    //==============================================================================
+    void runOrderingTests()
+    {
+        beginTest ("Short and long messages");
+        {
+            MidiMessageFifo fifo (8, 32);
+            const juce::uint8 sysexData[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a };
+            const auto sysex = juce::MidiMessage::createSysExMessage (sysexData, (int) sizeof (sysexData));
+
+            // Pushing the sysex a few times makes it wrap around the end of the byte ring
+            for (int i = 0; i < 4; ++i)
+            {
+                expect (fifo.push (juce::MidiMessage::noteOn (1, 60 + i, 1.0f).withTimeStamp (i)));
+                expect (fifo.push (sysex.withTimeStamp (i)));
+
+                juce::Array<juce::MidiMessage> popped;
+                fifo.popAll ([&] (const juce::uint8* data, int numBytes, double timestamp)
+                {
+                    popped.add (juce::MidiMessage (data, numBytes, timestamp));
+                });
+
+                expectEquals (popped.size(), 2);
+                expectEquals (popped[0].getNoteNumber(), 60 + i);
+                expect (popped[1].isSysEx());
+                expectEquals (popped[1].getSysExDataSize(), (int) sizeof (sysexData));
+                expect (std::equal (sysexData, sysexData + sizeof (sysexData), popped[1].getSysExData()));
+                expectEquals (popped[1].getTimeStamp(), (double) i);
+            }
+        }
+
+        beginTest ("Full fifo drops messages");
+        {
+            MidiMessageFifo fifo (4, 16);
+
+            for (int i = 0; i < 4; ++i)
+                expect (fifo.push (juce::MidiMessage::noteOn (1, 60, 1.0f)));
+
+            expect (! fifo.push (juce::MidiMessage::noteOn (1, 60, 1.0f)));
+            expectEquals (fifo.getNumReady(), 4);
+            expectEquals (fifo.getNumDropped(), 1);
+
+            fifo.discardAll();
+            const juce::uint8 sysexData[20] = {};
+            expect (! fifo.push (juce::MidiMessage::createSysExMessage (sysexData, (int) sizeof (sysexData))));
+            expectEquals (fifo.getNumReady(), 0);
+            expectEquals (fifo.getNumDropped(), 2);
+        }
+
+        beginTest ("Popping stops at the first late message");
+        {
+            MidiMessageFifo fifo;
+
+            for (double time : { 0.1, 0.2, 0.5, 0.3 })
+                fifo.push (juce::MidiMessage::noteOn (1, 60, 1.0f).withTimeStamp (time));
+
+            expectEquals (fifo.popUntil (0.4, [] (const juce::uint8*, int, double) {}), 2);
+            expectEquals (fifo.getNumReady(), 2);
+            expectEquals (fifo.popUntil (1.0, [] (const juce::uint8*, int, double) {}), 2);
+        }
+    }
+
+    void runBlockPlacementTests()
+    {
+        beginTest ("Messages keep their positions one block later");
+        {
+            MidiMessageFifo fifo;
+            const double blockLength = 0.01;
+
+            // The previous block started at 1.0 so these arrived during it, apart from the
+            // last one which arrived after this block started at 1.01
+            for (double time : { 1.0, 1.002, 1.0095, 1.011 })
+                fifo.push (juce::MidiMessage::noteOn (1, 60, 1.0f).withTimeStamp (time));
+
+            juce::Array<double> times;
+            auto addTime = [&] (const juce::uint8*, int, double timeInBlock) { times.add (timeInBlock); };
+
+            expectEquals (fifo.popPreviousBlock (1.01, blockLength, addTime), 3);
+            expectWithinAbsoluteError (times[0], 0.0, 1.0e-9);
+            expectWithinAbsoluteError (times[1], 0.002, 1.0e-9);
+            expectWithinAbsoluteError (times[2], 0.0095, 1.0e-9);
+
+            times.clear();
+            expectEquals (fifo.popPreviousBlock (1.02, blockLength, addTime), 1);
+            expectWithinAbsoluteError (times[0], 0.001, 1.0e-9);
+        }
+
+        beginTest ("Stale and bad timestamps");
+        {
+            MidiMessageFifo fifo;
+            fifo.push (juce::MidiMessage::noteOn (1, 60, 1.0f).withTimeStamp (0.5));
+            fifo.push (juce::MidiMessage::noteOn (1, 60, 1.0f).withTimeStamp (100.0));
+
+            juce::Array<double> times;
+            fifo.popPreviousBlock (1.0, 0.01, [&] (const juce::uint8*, int, double timeInBlock) { times.add (timeInBlock); });
+
+            expectEquals (times.size(), 2);
+            expectEquals (times[0], 0.0);
+            expectEquals (times[1], 0.0);
+        }
+    }
+
+    void runThreadedTests()
+    {
+        beginTest ("Messages arrive in order across threads");
+        {
+            MidiMessageFifo fifo (64, 256);
+            const int numMessages = 100000;
+            std::atomic<bool> producerFinished { false };
+
+            std::thread producer ([&]
+            {
+                for (int i = 0; i < numMessages;)
+                {
+                    if (fifo.push (juce::MidiMessage::controllerEvent (1, (i >> 7) & 0x7f, i & 0x7f).withTimeStamp (i)))
+                        ++i;
+                    else
+                        std::this_thread::yield();
+                }
+
+                producerFinished = true;
+            });
+
+            int numReceived = 0;
+            bool allInOrder = true;
+
+            auto checkMessage = [&] (const juce::uint8* data, int numBytes, double timestamp)
+            {
+                allInOrder = allInOrder && numBytes == 3
+                               && (int) timestamp == numReceived
+                               && ((data[1] << 7) | data[2]) == (numReceived & 0x3fff);
+                ++numReceived;
+            };
+
+            while (! producerFinished)
+                fifo.popAll (checkMessage);
+
+            producer.join();
+            fifo.popAll (checkMessage);
+
+            expectEquals (numReceived, numMessages);
+            expect (allInOrder);
+        }
+    }
+};
+
+static MidiMessageFifoTests midiMessageFifoTests;
+
+
+//==============================================================================
+//==============================================================================
+/**
+    Measures how many messages per second can be passed between threads and how
+    long they take to get from a MIDI thread to their place in an audio block.
+    These are in the performance category as they take a while to run.
+
+    Throughput is compared with a CriticalSection guarded array, which is how
+    messages used to be passed to the audio thread.
+*/
+class MidiMessageFifoPerformanceTests : public juce::UnitTest
+{
+public:
+    MidiMessageFifoPerformanceTests()
+        : juce::UnitTest ("MidiMessageFifo Performance", "tracktion_graph_performance")
+    {
+    }
+
+    void runTest() override
+    {
+        juce::Array<juce::var> results;
+
+        beginTest ("Throughput");
+        {
+            const auto fifoEventsPerSecond = measureThroughput<FifoQueue>();
+            const auto lockedEventsPerSecond = measureThroughput<LockedQueue>();
+            expectGreaterThan (fifoEventsPerSecond, 0.0);
+            expectGreaterThan (lockedEventsPerSecond, 0.0);
+
+            results.add (juce::var (createResult ("MidiMessageFifo throughput", "eventsPerSecond", fifoEventsPerSecond)));
+            results.add (juce::var (createResult ("Locked array throughput", "eventsPerSecond", lockedEventsPerSecond)));
+        }
+
+        beginTest ("End-to-end latency");
+        {
+            for (int blockSize : { 64, 256, 1024 })
+            {
+                auto latencies = measureLatency (blockSize);
+                expect (! latencies.empty());
+
+                const auto blockLengthUs = blockSize * 1.0e6 / sampleRate;
+                auto o = createResult ("Latency", "blockSize", blockSize);
+                o->setProperty ("blockUs", blockLengthUs);
+                o->setProperty ("latencyUsP50", getPercentile (latencies, 0.5));
+                o->setProperty ("latencyUsP99", getPercentile (latencies, 0.99));
+                o->setProperty ("latencyUsMax", latencies.back());
+                o->setProperty ("jitterUs", latencies.back() - latencies.front());
+                results.add (juce::var (o));
+
+                // Messages should be heard one block after they arrive, give or take how late
+                // the simulated callbacks wake up
+                expectWithinAbsoluteError (getPercentile (latencies, 0.5), blockLengthUs, blockLengthUs * 0.5);
+            }
+        }
+
+        logMessage (juce::JSON::toString (juce::var (results)));
+    }
+
+private:
+    static constexpr double sampleRate = 44100.0;
+
+    //==============================================================================
+    struct FifoQueue
+    {
+        tracktion_engine::MidiMessageFifo fifo { 4096, 1024 };
+
+        bool push (const juce::MidiMessage& m)                  { return fifo.push (m); }
+        template<typename Callback> int popAll (Callback&& c)   { return fifo.popAll (c); }
+    };
+
+    struct LockedQueue
+    {
+        LockedQueue()
+        {
+            for (int i = 4096; --i >= 0;)
+                messages.add (new juce::MidiMessage (0x80, 0, 0));
+        }
+
+        bool push (const juce::MidiMessage& m)
+        {
+            const juce::ScopedLock sl (lock);
+
+            if (numMessages >= messages.size())
+                return false;
+
+            *messages.getUnchecked (numMessages++) = m;
+            return true;
+        }
+
+        template<typename Callback>
+        int popAll (Callback&& callback)
+        {
+            const juce::ScopedLock sl (lock);
+
+            for (int i = 0; i < numMessages; ++i)
+            {
+                auto& m = *messages.getUnchecked (i);
+                callback (m.getRawData(), m.getRawDataSize(), m.getTimeStamp());
+            }
+
+            return std::exchange (numMessages, 0);
+        }
+
+        juce::CriticalSection lock;
+        juce::OwnedArray<juce::MidiMessage> messages;
+        int numMessages = 0;
+    };
+
+    //==============================================================================
+    template<typename QueueType>
+    static double measureThroughput()
+    {
+        using Clock = std::chrono::high_resolution_clock;
+        const int numMessages = 2000000;
+
+        QueueType queue;
+        std::atomic<bool> producerFinished { false };
+        int numReceived = 0;
+        auto countMessage = [&numReceived] (const juce::uint8*, int, double) { ++numReceived; };
+
+        const auto start = Clock::now();
+
+        std::thread producer ([&]
+        {
+            const auto message = juce::MidiMessage::noteOn (1, 60, 1.0f);
+
+            for (int i = 0; i < numMessages;)
+            {
+                if (queue.push (message))
+                    ++i;
+                else
+                    std::this_thread::yield();
+            }
+
+            producerFinished = true;
+        });
+
+        while (! producerFinished)
+            queue.popAll (countMessage);
+
+        producer.join();
+        queue.popAll (countMessage);
+
+        const auto seconds = std::chrono::duration<double> (Clock::now() - start).count();
+        jassert (numReceived == numMessages);
+
+        return seconds > 0.0 ? numReceived / seconds : 0.0;
+    }
+
+    /** Pushes messages from one thread, timestamped on arrival, while another simulates audio
+        callbacks that place them in blocks the same way MidiInputDevice does.
+        Returns the sorted times between each message arriving and the point in the output
+        where it would be heard, in microseconds.
+    */
+    static std::vector<double> measureLatency (int blockSize)
+    {
+        const double blockLength = blockSize / sampleRate;
+        const double durationInSeconds = 2.0;
+        const double messageInterval = 0.0005;
+
+        auto getTime = [] { return juce::Time::getMillisecondCounterHiRes() * 0.001; };
+
+        // Each message holds its index so the consumer can look up when it was pushed
+        const int maxNumMessages = 0x3fff;
+        std::vector<double> pushTimes ((size_t) maxNumMessages);
+        std::vector<double> latencies;
+        latencies.reserve ((size_t) maxNumMessages);
+
+        tracktion_engine::MidiMessageFifo fifo;
+        std::atomic<bool> finished { false };
+
+        std::thread producer ([&]
+        {
+            auto nextTime = getTime();
+
+            for (int i = 0; i < maxNumMessages && ! finished; ++i, nextTime += messageInterval)
+            {
+                while (getTime() < nextTime)
+                    std::this_thread::yield();
+
+                pushTimes[(size_t) i] = getTime();
+                fifo.push (juce::MidiMessage::controllerEvent (1, i >> 7, i & 0x7f).withTimeStamp (pushTimes[(size_t) i]));
+            }
+        });
+
+        const auto startTime = getTime();
+
+        for (auto blockStart = startTime; blockStart < startTime + durationInSeconds; blockStart += blockLength)
+        {
+            while (getTime() < blockStart)
+                std::this_thread::yield();
+
+            // As the callback may wake up late, the block is heard from when it actually started
+            const auto callbackTime = getTime();
+
+            fifo.popPreviousBlock (callbackTime, blockLength, [&] (const juce::uint8* data, int, double timeInBlock)
+            {
+                const auto pushTime = pushTimes[(size_t) ((data[1] << 7) | data[2])];
+                latencies.push_back ((callbackTime + timeInBlock - pushTime) * 1.0e6);
+            });
+        }
+
+        finished = true;
+        producer.join();
+
+        std::sort (latencies.begin(), latencies.end());
+        return latencies;
+    }
+
+    static double getPercentile (const std::vector<double>& sorted, double percentile)
+    {
+        return sorted[std::min (sorted.size() - 1, (size_t) (percentile * (double) sorted.size()))];
+    }
+
+    static juce::DynamicObject* createResult (const juce::String& name, const juce::String& property, juce::var value)
+    {
+        auto o = new juce::DynamicObject();
+        o->setProperty ("name", name);
+        o->setProperty (property, value);
+        return o;
+    }
+};
+
+static MidiMessageFifoPerformanceTests midiMessageFifoPerformanceTests;
+
+}
@@ -49,7 +49,12 @@ public:
             // Tests rebuilding the graph mid render
             runRebuildTests (setup);
             runCycleTests (setup);
+
+            // Tests the multi-threaded scheduling
+            runMultiThreadedTests (setup);
         }
+
+        runProfilerTests();
     }
 
 private:
@@ -644,6 +649,78 @@ private:
             expectAudioBuffer (*this, testContext->buffer, 0, 1.0f, 0.707f);
         }
     }
+
+    void runMultiThreadedTests (TestSetup testSetup)
+    {
+        beginTest ("Multi-threaded uneven branches");
+        {
+            // One long chain that should be prioritised, one short chain that cancels it
+            // out and some cheap branches that contribute nothing
+            auto longChain = makeNode<SinNode> (220.0f, 1);
+
+            for (int i = 0; i < 16; ++i)
+                longChain = makeGainNode (std::move (longChain), 1.0f);
+
+            auto shortChain = makeGainNode (makeNode<SinNode> (220.0f, 1), -1.0f);
+
+            std::vector<std::unique_ptr<Node>> nodes;
+            nodes.push_back (std::move (longChain));
+            nodes.push_back (std::move (shortChain));
+
+            for (int i = 0; i < 8; ++i)
+                nodes.push_back (makeGainNode (makeNode<SinNode> (440.0f, 1), 0.0f));
+
+            auto sumNode = std::make_unique<BasicSummingNode> (std::move (nodes));
+            auto player = std::make_unique<MultiThreadedNodePlayer> (std::move (sumNode));
+
+            auto testContext = createTestContext (std::move (player), testSetup, 1, 5.0);
+            test_utilities::expectAudioBuffer (*this, testContext->buffer, 0, 0.0f, 0.0f);
+        }
+    }
+
+    void runProfilerTests()
+    {
+        beginTest ("Profiling");
+        {
+            auto node = makeSummingNode ({ makeGainNode (makeNode<SinNode> (220.0f, 1), 0.5f).release(),
+                                           makeNode<SinNode> (440.0f, 1).release() });
+            auto rootNode = node.get();
+
+            tracktion_engine::NodeProfiler profiler;
+            NodePlayer player (std::move (node));
+            player.setProfiler (&profiler);
+            player.prepareToPlay (44100.0, 512);
+
+            const int numBlocks = 100;
+            juce::AudioBuffer<float> buffer (1, 512);
+            tracktion_engine::MidiMessageArray midi;
+
+            for (int i = 0; i < numBlocks; ++i)
+                player.process ({ juce::Range<int64_t>::withStartAndLength ((int64_t) (i * 512), (int64_t) 512),
+                                  { { buffer }, midi } });
+
+            auto stats = profiler.getStats();
+            expectEquals ((int) stats.numBlocks, numBlocks);
+            expectEquals ((int) stats.nodes.size(), (int) getNodes (*rootNode, VertexOrdering::postordering).size());
+            expectEquals ((int) stats.threads.size(), 1);
+            expectEquals ((int) stats.numDroppedEvents, 0);
+
+            for (auto& n : stats.nodes)
+            {
+                expectEquals ((int) n.numBlocksProcessed, numBlocks);
+                // A single slow block can pull the mean above the 99th percentile so only the max bounds both
+                expect (n.meanMs <= n.maxMs && n.p99Ms <= n.maxMs);
+            }
+
+            // The critical path ends at the summing node and goes through one of the sins
+            expect (stats.criticalPath.size() >= 2);
+            expect (stats.criticalPath.front() == rootNode);
+            expect (stats.criticalPathMs <= stats.maxBlockMs);
+
+            profiler.reset();
+            expectEquals ((int) profiler.getStats().numBlocks, 0);
+        }
+    }
 };
 
 static NodeTests NodeTests;
@@ -0,0 +1,113 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+
+namespace tracktion_graph
+{
+
+using namespace benchmark_utilities;
+
+//==============================================================================
+//==============================================================================
+/**
+    Measures how fast different shapes of graph are processed by each player.
+    These are in their own category as they take a while to run.
+
+    The results are logged as JSON and, if the TRACKTION_GRAPH_BENCHMARK_FILE
+    environment variable is set, written to that file so they can be compared
+    between builds.
+*/
+class PerformanceTests : public juce::UnitTest
+{
+public:
+    PerformanceTests()
+        : juce::UnitTest ("Performance", "tracktion_graph_performance")
+    {
+    }
+    
+    void runTest() override
+    {
+        std::vector<Result> results;
+
+        for (auto shape : getGraphShapes())
+        {
+            beginTest ("Graph " + shape.getDescription());
+
+            auto singleThreadedResult = measureNodePlayer (shape, sampleRate, blockSize, durationInSeconds);
+            // The nodes are processed in postorder so should all be ready on the first pass
+            expectEquals ((int) singleThreadedResult.numMisses, 0, "NodePlayer had to check nodes more than once");
+            results.push_back (singleThreadedResult);
+
+            for (auto numThreads : getThreadCounts())
+                results.push_back (measureMultiThreadedNodePlayer (shape, numThreads, sampleRate, blockSize, durationInSeconds));
+        }
+
+        for (auto& r : results)
+            expectGreaterThan (r.nsPerNode, 0.0);
+
+        const auto json = toJSON (results);
+        logMessage (json);
+
+        auto outputPath = juce::SystemStats::getEnvironmentVariable ("TRACKTION_GRAPH_BENCHMARK_FILE", {});
+
+        if (outputPath.isNotEmpty())
+            expect (juce::File (outputPath).replaceWithText (json), "Unable to write benchmark results");
+    }
+
+private:
+    static constexpr double sampleRate = 44100.0;
+    static constexpr int blockSize = 256;
+    static constexpr double durationInSeconds = 5.0;
+
+    static std::vector<GraphShape> getGraphShapes()
+    {
+        std::vector<GraphShape> shapes;
+
+        for (int numTracks : { 8, 64, 256 })
+        {
+            for (int numNodesPerTrack : { 1, 8 })
+            {
+                GraphShape shape;
+                shape.numTracks = numTracks;
+                shape.numNodesPerTrack = numNodesPerTrack;
+                shapes.push_back (shape);
+            }
+        }
+
+        GraphShape sends;
+        sends.numTracks = 64;
+        sends.addSendsAndReturns = true;
+        shapes.push_back (sends);
+
+        GraphShape latency;
+        latency.numTracks = 64;
+        latency.addLatency = true;
+        shapes.push_back (latency);
+
+        return shapes;
+    }
+
+    static std::vector<size_t> getThreadCounts()
+    {
+        std::vector<size_t> threadCounts;
+        const auto numCores = (size_t) std::max (1u, std::thread::hardware_concurrency());
+
+        for (size_t numThreads = 1; numThreads < numCores; numThreads *= 2)
+            threadCounts.push_back (numThreads);
+
+        threadCounts.push_back (numCores);
+
+        return threadCounts;
+    }
+};
+
+static PerformanceTests performanceTests;
+
+}
@@ -0,0 +1,359 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+#pragma once
+
+namespace tracktion_engine
+{
+
+/**
+    A compact buffer of timestamped MIDI events, intended to be cleared and refilled
+    every block.
+
+    Unlike MidiMessageArray, which holds a juce::MidiMessage per event, each event here
+    is a 16 byte POD holding the timestamp, MPE source ID and up to 3 bytes of data.
+    Anything longer, such as sysex, is copied in to an arena owned by the buffer and
+    the event refers to it. Clearing the buffer keeps all of its storage, so once it
+    has grown to fit a block, filling, merging and copying it never allocate.
+
+    Events can be combined with mergeSorted, which does a stable k-way merge of buffers
+    that are already in time order, and converted to and from juce::MidiBuffer and
+    MidiMessageArray.
+
+    At the moment this is only used to collect live MIDI input for a block. The buffers
+    passed between Nodes and AudioNodes are still MidiMessageArrays.
+*/
+class MidiEventBuffer
+{
+public:
+    using MPESourceID = MidiMessageArray::MPESourceID;
+
+    /** A single event in the buffer. */
+    struct Event
+    {
+        double timestamp;
+        MPESourceID mpeSourceID;
+
+        /** The message bytes, or for long messages, the offset of them in the arena. */
+        juce::uint8 data[3];
+
+        /** The number of bytes in data, or 0 for a long message. */
+        juce::uint8 numBytes;
+
+        bool isLongMessage() const noexcept     { return numBytes == 0; }
+    };
+
+    static_assert (sizeof (Event) == 16, "Events should be kept small so more fit in the cache");
+    static_assert (std::is_trivially_copyable<Event>::value, "Events must be trivially copyable");
+
+    MidiEventBuffer() = default;
+    MidiEventBuffer (const MidiEventBuffer&) = default;
+    MidiEventBuffer (MidiEventBuffer&&) = default;
+    MidiEventBuffer& operator= (const MidiEventBuffer&) = default;
+    MidiEventBuffer& operator= (MidiEventBuffer&&) = default;
+
+    //==============================================================================
+    bool isEmpty() const noexcept                   { return events.empty(); }
+    bool isNotEmpty() const noexcept                { return ! events.empty(); }
+    int size() const noexcept                       { return (int) events.size(); }
+
+    const Event& operator[] (int i) const noexcept  { return events[(size_t) i]; }
+    const Event* begin() const noexcept             { return events.data(); }
+    const Event* end() const noexcept               { return events.data() + events.size(); }
+
+    /** Removes all the events but keeps the storage allocated. */
+    void clear() noexcept
+    {
+        isAllNotesOff = false;
+        events.clear();
+        arena.clear();
+    }
+
+    /** Makes sure the buffer can hold this many events and bytes of long messages without allocating. */
+    void reserve (int numEvents, int numLongMessageBytes = 0)
+    {
+        events.reserve ((size_t) numEvents);
+        arena.reserve ((size_t) numLongMessageBytes);
+    }
+
+    void swapWith (MidiEventBuffer& other) noexcept
+    {
+        std::swap (isAllNotesOff, other.isAllNotesOff);
+        events.swap (other.events);
+        arena.swap (other.arena);
+    }
+
+    //==============================================================================
+    /** Adds an event with the given raw MIDI data, which is copied. */
+    void add (const juce::uint8* data, int numBytes, double timestamp, MPESourceID mpeSourceID)
+    {
+        jassert (numBytes > 0);
+
+        Event e;
+        e.timestamp = timestamp;
+        e.mpeSourceID = mpeSourceID;
+
+        if (numBytes <= 3)
+        {
+            e.numBytes = (juce::uint8) numBytes;
+            std::fill (std::begin (e.data), std::end (e.data), (juce::uint8) 0);
+            std::copy (data, data + numBytes, e.data);
+        }
+        else
+        {
+            e.numBytes = 0;
+            setArenaOffset (e, appendToArena (data, numBytes));
+        }
+
+        events.push_back (e);
+    }
+
+    /** Adds a message, using its timestamp. */
+    void add (const juce::MidiMessage& m, MPESourceID mpeSourceID)
+    {
+        add (m.getRawData(), m.getRawDataSize(), m.getTimeStamp(), mpeSourceID);
+    }
+
+    /** Adds an event from another buffer, copying any long message data it refers to. */
+    void add (const Event& e, const MidiEventBuffer& source)
+    {
+        if (! e.isLongMessage())
+            events.push_back (e);
+        else
+            add (source.getRawData (e), source.getRawDataSize (e), e.timestamp, e.mpeSourceID);
+    }
+
+    //==============================================================================
+    /** Returns a pointer to the bytes of an event in this buffer. */
+    const juce::uint8* getRawData (const Event& e) const noexcept
+    {
+        if (! e.isLongMessage())
+            return e.data;
+
+        return arena.data() + getArenaOffset (e) + sizeof (juce::uint32);
+    }
+
+    /** Returns the number of bytes in an event in this buffer. */
+    int getRawDataSize (const Event& e) const noexcept
+    {
+        if (! e.isLongMessage())
+            return e.numBytes;
+
+        juce::uint32 numBytes;
+        std::memcpy (&numBytes, arena.data() + getArenaOffset (e), sizeof (numBytes));
+        return (int) numBytes;
+    }
+
+    /** Creates a juce::MidiMessage for an event. This may allocate for long messages. */
+    juce::MidiMessage getMessage (const Event& e) const
+    {
+        return juce::MidiMessage (getRawData (e), getRawDataSize (e), e.timestamp);
+    }
+
+    //==============================================================================
+    void addToTimestamps (double delta) noexcept
+    {
+        for (auto& e : events)
+            e.timestamp += delta;
+    }
+
+    /** Returns true if the events are in time order. */
+    bool isSorted() const noexcept
+    {
+        return std::is_sorted (events.begin(), events.end(),
+                               [] (const Event& a, const Event& b) { return a.timestamp < b.timestamp; });
+    }
+
+    /** Sorts the events by time, keeping events with the same time in the order they were added.
+        This is an insertion sort so it doesn't allocate, but it's intended for buffers which are
+        nearly in order already. To combine buffers, use mergeSorted instead.
+    */
+    void sortByTimestamp() noexcept
+    {
+        for (size_t i = 1; i < events.size(); ++i)
+        {
+            auto e = events[i];
+            auto j = i;
+
+            for (; j > 0 && e.timestamp < events[j - 1].timestamp; --j)
+                events[j] = events[j - 1];
+
+            events[j] = e;
+        }
+    }
+
+    /** Appends all the events from another buffer. */
+    void mergeFrom (const MidiEventBuffer& source)
+    {
+        jassert (&source != this);
+        isAllNotesOff = isAllNotesOff || source.isAllNotesOff;
+
+        if (source.arena.empty())
+        {
+            events.insert (events.end(), source.events.begin(), source.events.end());
+            return;
+        }
+
+        for (auto& e : source.events)
+            add (e, source);
+    }
+
+    /** Replaces the contents of this buffer with the events from a number of other
+        buffers, merged in time order.
+
+        Each of the sources must already be sorted. The merge is stable, so events with
+        the same time keep the order they had in their source, and events from earlier
+        sources come before those from later ones.
+    */
+    void mergeSorted (const MidiEventBuffer* const* sources, int numSources)
+    {
+        clear();
+
+        size_t totalNumEvents = 0, totalArenaSize = 0;
+        mergeHeap.clear();
+
+        for (int i = 0; i < numSources; ++i)
+        {
+            auto& source = *sources[i];
+            jassert (&source != this);
+            jassert (source.isSorted());
+
+            isAllNotesOff = isAllNotesOff || source.isAllNotesOff;
+            totalNumEvents += source.events.size();
+            totalArenaSize += source.arena.size();
+
+            if (source.isNotEmpty())
+                mergeHeap.push_back ({ source.events[0].timestamp, i, 0 });
+        }
+
+        events.reserve (totalNumEvents);
+        arena.reserve (totalArenaSize);
+
+        // The heap yields the earliest event next, with ties going to the earliest source
+        auto isLater = [] (const MergePosition& a, const MergePosition& b)
+        {
+            return a.timestamp > b.timestamp || (a.timestamp == b.timestamp && a.sourceIndex > b.sourceIndex);
+        };
+
+        std::make_heap (mergeHeap.begin(), mergeHeap.end(), isLater);
+
+        while (! mergeHeap.empty())
+        {
+            std::pop_heap (mergeHeap.begin(), mergeHeap.end(), isLater);
+            auto& next = mergeHeap.back();
+            auto& source = *sources[next.sourceIndex];
+
+            add (source.events[(size_t) next.eventIndex], source);
+
+            if (++next.eventIndex < source.size())
+            {
+                next.timestamp = source.events[(size_t) next.eventIndex].timestamp;
+                std::push_heap (mergeHeap.begin(), mergeHeap.end(), isLater);
+            }
+            else
+            {
+                mergeHeap.pop_back();
+            }
+        }
+    }
+
+    //==============================================================================
+    /** Adds the events to a juce::MidiBuffer, converting the timestamps in seconds
+        to sample positions within a block of the given length.
+    */
+    void addToMidiBuffer (juce::MidiBuffer& dest, double sampleRate, int numSamples) const
+    {
+        for (auto& e : events)
+        {
+            const int samplePosition = juce::jlimit (0, std::max (0, numSamples - 1),
+                                                     juce::roundToInt (e.timestamp * sampleRate));
+            dest.addEvent (getRawData (e), getRawDataSize (e), samplePosition);
+        }
+    }
+
+    /** Adds the events from a juce::MidiBuffer, converting their sample positions to
+        timestamps in seconds.
+    */
+    void addFromMidiBuffer (const juce::MidiBuffer& source, double sampleRate, MPESourceID mpeSourceID)
+    {
+        jassert (sampleRate > 0.0);
+
+        const juce::uint8* data;
+        int numBytes, samplePosition;
+
+        for (juce::MidiBuffer::Iterator iter (source); iter.getNextEvent (data, numBytes, samplePosition);)
+            add (data, numBytes, samplePosition / sampleRate, mpeSourceID);
+    }
+
+    /** Appends the events to a MidiMessageArray. */
+    void addToMidiMessageArray (MidiMessageArray& dest) const
+    {
+        dest.isAllNotesOff = dest.isAllNotesOff || isAllNotesOff;
+        dest.reserve (dest.size() + size());
+
+        for (auto& e : events)
+            dest.addMidiMessage (getMessage (e), e.mpeSourceID);
+    }
+
+    /** Appends the events in a MidiMessageArray. */
+    void addFromMidiMessageArray (const MidiMessageArray& source)
+    {
+        isAllNotesOff = isAllNotesOff || source.isAllNotesOff;
+        events.reserve (events.size() + (size_t) source.size());
+
+        for (auto& m : source)
+            add (m, m.mpeSourceID);
+    }
+
+    bool isAllNotesOff = false;
+
+private:
+    //==============================================================================
+    struct MergePosition
+    {
+        double timestamp;
+        int sourceIndex, eventIndex;
+    };
+
+    std::vector<Event> events;
+    std::vector<juce::uint8> arena;
+    std::vector<MergePosition> mergeHeap;
+
+    // Long messages are stored in the arena as a 32-bit size followed by the bytes,
+    // and the event's data holds the 24-bit offset of the size
+    juce::uint32 appendToArena (const juce::uint8* data, int numBytes)
+    {
+        const auto offset = (juce::uint32) arena.size();
+        jassert (offset < (1u << 24));
+
+        const auto size = (juce::uint32) numBytes;
+        auto sizeBytes = reinterpret_cast<const juce::uint8*> (&size);
+        arena.insert (arena.end(), sizeBytes, sizeBytes + sizeof (size));
+        arena.insert (arena.end(), data, data + numBytes);
+
+        return offset;
+    }
+
+    static void setArenaOffset (Event& e, juce::uint32 offset) noexcept
+    {
+        e.data[0] = (juce::uint8) (offset & 0xff);
+        e.data[1] = (juce::uint8) ((offset >> 8) & 0xff);
+        e.data[2] = (juce::uint8) ((offset >> 16) & 0xff);
+    }
+
+    static juce::uint32 getArenaOffset (const Event& e) noexcept
+    {
+        return (juce::uint32) e.data[0]
+                | ((juce::uint32) e.data[1] << 8)
+                | ((juce::uint32) e.data[2] << 16);
+    }
+};
+
+} // namespace tracktion_engine
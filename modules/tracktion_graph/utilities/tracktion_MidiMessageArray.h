@@ -235,21 +235,68 @@ struct MidiMessageArray
             m.multiplyVelocity (factor);
     }
 
+    /** Sorts the messages by time, keeping messages with the same time in the order they were added.
+        This merges the runs that are already in order, which is usually one run per source that
+        was merged in, so it's O(n log n) at worst and O(n) for an array that's already sorted.
+        The messages are moved between this and a scratch array, so once reserve() has been called
+        with a big enough size it won't allocate.
+    */
     void sortByTimestamp()
     {
-        std::sort (messages.begin(), messages.end(),
-                   [] (const juce::MidiMessage& a, const juce::MidiMessage& b) { return a.getTimeStamp() < b.getTimeStamp(); });
+        const int numMessages = messages.size();
+
+        while (findEndOfSortedRun (0) < numMessages)
+        {
+            sortingBuffer.clearQuick();
+            sortingBuffer.ensureStorageAllocated (numMessages);
+
+            auto data = messages.begin();
+
+            for (int start = 0; start < numMessages;)
+            {
+                const int middle = findEndOfSortedRun (start);
+                const int end = middle < numMessages ? findEndOfSortedRun (middle) : numMessages;
+                int left = start, right = middle;
+
+                // Taking from the left run when the times are equal keeps the sort stable
+                while (left < middle && right < end)
+                    sortingBuffer.add (std::move (data[right].getTimeStamp() < data[left].getTimeStamp() ? data[right++]
+                                                                                                        : data[left++]));
+
+                while (left < middle)   sortingBuffer.add (std::move (data[left++]));
+                while (right < end)     sortingBuffer.add (std::move (data[right++]));
+
+                start = end;
+            }
+
+            messages.swapWith (sortingBuffer);
+        }
+
+        sortingBuffer.clearQuick();
     }
 
     void reserve (int size)
     {
         messages.ensureStorageAllocated (size);
+        sortingBuffer.ensureStorageAllocated (size);
     }
 
     bool isAllNotesOff = false;
 
 private:
-    juce::Array<MidiMessageWithSource> messages;
+    juce::Array<MidiMessageWithSource> messages, sortingBuffer;
+
+    int findEndOfSortedRun (int start) const noexcept
+    {
+        auto data = messages.begin();
+        const int numMessages = messages.size();
+
+        for (int i = start + 1; i < numMessages; ++i)
+            if (data[i].getTimeStamp() < data[i - 1].getTimeStamp())
+                return i;
+
+        return numMessages;
+    }
 };
 
 } // namespace tracktion_engine
@@ -0,0 +1,248 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+#pragma once
+
+namespace tracktion_engine
+{
+
+/**
+    A lock-free, single producer single consumer queue of timestamped MIDI messages.
+
+    This is used to pass live input from a MIDI device's thread to the audio thread.
+    All the storage is allocated up front so neither pushing nor popping allocate or
+    block. Messages of up to 4 bytes are held in the event itself, longer ones such as
+    sysex are copied in to a separate ring of bytes.
+
+    If there's no room for a message it's dropped and counted, rather than waiting for
+    the consumer to catch up.
+*/
+class MidiMessageFifo
+{
+public:
+    MidiMessageFifo (int maxNumEvents = 1024, int maxNumLongMessageBytes = 8192)
+        : eventFifo (maxNumEvents + 1), events ((size_t) maxNumEvents + 1),
+          byteFifo (maxNumLongMessageBytes + 1), bytes ((size_t) maxNumLongMessageBytes + 1),
+          scratch ((size_t) maxNumLongMessageBytes)
+    {
+    }
+
+    /** Empties the queue. This must only be called when neither thread is using it. */
+    void reset() noexcept
+    {
+        eventFifo.reset();
+        byteFifo.reset();
+        numDropped = 0;
+    }
+
+    /** Returns the number of messages waiting to be popped. */
+    int getNumReady() const noexcept                { return eventFifo.getNumReady(); }
+
+    /** Returns the number of messages that have been dropped because the queue was full. */
+    int getNumDropped() const noexcept              { return numDropped.load(); }
+
+    //==============================================================================
+    /** Adds a message to the queue. This must only be called by the producer thread.
+        @returns false if there wasn't room for the message so it was dropped
+    */
+    bool push (const juce::uint8* data, int numBytes, double timestamp) noexcept
+    {
+        jassert (numBytes > 0);
+
+        if (eventFifo.getFreeSpace() < 1)
+            return drop();
+
+        Event e;
+        e.timestamp = timestamp;
+        e.numBytes = (juce::uint32) numBytes;
+
+        if (numBytes <= (int) sizeof (e.data))
+        {
+            std::copy (data, data + numBytes, e.data);
+        }
+        else
+        {
+            int start1, size1, start2, size2;
+            byteFifo.prepareToWrite (numBytes, start1, size1, start2, size2);
+
+            if (size1 + size2 < numBytes)
+                return drop();
+
+            std::copy (data, data + size1, bytes.data() + start1);
+            std::copy (data + size1, data + numBytes, bytes.data() + start2);
+            byteFifo.finishedWrite (numBytes);
+        }
+
+        int start1, size1, start2, size2;
+        eventFifo.prepareToWrite (1, start1, size1, start2, size2);
+        jassert (size1 == 1);
+        events[(size_t) start1] = e;
+        eventFifo.finishedWrite (1);
+
+        return true;
+    }
+
+    /** Adds a message to the queue using its timestamp. */
+    bool push (const juce::MidiMessage& m) noexcept
+    {
+        return push (m.getRawData(), m.getRawDataSize(), m.getTimeStamp());
+    }
+
+    //==============================================================================
+    /** Removes messages from the front of the queue while their timestamps satisfy a
+        predicate, passing each one to a callback. This must only be called by the
+        consumer thread.
+
+        The predicate should have the form (double timestamp) -> bool and the callback
+        (const juce::uint8* data, int numBytes, double timestamp). The data is only valid
+        for the duration of the call.
+        Messages are popped in the order they were pushed so this stops at the first one
+        that fails the predicate, even if others after it would pass.
+
+        @returns the number of messages popped
+    */
+    template<typename Predicate, typename Callback>
+    int popWhile (Predicate&& shouldPop, Callback&& callback)
+    {
+        int numPopped = 0;
+
+        for (;;)
+        {
+            int start1, size1, start2, size2;
+            eventFifo.prepareToRead (1, start1, size1, start2, size2);
+
+            if (size1 == 0)
+                break;
+
+            auto& e = events[(size_t) start1];
+
+            if (! shouldPop (e.timestamp))
+                break;
+
+            if (e.numBytes <= sizeof (e.data))
+                callback (static_cast<const juce::uint8*> (e.data), (int) e.numBytes, e.timestamp);
+            else
+                popLongMessage (e, callback);
+
+            eventFifo.finishedRead (1);
+            ++numPopped;
+        }
+
+        return numPopped;
+    }
+
+    /** Removes the messages at the front of the queue that are timestamped before the
+        given time, passing each one to a callback.
+        @see popWhile
+    */
+    template<typename Callback>
+    int popUntil (double endTime, Callback&& callback)
+    {
+        return popWhile ([endTime] (double timestamp) { return timestamp < endTime; }, callback);
+    }
+
+    /** Removes the messages that arrived during the block before the given time, passing
+        each one to a callback with its time relative to the start of the next block.
+
+        This is for a consumer that pops once per block, where the producer timestamps
+        messages with the time of the most recent block start plus the time since then.
+        Placing the messages at the same offsets in the next block delays them all by
+        exactly one block, rather than bunching them up at the start of it, so the timing
+        between them is kept.
+
+        Messages timestamped after blockStartTime arrived after the block started so are
+        left for the next one, unless they're so far ahead that their times can't be right,
+        in which case they're placed at the start.
+
+        The callback should have the form (const juce::uint8* data, int numBytes, double timeInBlock).
+        @see popWhile
+    */
+    template<typename Callback>
+    int popPreviousBlock (double blockStartTime, double blockLength, Callback&& callback)
+    {
+        const auto previousBlockStart = blockStartTime - blockLength;
+
+        auto isReady = [blockStartTime, blockLength] (double timestamp)
+        {
+            return timestamp < blockStartTime || timestamp >= blockStartTime + blockLength;
+        };
+
+        return popWhile (isReady, [&] (const juce::uint8* data, int numBytes, double timestamp)
+        {
+            callback (data, numBytes, timestamp < blockStartTime ? juce::jlimit (0.0, blockLength, timestamp - previousBlockStart)
+                                                                 : 0.0);
+        });
+    }
+
+    /** Removes all the messages in the queue, passing each one to a callback.
+        @see popWhile
+    */
+    template<typename Callback>
+    int popAll (Callback&& callback)
+    {
+        return popWhile ([] (double) { return true; }, callback);
+    }
+
+    /** Removes all the messages in the queue without looking at them. */
+    int discardAll()
+    {
+        return popAll ([] (const juce::uint8*, int, double) {});
+    }
+
+private:
+    //==============================================================================
+    struct Event
+    {
+        double timestamp;
+        juce::uint32 numBytes;
+        juce::uint8 data[4];
+    };
+
+    static_assert (sizeof (Event) == 16, "Events should be kept small so more fit in the cache");
+
+    juce::AbstractFifo eventFifo;
+    std::vector<Event> events;
+    juce::AbstractFifo byteFifo;
+    std::vector<juce::uint8> bytes, scratch;
+    std::atomic<int> numDropped { 0 };
+
+    bool drop() noexcept
+    {
+        ++numDropped;
+        return false;
+    }
+
+    template<typename Callback>
+    void popLongMessage (const Event& e, Callback& callback)
+    {
+        const int numBytes = (int) e.numBytes;
+        int start1, size1, start2, size2;
+        byteFifo.prepareToRead (numBytes, start1, size1, start2, size2);
+        jassert (size1 + size2 == numBytes);
+
+        if (size2 == 0)
+        {
+            callback (static_cast<const juce::uint8*> (bytes.data() + start1), numBytes, e.timestamp);
+        }
+        else
+        {
+            // The message wraps around the end of the ring so needs to be made contiguous
+            std::copy (bytes.data() + start1, bytes.data() + start1 + size1, scratch.data());
+            std::copy (bytes.data() + start2, bytes.data() + start2 + size2, scratch.data() + size1);
+            callback (static_cast<const juce::uint8*> (scratch.data()), numBytes, e.timestamp);
+        }
+
+        byteFifo.finishedRead (numBytes);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (MidiMessageFifo)
+};
+
+} // namespace tracktion_engine
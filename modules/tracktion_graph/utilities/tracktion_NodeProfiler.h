@@ -0,0 +1,544 @@
+/*
+    ,--.                     ,--.     ,--.  ,--.
+  ,-'  '-.,--.--.,--,--.,---.|  |,-.,-'  '-.`--' ,---. ,--,--,      Copyright 2018
+  '-.  .-'|  .--' ,-.  | .--'|     /'-.  .-',--.| .-. ||      \   Tracktion Software
+    |  |  |  |  \ '-'  \ `--.|  \  \  |  |  |  |' '-' '|  ||  |       Corporation
+    `---' `--'   `--`--'`---'`--'`--' `---' `--' `---' `--''--'    www.tracktion.com
+
+    Tracktion Engine uses a GPL/commercial licence - see LICENCE.md for details.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
+
+#if JUCE_GCC || JUCE_CLANG
+ #include <cxxabi.h>
+#endif
+
+namespace tracktion_engine
+{
+
+//==============================================================================
+/**
+    Records how long each node in a playback graph takes to process and where
+    that time is spent across threads.
+
+    This works with both AudioNode graphs and tracktion_graph players. The audio
+    threads wrap each node's processing in a ScopedNodeTimer which pushes an event
+    in to a lock-free ring. A non-realtime thread then periodically calls getStats()
+    which drains the ring and returns the aggregated timings.
+
+    Times are "self" times, i.e. if timers are nested on the same thread (as they
+    are in AudioNode graphs where nodes pull from their inputs) the time spent in
+    any inner timed nodes is subtracted from the outer node.
+
+    If you supply the graph topology with setGraph(), the stats will also include
+    the critical path, i.e. the longest chain of dependent nodes. This is the lower
+    bound on how long a block can take no matter how many threads process it.
+*/
+class NodeProfiler
+{
+public:
+    /** Creates a profiler.
+        @param maxNumEventsBetweenUpdates   the size of the ring, if more events than
+                                            this are pushed between calls to getStats()
+                                            they will be dropped and counted.
+        @param numBlocksToAnalyse           the number of recent blocks the mean, p99
+                                            and max values are calculated over
+    */
+    NodeProfiler (size_t maxNumEventsBetweenUpdates = 32768, size_t numBlocksToAnalyse = 512)
+        : slots ((size_t) juce::nextPowerOfTwo ((int) maxNumEventsBetweenUpdates)),
+          historySize (std::max ((size_t) 1, numBlocksToAnalyse))
+    {
+        for (size_t i = 0; i < slots.size(); ++i)
+            slots[i].sequence.store (i, std::memory_order_relaxed);
+    }
+
+    //==============================================================================
+    /** Call this on the audio thread at the start of each block, before any nodes are processed. */
+    void beginBlock() noexcept
+    {
+        blockStartTicks = juce::Time::getHighResolutionTicks();
+        currentBlock.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    /** Call this on the audio thread once all the nodes in a block have been processed. */
+    void endBlock() noexcept
+    {
+        const auto duration = juce::Time::getHighResolutionTicks() - blockStartTicks;
+        push ({ nullptr, juce::Thread::getCurrentThreadId(), currentBlock.load (std::memory_order_relaxed), duration, duration });
+    }
+
+    //==============================================================================
+    /** Times the processing of a node for as long as this object is in scope.
+        The profiler can be nullptr in which case this does nothing so it's cheap to
+        leave these in processing code paths.
+    */
+    struct ScopedNodeTimer
+    {
+        ScopedNodeTimer (NodeProfiler* profilerToUse, const void* nodeBeingProcessed) noexcept
+            : profiler (profilerToUse), node (nodeBeingProcessed)
+        {
+            if (profiler != nullptr)
+            {
+                auto& current = getCurrentTimer();
+                parent = current;
+                current = this;
+                startTicks = juce::Time::getHighResolutionTicks();
+            }
+        }
+
+        ~ScopedNodeTimer() noexcept
+        {
+            if (profiler == nullptr)
+                return;
+
+            const auto totalTicks = juce::Time::getHighResolutionTicks() - startTicks;
+            getCurrentTimer() = parent;
+
+            if (parent != nullptr)
+                parent->nestedTicks += totalTicks;
+
+            profiler->push ({ node, juce::Thread::getCurrentThreadId(),
+                              profiler->currentBlock.load (std::memory_order_relaxed),
+                              std::max ((juce::int64) 0, totalTicks - nestedTicks), totalTicks });
+        }
+
+    private:
+        NodeProfiler* const profiler;
+        const void* const node;
+        ScopedNodeTimer* parent = nullptr;
+        juce::int64 startTicks = 0, nestedTicks = 0;
+
+        static ScopedNodeTimer*& getCurrentTimer() noexcept
+        {
+            thread_local ScopedNodeTimer* current = nullptr;
+            return current;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedNodeTimer)
+    };
+
+    //==============================================================================
+    /** Describes a node in the graph being profiled. */
+    struct GraphNode
+    {
+        const void* node = nullptr;
+        juce::String name;
+
+        /** The nodes that must be processed before this one. */
+        std::vector<const void*> inputs;
+
+        /** If false, this node processes its inputs itself one after another (as AudioNodes
+            usually do) so the time of all of them counts towards the critical path, rather
+            than just the longest one.
+        */
+        bool inputsCanBeProcessedInParallel = true;
+    };
+
+    /** Sets the topology of the graph being profiled.
+        This is used for naming nodes and calculating the critical path so should be
+        called whenever the graph changes. Don't call this on the audio thread.
+    */
+    void setGraph (std::vector<GraphNode> newGraph)
+    {
+        const juce::ScopedLock sl (lock);
+        graph.clear();
+
+        for (auto& n : newGraph)
+        {
+            auto& state = nodeStates[n.node];
+
+            if (state.name.isEmpty())
+                state.name = n.name;
+
+            graph[n.node] = std::move (n);
+        }
+    }
+
+    /** Returns a readable name for a class to use when naming GraphNodes. */
+    static juce::String getTypeName (const std::type_info& type)
+    {
+       #if JUCE_GCC || JUCE_CLANG
+        int status = 0;
+
+        if (auto demangled = abi::__cxa_demangle (type.name(), nullptr, nullptr, &status))
+        {
+            juce::String name (demangled);
+            std::free (demangled);
+            return name.fromLastOccurrenceOf ("::", false, false);
+        }
+       #endif
+
+        return juce::String (type.name()).fromLastOccurrenceOf (" ", false, false)
+                                         .fromLastOccurrenceOf ("::", false, false);
+    }
+
+    //==============================================================================
+    struct NodeStats
+    {
+        const void* node = nullptr;
+        juce::String name;
+        juce::uint64 numBlocksProcessed = 0;
+        double meanMs = 0.0, p99Ms = 0.0, maxMs = 0.0;
+        bool isOnCriticalPath = false;
+    };
+
+    struct ThreadStats
+    {
+        juce::Thread::ThreadID threadID = {};
+        juce::uint64 numNodesProcessed = 0;
+        double meanBusyMsPerBlock = 0.0;
+    };
+
+    struct Stats
+    {
+        /** The timed nodes, sorted with the most expensive first. */
+        std::vector<NodeStats> nodes;
+        std::vector<ThreadStats> threads;
+
+        juce::uint64 numBlocks = 0;
+        double meanBlockMs = 0.0, p99BlockMs = 0.0, maxBlockMs = 0.0;
+
+        /** The sum of the mean times of the nodes on the critical path. */
+        double criticalPathMs = 0.0;
+        /** The critical path nodes, starting from the one processed last. */
+        std::vector<const void*> criticalPath;
+
+        /** The number of events lost because the ring was full. */
+        juce::uint64 numDroppedEvents = 0;
+    };
+
+    /** Drains any pending events and returns the current stats.
+        Don't call this on the audio thread.
+    */
+    Stats getStats()
+    {
+        const juce::ScopedLock sl (lock);
+        drainEvents();
+
+        Stats stats;
+        stats.numBlocks = numBlocksProcessed;
+        stats.numDroppedEvents = numDroppedEvents.load();
+        calculateHistoryStats (blockHistory, stats.meanBlockMs, stats.p99BlockMs, stats.maxBlockMs);
+
+        for (auto& ns : nodeStates)
+        {
+            if (ns.second.numBlocksProcessed == 0)
+                continue;
+
+            NodeStats s;
+            s.node = ns.first;
+            s.name = ns.second.name;
+            s.numBlocksProcessed = ns.second.numBlocksProcessed;
+            calculateHistoryStats (ns.second.history, s.meanMs, s.p99Ms, s.maxMs);
+            stats.nodes.push_back (s);
+        }
+
+        for (auto& ts : threadStates)
+            stats.threads.push_back ({ ts.first, ts.second.numNodesProcessed,
+                                       numBlocksProcessed > 0 ? ts.second.busyMs / (double) numBlocksProcessed : 0.0 });
+
+        calculateCriticalPath (stats);
+
+        std::sort (stats.nodes.begin(), stats.nodes.end(),
+                   [] (const NodeStats& a, const NodeStats& b) { return a.meanMs > b.meanMs; });
+
+        return stats;
+    }
+
+    /** Clears all the recorded timings but keeps the graph. */
+    void reset()
+    {
+        const juce::ScopedLock sl (lock);
+        drainEvents();
+
+        for (auto& ns : nodeStates)
+            ns.second = NodeState { ns.second.name };
+
+        nodesWithPendingTimes.clear();
+        threadStates.clear();
+        blockHistory.clear();
+        blockHistoryPos = 0;
+        numBlocksProcessed = 0;
+        numDroppedEvents = 0;
+    }
+
+private:
+    //==============================================================================
+    struct Event
+    {
+        const void* node;
+        juce::Thread::ThreadID threadID;
+        juce::uint32 block;
+        juce::int64 selfTicks, totalTicks;
+    };
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence { 0 };
+        Event event;
+    };
+
+    std::vector<Slot> slots;
+    std::atomic<size_t> writePosition { 0 };
+    size_t readPosition = 0;
+    std::atomic<juce::uint64> numDroppedEvents { 0 };
+
+    std::atomic<juce::uint32> currentBlock { 0 };
+    juce::int64 blockStartTicks = 0;
+
+    /** Multiple-producer, single-consumer bounded queue. Each slot's sequence number
+        tells a writer if it's free for this lap and the reader if it's been filled.
+    */
+    void push (const Event& e) noexcept
+    {
+        const auto mask = slots.size() - 1;
+        auto pos = writePosition.load (std::memory_order_relaxed);
+
+        for (;;)
+        {
+            auto& slot = slots[pos & mask];
+            const auto seq = slot.sequence.load (std::memory_order_acquire);
+            const auto diff = (std::ptrdiff_t) seq - (std::ptrdiff_t) pos;
+
+            if (diff == 0)
+            {
+                if (writePosition.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.event = e;
+                    slot.sequence.store (pos + 1, std::memory_order_release);
+                    return;
+                }
+            }
+            else if (diff < 0)
+            {
+                numDroppedEvents.fetch_add (1, std::memory_order_relaxed);
+                return;
+            }
+            else
+            {
+                pos = writePosition.load (std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop (Event& e) noexcept
+    {
+        auto& slot = slots[readPosition & (slots.size() - 1)];
+
+        if (slot.sequence.load (std::memory_order_acquire) != readPosition + 1)
+            return false;
+
+        e = slot.event;
+        slot.sequence.store (readPosition + slots.size(), std::memory_order_release);
+        ++readPosition;
+        return true;
+    }
+
+    //==============================================================================
+    struct NodeState
+    {
+        juce::String name;
+        juce::uint64 numBlocksProcessed = 0;
+        std::vector<double> history;
+        size_t historyPos = 0;
+        juce::uint32 pendingBlock = 0;
+        double pendingMs = 0.0;
+        bool hasPending = false;
+    };
+
+    struct ThreadState
+    {
+        juce::uint64 numNodesProcessed = 0;
+        double busyMs = 0.0;
+    };
+
+    juce::CriticalSection lock;
+    std::unordered_map<const void*, GraphNode> graph;
+    std::unordered_map<const void*, NodeState> nodeStates;
+    std::map<juce::Thread::ThreadID, ThreadState> threadStates;
+    std::vector<NodeState*> nodesWithPendingTimes;
+    const size_t historySize;
+    std::vector<double> blockHistory;
+    size_t blockHistoryPos = 0;
+    juce::uint64 numBlocksProcessed = 0;
+
+    static double ticksToMs (juce::int64 ticks) noexcept
+    {
+        return juce::Time::highResolutionTicksToSeconds (ticks) * 1000.0;
+    }
+
+    void addToHistory (std::vector<double>& history, size_t& pos, double value)
+    {
+        if (history.size() < historySize)
+        {
+            history.push_back (value);
+        }
+        else
+        {
+            history[pos] = value;
+            pos = (pos + 1) % historySize;
+        }
+    }
+
+    static void calculateHistoryStats (const std::vector<double>& history, double& mean, double& p99, double& max)
+    {
+        if (history.empty())
+            return;
+
+        auto sorted = history;
+        std::sort (sorted.begin(), sorted.end());
+        mean = std::accumulate (sorted.begin(), sorted.end(), 0.0) / (double) sorted.size();
+        p99 = sorted[std::min (sorted.size() - 1, (size_t) std::ceil ((double) sorted.size() * 0.99) - 1)];
+        max = sorted.back();
+    }
+
+    void flushPendingTimes()
+    {
+        for (auto ns : nodesWithPendingTimes)
+        {
+            addToHistory (ns->history, ns->historyPos, ns->pendingMs);
+            ++ns->numBlocksProcessed;
+            ns->pendingMs = 0.0;
+            ns->hasPending = false;
+        }
+
+        nodesWithPendingTimes.clear();
+    }
+
+    void drainEvents()
+    {
+        Event e;
+
+        while (pop (e))
+        {
+            if (e.node == nullptr)
+            {
+                // A block has finished so any node times accumulated for it are complete
+                flushPendingTimes();
+                addToHistory (blockHistory, blockHistoryPos, ticksToMs (e.totalTicks));
+                ++numBlocksProcessed;
+                continue;
+            }
+
+            const auto selfMs = ticksToMs (e.selfTicks);
+            auto& ns = nodeStates[e.node];
+
+            if (ns.name.isEmpty())
+                ns.name = juce::String::toHexString ((juce::pointer_sized_int) e.node);
+
+            if (ns.hasPending && ns.pendingBlock != e.block)
+            {
+                addToHistory (ns.history, ns.historyPos, ns.pendingMs);
+                ++ns.numBlocksProcessed;
+                ns.pendingMs = 0.0;
+            }
+
+            if (! ns.hasPending)
+            {
+                ns.hasPending = true;
+                nodesWithPendingTimes.push_back (&ns);
+            }
+
+            // Nodes can be processed more than once in a block e.g. around loop points
+            ns.pendingBlock = e.block;
+            ns.pendingMs += selfMs;
+
+            auto& ts = threadStates[e.threadID];
+            ++ts.numNodesProcessed;
+            ts.busyMs += selfMs;
+        }
+    }
+
+    void calculateCriticalPath (Stats& stats) const
+    {
+        if (graph.empty())
+            return;
+
+        std::unordered_map<const void*, double> meanTimes;
+
+        for (auto& n : stats.nodes)
+            meanTimes[n.node] = n.meanMs;
+
+        struct PathInfo { double length = 0.0; const void* next = nullptr; };
+        std::unordered_map<const void*, PathInfo> paths;
+        std::unordered_set<const void*> visiting;
+
+        // Longest path ending at each node, memoised as the graph is a DAG
+        std::function<double (const void*)> getPathLength = [&] (const void* node) -> double
+        {
+            auto found = paths.find (node);
+
+            if (found != paths.end())
+                return found->second.length;
+
+            if (! visiting.insert (node).second)
+                return 0.0; // Guard against cycles in malformed graphs
+
+            PathInfo info;
+            auto graphNode = graph.find (node);
+
+            if (graphNode != graph.end())
+            {
+                double inputsLength = 0.0, longestInputLength = 0.0;
+
+                for (auto input : graphNode->second.inputs)
+                {
+                    const auto inputLength = getPathLength (input);
+
+                    if (graphNode->second.inputsCanBeProcessedInParallel)
+                        inputsLength = std::max (inputsLength, inputLength);
+                    else
+                        inputsLength += inputLength;
+
+                    if (info.next == nullptr || inputLength > longestInputLength)
+                    {
+                        longestInputLength = inputLength;
+                        info.next = input;
+                    }
+                }
+
+                info.length = inputsLength;
+            }
+
+            auto time = meanTimes.find (node);
+            info.length += time != meanTimes.end() ? time->second : 0.0;
+
+            visiting.erase (node);
+            paths[node] = info;
+            return info.length;
+        };
+
+        const void* start = nullptr;
+
+        for (auto& n : graph)
+        {
+            const auto length = getPathLength (n.first);
+
+            if (start == nullptr || length > stats.criticalPathMs)
+            {
+                stats.criticalPathMs = length;
+                start = n.first;
+            }
+        }
+
+        for (auto node = start; node != nullptr; node = paths[node].next)
+            stats.criticalPath.push_back (node);
+
+        for (auto& n : stats.nodes)
+            n.isOnCriticalPath = std::find (stats.criticalPath.begin(), stats.criticalPath.end(), n.node)
+                                    != stats.criticalPath.end();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (NodeProfiler)
+};
+
+} // namespace tracktion_engine